@@ -286,7 +286,10 @@
 //#define MBEDTLS_DES_ALT
 //#define MBEDTLS_DHM_ALT
 //#define MBEDTLS_ECJPAKE_ALT
-//#define MBEDTLS_GCM_ALT
+/* mbedtls_gcm_alt.c uses AES-NI and PCLMULQDQ. */
+#if defined(__x86_64__)
+#define MBEDTLS_GCM_ALT
+#endif
 //#define MBEDTLS_MD2_ALT
 //#define MBEDTLS_MD4_ALT
 //#define MBEDTLS_MD5_ALT
@@ -347,7 +350,10 @@
 //#define MBEDTLS_MD5_PROCESS_ALT
 //#define MBEDTLS_RIPEMD160_PROCESS_ALT
 //#define MBEDTLS_SHA1_PROCESS_ALT
-//#define MBEDTLS_SHA256_PROCESS_ALT
+/* mbedtls_sha256_process.c uses the x86 SHA extensions. */
+#if defined(__x86_64__)
+#define MBEDTLS_SHA256_PROCESS_ALT
+#endif
 //#define MBEDTLS_SHA512_PROCESS_ALT
 //#define MBEDTLS_DES_SETKEY_ALT
 //#define MBEDTLS_DES_CRYPT_ECB_ALT
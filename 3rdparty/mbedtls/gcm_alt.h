@@ -0,0 +1,114 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef MBEDTLS_GCM_ALT_H
+#define MBEDTLS_GCM_ALT_H
+
+/*
+ * Open Enclave replacement for the mbedtls GCM module (MBEDTLS_GCM_ALT).
+ * See mbedtls_gcm_alt.c. The API is identical to the one documented in
+ * mbedtls/gcm.h, plus mbedtls_gcm_set_acceleration().
+ */
+
+#include <mbedtls/aes.h>
+#include <mbedtls/cipher.h>
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          The GCM context structure.
+ */
+typedef struct
+{
+    mbedtls_cipher_context_t cipher_ctx; /*!< The cipher context used. */
+    mbedtls_aes_context aes;   /*!< AES key schedule (accelerated path). */
+    uint64_t HL[16];           /*!< Precalculated HTable low. */
+    uint64_t HH[16];           /*!< Precalculated HTable high. */
+    unsigned char h_pow[4][16];/*!< H^1..H^4, byte-reflected (accelerated
+                                    path). */
+    uint64_t len;              /*!< The total length of the encrypted data. */
+    uint64_t add_len;          /*!< The total length of the additional data. */
+    unsigned char base_ectr[16]; /*!< The first ECTR for tag. */
+    unsigned char y[16];       /*!< The Y working value. */
+    unsigned char buf[16];     /*!< The buf working value. */
+    int mode;                  /*!< The operation to perform:
+                                    #MBEDTLS_GCM_ENCRYPT or
+                                    #MBEDTLS_GCM_DECRYPT. */
+    int accel_available;       /*!< AES-NI/PCLMULQDQ usable for this key. */
+    int accel;                 /*!< AES-NI/PCLMULQDQ path is selected. */
+}
+mbedtls_gcm_context;
+
+void mbedtls_gcm_init( mbedtls_gcm_context *ctx );
+
+int mbedtls_gcm_setkey( mbedtls_gcm_context *ctx,
+                        mbedtls_cipher_id_t cipher,
+                        const unsigned char *key,
+                        unsigned int keybits );
+
+int mbedtls_gcm_crypt_and_tag( mbedtls_gcm_context *ctx,
+                       int mode,
+                       size_t length,
+                       const unsigned char *iv,
+                       size_t iv_len,
+                       const unsigned char *add,
+                       size_t add_len,
+                       const unsigned char *input,
+                       unsigned char *output,
+                       size_t tag_len,
+                       unsigned char *tag );
+
+int mbedtls_gcm_auth_decrypt( mbedtls_gcm_context *ctx,
+                      size_t length,
+                      const unsigned char *iv,
+                      size_t iv_len,
+                      const unsigned char *add,
+                      size_t add_len,
+                      const unsigned char *tag,
+                      size_t tag_len,
+                      const unsigned char *input,
+                      unsigned char *output );
+
+int mbedtls_gcm_starts( mbedtls_gcm_context *ctx,
+                int mode,
+                const unsigned char *iv,
+                size_t iv_len,
+                const unsigned char *add,
+                size_t add_len );
+
+int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
+                size_t length,
+                const unsigned char *input,
+                unsigned char *output );
+
+int mbedtls_gcm_finish( mbedtls_gcm_context *ctx,
+                unsigned char *tag,
+                size_t tag_len );
+
+void mbedtls_gcm_free( mbedtls_gcm_context *ctx );
+
+/**
+ * \brief           This function selects between the AES-NI/PCLMULQDQ
+ *                  implementation, which is the default when the processor
+ *                  supports it and the cipher is AES, and the portable
+ *                  implementation. It must be called after
+ *                  mbedtls_gcm_setkey() and before mbedtls_gcm_starts().
+ *                  It exists mainly to compare both implementations.
+ *
+ * \param ctx       The GCM context.
+ * \param enable    Non-zero to select the accelerated implementation.
+ *
+ * \return          \c 0 on success, or #MBEDTLS_ERR_GCM_HW_ACCEL_FAILED if
+ *                  acceleration is requested but is not available.
+ */
+int mbedtls_gcm_set_acceleration( mbedtls_gcm_context *ctx, int enable );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MBEDTLS_GCM_ALT_H */
@@ -36,6 +36,11 @@
 
 #include <string.h>
 
+#if defined(OE_BUILD_ENCLAVE)
+/* Open Enclave: CPUID traps inside the enclave, use the cached leaves */
+#include <openenclave/internal/cpuid.h>
+#endif
+
 #ifndef asm
 #define asm __asm
 #endif
@@ -52,11 +57,17 @@ int mbedtls_aesni_has_support( unsigned int what )
 
     if( ! done )
     {
+#if defined(OE_BUILD_ENCLAVE)
+        uint32_t a, b, d;
+        if( oe_cpuid( 1, 0, &a, &b, &c, &d ) != OE_OK )
+            c = 0;
+#else
         asm( "movl  $1, %%eax   \n\t"
              "cpuid             \n\t"
              : "=c" (c)
              :
              : "eax", "ebx", "edx" );
+#endif
         done = 1;
     }
 
@@ -0,0 +1,845 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <mbedtls/gcm.h>
+
+#if defined(MBEDTLS_GCM_ALT)
+
+#include <mbedtls/aesni.h>
+#include <string.h>
+
+#include <immintrin.h>
+
+/*
+ * MBEDTLS links these function definitions when MBEDTLS_GCM_ALT is defined
+ * in the MBEDTLS config.h file.
+ *
+ * When the cipher is AES and the processor supports AES-NI and PCLMULQDQ,
+ * the counter mode encryption and GHASH are done directly with those
+ * instructions: four counter blocks are encrypted in parallel and four
+ * ciphertext blocks are folded into the GHASH state with a single reduction
+ * (using the precomputed powers H^1..H^4). Otherwise, the implementation
+ * behaves like the mbedtls GCM module, encrypting one block at a time
+ * through the cipher layer.
+ *
+ * In the accelerated path, field elements are kept byte-reflected (the
+ * byte order reversed) so that the carry-less multiplication of the
+ * bit-reflected GCM representation only needs a one bit shift before the
+ * reduction.
+ */
+
+#define GCM_TARGET __attribute__((target("aes,pclmul,ssse3")))
+
+#define GET_UINT32_BE(n, b, i)                                            \
+    do                                                                    \
+    {                                                                     \
+        (n) = ((uint32_t)(b)[(i)] << 24) | ((uint32_t)(b)[(i) + 1] << 16) | \
+              ((uint32_t)(b)[(i) + 2] << 8) | ((uint32_t)(b)[(i) + 3]);   \
+    } while (0)
+
+#define PUT_UINT32_BE(n, b, i)                      \
+    do                                              \
+    {                                               \
+        (b)[(i)] = (unsigned char)((n) >> 24);      \
+        (b)[(i) + 1] = (unsigned char)((n) >> 16);  \
+        (b)[(i) + 2] = (unsigned char)((n) >> 8);   \
+        (b)[(i) + 3] = (unsigned char)((n));        \
+    } while (0)
+
+static void _zeroize(void* v, size_t n)
+{
+    volatile unsigned char* p = v;
+
+    while (n--)
+        *p++ = 0;
+}
+
+static int _have_accel(void)
+{
+    return mbedtls_aesni_has_support(MBEDTLS_AESNI_AES) &&
+           mbedtls_aesni_has_support(MBEDTLS_AESNI_CLMUL);
+}
+
+/*
+**==============================================================================
+**
+** AES-NI/PCLMULQDQ implementation
+**
+**==============================================================================
+*/
+
+GCM_TARGET static inline __m128i _reflect(__m128i x)
+{
+    const __m128i mask =
+        _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    return _mm_shuffle_epi8(x, mask);
+}
+
+/* Accumulate the unreduced 256-bit carry-less product of a and b */
+GCM_TARGET static inline void _clmul_acc(
+    __m128i a,
+    __m128i b,
+    __m128i* lo,
+    __m128i* hi)
+{
+    __m128i t0 = _mm_clmulepi64_si128(a, b, 0x00);
+    __m128i t1 = _mm_clmulepi64_si128(a, b, 0x10);
+    __m128i t2 = _mm_clmulepi64_si128(a, b, 0x01);
+    __m128i t3 = _mm_clmulepi64_si128(a, b, 0x11);
+
+    t1 = _mm_xor_si128(t1, t2);
+    *lo = _mm_xor_si128(*lo, _mm_xor_si128(t0, _mm_slli_si128(t1, 8)));
+    *hi = _mm_xor_si128(*hi, _mm_xor_si128(t3, _mm_srli_si128(t1, 8)));
+}
+
+/* Reduce hi:lo modulo the GCM polynomial x^128 + x^7 + x^2 + x + 1 */
+GCM_TARGET static inline __m128i _reduce(__m128i lo, __m128i hi)
+{
+    __m128i t0, t1, t2, t3;
+
+    /* Shift hi:lo left by one bit to account for the bit reflection */
+    t0 = _mm_srli_epi32(lo, 31);
+    t1 = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    t2 = _mm_srli_si128(t0, 12);
+    t1 = _mm_slli_si128(t1, 4);
+    t0 = _mm_slli_si128(t0, 4);
+    lo = _mm_or_si128(lo, t0);
+    hi = _mm_or_si128(hi, t1);
+    hi = _mm_or_si128(hi, t2);
+
+    /* First phase of the reduction */
+    t0 = _mm_slli_epi32(lo, 31);
+    t1 = _mm_slli_epi32(lo, 30);
+    t2 = _mm_slli_epi32(lo, 25);
+    t0 = _mm_xor_si128(t0, t1);
+    t0 = _mm_xor_si128(t0, t2);
+    t3 = _mm_srli_si128(t0, 4);
+    t0 = _mm_slli_si128(t0, 12);
+    lo = _mm_xor_si128(lo, t0);
+
+    /* Second phase of the reduction */
+    t0 = _mm_srli_epi32(lo, 1);
+    t1 = _mm_srli_epi32(lo, 2);
+    t2 = _mm_srli_epi32(lo, 7);
+    t0 = _mm_xor_si128(t0, t1);
+    t0 = _mm_xor_si128(t0, t2);
+    t0 = _mm_xor_si128(t0, t3);
+    lo = _mm_xor_si128(lo, t0);
+
+    return _mm_xor_si128(hi, lo);
+}
+
+GCM_TARGET static inline __m128i _gfmul(__m128i a, __m128i b)
+{
+    __m128i lo = _mm_setzero_si128();
+    __m128i hi = _mm_setzero_si128();
+
+    _clmul_acc(a, b, &lo, &hi);
+
+    return _reduce(lo, hi);
+}
+
+/* Fold four byte-reflected blocks into x with a single reduction */
+GCM_TARGET static inline __m128i _ghash4(
+    const mbedtls_gcm_context* ctx,
+    __m128i x,
+    __m128i b0,
+    __m128i b1,
+    __m128i b2,
+    __m128i b3)
+{
+    __m128i lo = _mm_setzero_si128();
+    __m128i hi = _mm_setzero_si128();
+
+    _clmul_acc(
+        _mm_xor_si128(x, b0),
+        _mm_loadu_si128((const __m128i*)ctx->h_pow[3]),
+        &lo,
+        &hi);
+    _clmul_acc(b1, _mm_loadu_si128((const __m128i*)ctx->h_pow[2]), &lo, &hi);
+    _clmul_acc(b2, _mm_loadu_si128((const __m128i*)ctx->h_pow[1]), &lo, &hi);
+    _clmul_acc(b3, _mm_loadu_si128((const __m128i*)ctx->h_pow[0]), &lo, &hi);
+
+    return _reduce(lo, hi);
+}
+
+GCM_TARGET static void _gen_powers_accel(mbedtls_gcm_context* ctx)
+{
+    unsigned char h[16];
+    __m128i h1, hn;
+    int i;
+
+    PUT_UINT32_BE(ctx->HH[8] >> 32, h, 0);
+    PUT_UINT32_BE(ctx->HH[8], h, 4);
+    PUT_UINT32_BE(ctx->HL[8] >> 32, h, 8);
+    PUT_UINT32_BE(ctx->HL[8], h, 12);
+
+    h1 = _reflect(_mm_loadu_si128((const __m128i*)h));
+    hn = h1;
+    _mm_storeu_si128((__m128i*)ctx->h_pow[0], h1);
+
+    for (i = 1; i < 4; i++)
+    {
+        hn = _gfmul(hn, h1);
+        _mm_storeu_si128((__m128i*)ctx->h_pow[i], hn);
+    }
+
+    _zeroize(h, sizeof(h));
+}
+
+/* buf = (buf ^ p[0]) * H ... over len bytes, the last block zero-padded */
+GCM_TARGET static void _ghash_accel(
+    const mbedtls_gcm_context* ctx,
+    unsigned char buf[16],
+    const unsigned char* p,
+    size_t len)
+{
+    const __m128i h1 = _mm_loadu_si128((const __m128i*)ctx->h_pow[0]);
+    __m128i x = _reflect(_mm_loadu_si128((const __m128i*)buf));
+
+    while (len >= 64)
+    {
+        x = _ghash4(
+            ctx,
+            x,
+            _reflect(_mm_loadu_si128((const __m128i*)p)),
+            _reflect(_mm_loadu_si128((const __m128i*)(p + 16))),
+            _reflect(_mm_loadu_si128((const __m128i*)(p + 32))),
+            _reflect(_mm_loadu_si128((const __m128i*)(p + 48))));
+        p += 64;
+        len -= 64;
+    }
+
+    while (len > 0)
+    {
+        unsigned char block[16];
+        size_t use_len = (len < 16) ? len : 16;
+
+        memset(block, 0, sizeof(block));
+        memcpy(block, p, use_len);
+
+        x = _mm_xor_si128(x, _reflect(_mm_loadu_si128((const __m128i*)block)));
+        x = _gfmul(x, h1);
+
+        p += use_len;
+        len -= use_len;
+    }
+
+    _mm_storeu_si128((__m128i*)buf, _reflect(x));
+}
+
+GCM_TARGET static void _update_accel(
+    mbedtls_gcm_context* ctx,
+    size_t length,
+    const unsigned char* input,
+    unsigned char* output)
+{
+    const __m128i one = _mm_set_epi32(0, 0, 0, 1);
+    const __m128i h1 = _mm_loadu_si128((const __m128i*)ctx->h_pow[0]);
+    const int decrypt = (ctx->mode == MBEDTLS_GCM_DECRYPT);
+    const int nr = ctx->aes.nr;
+    __m128i rk[15];
+    __m128i x, ctr;
+    int r;
+
+    for (r = 0; r <= nr; r++)
+        rk[r] = _mm_loadu_si128((const __m128i*)(ctx->aes.rk + 4 * r));
+
+    x = _reflect(_mm_loadu_si128((const __m128i*)ctx->buf));
+
+    /* Byte-reflecting the counter block puts its 32-bit big-endian counter
+     * into the lowest lane, so it wraps like the mbedtls implementation */
+    ctr = _reflect(_mm_loadu_si128((const __m128i*)ctx->y));
+
+    while (length >= 64)
+    {
+        __m128i b0, b1, b2, b3, c0, c1, c2, c3;
+
+        ctr = _mm_add_epi32(ctr, one);
+        b0 = _mm_xor_si128(_reflect(ctr), rk[0]);
+        ctr = _mm_add_epi32(ctr, one);
+        b1 = _mm_xor_si128(_reflect(ctr), rk[0]);
+        ctr = _mm_add_epi32(ctr, one);
+        b2 = _mm_xor_si128(_reflect(ctr), rk[0]);
+        ctr = _mm_add_epi32(ctr, one);
+        b3 = _mm_xor_si128(_reflect(ctr), rk[0]);
+
+        for (r = 1; r < nr; r++)
+        {
+            b0 = _mm_aesenc_si128(b0, rk[r]);
+            b1 = _mm_aesenc_si128(b1, rk[r]);
+            b2 = _mm_aesenc_si128(b2, rk[r]);
+            b3 = _mm_aesenc_si128(b3, rk[r]);
+        }
+
+        b0 = _mm_aesenclast_si128(b0, rk[nr]);
+        b1 = _mm_aesenclast_si128(b1, rk[nr]);
+        b2 = _mm_aesenclast_si128(b2, rk[nr]);
+        b3 = _mm_aesenclast_si128(b3, rk[nr]);
+
+        /* Load all the input before storing any output (in-place use) */
+        c0 = _mm_loadu_si128((const __m128i*)input);
+        c1 = _mm_loadu_si128((const __m128i*)(input + 16));
+        c2 = _mm_loadu_si128((const __m128i*)(input + 32));
+        c3 = _mm_loadu_si128((const __m128i*)(input + 48));
+
+        b0 = _mm_xor_si128(b0, c0);
+        b1 = _mm_xor_si128(b1, c1);
+        b2 = _mm_xor_si128(b2, c2);
+        b3 = _mm_xor_si128(b3, c3);
+
+        _mm_storeu_si128((__m128i*)output, b0);
+        _mm_storeu_si128((__m128i*)(output + 16), b1);
+        _mm_storeu_si128((__m128i*)(output + 32), b2);
+        _mm_storeu_si128((__m128i*)(output + 48), b3);
+
+        /* GHASH is always computed over the ciphertext */
+        if (decrypt)
+        {
+            x = _ghash4(
+                ctx, x, _reflect(c0), _reflect(c1), _reflect(c2), _reflect(c3));
+        }
+        else
+        {
+            x = _ghash4(
+                ctx, x, _reflect(b0), _reflect(b1), _reflect(b2), _reflect(b3));
+        }
+
+        input += 64;
+        output += 64;
+        length -= 64;
+    }
+
+    while (length > 0)
+    {
+        size_t use_len = (length < 16) ? length : 16;
+        unsigned char ectr[16];
+        unsigned char block[16];
+        __m128i b;
+        size_t i;
+
+        ctr = _mm_add_epi32(ctr, one);
+        b = _mm_xor_si128(_reflect(ctr), rk[0]);
+
+        for (r = 1; r < nr; r++)
+            b = _mm_aesenc_si128(b, rk[r]);
+
+        b = _mm_aesenclast_si128(b, rk[nr]);
+        _mm_storeu_si128((__m128i*)ectr, b);
+
+        memset(block, 0, sizeof(block));
+
+        for (i = 0; i < use_len; i++)
+        {
+            unsigned char c = input[i];
+
+            output[i] = ectr[i] ^ c;
+            block[i] = decrypt ? c : output[i];
+        }
+
+        x = _mm_xor_si128(x, _reflect(_mm_loadu_si128((const __m128i*)block)));
+        x = _gfmul(x, h1);
+
+        _zeroize(ectr, sizeof(ectr));
+
+        input += use_len;
+        output += use_len;
+        length -= use_len;
+    }
+
+    _mm_storeu_si128((__m128i*)ctx->y, _reflect(ctr));
+    _mm_storeu_si128((__m128i*)ctx->buf, _reflect(x));
+}
+
+/*
+**==============================================================================
+**
+** Portable implementation
+**
+**     This follows the mbedtls GCM module: Shoup's 4-bit tables, or the
+**     single-block PCLMULQDQ multiplication of the mbedtls AESNI module.
+**
+**==============================================================================
+*/
+
+/*
+ * Precompute small multiples of H, that is set
+ *      HH[i] || HL[i] = H times i,
+ * where i is seen as a field element as in [MGV], ie high-order bits
+ * correspond to low powers of P.
+ */
+static int _gen_table(mbedtls_gcm_context* ctx)
+{
+    int ret, i, j;
+    uint32_t hi, lo;
+    uint64_t vl, vh;
+    unsigned char h[16];
+    size_t olen = 0;
+
+    memset(h, 0, 16);
+    if ((ret = mbedtls_cipher_update(&ctx->cipher_ctx, h, 16, h, &olen)) != 0)
+        return ret;
+
+    /* pack h as two 64-bits ints, big-endian */
+    GET_UINT32_BE(hi, h, 0);
+    GET_UINT32_BE(lo, h, 4);
+    vh = (uint64_t)hi << 32 | lo;
+
+    GET_UINT32_BE(hi, h, 8);
+    GET_UINT32_BE(lo, h, 12);
+    vl = (uint64_t)hi << 32 | lo;
+
+    _zeroize(h, sizeof(h));
+
+    /* 8 = 1000 corresponds to 1 in GF(2^128) */
+    ctx->HL[8] = vl;
+    ctx->HH[8] = vh;
+
+    /* 0 corresponds to 0 in GF(2^128) */
+    ctx->HH[0] = 0;
+    ctx->HL[0] = 0;
+
+    for (i = 4; i > 0; i >>= 1)
+    {
+        uint32_t T = (vl & 1) * 0xe1000000U;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ ((uint64_t)T << 32);
+
+        ctx->HL[i] = vl;
+        ctx->HH[i] = vh;
+    }
+
+    for (i = 2; i <= 8; i *= 2)
+    {
+        uint64_t *HiL = ctx->HL + i, *HiH = ctx->HH + i;
+        vh = *HiH;
+        vl = *HiL;
+        for (j = 1; j < i; j++)
+        {
+            HiH[j] = vh ^ ctx->HH[j];
+            HiL[j] = vl ^ ctx->HL[j];
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Shoup's method for multiplication use this table with
+ *      last4[x] = x times P^128
+ * where x and last4[x] are seen as elements of GF(2^128) as in [MGV]
+ */
+static const uint64_t _last4[16] = {0x0000,
+                                    0x1c20,
+                                    0x3840,
+                                    0x2460,
+                                    0x7080,
+                                    0x6ca0,
+                                    0x48c0,
+                                    0x54e0,
+                                    0xe100,
+                                    0xfd20,
+                                    0xd940,
+                                    0xc560,
+                                    0x9180,
+                                    0x8da0,
+                                    0xa9c0,
+                                    0xb5e0};
+
+/* Sets output to x times H */
+static void _gcm_mult(
+    const mbedtls_gcm_context* ctx,
+    const unsigned char x[16],
+    unsigned char output[16])
+{
+    int i = 0;
+    unsigned char lo, hi, rem;
+    uint64_t zh, zl;
+
+    if (mbedtls_aesni_has_support(MBEDTLS_AESNI_CLMUL))
+    {
+        unsigned char h[16];
+
+        PUT_UINT32_BE(ctx->HH[8] >> 32, h, 0);
+        PUT_UINT32_BE(ctx->HH[8], h, 4);
+        PUT_UINT32_BE(ctx->HL[8] >> 32, h, 8);
+        PUT_UINT32_BE(ctx->HL[8], h, 12);
+
+        mbedtls_aesni_gcm_mult(output, x, h);
+        return;
+    }
+
+    lo = x[15] & 0xf;
+
+    zh = ctx->HH[lo];
+    zl = ctx->HL[lo];
+
+    for (i = 15; i >= 0; i--)
+    {
+        lo = x[i] & 0xf;
+        hi = x[i] >> 4;
+
+        if (i != 15)
+        {
+            rem = (unsigned char)zl & 0xf;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4);
+            zh ^= (uint64_t)_last4[rem] << 48;
+            zh ^= ctx->HH[lo];
+            zl ^= ctx->HL[lo];
+        }
+
+        rem = (unsigned char)zl & 0xf;
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4);
+        zh ^= (uint64_t)_last4[rem] << 48;
+        zh ^= ctx->HH[hi];
+        zl ^= ctx->HL[hi];
+    }
+
+    PUT_UINT32_BE(zh >> 32, output, 0);
+    PUT_UINT32_BE(zh, output, 4);
+    PUT_UINT32_BE(zl >> 32, output, 8);
+    PUT_UINT32_BE(zl, output, 12);
+}
+
+static void _ghash(
+    const mbedtls_gcm_context* ctx,
+    unsigned char buf[16],
+    const unsigned char* p,
+    size_t len)
+{
+    if (ctx->accel)
+    {
+        _ghash_accel(ctx, buf, p, len);
+        return;
+    }
+
+    while (len > 0)
+    {
+        size_t use_len = (len < 16) ? len : 16;
+        size_t i;
+
+        for (i = 0; i < use_len; i++)
+            buf[i] ^= p[i];
+
+        _gcm_mult(ctx, buf, buf);
+
+        len -= use_len;
+        p += use_len;
+    }
+}
+
+static int _update_portable(
+    mbedtls_gcm_context* ctx,
+    size_t length,
+    const unsigned char* input,
+    unsigned char* output)
+{
+    int ret;
+    unsigned char ectr[16];
+    size_t i;
+    const unsigned char* p = input;
+    unsigned char* out_p = output;
+    size_t use_len, olen = 0;
+
+    while (length > 0)
+    {
+        use_len = (length < 16) ? length : 16;
+
+        for (i = 16; i > 12; i--)
+            if (++ctx->y[i - 1] != 0)
+                break;
+
+        if ((ret = mbedtls_cipher_update(
+                 &ctx->cipher_ctx, ctx->y, 16, ectr, &olen)) != 0)
+        {
+            return ret;
+        }
+
+        for (i = 0; i < use_len; i++)
+        {
+            if (ctx->mode == MBEDTLS_GCM_DECRYPT)
+                ctx->buf[i] ^= p[i];
+            out_p[i] = ectr[i] ^ p[i];
+            if (ctx->mode == MBEDTLS_GCM_ENCRYPT)
+                ctx->buf[i] ^= out_p[i];
+        }
+
+        _gcm_mult(ctx, ctx->buf, ctx->buf);
+
+        length -= use_len;
+        p += use_len;
+        out_p += use_len;
+    }
+
+    return 0;
+}
+
+/*
+**==============================================================================
+**
+** mbedtls GCM API
+**
+**==============================================================================
+*/
+
+void mbedtls_gcm_init(mbedtls_gcm_context* ctx)
+{
+    memset(ctx, 0, sizeof(mbedtls_gcm_context));
+    mbedtls_aes_init(&ctx->aes);
+}
+
+int mbedtls_gcm_setkey(
+    mbedtls_gcm_context* ctx,
+    mbedtls_cipher_id_t cipher,
+    const unsigned char* key,
+    unsigned int keybits)
+{
+    int ret;
+    const mbedtls_cipher_info_t* cipher_info;
+
+    cipher_info =
+        mbedtls_cipher_info_from_values(cipher, keybits, MBEDTLS_MODE_ECB);
+    if (cipher_info == NULL)
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+
+    if (cipher_info->block_size != 16)
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+
+    mbedtls_cipher_free(&ctx->cipher_ctx);
+    ctx->accel_available = 0;
+    ctx->accel = 0;
+
+    if ((ret = mbedtls_cipher_setup(&ctx->cipher_ctx, cipher_info)) != 0)
+        return ret;
+
+    if ((ret = mbedtls_cipher_setkey(
+             &ctx->cipher_ctx, key, keybits, MBEDTLS_ENCRYPT)) != 0)
+    {
+        return ret;
+    }
+
+    if ((ret = _gen_table(ctx)) != 0)
+        return ret;
+
+    if (cipher == MBEDTLS_CIPHER_ID_AES && _have_accel())
+    {
+        if ((ret = mbedtls_aes_setkey_enc(&ctx->aes, key, keybits)) != 0)
+            return ret;
+
+        _gen_powers_accel(ctx);
+        ctx->accel_available = 1;
+        ctx->accel = 1;
+    }
+
+    return 0;
+}
+
+int mbedtls_gcm_set_acceleration(mbedtls_gcm_context* ctx, int enable)
+{
+    if (enable && !ctx->accel_available)
+        return MBEDTLS_ERR_GCM_HW_ACCEL_FAILED;
+
+    ctx->accel = enable ? 1 : 0;
+    return 0;
+}
+
+int mbedtls_gcm_starts(
+    mbedtls_gcm_context* ctx,
+    int mode,
+    const unsigned char* iv,
+    size_t iv_len,
+    const unsigned char* add,
+    size_t add_len)
+{
+    int ret;
+    unsigned char work_buf[16];
+    size_t olen = 0;
+
+    /* IV and AD are limited to 2^64 bits, so 2^61 bytes */
+    /* IV is not allowed to be zero length */
+    if (iv_len == 0 || ((uint64_t)iv_len) >> 61 != 0 ||
+        ((uint64_t)add_len) >> 61 != 0)
+    {
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+    }
+
+    memset(ctx->y, 0x00, sizeof(ctx->y));
+    memset(ctx->buf, 0x00, sizeof(ctx->buf));
+
+    ctx->mode = mode;
+    ctx->len = 0;
+    ctx->add_len = 0;
+
+    if (iv_len == 12)
+    {
+        memcpy(ctx->y, iv, iv_len);
+        ctx->y[15] = 1;
+    }
+    else
+    {
+        memset(work_buf, 0x00, 16);
+        PUT_UINT32_BE(iv_len * 8, work_buf, 12);
+
+        _ghash(ctx, ctx->y, iv, iv_len);
+        _ghash(ctx, ctx->y, work_buf, 16);
+    }
+
+    if ((ret = mbedtls_cipher_update(
+             &ctx->cipher_ctx, ctx->y, 16, ctx->base_ectr, &olen)) != 0)
+    {
+        return ret;
+    }
+
+    ctx->add_len = add_len;
+    _ghash(ctx, ctx->buf, add, add_len);
+
+    return 0;
+}
+
+int mbedtls_gcm_update(
+    mbedtls_gcm_context* ctx,
+    size_t length,
+    const unsigned char* input,
+    unsigned char* output)
+{
+    if (output > input && (size_t)(output - input) < length)
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+
+    /* Total length is restricted to 2^39 - 256 bits, ie 2^36 - 2^5 bytes
+     * Also check for possible overflow */
+    if (ctx->len + length < ctx->len ||
+        (uint64_t)ctx->len + length > 0xFFFFFFFE0ull)
+    {
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+    }
+
+    ctx->len += length;
+
+    if (ctx->accel)
+    {
+        _update_accel(ctx, length, input, output);
+        return 0;
+    }
+
+    return _update_portable(ctx, length, input, output);
+}
+
+int mbedtls_gcm_finish(
+    mbedtls_gcm_context* ctx,
+    unsigned char* tag,
+    size_t tag_len)
+{
+    unsigned char work_buf[16];
+    size_t i;
+    uint64_t orig_len = ctx->len * 8;
+    uint64_t orig_add_len = ctx->add_len * 8;
+
+    if (tag_len > 16 || tag_len < 4)
+        return MBEDTLS_ERR_GCM_BAD_INPUT;
+
+    memcpy(tag, ctx->base_ectr, tag_len);
+
+    if (orig_len || orig_add_len)
+    {
+        memset(work_buf, 0x00, 16);
+
+        PUT_UINT32_BE((orig_add_len >> 32), work_buf, 0);
+        PUT_UINT32_BE((orig_add_len), work_buf, 4);
+        PUT_UINT32_BE((orig_len >> 32), work_buf, 8);
+        PUT_UINT32_BE((orig_len), work_buf, 12);
+
+        _ghash(ctx, ctx->buf, work_buf, 16);
+
+        for (i = 0; i < tag_len; i++)
+            tag[i] ^= ctx->buf[i];
+    }
+
+    return 0;
+}
+
+int mbedtls_gcm_crypt_and_tag(
+    mbedtls_gcm_context* ctx,
+    int mode,
+    size_t length,
+    const unsigned char* iv,
+    size_t iv_len,
+    const unsigned char* add,
+    size_t add_len,
+    const unsigned char* input,
+    unsigned char* output,
+    size_t tag_len,
+    unsigned char* tag)
+{
+    int ret;
+
+    if ((ret = mbedtls_gcm_starts(ctx, mode, iv, iv_len, add, add_len)) != 0)
+        return ret;
+
+    if ((ret = mbedtls_gcm_update(ctx, length, input, output)) != 0)
+        return ret;
+
+    if ((ret = mbedtls_gcm_finish(ctx, tag, tag_len)) != 0)
+        return ret;
+
+    return 0;
+}
+
+int mbedtls_gcm_auth_decrypt(
+    mbedtls_gcm_context* ctx,
+    size_t length,
+    const unsigned char* iv,
+    size_t iv_len,
+    const unsigned char* add,
+    size_t add_len,
+    const unsigned char* tag,
+    size_t tag_len,
+    const unsigned char* input,
+    unsigned char* output)
+{
+    int ret;
+    unsigned char check_tag[16];
+    size_t i;
+    int diff;
+
+    if ((ret = mbedtls_gcm_crypt_and_tag(
+             ctx,
+             MBEDTLS_GCM_DECRYPT,
+             length,
+             iv,
+             iv_len,
+             add,
+             add_len,
+             input,
+             output,
+             tag_len,
+             check_tag)) != 0)
+    {
+        return ret;
+    }
+
+    /* Check tag in "constant-time" */
+    for (diff = 0, i = 0; i < tag_len; i++)
+        diff |= tag[i] ^ check_tag[i];
+
+    if (diff != 0)
+    {
+        _zeroize(output, length);
+        return MBEDTLS_ERR_GCM_AUTH_FAILED;
+    }
+
+    return 0;
+}
+
+void mbedtls_gcm_free(mbedtls_gcm_context* ctx)
+{
+    mbedtls_cipher_free(&ctx->cipher_ctx);
+    mbedtls_aes_free(&ctx->aes);
+    _zeroize(ctx, sizeof(mbedtls_gcm_context));
+}
+
+#endif /* MBEDTLS_GCM_ALT */
@@ -0,0 +1,235 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <mbedtls/sha256.h>
+#include <stdint.h>
+
+#if defined(MBEDTLS_SHA256_PROCESS_ALT)
+
+#include <immintrin.h>
+
+#if defined(OE_BUILD_ENCLAVE)
+#include <openenclave/internal/cpuid.h>
+#endif
+
+/*
+ * MBEDTLS links this function definition when MBEDTLS_SHA256_PROCESS_ALT is
+ * defined in the MBEDTLS config.h file. It replaces the portable SHA-256
+ * compression function with one that uses the SHA extensions (SHA-NI) when
+ * the processor supports them, and falls back to a portable implementation
+ * otherwise. The choice is made once, on first use.
+ */
+
+#define CPUID_SSE41_FEATURE 0x00080000u /* leaf 1, ECX bit 19 */
+#define CPUID_SHA_FEATURE 0x20000000u   /* leaf 7, EBX bit 29 */
+
+static const uint32_t _K[64] = {
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1,
+    0x923F82A4, 0xAB1C5ED5, 0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+    0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174, 0xE49B69C1, 0xEFBE4786,
+    0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147,
+    0x06CA6351, 0x14292967, 0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+    0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85, 0xA2BFE8A1, 0xA81A664B,
+    0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A,
+    0x5B9CCA4F, 0x682E6FF3, 0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+    0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+/* -1: not yet determined, 0: not supported, 1: supported */
+static int _have_sha_ni = -1;
+
+static void _cpuid(uint32_t leaf, uint32_t regs[4])
+{
+#if defined(OE_BUILD_ENCLAVE)
+    /* CPUID traps inside the enclave, so read the cached leaves instead */
+    if (oe_cpuid(leaf, 0, &regs[0], &regs[1], &regs[2], &regs[3]) != OE_OK)
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#else
+    asm volatile("cpuid"
+                 : "=a"(regs[0]), "=b"(regs[1]), "=c"(regs[2]), "=d"(regs[3])
+                 : "a"(leaf), "c"(0));
+#endif
+}
+
+static int _detect_sha_ni(void)
+{
+    uint32_t regs[4];
+
+    _cpuid(0, regs);
+    if (regs[0] < 7)
+        return 0;
+
+    _cpuid(1, regs);
+    if (!(regs[2] & CPUID_SSE41_FEATURE))
+        return 0;
+
+    _cpuid(7, regs);
+    return (regs[1] & CPUID_SHA_FEATURE) ? 1 : 0;
+}
+
+/*
+**==============================================================================
+**
+** Portable implementation
+**
+**==============================================================================
+*/
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define S0(x) (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define S1(x) (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+#define S2(x) (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define S3(x) (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define F0(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+#define F1(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+
+static void _process_generic(uint32_t state[8], const unsigned char data[64])
+{
+    uint32_t W[64];
+    uint32_t a, b, c, d, e, f, g, h;
+    size_t i;
+
+    for (i = 0; i < 16; i++)
+    {
+        W[i] = ((uint32_t)data[4 * i] << 24) |
+               ((uint32_t)data[4 * i + 1] << 16) |
+               ((uint32_t)data[4 * i + 2] << 8) | ((uint32_t)data[4 * i + 3]);
+    }
+
+    for (i = 16; i < 64; i++)
+        W[i] = S1(W[i - 2]) + W[i - 7] + S0(W[i - 15]) + W[i - 16];
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    for (i = 0; i < 64; i++)
+    {
+        uint32_t t1 = h + S3(e) + F1(e, f, g) + _K[i] + W[i];
+        uint32_t t2 = S2(a) + F0(a, b, c);
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+/*
+**==============================================================================
+**
+** SHA-NI implementation
+**
+**     The state is kept in the ABEF/CDGH register layout expected by the
+**     SHA256RNDS2 instruction. Each iteration of the loop performs four
+**     rounds and computes the message schedule four words ahead.
+**
+**==============================================================================
+*/
+
+__attribute__((target("sha,sse4.1"))) static void _process_sha_ni(
+    uint32_t state[8],
+    const unsigned char data[64])
+{
+    const __m128i mask =
+        _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0, state1, abef, cdgh, tmp, msg;
+    __m128i w[4];
+    size_t i;
+
+    /* Load the state as ABEF and CDGH */
+    tmp = _mm_loadu_si128((const __m128i*)&state[0]);
+    state1 = _mm_loadu_si128((const __m128i*)&state[4]);
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    abef = state0;
+    cdgh = state1;
+
+    for (i = 0; i < 16; i++)
+    {
+        __m128i* cur = &w[i & 3];
+
+        if (i < 4)
+        {
+            *cur = _mm_shuffle_epi8(
+                _mm_loadu_si128((const __m128i*)(data + 16 * i)), mask);
+        }
+        else
+        {
+            /* W[t] = S1(W[t-2]) + W[t-7] + S0(W[t-15]) + W[t-16] */
+            const __m128i prev1 = w[(i + 3) & 3];
+            const __m128i prev2 = w[(i + 2) & 3];
+            const __m128i prev3 = w[(i + 1) & 3];
+
+            tmp = _mm_sha256msg1_epu32(*cur, prev3);
+            tmp = _mm_add_epi32(tmp, _mm_alignr_epi8(prev1, prev2, 4));
+            *cur = _mm_sha256msg2_epu32(tmp, prev1);
+        }
+
+        msg = _mm_add_epi32(*cur, _mm_loadu_si128((const __m128i*)&_K[4 * i]));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    }
+
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+
+    /* Store the state back as ABCD and EFGH */
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+
+    _mm_storeu_si128((__m128i*)&state[0], state0);
+    _mm_storeu_si128((__m128i*)&state[4], state1);
+}
+
+int mbedtls_internal_sha256_process(
+    mbedtls_sha256_context* ctx,
+    const unsigned char data[64])
+{
+    if (_have_sha_ni < 0)
+        _have_sha_ni = _detect_sha_ni();
+
+    if (_have_sha_ni)
+        _process_sha_ni(ctx->state, data);
+    else
+        _process_generic(ctx->state, data);
+
+    return 0;
+}
+
+#if !defined(MBEDTLS_DEPRECATED_REMOVED)
+void mbedtls_sha256_process(
+    mbedtls_sha256_context* ctx,
+    const unsigned char data[64])
+{
+    mbedtls_internal_sha256_process(ctx, data);
+}
+#endif
+
+#endif /* MBEDTLS_SHA256_PROCESS_ALT */
@@ -0,0 +1,52 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+#include <openenclave/internal/crypto/sha.h>
+#include <openenclave/internal/raise.h>
+
+/*
+**==============================================================================
+**
+** oe_sha256_multi()
+**
+**     Hash a batch of independent messages. The per-message work is done by
+**     the platform SHA-256 implementation (which selects the SHA extensions
+**     when available), so batching mainly saves callers the per-message
+**     context handling. A lane-parallel backend can replace this function
+**     without changing its callers.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_sha256_multi(
+    const void* const* data,
+    const size_t* sizes,
+    size_t count,
+    OE_SHA256* hashes)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_sha256_context_t context;
+
+    if ((!data || !sizes || !hashes) && count)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!data[i] && sizes[i])
+            OE_RAISE(OE_INVALID_PARAMETER);
+
+        OE_CHECK(oe_sha256_init(&context));
+
+        if (sizes[i])
+            OE_CHECK(oe_sha256_update(&context, data[i], sizes[i]));
+
+        OE_CHECK(oe_sha256_final(&context, &hashes[i]));
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
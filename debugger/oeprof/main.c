@@ -0,0 +1,744 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <dirent.h>
+#include <errno.h>
+#include <getopt.h>
+#include <openenclave/internal/debugrt/host.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "../ptraceLib/enclave_context.h"
+#include "oeprof.h"
+
+#define NS_PER_SEC 1000000000ULL
+
+/* How often to look for the debugger contract list until it is found. */
+#define LOOKUP_INTERVAL_NS (NS_PER_SEC / 10)
+
+static const char* arg0;
+
+static const char _usage[] =
+    "Usage: %s [options] -p PID\n"
+    "       %s [options] [--] PROGRAM [ARGS...]\n"
+    "\n"
+    "Sample the threads of a process that run in debug enclaves, and write\n"
+    "the enclave stacks that were hit, symbolized with the enclave images.\n"
+    "\n"
+    "Options:\n"
+    "  -p, --pid PID        Profile a running process.\n"
+    "  -F, --frequency HZ   Samples per second per thread (default: 99).\n"
+    "  -d, --duration SECS  Stop after this time. By default, stop when the\n"
+    "                       program exits, or on SIGINT for -p.\n"
+    "  -f, --format FORMAT  'folded' (default) for flame graphs, or 'pprof'.\n"
+    "  -o, --output FILE    Output file, or - for standard output\n"
+    "                       (default: oeprof.folded or oeprof.pprof).\n"
+    "  -h, --help           Print this help.\n"
+    "\n"
+    "Enclave stacks are walked by frame pointers; build enclaves with\n"
+    "-fno-omit-frame-pointer for complete stacks.\n";
+
+typedef struct _options
+{
+    pid_t pid;
+    char* const* command;
+    uint64_t frequency;
+    uint64_t duration_ns;
+    bool pprof;
+    const char* output;
+} options_t;
+
+typedef struct _session
+{
+    pid_t pid;
+
+    /* The threads of the process that have been seized. */
+    pid_t* threads;
+    size_t num_threads;
+    size_t threads_capacity;
+
+    /* The address of oe_debug_enclaves_list in the process, once found. */
+    uint64_t list_address;
+    uint64_t next_lookup_ns;
+
+    oeprof_enclave_t* enclaves;
+    oeprof_profile_t profile;
+
+    bool exited;
+    int exit_status;
+} session_t;
+
+OE_PRINTF_FORMAT(1, 2)
+static void _err(const char* format, ...)
+{
+    fprintf(stderr, "%s ERROR: ", arg0);
+
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+
+    fprintf(stderr, "\n");
+}
+
+OE_PRINTF_FORMAT(1, 2)
+void oeprof_warn(const char* format, ...)
+{
+    fprintf(stderr, "%s WARNING: ", arg0);
+
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+
+    fprintf(stderr, "\n");
+}
+
+static uint64_t _now(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+/*
+**==============================================================================
+**
+** Threads
+**
+**     Every thread of the process is seized with PTRACE_SEIZE, which does
+**     not stop it. New threads are found in /proc/PID/task on each tick.
+**     A seized thread also stops for the signals that it receives and for
+**     group-stops; these stops are resumed as they are reported, with the
+**     signal delivered, so that the program behaves as it would untraced.
+**
+**==============================================================================
+*/
+
+static bool _has_thread(const session_t* session, pid_t tid)
+{
+    for (size_t i = 0; i < session->num_threads; i++)
+    {
+        if (session->threads[i] == tid)
+            return true;
+    }
+
+    return false;
+}
+
+static int _add_thread(session_t* session, pid_t tid)
+{
+    if (session->num_threads == session->threads_capacity)
+    {
+        const size_t capacity =
+            session->threads_capacity ? session->threads_capacity * 2 : 16;
+        pid_t* threads;
+
+        if (!(threads = realloc(session->threads, capacity * sizeof(pid_t))))
+            return -1;
+
+        session->threads = threads;
+        session->threads_capacity = capacity;
+    }
+
+    session->threads[session->num_threads++] = tid;
+
+    return 0;
+}
+
+static void _remove_thread(session_t* session, pid_t tid)
+{
+    for (size_t i = 0; i < session->num_threads; i++)
+    {
+        if (session->threads[i] == tid)
+        {
+            session->threads[i] = session->threads[--session->num_threads];
+            break;
+        }
+    }
+}
+
+static void _attach_threads(session_t* session)
+{
+    char path[64];
+    DIR* dir;
+    struct dirent* entry;
+
+    snprintf(path, sizeof(path), "/proc/%d/task", (int)session->pid);
+
+    if (!(dir = opendir(path)))
+        return;
+
+    while ((entry = readdir(dir)))
+    {
+        const pid_t tid = (pid_t)atoi(entry->d_name);
+
+        if (tid <= 0 || _has_thread(session, tid))
+            continue;
+
+        /* The thread may have exited since the directory was read. */
+        if (ptrace(PTRACE_SEIZE, tid, NULL, NULL) == 0)
+            _add_thread(session, tid);
+    }
+
+    closedir(dir);
+}
+
+static void _resume(pid_t tid, int status)
+{
+    const int sig = WSTOPSIG(status);
+    const int event = status >> 16;
+
+    if (event == PTRACE_EVENT_STOP)
+    {
+        /* Leave a thread in a group-stop stopped, until SIGCONT. */
+        if (sig == SIGSTOP || sig == SIGTSTP || sig == SIGTTIN ||
+            sig == SIGTTOU)
+        {
+            ptrace(PTRACE_LISTEN, tid, NULL, NULL);
+        }
+        else
+        {
+            ptrace(PTRACE_CONT, tid, NULL, NULL);
+        }
+    }
+    else if (event)
+    {
+        ptrace(PTRACE_CONT, tid, NULL, NULL);
+    }
+    else
+    {
+        /* Deliver the signal of a signal-delivery-stop. */
+        ptrace(PTRACE_CONT, tid, NULL, (void*)(intptr_t)sig);
+    }
+}
+
+static void _handle_exit(session_t* session, pid_t tid, int status)
+{
+    _remove_thread(session, tid);
+
+    /* The main thread is reported last, when the whole process exits. */
+    if (tid == session->pid)
+    {
+        session->exited = true;
+
+        if (WIFEXITED(status))
+            session->exit_status = WEXITSTATUS(status);
+        else
+            session->exit_status = 128 + WTERMSIG(status);
+    }
+}
+
+/* Resume the threads that stopped by themselves. */
+static void _drain(session_t* session)
+{
+    pid_t tid;
+    int status;
+
+    while ((tid = waitpid(-1, &status, __WALL | WNOHANG)) > 0)
+    {
+        if (WIFSTOPPED(status))
+            _resume(tid, status);
+        else
+            _handle_exit(session, tid, status);
+    }
+}
+
+/* Wait for the stop of a thread that PTRACE_INTERRUPT has requested. */
+static int _wait_for_interrupt(session_t* session, pid_t tid, int* status)
+{
+    for (;;)
+    {
+        if (waitpid(tid, status, __WALL) != tid)
+            return -1;
+
+        if (!WIFSTOPPED(*status))
+        {
+            _handle_exit(session, tid, *status);
+            return -1;
+        }
+
+        if (*status >> 16 == PTRACE_EVENT_STOP)
+            return 0;
+
+        _resume(tid, *status);
+    }
+}
+
+/*
+**==============================================================================
+**
+** Sampling
+**
+**     On hardware, a thread that is interrupted in an enclave exits it
+**     asynchronously (AEX) and stops at the AEP, with its enclave registers
+**     saved in the SSA of the TCS in rbx; oe_get_enclave_thread_gpr() reads
+**     them from there. In simulation mode, enclave code runs as ordinary
+**     code, and the registers of the thread are those of the enclave.
+**
+**     The enclave stack is then walked by the rbp chain. Each frame must be
+**     inside the enclave and above the previous one, which stops the walk
+**     at the first function that does not keep a frame pointer.
+**
+**==============================================================================
+*/
+
+static size_t _walk_stack(
+    pid_t pid,
+    const oeprof_enclave_t* enclave,
+    const struct user_regs_struct* regs,
+    uint64_t* frames)
+{
+    size_t n = 0;
+    uint64_t fp = regs->rbp;
+
+    frames[n++] = regs->rip;
+
+    while (n < OEPROF_MAX_FRAMES)
+    {
+        /* The saved rbp and the return address. */
+        uint64_t frame[2];
+        size_t size = 0;
+
+        if ((fp & 7) || fp - enclave->base > enclave->size - sizeof(frame))
+            break;
+
+        if (oe_read_process_memory(
+                pid, (void*)fp, frame, sizeof(frame), &size) != 0 ||
+            size != sizeof(frame))
+        {
+            break;
+        }
+
+        if (frame[1] - enclave->base >= enclave->size)
+            break;
+
+        /* Record the call rather than the return address, which may be
+         * past the end of the calling function. */
+        frames[n++] = frame[1] - 1;
+
+        if (frame[0] <= fp)
+            break;
+
+        fp = frame[0];
+    }
+
+    return n;
+}
+
+static void _sample_thread(session_t* session, pid_t tid)
+{
+    struct user_regs_struct regs;
+    oeprof_enclave_t* enclave;
+    uint64_t frames[OEPROF_MAX_FRAMES];
+    size_t num_frames;
+
+    if (ptrace(PTRACE_GETREGS, tid, NULL, &regs) != 0)
+        return;
+
+    if (oe_is_aep(session->pid, &regs))
+    {
+        void* tcs = (void*)regs.rbx;
+
+        if (!(enclave = oeprof_find_enclave(session->enclaves, regs.rbx)) ||
+            !(enclave->flags & OE_DEBUG_ENCLAVE_MASK_DEBUG) ||
+            oe_get_enclave_thread_gpr(session->pid, tcs, &regs) != 0)
+        {
+            session->profile.num_opaque_samples++;
+            return;
+        }
+    }
+    else if (!(enclave = oeprof_find_enclave(session->enclaves, regs.rip)))
+    {
+        session->profile.num_host_samples++;
+        return;
+    }
+    else if (!(enclave->flags & OE_DEBUG_ENCLAVE_MASK_DEBUG))
+    {
+        session->profile.num_opaque_samples++;
+        return;
+    }
+
+    num_frames = _walk_stack(session->pid, enclave, &regs, frames);
+
+    if (oeprof_profile_add(&session->profile, enclave, frames, num_frames) != 0)
+        oeprof_warn("out of memory; dropped a sample");
+}
+
+static bool _has_live_enclaves(const session_t* session)
+{
+    for (const oeprof_enclave_t* p = session->enclaves; p; p = p->next)
+    {
+        if (p->live)
+            return true;
+    }
+
+    return false;
+}
+
+static void _tick(session_t* session)
+{
+    pid_t* interrupted = NULL;
+    size_t num_interrupted = 0;
+
+    _attach_threads(session);
+
+    /* The host program may not have been loaded yet. */
+    if (!session->list_address)
+    {
+        const uint64_t now = _now(CLOCK_MONOTONIC);
+
+        if (now < session->next_lookup_ns)
+            return;
+
+        if (oeprof_find_enclaves_list(session->pid, &session->list_address))
+        {
+            session->next_lookup_ns = now + LOOKUP_INTERVAL_NS;
+            return;
+        }
+    }
+
+    oeprof_refresh_enclaves(
+        session->pid, session->list_address, &session->enclaves);
+
+    /* Only stop the threads while there are enclaves to sample. */
+    if (!_has_live_enclaves(session))
+        return;
+
+    if (!(interrupted = calloc(session->num_threads, sizeof(pid_t))))
+        return;
+
+    /* Interrupt all the threads first, so that they stop together. */
+    for (size_t i = 0; i < session->num_threads; i++)
+    {
+        const pid_t tid = session->threads[i];
+
+        if (ptrace(PTRACE_INTERRUPT, tid, NULL, NULL) == 0)
+            interrupted[num_interrupted++] = tid;
+    }
+
+    for (size_t i = 0; i < num_interrupted; i++)
+    {
+        int status;
+
+        if (_wait_for_interrupt(session, interrupted[i], &status) == 0)
+        {
+            _sample_thread(session, interrupted[i]);
+            _resume(interrupted[i], status);
+        }
+    }
+
+    free(interrupted);
+}
+
+static void _detach(session_t* session)
+{
+    while (session->num_threads)
+    {
+        const pid_t tid = session->threads[0];
+        int status;
+
+        if (ptrace(PTRACE_INTERRUPT, tid, NULL, NULL) == 0 &&
+            _wait_for_interrupt(session, tid, &status) == 0)
+        {
+            ptrace(PTRACE_DETACH, tid, NULL, NULL);
+        }
+
+        _remove_thread(session, tid);
+    }
+}
+
+static void _run(session_t* session, const options_t* options)
+{
+    const uint64_t period = session->profile.period_ns;
+    const uint64_t start = _now(CLOCK_MONOTONIC);
+    uint64_t next = start;
+    sigset_t set;
+
+    /* Sleep in sigtimedwait() between ticks, so that the stops of the
+     * threads (SIGCHLD) and SIGINT or SIGTERM wake the profiler. */
+    sigemptyset(&set);
+    sigaddset(&set, SIGCHLD);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    sigprocmask(SIG_BLOCK, &set, NULL);
+
+    session->profile.start_time_ns = _now(CLOCK_REALTIME);
+
+    while (!session->exited)
+    {
+        uint64_t now = _now(CLOCK_MONOTONIC);
+        uint64_t wake = next;
+        struct timespec timeout;
+        int sig;
+
+        if (options->duration_ns && now - start >= options->duration_ns)
+            break;
+
+        if (now >= next)
+        {
+            _tick(session);
+
+            /* Skip the ticks that the last one overran. */
+            next += period;
+
+            if (next <= now)
+                next = now + period;
+
+            continue;
+        }
+
+        _drain(session);
+
+        if (options->duration_ns && start + options->duration_ns < wake)
+            wake = start + options->duration_ns;
+
+        timeout.tv_sec = (time_t)((wake - now) / NS_PER_SEC);
+        timeout.tv_nsec = (long)((wake - now) % NS_PER_SEC);
+
+        sig = sigtimedwait(&set, NULL, &timeout);
+
+        if (sig == SIGINT || sig == SIGTERM)
+            break;
+    }
+
+    session->profile.duration_ns = _now(CLOCK_MONOTONIC) - start;
+
+    if (!session->exited)
+        _detach(session);
+}
+
+static pid_t _launch(char* const* command)
+{
+    pid_t pid;
+    int status;
+
+    if ((pid = fork()) == -1)
+        return -1;
+
+    if (pid == 0)
+    {
+        /* Wait to be seized, so that the program is profiled from the
+         * start. */
+        raise(SIGSTOP);
+        execvp(command[0], command);
+        fprintf(stderr, "%s: %s: %s\n", arg0, command[0], strerror(errno));
+        _exit(127);
+    }
+
+    if (waitpid(pid, &status, WUNTRACED) != pid || !WIFSTOPPED(status))
+        return -1;
+
+    /* Kill the program if the profiler dies before it detaches. */
+    if (ptrace(PTRACE_SEIZE, pid, NULL, (void*)PTRACE_O_EXITKILL) != 0)
+    {
+        kill(pid, SIGKILL);
+        waitpid(pid, &status, 0);
+        return -1;
+    }
+
+    kill(pid, SIGCONT);
+
+    return pid;
+}
+
+static int _parse_options(int argc, char* const argv[], options_t* options)
+{
+    const struct option long_options[] = {
+        {"help", no_argument, NULL, 'h'},
+        {"pid", required_argument, NULL, 'p'},
+        {"frequency", required_argument, NULL, 'F'},
+        {"duration", required_argument, NULL, 'd'},
+        {"format", required_argument, NULL, 'f'},
+        {"output", required_argument, NULL, 'o'},
+        {NULL, 0, NULL, 0},
+    };
+    /* Stop at the program, whose options are its own. */
+    const char short_options[] = "+hp:F:d:f:o:";
+    int c;
+    char* end;
+
+    memset(options, 0, sizeof(options_t));
+    options->frequency = 99;
+
+    while ((c = getopt_long(argc, argv, short_options, long_options, NULL)) !=
+           -1)
+    {
+        switch (c)
+        {
+            case 'p':
+                options->pid = (pid_t)strtol(optarg, &end, 10);
+
+                if (*end || options->pid <= 0)
+                {
+                    _err("bad process id: %s", optarg);
+                    return -1;
+                }
+                break;
+
+            case 'F':
+                options->frequency = strtoull(optarg, &end, 10);
+
+                if (*end || options->frequency == 0 ||
+                    options->frequency > 10000)
+                {
+                    _err("frequency must be 1 to 10000 Hz: %s", optarg);
+                    return -1;
+                }
+                break;
+
+            case 'd':
+            {
+                const double seconds = strtod(optarg, &end);
+
+                if (*end || !(seconds > 0))
+                {
+                    _err("bad duration: %s", optarg);
+                    return -1;
+                }
+
+                options->duration_ns = (uint64_t)(seconds * NS_PER_SEC);
+                break;
+            }
+
+            case 'f':
+                if (strcmp(optarg, "pprof") == 0)
+                    options->pprof = true;
+                else if (strcmp(optarg, "folded") != 0)
+                {
+                    _err("unknown format: %s", optarg);
+                    return -1;
+                }
+                break;
+
+            case 'o':
+                options->output = optarg;
+                break;
+
+            default:
+                fprintf(stderr, _usage, arg0, arg0);
+                return -1;
+        }
+    }
+
+    if (optind < argc)
+        options->command = &argv[optind];
+
+    if (!options->pid == !options->command)
+    {
+        fprintf(stderr, _usage, arg0, arg0);
+        return -1;
+    }
+
+    if (!options->output)
+        options->output = options->pprof ? "oeprof.pprof" : "oeprof.folded";
+
+    return 0;
+}
+
+static int _write_profile(const session_t* session, const options_t* options)
+{
+    int ret = -1;
+    const bool to_stdout = strcmp(options->output, "-") == 0;
+    FILE* os = to_stdout ? stdout : fopen(options->output, "wb");
+
+    if (!os)
+    {
+        _err("cannot open %s: %s", options->output, strerror(errno));
+        goto done;
+    }
+
+    if (options->pprof)
+        ret = oeprof_write_pprof(&session->profile, session->enclaves, os);
+    else
+        ret = oeprof_write_folded(&session->profile, os);
+
+    if (ret != 0)
+        _err("cannot write %s", options->output);
+
+done:
+
+    if (os && !to_stdout)
+        fclose(os);
+
+    return ret;
+}
+
+int main(int argc, char* argv[])
+{
+    int ret = 1;
+    options_t options;
+    session_t session;
+
+    arg0 = argv[0];
+    memset(&session, 0, sizeof(session));
+
+    if (_parse_options(argc, argv, &options) != 0)
+        goto done;
+
+    if (oeprof_profile_init(&session.profile, NS_PER_SEC / options.frequency))
+    {
+        _err("out of memory");
+        goto done;
+    }
+
+    if (options.command)
+    {
+        if ((session.pid = _launch(options.command)) == -1)
+        {
+            _err("cannot start %s: %s", options.command[0], strerror(errno));
+            goto done;
+        }
+
+        _add_thread(&session, session.pid);
+    }
+    else
+    {
+        session.pid = options.pid;
+        _attach_threads(&session);
+
+        if (!_has_thread(&session, session.pid))
+        {
+            _err(
+                "cannot attach to process %d: %s (see "
+                "/proc/sys/kernel/yama/ptrace_scope)",
+                (int)session.pid,
+                strerror(errno));
+            goto done;
+        }
+    }
+
+    _run(&session, &options);
+
+    if (!session.list_address)
+        oeprof_warn("the process does not use the Open Enclave host runtime");
+
+    if (_write_profile(&session, &options) != 0)
+        goto done;
+
+    fprintf(
+        stderr,
+        "%s: %llu samples in enclaves, %llu in host code, %llu in unreadable "
+        "enclaves\n",
+        arg0,
+        (unsigned long long)session.profile.num_samples,
+        (unsigned long long)session.profile.num_host_samples,
+        (unsigned long long)session.profile.num_opaque_samples);
+
+    /* Pass on the failure of a program that ran to completion. */
+    ret = session.exited ? session.exit_status : 0;
+
+done:
+    oeprof_profile_free(&session.profile);
+    oeprof_free_enclaves(session.enclaves);
+    free(session.threads);
+
+    return ret;
+}
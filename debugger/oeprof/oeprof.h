@@ -0,0 +1,157 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OEPROF_H
+#define _OEPROF_H
+
+#include <openenclave/internal/elf.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+/* The deepest enclave stack that is recorded for a sample. */
+#define OEPROF_MAX_FRAMES 128
+
+/* A function of an enclave image, at an address relative to the base. */
+typedef struct _oeprof_symbol
+{
+    uint64_t start;
+    uint64_t size;
+    const char* name;
+} oeprof_symbol_t;
+
+/* An enclave that has been seen in the debugger contract list of the
+ * profiled process (see oe_debug_enclaves_list). Enclaves stay in the list
+ * after they are terminated, since samples still refer to them. */
+typedef struct _oeprof_enclave
+{
+    struct _oeprof_enclave* next;
+
+    /* 1-based, in the order of discovery. */
+    uint64_t id;
+
+    char* path;
+    uint64_t base;
+    uint64_t size;
+    uint64_t flags;
+
+    /* Whether the enclave was in the list at the last refresh. */
+    bool live;
+
+    /* The image and its function symbols, sorted by address. */
+    elf64_t elf;
+    oeprof_symbol_t* symbols;
+    size_t num_symbols;
+} oeprof_enclave_t;
+
+/* A distinct enclave stack and the number of samples that hit it. */
+typedef struct _oeprof_stack
+{
+    struct _oeprof_stack* next;
+    uint64_t hash;
+    oeprof_enclave_t* enclave;
+    uint64_t count;
+
+    /* Absolute addresses, innermost first. */
+    size_t num_frames;
+    uint64_t frames[];
+} oeprof_stack_t;
+
+typedef struct _oeprof_profile
+{
+    oeprof_stack_t** buckets;
+    size_t num_buckets;
+    size_t num_stacks;
+
+    /* Samples that hit a debug enclave. */
+    uint64_t num_samples;
+
+    /* Samples of threads that ran host code. */
+    uint64_t num_host_samples;
+
+    /* Samples in release enclaves, whose state cannot be read. */
+    uint64_t num_opaque_samples;
+
+    /* Sampling period and the wall time of the session. */
+    uint64_t period_ns;
+    uint64_t start_time_ns;
+    uint64_t duration_ns;
+} oeprof_profile_t;
+
+/*
+**==============================================================================
+**
+** main.c
+**
+**==============================================================================
+*/
+
+OE_PRINTF_FORMAT(1, 2)
+void oeprof_warn(const char* format, ...);
+
+/*
+**==============================================================================
+**
+** symbols.c
+**
+**==============================================================================
+*/
+
+/* Find the address of oe_debug_enclaves_list in a process, from the symbol
+ * tables of the files that it has mapped. */
+int oeprof_find_enclaves_list(pid_t pid, uint64_t* address);
+
+/* Read the debugger contract list of the process and add the enclaves that
+ * are new since the last call to *enclaves. */
+int oeprof_refresh_enclaves(
+    pid_t pid,
+    uint64_t list_address,
+    oeprof_enclave_t** enclaves);
+
+/* Find the live enclave that contains an address. */
+oeprof_enclave_t* oeprof_find_enclave(
+    oeprof_enclave_t* enclaves,
+    uint64_t address);
+
+/* Return the name of the enclave function that contains an absolute
+ * address, or NULL. */
+const char* oeprof_symbolize(
+    const oeprof_enclave_t* enclave,
+    uint64_t address);
+
+/* Return the file name of the enclave, without its directory. */
+const char* oeprof_enclave_name(const oeprof_enclave_t* enclave);
+
+void oeprof_free_enclaves(oeprof_enclave_t* enclaves);
+
+/*
+**==============================================================================
+**
+** profile.c
+**
+**==============================================================================
+*/
+
+int oeprof_profile_init(oeprof_profile_t* profile, uint64_t period_ns);
+
+/* Count a sample of an enclave stack. */
+int oeprof_profile_add(
+    oeprof_profile_t* profile,
+    oeprof_enclave_t* enclave,
+    const uint64_t* frames,
+    size_t num_frames);
+
+/* Write the profile as folded stacks, one "root;...;leaf count" line per
+ * stack, which is the input of flamegraph.pl and speedscope. */
+int oeprof_write_folded(const oeprof_profile_t* profile, FILE* os);
+
+/* Write the profile as an uncompressed pprof protobuf. */
+int oeprof_write_pprof(
+    const oeprof_profile_t* profile,
+    const oeprof_enclave_t* enclaves,
+    FILE* os);
+
+void oeprof_profile_free(oeprof_profile_t* profile);
+
+#endif /* _OEPROF_H */
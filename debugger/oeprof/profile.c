@@ -0,0 +1,607 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/mem.h>
+#include <stdlib.h>
+#include <string.h>
+#include "oeprof.h"
+
+#define INITIAL_BUCKETS 1024
+
+int oeprof_profile_init(oeprof_profile_t* profile, uint64_t period_ns)
+{
+    memset(profile, 0, sizeof(oeprof_profile_t));
+
+    if (!(profile->buckets = calloc(INITIAL_BUCKETS, sizeof(void*))))
+        return -1;
+
+    profile->num_buckets = INITIAL_BUCKETS;
+    profile->period_ns = period_ns;
+
+    return 0;
+}
+
+/* FNV-1a over the enclave and the frames. */
+static uint64_t _hash(
+    const oeprof_enclave_t* enclave,
+    const uint64_t* frames,
+    size_t num_frames)
+{
+    uint64_t h = 14695981039346656037ULL;
+
+    h = (h ^ enclave->id) * 1099511628211ULL;
+
+    for (size_t i = 0; i < num_frames; i++)
+        h = (h ^ frames[i]) * 1099511628211ULL;
+
+    return h;
+}
+
+static void _grow(oeprof_profile_t* profile)
+{
+    const size_t num_buckets = profile->num_buckets * 2;
+    oeprof_stack_t** buckets;
+
+    /* Keep the current table if there is no memory for a larger one. */
+    if (!(buckets = calloc(num_buckets, sizeof(void*))))
+        return;
+
+    for (size_t i = 0; i < profile->num_buckets; i++)
+    {
+        oeprof_stack_t* p = profile->buckets[i];
+
+        while (p)
+        {
+            oeprof_stack_t* next = p->next;
+            const size_t index = p->hash & (num_buckets - 1);
+
+            p->next = buckets[index];
+            buckets[index] = p;
+            p = next;
+        }
+    }
+
+    free(profile->buckets);
+    profile->buckets = buckets;
+    profile->num_buckets = num_buckets;
+}
+
+int oeprof_profile_add(
+    oeprof_profile_t* profile,
+    oeprof_enclave_t* enclave,
+    const uint64_t* frames,
+    size_t num_frames)
+{
+    const uint64_t hash = _hash(enclave, frames, num_frames);
+    const size_t frames_size = num_frames * sizeof(uint64_t);
+    oeprof_stack_t** bucket;
+    oeprof_stack_t* p;
+
+    profile->num_samples++;
+
+    bucket = &profile->buckets[hash & (profile->num_buckets - 1)];
+
+    for (p = *bucket; p; p = p->next)
+    {
+        if (p->hash == hash && p->enclave == enclave &&
+            p->num_frames == num_frames &&
+            memcmp(p->frames, frames, frames_size) == 0)
+        {
+            p->count++;
+            return 0;
+        }
+    }
+
+    if (!(p = malloc(sizeof(oeprof_stack_t) + frames_size)))
+        return -1;
+
+    p->hash = hash;
+    p->enclave = enclave;
+    p->count = 1;
+    p->num_frames = num_frames;
+    memcpy(p->frames, frames, frames_size);
+    p->next = *bucket;
+    *bucket = p;
+
+    if (++profile->num_stacks > profile->num_buckets)
+        _grow(profile);
+
+    return 0;
+}
+
+void oeprof_profile_free(oeprof_profile_t* profile)
+{
+    for (size_t i = 0; i < profile->num_buckets; i++)
+    {
+        oeprof_stack_t* p = profile->buckets[i];
+
+        while (p)
+        {
+            oeprof_stack_t* next = p->next;
+            free(p);
+            p = next;
+        }
+    }
+
+    free(profile->buckets);
+    memset(profile, 0, sizeof(oeprof_profile_t));
+}
+
+/*
+**==============================================================================
+**
+** Folded stacks
+**
+**     The enclave is the root frame, so that the stacks of different
+**     enclaves stay apart. Addresses without a symbol are written as an
+**     offset in the enclave. Stacks that only differ in addresses within
+**     the same functions are merged.
+**
+**==============================================================================
+*/
+
+typedef struct _folded_line
+{
+    char* text;
+    uint64_t count;
+} folded_line_t;
+
+static int _compare_lines(const void* p1, const void* p2)
+{
+    const folded_line_t* l1 = (const folded_line_t*)p1;
+    const folded_line_t* l2 = (const folded_line_t*)p2;
+
+    return strcmp(l1->text, l2->text);
+}
+
+static char* _fold(const oeprof_stack_t* stack)
+{
+    mem_t buf = MEM_DYNAMIC_INIT;
+    const char* name = oeprof_enclave_name(stack->enclave);
+    int rc = mem_cat(&buf, name, strlen(name));
+
+    for (size_t i = stack->num_frames; i-- > 0 && rc == 0;)
+    {
+        const uint64_t address = stack->frames[i];
+        const char* symbol = oeprof_symbolize(stack->enclave, address);
+        char unknown[64];
+
+        if (!symbol)
+        {
+            snprintf(
+                unknown,
+                sizeof(unknown),
+                "[+0x%llx]",
+                (unsigned long long)(address - stack->enclave->base));
+            symbol = unknown;
+        }
+
+        if ((rc = mem_catc(&buf, ';')) == 0)
+            rc = mem_cat(&buf, symbol, strlen(symbol));
+    }
+
+    if (rc != 0 || mem_catc(&buf, '\0') != 0)
+    {
+        mem_free(&buf);
+        return NULL;
+    }
+
+    return (char*)mem_steal(&buf);
+}
+
+int oeprof_write_folded(const oeprof_profile_t* profile, FILE* os)
+{
+    int ret = -1;
+    folded_line_t* lines = NULL;
+    size_t num_lines = 0;
+
+    if (!(lines = calloc(profile->num_stacks + 1, sizeof(folded_line_t))))
+        goto done;
+
+    for (size_t i = 0; i < profile->num_buckets; i++)
+    {
+        for (oeprof_stack_t* p = profile->buckets[i]; p; p = p->next)
+        {
+            if (!(lines[num_lines].text = _fold(p)))
+                goto done;
+
+            lines[num_lines++].count = p->count;
+        }
+    }
+
+    qsort(lines, num_lines, sizeof(folded_line_t), _compare_lines);
+
+    for (size_t i = 0; i < num_lines;)
+    {
+        uint64_t count = 0;
+        size_t j;
+
+        for (j = i; j < num_lines; j++)
+        {
+            if (strcmp(lines[i].text, lines[j].text) != 0)
+                break;
+
+            count += lines[j].count;
+        }
+
+        fprintf(os, "%s %llu\n", lines[i].text, (unsigned long long)count);
+        i = j;
+    }
+
+    if (fflush(os) != 0 || ferror(os))
+        goto done;
+
+    ret = 0;
+
+done:
+
+    if (lines)
+    {
+        for (size_t i = 0; i < num_lines; i++)
+            free(lines[i].text);
+
+        free(lines);
+    }
+
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** pprof
+**
+**     The profile.proto message of github.com/google/pprof, encoded by
+**     hand. pprof reads both gzipped and plain protobufs, so the output is
+**     left uncompressed (gzip it for other consumers).
+**
+**     Each enclave is a mapping, each distinct address a location, and
+**     each symbol a function. The string table is sorted, which puts the
+**     empty string at index 0 as pprof requires.
+**
+**==============================================================================
+*/
+
+/* Field numbers of profile.proto. */
+#define PROFILE_SAMPLE_TYPE 1
+#define PROFILE_SAMPLE 2
+#define PROFILE_MAPPING 3
+#define PROFILE_LOCATION 4
+#define PROFILE_FUNCTION 5
+#define PROFILE_STRING_TABLE 6
+#define PROFILE_TIME_NANOS 9
+#define PROFILE_DURATION_NANOS 10
+#define PROFILE_PERIOD_TYPE 11
+#define PROFILE_PERIOD 12
+#define VALUE_TYPE_TYPE 1
+#define VALUE_TYPE_UNIT 2
+#define SAMPLE_LOCATION_ID 1
+#define SAMPLE_VALUE 2
+#define MAPPING_ID 1
+#define MAPPING_MEMORY_START 2
+#define MAPPING_MEMORY_LIMIT 3
+#define MAPPING_FILENAME 5
+#define MAPPING_HAS_FUNCTIONS 7
+#define LOCATION_ID 1
+#define LOCATION_MAPPING_ID 2
+#define LOCATION_ADDRESS 3
+#define LOCATION_LINE 4
+#define LINE_FUNCTION_ID 1
+#define FUNCTION_ID 1
+#define FUNCTION_NAME 2
+#define FUNCTION_SYSTEM_NAME 3
+
+#define WIRE_VARINT 0
+#define WIRE_BYTES 2
+
+/* An encoder that remembers the first failure, so that a message can be
+ * built without checking every field. */
+typedef struct _pb
+{
+    mem_t mem;
+    bool failed;
+} pb_t;
+
+#define PB_INIT            \
+    {                      \
+        MEM_DYNAMIC_INIT, 0 \
+    }
+
+static void _pb_varint(pb_t* pb, uint64_t value)
+{
+    uint8_t bytes[10];
+    size_t n = 0;
+
+    do
+    {
+        bytes[n] = value & 0x7f;
+        value >>= 7;
+
+        if (value)
+            bytes[n] |= 0x80;
+
+        n++;
+    } while (value);
+
+    if (mem_append(&pb->mem, bytes, n) != 0)
+        pb->failed = true;
+}
+
+static void _pb_uint64(pb_t* pb, uint32_t field, uint64_t value)
+{
+    _pb_varint(pb, (uint64_t)field << 3 | WIRE_VARINT);
+    _pb_varint(pb, value);
+}
+
+static void _pb_bytes(pb_t* pb, uint32_t field, const void* data, size_t size)
+{
+    _pb_varint(pb, (uint64_t)field << 3 | WIRE_BYTES);
+    _pb_varint(pb, size);
+
+    if (mem_append(&pb->mem, data, size) != 0)
+        pb->failed = true;
+}
+
+/* Append an embedded message and reset it for the next one. */
+static void _pb_message(pb_t* pb, uint32_t field, pb_t* message)
+{
+    _pb_bytes(pb, field, mem_ptr(&message->mem), mem_size(&message->mem));
+
+    if (message->failed)
+        pb->failed = true;
+
+    mem_clear(&message->mem);
+}
+
+typedef struct _location
+{
+    const oeprof_enclave_t* enclave;
+    uint64_t address;
+    const char* function;
+} location_t;
+
+static int _compare_locations(const void* p1, const void* p2)
+{
+    const location_t* l1 = (const location_t*)p1;
+    const location_t* l2 = (const location_t*)p2;
+
+    if (l1->enclave->id != l2->enclave->id)
+        return l1->enclave->id < l2->enclave->id ? -1 : 1;
+
+    if (l1->address != l2->address)
+        return l1->address < l2->address ? -1 : 1;
+
+    return 0;
+}
+
+static int _compare_strings(const void* p1, const void* p2)
+{
+    return strcmp(*(const char* const*)p1, *(const char* const*)p2);
+}
+
+/* Sort and remove duplicates; return the new count. */
+static size_t _unique(
+    void* base,
+    size_t count,
+    size_t size,
+    int (*compare)(const void*, const void*))
+{
+    uint8_t* p = (uint8_t*)base;
+    size_t n = 0;
+
+    qsort(base, count, size, compare);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (n == 0 || compare(p + (n - 1) * size, p + i * size) != 0)
+        {
+            if (n != i)
+                memcpy(p + n * size, p + i * size, size);
+
+            n++;
+        }
+    }
+
+    return n;
+}
+
+static uint64_t _index_of(
+    const void* key,
+    const void* base,
+    size_t count,
+    size_t size,
+    int (*compare)(const void*, const void*))
+{
+    const uint8_t* p = (const uint8_t*)bsearch(key, base, count, size, compare);
+
+    return p ? (uint64_t)(p - (const uint8_t*)base) / size : 0;
+}
+
+int oeprof_write_pprof(
+    const oeprof_profile_t* profile,
+    const oeprof_enclave_t* enclaves,
+    FILE* os)
+{
+    int ret = -1;
+    static const char* const names[] = {
+        "", "samples", "count", "cpu", "nanoseconds"};
+    const size_t num_names = OE_COUNTOF(names);
+    location_t* locations = NULL;
+    size_t num_locations = 0;
+    const char** strings = NULL;
+    size_t num_strings = 0;
+    const char** functions = NULL;
+    size_t num_functions = 0;
+    size_t num_enclaves = 0;
+    size_t max_locations = 0;
+    pb_t pb = PB_INIT;
+    pb_t message = PB_INIT;
+    pb_t inner = PB_INIT;
+
+    for (const oeprof_enclave_t* e = enclaves; e; e = e->next)
+        num_enclaves++;
+
+    for (size_t i = 0; i < profile->num_buckets; i++)
+    {
+        for (oeprof_stack_t* p = profile->buckets[i]; p; p = p->next)
+            max_locations += p->num_frames;
+    }
+
+    if (!(locations = calloc(max_locations + 1, sizeof(location_t))) ||
+        !(functions = calloc(max_locations + 1, sizeof(char*))) ||
+        !(strings = calloc(
+              num_names + num_enclaves + max_locations, sizeof(char*))))
+    {
+        goto done;
+    }
+
+    /* Collect the distinct locations and functions. */
+    for (size_t i = 0; i < profile->num_buckets; i++)
+    {
+        for (oeprof_stack_t* p = profile->buckets[i]; p; p = p->next)
+        {
+            for (size_t j = 0; j < p->num_frames; j++)
+            {
+                location_t* l = &locations[num_locations++];
+
+                l->enclave = p->enclave;
+                l->address = p->frames[j];
+                l->function = oeprof_symbolize(p->enclave, p->frames[j]);
+
+                if (l->function)
+                    functions[num_functions++] = l->function;
+            }
+        }
+    }
+
+    num_locations = _unique(
+        locations, num_locations, sizeof(location_t), _compare_locations);
+    num_functions = _unique(
+        functions, num_functions, sizeof(char*), _compare_strings);
+
+    for (size_t i = 0; i < num_names; i++)
+        strings[num_strings++] = names[i];
+
+    for (const oeprof_enclave_t* e = enclaves; e; e = e->next)
+        strings[num_strings++] = e->path;
+
+    for (size_t i = 0; i < num_functions; i++)
+        strings[num_strings++] = functions[i];
+
+    num_strings =
+        _unique(strings, num_strings, sizeof(char*), _compare_strings);
+
+#define STRING(S) \
+    _index_of(&(S), strings, num_strings, sizeof(char*), _compare_strings)
+
+    /* sample_type: samples/count and cpu/nanoseconds */
+    _pb_uint64(&message, VALUE_TYPE_TYPE, STRING(names[1]));
+    _pb_uint64(&message, VALUE_TYPE_UNIT, STRING(names[2]));
+    _pb_message(&pb, PROFILE_SAMPLE_TYPE, &message);
+    _pb_uint64(&message, VALUE_TYPE_TYPE, STRING(names[3]));
+    _pb_uint64(&message, VALUE_TYPE_UNIT, STRING(names[4]));
+    _pb_message(&pb, PROFILE_SAMPLE_TYPE, &message);
+
+    /* Samples, with their locations innermost first. */
+    for (size_t i = 0; i < profile->num_buckets; i++)
+    {
+        for (oeprof_stack_t* p = profile->buckets[i]; p; p = p->next)
+        {
+            for (size_t j = 0; j < p->num_frames; j++)
+            {
+                const location_t key = {p->enclave, p->frames[j], NULL};
+                const uint64_t id = _index_of(
+                                        &key,
+                                        locations,
+                                        num_locations,
+                                        sizeof(location_t),
+                                        _compare_locations) +
+                                    1;
+
+                _pb_varint(&inner, id);
+            }
+
+            _pb_message(&message, SAMPLE_LOCATION_ID, &inner);
+            _pb_varint(&inner, p->count);
+            _pb_varint(&inner, p->count * profile->period_ns);
+            _pb_message(&message, SAMPLE_VALUE, &inner);
+            _pb_message(&pb, PROFILE_SAMPLE, &message);
+        }
+    }
+
+    for (const oeprof_enclave_t* e = enclaves; e; e = e->next)
+    {
+        _pb_uint64(&message, MAPPING_ID, e->id);
+        _pb_uint64(&message, MAPPING_MEMORY_START, e->base);
+        _pb_uint64(&message, MAPPING_MEMORY_LIMIT, e->base + e->size);
+        _pb_uint64(&message, MAPPING_FILENAME, STRING(e->path));
+        _pb_uint64(&message, MAPPING_HAS_FUNCTIONS, e->num_symbols != 0);
+        _pb_message(&pb, PROFILE_MAPPING, &message);
+    }
+
+    for (size_t i = 0; i < num_locations; i++)
+    {
+        const location_t* l = &locations[i];
+
+        _pb_uint64(&message, LOCATION_ID, i + 1);
+        _pb_uint64(&message, LOCATION_MAPPING_ID, l->enclave->id);
+        _pb_uint64(&message, LOCATION_ADDRESS, l->address);
+
+        if (l->function)
+        {
+            const uint64_t id = _index_of(
+                &l->function,
+                functions,
+                num_functions,
+                sizeof(char*),
+                _compare_strings);
+
+            _pb_uint64(&inner, LINE_FUNCTION_ID, id + 1);
+            _pb_message(&message, LOCATION_LINE, &inner);
+        }
+
+        _pb_message(&pb, PROFILE_LOCATION, &message);
+    }
+
+    for (size_t i = 0; i < num_functions; i++)
+    {
+        _pb_uint64(&message, FUNCTION_ID, i + 1);
+        _pb_uint64(&message, FUNCTION_NAME, STRING(functions[i]));
+        _pb_uint64(&message, FUNCTION_SYSTEM_NAME, STRING(functions[i]));
+        _pb_message(&pb, PROFILE_FUNCTION, &message);
+    }
+
+    for (size_t i = 0; i < num_strings; i++)
+        _pb_bytes(&pb, PROFILE_STRING_TABLE, strings[i], strlen(strings[i]));
+
+    _pb_uint64(&pb, PROFILE_TIME_NANOS, profile->start_time_ns);
+    _pb_uint64(&pb, PROFILE_DURATION_NANOS, profile->duration_ns);
+    _pb_uint64(&message, VALUE_TYPE_TYPE, STRING(names[3]));
+    _pb_uint64(&message, VALUE_TYPE_UNIT, STRING(names[4]));
+    _pb_message(&pb, PROFILE_PERIOD_TYPE, &message);
+    _pb_uint64(&pb, PROFILE_PERIOD, profile->period_ns);
+
+#undef STRING
+
+    if (pb.failed)
+        goto done;
+
+    if (fwrite(mem_ptr(&pb.mem), 1, mem_size(&pb.mem), os) !=
+            mem_size(&pb.mem) ||
+        fflush(os) != 0)
+    {
+        goto done;
+    }
+
+    ret = 0;
+
+done:
+    free(locations);
+    free(functions);
+    free(strings);
+    mem_free(&pb.mem);
+    mem_free(&message.mem);
+    mem_free(&inner.mem);
+
+    return ret;
+}
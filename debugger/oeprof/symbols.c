@@ -0,0 +1,376 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <limits.h>
+#include <openenclave/internal/debugrt/host.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../ptraceLib/enclave_context.h"
+#include "oeprof.h"
+
+/* Bounds the walk of a list that is being changed under the reader. */
+#define MAX_ENCLAVES 1024
+
+static int _read(pid_t pid, uint64_t address, void* buf, size_t size)
+{
+    size_t n = 0;
+
+    if (oe_read_process_memory(pid, (void*)address, buf, size, &n) != 0 ||
+        n != size)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+**==============================================================================
+**
+** oeprof_find_enclaves_list()
+**
+**     The host links debugrt, which defines oe_debug_enclaves_list, into
+**     the application or one of its shared libraries. Look the symbol up in
+**     each file that is mapped from offset 0, and relocate it by the load
+**     bias of the mapping.
+**
+**==============================================================================
+*/
+
+static int _find_symbol_in_file(
+    const char* path,
+    uint64_t map_start,
+    uint64_t* address)
+{
+    int ret = -1;
+    elf64_t elf = ELF64_INIT;
+    elf64_sym_t sym;
+    elf64_ehdr_t* ehdr;
+    const char* name = "oe_debug_enclaves_list";
+    uint64_t bias = 0;
+
+    if (elf64_load(path, &elf) != 0)
+        goto done;
+
+    if (elf64_find_symbol_by_name(&elf, name, &sym) != 0 &&
+        elf64_find_dynamic_symbol_by_name(&elf, name, &sym) != 0)
+    {
+        goto done;
+    }
+
+    /* Skip libraries that only refer to the symbol. */
+    if (sym.st_shndx == SHN_UNDEF || sym.st_value == 0)
+        goto done;
+
+    if (!(ehdr = elf64_get_header(&elf)))
+        goto done;
+
+    if (ehdr->e_type == ET_DYN)
+    {
+        for (size_t i = 0; i < ehdr->e_phnum; i++)
+        {
+            const elf64_phdr_t* ph = elf64_get_program_header(&elf, i);
+
+            if (ph && ph->p_type == PT_LOAD)
+            {
+                bias = map_start - (ph->p_vaddr & ~(OE_PAGE_SIZE - 1));
+                break;
+            }
+        }
+    }
+
+    *address = bias + sym.st_value;
+    ret = 0;
+
+done:
+
+    if (elf.data)
+        elf64_unload(&elf);
+
+    return ret;
+}
+
+int oeprof_find_enclaves_list(pid_t pid, uint64_t* address)
+{
+    int ret = -1;
+    char path[PATH_MAX];
+    char line[PATH_MAX + 128];
+    FILE* is = NULL;
+
+    snprintf(path, sizeof(path), "/proc/%d/maps", (int)pid);
+
+    if (!(is = fopen(path, "r")))
+        goto done;
+
+    while (fgets(line, sizeof(line), is))
+    {
+        unsigned long start;
+        unsigned long offset;
+        char perms[5];
+
+        if (sscanf(
+                line,
+                "%lx-%*x %4s %lx %*s %*s %4095s",
+                &start,
+                perms,
+                &offset,
+                path) != 4)
+        {
+            continue;
+        }
+
+        if (offset != 0 || path[0] != '/')
+            continue;
+
+        if (_find_symbol_in_file(path, start, address) == 0)
+        {
+            ret = 0;
+            break;
+        }
+    }
+
+done:
+
+    if (is)
+        fclose(is);
+
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** oeprof_refresh_enclaves()
+**
+**==============================================================================
+*/
+
+static int _compare_symbols(const void* p1, const void* p2)
+{
+    const oeprof_symbol_t* s1 = (const oeprof_symbol_t*)p1;
+    const oeprof_symbol_t* s2 = (const oeprof_symbol_t*)p2;
+
+    if (s1->start < s2->start)
+        return -1;
+
+    return s1->start > s2->start;
+}
+
+/* Collect the function symbols of the enclave image. Enclaves are linked at
+ * address 0, so a symbol value is the offset from the enclave base. */
+static void _load_symbols(oeprof_enclave_t* enclave)
+{
+    uint8_t* data;
+    size_t size;
+    const elf64_sym_t* symtab;
+    size_t n;
+
+    if (elf64_load(enclave->path, &enclave->elf) != 0)
+    {
+        oeprof_warn("cannot load enclave image: %s", enclave->path);
+        return;
+    }
+
+    if (elf64_find_section(&enclave->elf, ".symtab", &data, &size) != 0)
+    {
+        oeprof_warn("enclave image has no symbols: %s", enclave->path);
+        return;
+    }
+
+    symtab = (const elf64_sym_t*)data;
+    n = size / sizeof(elf64_sym_t);
+
+    if (!(enclave->symbols = calloc(n, sizeof(oeprof_symbol_t))))
+        return;
+
+    for (size_t i = 1; i < n; i++)
+    {
+        const elf64_sym_t* sym = &symtab[i];
+        const char* name;
+
+        if ((sym->st_info & 0x0f) != STT_FUNC || sym->st_value == 0)
+            continue;
+
+        name = elf64_get_string_from_strtab(&enclave->elf, sym->st_name);
+
+        if (!name || !*name)
+            continue;
+
+        enclave->symbols[enclave->num_symbols].start = sym->st_value;
+        enclave->symbols[enclave->num_symbols].size = sym->st_size;
+        enclave->symbols[enclave->num_symbols].name = name;
+        enclave->num_symbols++;
+    }
+
+    qsort(
+        enclave->symbols,
+        enclave->num_symbols,
+        sizeof(oeprof_symbol_t),
+        _compare_symbols);
+}
+
+static oeprof_enclave_t* _new_enclave(
+    const oe_debug_enclave_t* debug_enclave,
+    const char* path,
+    uint64_t id)
+{
+    oeprof_enclave_t* enclave;
+
+    if (!(enclave = calloc(1, sizeof(oeprof_enclave_t))))
+        return NULL;
+
+    if (!(enclave->path = strdup(path)))
+    {
+        free(enclave);
+        return NULL;
+    }
+
+    enclave->id = id;
+    enclave->base = (uint64_t)debug_enclave->base_address;
+    enclave->size = debug_enclave->size;
+    enclave->flags = debug_enclave->flags;
+    enclave->live = true;
+
+    if (enclave->flags & OE_DEBUG_ENCLAVE_MASK_DEBUG)
+        _load_symbols(enclave);
+    else
+        oeprof_warn("cannot profile release enclave: %s", path);
+
+    return enclave;
+}
+
+int oeprof_refresh_enclaves(
+    pid_t pid,
+    uint64_t list_address,
+    oeprof_enclave_t** enclaves)
+{
+    int ret = -1;
+    uint64_t address;
+    oeprof_enclave_t* p;
+    uint64_t last_id = 0;
+
+    for (p = *enclaves; p; p = p->next)
+    {
+        p->live = false;
+        last_id = p->id;
+    }
+
+    if (_read(pid, list_address, &address, sizeof(address)) != 0)
+        goto done;
+
+    for (size_t n = 0; address && n < MAX_ENCLAVES; n++)
+    {
+        oe_debug_enclave_t debug_enclave;
+        char path[PATH_MAX];
+
+        if (_read(pid, address, &debug_enclave, sizeof(debug_enclave)) != 0)
+            goto done;
+
+        /* An enclave that is being added or removed. */
+        if (debug_enclave.magic != OE_DEBUG_ENCLAVE_MAGIC ||
+            debug_enclave.path_length >= sizeof(path) ||
+            _read(
+                pid,
+                (uint64_t)debug_enclave.path,
+                path,
+                debug_enclave.path_length) != 0)
+        {
+            break;
+        }
+
+        path[debug_enclave.path_length] = '\0';
+
+        for (p = *enclaves; p; p = p->next)
+        {
+            if (p->base == (uint64_t)debug_enclave.base_address &&
+                p->size == debug_enclave.size && strcmp(p->path, path) == 0)
+            {
+                p->live = true;
+                break;
+            }
+        }
+
+        if (!p)
+        {
+            if (!(p = _new_enclave(&debug_enclave, path, ++last_id)))
+                goto done;
+
+            p->next = *enclaves;
+            *enclaves = p;
+        }
+
+        address = (uint64_t)debug_enclave.next;
+    }
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+oeprof_enclave_t* oeprof_find_enclave(
+    oeprof_enclave_t* enclaves,
+    uint64_t address)
+{
+    for (oeprof_enclave_t* p = enclaves; p; p = p->next)
+    {
+        if (p->live && address >= p->base && address - p->base < p->size)
+            return p;
+    }
+
+    return NULL;
+}
+
+const char* oeprof_symbolize(
+    const oeprof_enclave_t* enclave,
+    uint64_t address)
+{
+    const uint64_t offset = address - enclave->base;
+    size_t lo = 0;
+    size_t hi = enclave->num_symbols;
+    const oeprof_symbol_t* sym;
+
+    /* Find the last symbol that starts at or before the offset. */
+    while (lo < hi)
+    {
+        const size_t mid = lo + (hi - lo) / 2;
+
+        if (enclave->symbols[mid].start <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo == 0)
+        return NULL;
+
+    sym = &enclave->symbols[lo - 1];
+
+    if (offset - sym->start >= sym->size && offset != sym->start)
+        return NULL;
+
+    return sym->name;
+}
+
+const char* oeprof_enclave_name(const oeprof_enclave_t* enclave)
+{
+    const char* slash = strrchr(enclave->path, '/');
+
+    return slash ? slash + 1 : enclave->path;
+}
+
+void oeprof_free_enclaves(oeprof_enclave_t* enclaves)
+{
+    while (enclaves)
+    {
+        oeprof_enclave_t* next = enclaves->next;
+
+        if (enclaves->elf.data)
+            elf64_unload(&enclaves->elf);
+
+        free(enclaves->symbols);
+        free(enclaves->path);
+        free(enclaves);
+        enclaves = next;
+    }
+}
@@ -7,7 +7,9 @@
 #include <openenclave/enclave.h>
 #include <openenclave/internal/crypto/ec.h>
 #include <openenclave/internal/kdf.h>
+#include <openenclave/internal/keycache.h>
 #include <openenclave/internal/raise.h>
+#include <openenclave/internal/thread.h>
 #include <openenclave/internal/utils.h>
 #include <stdlib.h>
 
@@ -226,11 +228,293 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** Asymmetric key cache
+**
+**     Deriving an asymmetric key requires running the KDF and generating the
+**     EC key pair, which dominates the cost of the oe_get_*_key() functions.
+**     The exported public and private keys are therefore cached after their
+**     first derivation, keyed by the seal key information they were derived
+**     from and by the key parameters. The seal key itself is still requested
+**     on every call (it is cached by oecore), so that invalid key information
+**     keeps failing the same way.
+**
+**     Cached keys are zeroized when evicted with oe_evict_cached_keys*() and
+**     on enclave termination.
+**
+**==============================================================================
+*/
+
+#define OE_ASYMMETRIC_KEY_CACHE_SIZE 8
+
+typedef struct _asymmetric_key_cache_entry
+{
+    uint8_t* key_info;
+    size_t key_info_size;
+    oe_asymmetric_key_type_t type;
+    oe_asymmetric_key_format_t format;
+    uint8_t* user_data;
+    size_t user_data_size;
+    uint8_t* public_key;
+    size_t public_key_size;
+    uint8_t* private_key;
+    size_t private_key_size;
+} asymmetric_key_cache_entry_t;
+
+static asymmetric_key_cache_entry_t* _cache[OE_ASYMMETRIC_KEY_CACHE_SIZE];
+static size_t _cache_next_victim;
+static bool _cache_atexit_registered;
+static oe_spinlock_t _cache_lock = OE_SPINLOCK_INITIALIZER;
+
+static void _free_buffer(uint8_t* buffer, size_t size)
+{
+    if (buffer)
+    {
+        oe_secure_zero_fill(buffer, size);
+        free(buffer);
+    }
+}
+
+static void _free_cache_entry(asymmetric_key_cache_entry_t* entry)
+{
+    if (entry)
+    {
+        _free_buffer(entry->key_info, entry->key_info_size);
+        _free_buffer(entry->user_data, entry->user_data_size);
+        _free_buffer(entry->public_key, entry->public_key_size);
+        _free_buffer(entry->private_key, entry->private_key_size);
+        oe_secure_zero_fill(entry, sizeof(*entry));
+        free(entry);
+    }
+}
+
+static uint8_t* _clone_buffer(const void* buffer, size_t size)
+{
+    uint8_t* clone;
+
+    /* Always allocate at least one byte so that empty buffers are valid */
+    if (!(clone = (uint8_t*)malloc(size ? size : 1)))
+        return NULL;
+
+    if (size)
+        memcpy(clone, buffer, size);
+
+    return clone;
+}
+
+static bool _cache_entry_matches(
+    const asymmetric_key_cache_entry_t* entry,
+    const oe_asymmetric_key_params_t* key_params,
+    const uint8_t* key_info,
+    size_t key_info_size)
+{
+    return entry->type == key_params->type &&
+           entry->format == key_params->format &&
+           entry->key_info_size == key_info_size &&
+           entry->user_data_size == key_params->user_data_size &&
+           memcmp(entry->key_info, key_info, key_info_size) == 0 &&
+           (key_params->user_data_size == 0 ||
+            memcmp(
+                entry->user_data,
+                key_params->user_data,
+                key_params->user_data_size) == 0);
+}
+
+/* Evicts the entries derived with the given policy (all if NULL) */
+static void _evict_asymmetric_keys(const oe_seal_policy_t* seal_policy)
+{
+    asymmetric_key_cache_entry_t* evicted[OE_ASYMMETRIC_KEY_CACHE_SIZE];
+    size_t num_evicted = 0;
+
+    oe_spin_lock(&_cache_lock);
+
+    for (size_t i = 0; i < OE_ASYMMETRIC_KEY_CACHE_SIZE; i++)
+    {
+        asymmetric_key_cache_entry_t* entry = _cache[i];
+
+        if (entry && (!seal_policy || oe_key_info_has_seal_policy(
+                                          entry->key_info,
+                                          entry->key_info_size,
+                                          *seal_policy)))
+        {
+            evicted[num_evicted++] = entry;
+            _cache[i] = NULL;
+        }
+    }
+
+    oe_spin_unlock(&_cache_lock);
+
+    for (size_t i = 0; i < num_evicted; i++)
+        _free_cache_entry(evicted[i]);
+}
+
+static void _clear_asymmetric_key_cache(void)
+{
+    _evict_asymmetric_keys(NULL);
+}
+
+static oe_result_t _find_cached_key(
+    const oe_asymmetric_key_params_t* key_params,
+    bool is_public,
+    const uint8_t* key_info,
+    size_t key_info_size,
+    uint8_t** key_buffer,
+    size_t* key_buffer_size)
+{
+    oe_result_t result = OE_NOT_FOUND;
+
+    oe_spin_lock(&_cache_lock);
+
+    for (size_t i = 0; i < OE_ASYMMETRIC_KEY_CACHE_SIZE; i++)
+    {
+        const asymmetric_key_cache_entry_t* entry = _cache[i];
+
+        if (entry &&
+            _cache_entry_matches(entry, key_params, key_info, key_info_size))
+        {
+            const uint8_t* key =
+                is_public ? entry->public_key : entry->private_key;
+            size_t key_size =
+                is_public ? entry->public_key_size : entry->private_key_size;
+
+            if (!(*key_buffer = _clone_buffer(key, key_size)))
+            {
+                result = OE_OUT_OF_MEMORY;
+                break;
+            }
+
+            *key_buffer_size = key_size;
+            result = OE_OK;
+            break;
+        }
+    }
+
+    oe_spin_unlock(&_cache_lock);
+
+    return result;
+}
+
+/* Takes ownership of the entry */
+static void _add_cached_key(asymmetric_key_cache_entry_t* entry)
+{
+    asymmetric_key_cache_entry_t* victim = NULL;
+    bool register_atexit = false;
+    size_t slot = OE_ASYMMETRIC_KEY_CACHE_SIZE;
+    oe_asymmetric_key_params_t params;
+
+    params.type = entry->type;
+    params.format = entry->format;
+    params.user_data = entry->user_data;
+    params.user_data_size = entry->user_data_size;
+
+    oe_spin_lock(&_cache_lock);
+
+    for (size_t i = 0; i < OE_ASYMMETRIC_KEY_CACHE_SIZE; i++)
+    {
+        if (!_cache[i])
+        {
+            if (slot == OE_ASYMMETRIC_KEY_CACHE_SIZE)
+                slot = i;
+            continue;
+        }
+
+        /* Another thread may have added the same key meanwhile */
+        if (_cache_entry_matches(
+                _cache[i], &params, entry->key_info, entry->key_info_size))
+        {
+            victim = entry;
+            goto done;
+        }
+    }
+
+    /* Replace the entries in round-robin order once the cache is full */
+    if (slot == OE_ASYMMETRIC_KEY_CACHE_SIZE)
+    {
+        slot = _cache_next_victim;
+        victim = _cache[slot];
+        _cache_next_victim =
+            (_cache_next_victim + 1) % OE_ASYMMETRIC_KEY_CACHE_SIZE;
+    }
+
+    _cache[slot] = entry;
+
+    if (!_cache_atexit_registered)
+    {
+        _cache_atexit_registered = true;
+        register_atexit = true;
+    }
+
+done:
+    oe_spin_unlock(&_cache_lock);
+
+    _free_cache_entry(victim);
+
+    if (register_atexit)
+        oe_atexit(_clear_asymmetric_key_cache);
+}
+
+static oe_result_t _new_cache_entry(
+    const oe_asymmetric_key_params_t* key_params,
+    const uint8_t* key_info,
+    size_t key_info_size,
+    const oe_ec_private_key_t* private_key,
+    const oe_ec_public_key_t* public_key,
+    asymmetric_key_cache_entry_t** entry_out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    asymmetric_key_cache_entry_t* entry = NULL;
+
+    if (!(entry = (asymmetric_key_cache_entry_t*)calloc(1, sizeof(*entry))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    entry->type = key_params->type;
+    entry->format = key_params->format;
+
+    if (!(entry->key_info = _clone_buffer(key_info, key_info_size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    entry->key_info_size = key_info_size;
+
+    if (!(entry->user_data = _clone_buffer(
+              key_params->user_data, key_params->user_data_size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    entry->user_data_size = key_params->user_data_size;
+
+    OE_CHECK(_export_keypair(
+        key_params,
+        true,
+        private_key,
+        public_key,
+        &entry->public_key,
+        &entry->public_key_size));
+
+    OE_CHECK(_export_keypair(
+        key_params,
+        false,
+        private_key,
+        public_key,
+        &entry->private_key,
+        &entry->private_key_size));
+
+    *entry_out = entry;
+    entry = NULL;
+    result = OE_OK;
+
+done:
+    _free_cache_entry(entry);
+    return result;
+}
+
 static oe_result_t _derive_asymmetric_key(
     const oe_asymmetric_key_params_t* key_params,
     bool is_public,
     const uint8_t* master_key,
     size_t master_key_size,
+    const uint8_t* key_info,
+    size_t key_info_size,
     uint8_t** key_buffer,
     size_t* key_buffer_size)
 {
@@ -238,31 +522,62 @@ static oe_result_t _derive_asymmetric_key(
     oe_ec_public_key_t public_key;
     oe_ec_private_key_t private_key;
     bool keypair_created = false;
+    asymmetric_key_cache_entry_t* entry = NULL;
 
     /* Check invalid arguments. */
-    if (!master_key || !key_buffer || !key_buffer_size)
+    if (!master_key || !key_info || !key_buffer || !key_buffer_size)
         OE_RAISE(OE_INVALID_PARAMETER);
 
     OE_CHECK(_check_asymmetric_key_params(key_params));
 
+    /* Return the cached key if it was derived before. */
+    result = _find_cached_key(
+        key_params,
+        is_public,
+        key_info,
+        key_info_size,
+        key_buffer,
+        key_buffer_size);
+
+    if (result != OE_NOT_FOUND)
+        goto done;
+
     /* Derive the public/private key from the master key. */
     OE_CHECK(_create_asymmetric_keypair(
         key_params, master_key, master_key_size, &private_key, &public_key));
 
     keypair_created = true;
 
-    /* Export the key depending on what was requested. */
-    OE_CHECK(_export_keypair(
+    /* Export both keys into a new cache entry. */
+    OE_CHECK(_new_cache_entry(
         key_params,
-        is_public,
+        key_info,
+        key_info_size,
         &private_key,
         &public_key,
-        key_buffer,
-        key_buffer_size));
+        &entry));
+
+    /* Return the key that was requested. */
+    if (is_public)
+        *key_buffer = _clone_buffer(entry->public_key, entry->public_key_size);
+    else
+        *key_buffer =
+            _clone_buffer(entry->private_key, entry->private_key_size);
+
+    if (!*key_buffer)
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    *key_buffer_size =
+        is_public ? entry->public_key_size : entry->private_key_size;
+
+    _add_cached_key(entry);
+    entry = NULL;
 
     result = OE_OK;
 
 done:
+    _free_cache_entry(entry);
+
     if (keypair_created)
     {
         oe_ec_private_key_free(&private_key);
@@ -295,13 +610,9 @@ static oe_result_t _load_asymmetric_key_by_policy(
 
     OE_CHECK(_check_asymmetric_key_params(key_params));
 
-    /* Load seal key. */
+    /* Load seal key. The key info is always needed to look up the cache. */
     OE_CHECK(_load_seal_key_by_policy(
-        policy,
-        &key,
-        &key_size,
-        key_info ? &key_info_local : NULL,
-        key_info ? &key_info_size_local : NULL));
+        policy, &key, &key_size, &key_info_local, &key_info_size_local));
 
     /* Derive the asymmetric key. */
     OE_CHECK(_derive_asymmetric_key(
@@ -309,6 +620,8 @@ static oe_result_t _load_asymmetric_key_by_policy(
         is_public,
         key,
         key_size,
+        key_info_local,
+        key_info_size_local,
         &key_buffer_local,
         &key_buffer_size_local));
 
@@ -319,9 +632,9 @@ static oe_result_t _load_asymmetric_key_by_policy(
     {
         *key_info = key_info_local;
         *key_info_size = key_info_size_local;
+        key_info_local = NULL;
     }
     key_buffer_local = NULL;
-    key_info_local = NULL;
 
 done:
     if (key_buffer_local != NULL)
@@ -374,6 +687,8 @@ static oe_result_t _load_asymmetric_key(
         is_public,
         key,
         key_size,
+        key_info,
+        key_info_size,
         &key_buffer_local,
         &key_buffer_size_local));
 
@@ -461,6 +776,24 @@ oe_result_t oe_get_private_key(
         key_buffer_size);
 }
 
+oe_result_t oe_evict_cached_keys_by_policy(oe_seal_policy_t seal_policy)
+{
+    if (seal_policy != OE_SEAL_POLICY_UNIQUE &&
+        seal_policy != OE_SEAL_POLICY_PRODUCT)
+        return OE_INVALID_PARAMETER;
+
+    _evict_asymmetric_keys(&seal_policy);
+    oe_evict_seal_keys(&seal_policy);
+
+    return OE_OK;
+}
+
+void oe_evict_cached_keys(void)
+{
+    _evict_asymmetric_keys(NULL);
+    oe_evict_seal_keys(NULL);
+}
+
 void oe_free_key(
     uint8_t* key_buffer,
     size_t key_buffer_size,
@@ -68,10 +68,26 @@ void oe_set_allocation_failure_callback(
     _failure_callback = function;
 }
 
+static oe_memory_reclaim_callback_t _reclaim_callback;
+
+void oe_set_memory_reclaim_callback(oe_memory_reclaim_callback_t function)
+{
+    _reclaim_callback = function;
+}
+
+static bool _reclaim_memory(void)
+{
+    oe_memory_reclaim_callback_t callback = _reclaim_callback;
+    return callback && callback();
+}
+
 void* oe_malloc(size_t size)
 {
     void* p = MALLOC(size);
 
+    if (!p && size && _reclaim_memory())
+        p = MALLOC(size);
+
     if (!p && size)
     {
         errno = ENOMEM;
@@ -97,6 +113,9 @@ void* oe_calloc(size_t nmemb, size_t size)
 {
     void* p = CALLOC(nmemb, size);
 
+    if (!p && nmemb && size && _reclaim_memory())
+        p = CALLOC(nmemb, size);
+
     if (!p && nmemb && size)
     {
         errno = ENOMEM;
@@ -112,6 +131,9 @@ void* oe_realloc(void* ptr, size_t size)
 {
     void* p = REALLOC(ptr, size);
 
+    if (!p && size && _reclaim_memory())
+        p = REALLOC(ptr, size);
+
     if (!p && size)
     {
         errno = ENOMEM;
@@ -127,6 +149,9 @@ int oe_posix_memalign(void** memptr, size_t alignment, size_t size)
 {
     int rc = POSIX_MEMALIGN(memptr, alignment, size);
 
+    if (rc == ENOMEM && size && _reclaim_memory())
+        rc = POSIX_MEMALIGN(memptr, alignment, size);
+
     if (rc != 0 && size)
     {
         errno = ENOMEM;
@@ -142,6 +167,9 @@ void* oe_memalign(size_t alignment, size_t size)
 {
     void* p = MEMALIGN(alignment, size);
 
+    if (!p && size && _reclaim_memory())
+        p = MEMALIGN(alignment, size);
+
     if (!p && size)
     {
         errno = ENOMEM;
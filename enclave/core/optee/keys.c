@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 #include <openenclave/enclave.h>
+#include <openenclave/internal/keycache.h>
 
 oe_result_t oe_get_seal_key_by_policy_v2(
     oe_seal_policy_t seal_policy,
@@ -40,3 +41,20 @@ oe_result_t oe_get_seal_key_v2(
 
     return OE_UNSUPPORTED;
 }
+
+void oe_evict_seal_keys(const oe_seal_policy_t* seal_policy)
+{
+    OE_UNUSED(seal_policy);
+}
+
+bool oe_key_info_has_seal_policy(
+    const uint8_t* key_info,
+    size_t key_info_size,
+    oe_seal_policy_t seal_policy)
+{
+    OE_UNUSED(key_info);
+    OE_UNUSED(key_info_size);
+    OE_UNUSED(seal_policy);
+
+    return false;
+}
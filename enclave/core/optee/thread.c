@@ -46,6 +46,14 @@ bool oe_thread_equal(oe_thread_t thread1, oe_thread_t thread2)
     return thread1 == thread2;
 }
 
+oe_result_t oe_thread_create(void (*start_routine)(void*), void* arg)
+{
+    OE_UNUSED(start_routine);
+    OE_UNUSED(arg);
+
+    return OE_UNSUPPORTED;
+}
+
 /*
 **==============================================================================
 **
@@ -25,6 +25,7 @@
 #include "asmdefs.h"
 #include "cpuid.h"
 #include "init.h"
+#include "memops.h"
 #include "report.h"
 #include "sgx_t.h"
 #include "td.h"
@@ -123,6 +124,181 @@ extern bool oe_disable_debug_malloc_check;
 **==============================================================================
 */
 
+/*
+**==============================================================================
+**
+** ECALL staging buffers
+**
+**     Each TCS keeps the enclave buffer that receives the inputs and outputs
+**     of its ECALLs, so that steady-state ECALLs do not go through the heap.
+**     The buffer grows geometrically up to OE_ECALL_STAGING_MAX_SIZE. Larger
+**     ECALLs use a buffer that is freed on return; the cached buffer is
+**     released first so that only one copy of a large input is held. Idle
+**     buffers are returned to the heap when an allocation fails and when the
+**     enclave is destroyed.
+**
+**==============================================================================
+*/
+
+#define OE_ECALL_STAGING_MIN_SIZE OE_PAGE_SIZE
+#define OE_ECALL_STAGING_MAX_SIZE (1024 * 1024)
+
+#define ECALL_STAGING_IDLE 0
+#define ECALL_STAGING_IN_USE 1
+#define ECALL_STAGING_RECLAIMING 2
+
+typedef struct _ecall_staging
+{
+    /* The thread data of the TCS owning this entry (set once) */
+    td_t* td;
+
+    /* One of the ECALL_STAGING_* states above */
+    uint32_t state;
+
+    uint8_t* buffer;
+    size_t size;
+} ecall_staging_t;
+
+static ecall_staging_t _ecall_staging[OE_SGX_MAX_TCS];
+
+static bool _lock_ecall_staging(ecall_staging_t* staging, uint32_t new_state)
+{
+    uint32_t state = ECALL_STAGING_IDLE;
+
+    return __atomic_compare_exchange_n(
+        &staging->state,
+        &state,
+        new_state,
+        false,
+        __ATOMIC_ACQUIRE,
+        __ATOMIC_RELAXED);
+}
+
+static void _unlock_ecall_staging(ecall_staging_t* staging)
+{
+    __atomic_store_n(&staging->state, ECALL_STAGING_IDLE, __ATOMIC_RELEASE);
+}
+
+/* Find (or claim) the entry of the given TCS and lock it. Returns NULL for
+ * nested ECALLs (made from an OCALL), which find the entry already in use. */
+static ecall_staging_t* _acquire_ecall_staging(td_t* td)
+{
+    for (size_t i = 0; i < OE_COUNTOF(_ecall_staging); i++)
+    {
+        ecall_staging_t* staging = &_ecall_staging[i];
+        td_t* owner = __atomic_load_n(&staging->td, __ATOMIC_ACQUIRE);
+
+        if (owner == NULL &&
+            __atomic_compare_exchange_n(
+                &staging->td,
+                &owner,
+                td,
+                false,
+                __ATOMIC_ACQ_REL,
+                __ATOMIC_ACQUIRE))
+        {
+            owner = td;
+        }
+
+        if (owner == td)
+        {
+            while (!_lock_ecall_staging(staging, ECALL_STAGING_IN_USE))
+            {
+                if (__atomic_load_n(&staging->state, __ATOMIC_RELAXED) ==
+                    ECALL_STAGING_IN_USE)
+                    return NULL;
+
+                /* Wait for another thread to finish reclaiming the buffer */
+                asm volatile("pause");
+            }
+
+            return staging;
+        }
+    }
+
+    return NULL;
+}
+
+static void _free_ecall_staging_buffer(ecall_staging_t* staging)
+{
+    oe_free(staging->buffer);
+    staging->buffer = NULL;
+    staging->size = 0;
+}
+
+/* Return a buffer of at least size bytes for the current ECALL. Sets
+ * *cached to false if the caller must free the buffer. */
+static uint8_t* _get_ecall_staging_buffer(
+    ecall_staging_t* staging,
+    size_t size,
+    bool* cached)
+{
+    size_t new_size;
+
+    *cached = false;
+
+    if (!staging)
+        return oe_malloc(size);
+
+    if (size > OE_ECALL_STAGING_MAX_SIZE)
+    {
+        _free_ecall_staging_buffer(staging);
+        return oe_malloc(size);
+    }
+
+    *cached = true;
+
+    if (staging->size >= size)
+        return staging->buffer;
+
+    new_size = staging->size ? staging->size : OE_ECALL_STAGING_MIN_SIZE;
+
+    while (new_size < size)
+        new_size *= 2;
+
+    if (new_size > OE_ECALL_STAGING_MAX_SIZE)
+        new_size = OE_ECALL_STAGING_MAX_SIZE;
+
+    /* The old contents are not needed, so do not realloc */
+    _free_ecall_staging_buffer(staging);
+
+    /* Fall back to the exact size if the heap cannot spare more */
+    if (!(staging->buffer = oe_malloc(new_size)))
+    {
+        new_size = size;
+
+        if (!(staging->buffer = oe_malloc(new_size)))
+            return NULL;
+    }
+
+    staging->size = new_size;
+    return staging->buffer;
+}
+
+/* Free the buffers of the TCSs that are not in an ECALL. */
+static bool _release_idle_ecall_staging_buffers(void)
+{
+    bool released = false;
+
+    for (size_t i = 0; i < OE_COUNTOF(_ecall_staging); i++)
+    {
+        ecall_staging_t* staging = &_ecall_staging[i];
+
+        if (!_lock_ecall_staging(staging, ECALL_STAGING_RECLAIMING))
+            continue;
+
+        if (staging->buffer)
+        {
+            _free_ecall_staging_buffer(staging);
+            released = true;
+        }
+
+        _unlock_ecall_staging(staging);
+    }
+
+    return released;
+}
+
 /*
 **==============================================================================
 **
@@ -165,6 +341,13 @@ static oe_result_t _handle_init_enclave(uint64_t arg_in)
             /* Initialize the CPUID table before calling global constructors. */
             OE_CHECK(oe_initialize_cpuid());
 
+            /* Select the string routines for this processor. */
+            oe_initialize_memops();
+
+            /* Let the heap take back idle ECALL buffers when it runs out. */
+            oe_set_memory_reclaim_callback(
+                _release_idle_ecall_staging_buffers);
+
             /* Call global constructors. Now they can safely use simulated
              * instructions like CPUID. */
             oe_call_init_functions();
@@ -195,6 +378,8 @@ static oe_result_t _handle_call_enclave_function(uint64_t arg_in)
     size_t buffer_size = 0;
     size_t output_bytes_written = 0;
     ecall_table_t ecall_table;
+    ecall_staging_t* staging = NULL;
+    bool cached = false;
 
     // Ensure that args lies outside the enclave.
     if (!oe_is_outside_enclave(
@@ -257,8 +442,10 @@ static oe_result_t _handle_call_enclave_function(uint64_t arg_in)
     if (func == NULL)
         OE_RAISE(OE_NOT_FOUND);
 
-    // Allocate buffers in enclave memory
-    buffer = input_buffer = oe_malloc(buffer_size);
+    // Get buffers in enclave memory, reusing those of this TCS if possible.
+    staging = _acquire_ecall_staging(oe_get_td());
+    buffer = input_buffer =
+        _get_ecall_staging_buffer(staging, buffer_size, &cached);
     if (buffer == NULL)
         OE_RAISE(OE_OUT_OF_MEMORY);
 
@@ -295,9 +482,61 @@ static oe_result_t _handle_call_enclave_function(uint64_t arg_in)
     }
 
 done:
-    if (buffer)
+    if (buffer && !cached)
         oe_free(buffer);
 
+    if (staging)
+        _unlock_ecall_staging(staging);
+
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** _handle_call_enclave_functions()
+**
+**     Make each call of an oe_call_enclave_functions_args_t in turn, storing
+**     its outcome in its result field.
+**
+**==============================================================================
+*/
+
+static oe_result_t _handle_call_enclave_functions(uint64_t arg_in)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_call_enclave_functions_args_t args;
+    size_t size;
+
+    // Ensure that args lies outside the enclave.
+    if (!oe_is_outside_enclave(
+            (void*)arg_in, sizeof(oe_call_enclave_functions_args_t)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    // Copy args to enclave memory to avoid TOCTOU issues.
+    args = *(oe_call_enclave_functions_args_t*)arg_in;
+
+    // Ensure that the array of calls lies outside the enclave.
+    OE_CHECK(oe_safe_mul_sizet(
+        args.num_calls, sizeof(oe_call_enclave_function_args_t), &size));
+
+    if (args.calls == NULL || size == 0 ||
+        !oe_is_outside_enclave(args.calls, size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    for (size_t i = 0; i < args.num_calls; i++)
+    {
+        oe_call_enclave_function_args_t* call = &args.calls[i];
+
+        call->result = _handle_call_enclave_function((uint64_t)call);
+
+        /* clear up shared memory after each call */
+        oe_shm_clear();
+    }
+
+    result = OE_OK;
+
+done:
     return result;
 }
 
@@ -390,6 +629,11 @@ static void _handle_ecall(
             oe_shm_clear();
             break;
         }
+        case OE_ECALL_CALL_ENCLAVE_FUNCTIONS:
+        {
+            arg_out = _handle_call_enclave_functions(arg_in);
+            break;
+        }
         case OE_ECALL_DESTRUCTOR:
         {
             /* Call functions installed by __cxa_atexit() and oe_atexit() */
@@ -401,6 +645,9 @@ static void _handle_ecall(
             /* Free shared memory upon destroying enclave */
             oe_shm_destroy();
 
+            /* Free the ECALL buffers of all threads */
+            _release_idle_ecall_staging_buffers();
+
 #if defined(OE_USE_DEBUG_MALLOC)
 
             /* If memory still allocated, print a trace and return an error */
@@ -421,6 +668,11 @@ static void _handle_ecall(
             arg_out = _handle_init_enclave(arg_in);
             break;
         }
+        case OE_ECALL_RELEASE_THREAD_LOCALS:
+        {
+            /* The thread-local storage is released on return (below) */
+            break;
+        }
         default:
         {
             /* No function found with the number */
@@ -431,8 +683,12 @@ static void _handle_ecall(
 
 done:
 
-    /* Remove ECALL context from front of td_t.ecalls list */
-    td_pop_callsite(td);
+    /* Remove ECALL context from front of td_t.ecalls list. Thread-local
+     * storage kept across ECALLs is released when the enclave terminates. */
+    td_pop_callsite(
+        td,
+        func == OE_ECALL_RELEASE_THREAD_LOCALS ||
+            func == OE_ECALL_DESTRUCTOR);
 
     /* Perform ERET, giving control back to host */
     *output_arg1 = oe_make_call_arg1(OE_CODE_ERET, func, 0, result);
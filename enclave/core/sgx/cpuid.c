@@ -75,22 +75,56 @@ done:
 */
 int oe_emulate_cpuid(uint64_t* rax, uint64_t* rbx, uint64_t* rcx, uint64_t* rdx)
 {
+    uint32_t eax, ebx, ecx, edx;
+
     // upper bits zeroed on 64-bit for CPUID
-    uint32_t cpuid_leaf = (*rax) & 0xFFFFFFFF;
-    uint32_t cpuid_sub_leaf = (*rcx) & 0xFFFFFFFF;
+    if (oe_cpuid(
+            (*rax) & 0xFFFFFFFF,
+            (*rcx) & 0xFFFFFFFF,
+            &eax,
+            &ebx,
+            &ecx,
+            &edx) != OE_OK)
+        return -1;
 
-    if (cpuid_leaf < OE_CPUID_LEAF_COUNT &&
-        oe_is_emulated_cpuid_leaf(cpuid_leaf))
-    {
-        // For leaf 4 of cpuid, only subleaf of 0 is emulated
-        if ((cpuid_leaf == 4) && (cpuid_sub_leaf != 0))
-            return -1;
-
-        *rax = _cpuid_table[cpuid_leaf][OE_CPUID_RAX];
-        *rbx = _cpuid_table[cpuid_leaf][OE_CPUID_RBX];
-        *rcx = _cpuid_table[cpuid_leaf][OE_CPUID_RCX];
-        *rdx = _cpuid_table[cpuid_leaf][OE_CPUID_RDX];
-        return 0;
-    }
-    return -1;
+    *rax = eax;
+    *rbx = ebx;
+    *rcx = ecx;
+    *rdx = edx;
+    return 0;
+}
+
+/*
+**==============================================================================
+**
+** oe_cpuid()
+**
+**     Return the cached CPUID results without trapping. See
+**     oe_emulate_cpuid() for the leaves that are available.
+**
+**==============================================================================
+*/
+oe_result_t oe_cpuid(
+    uint32_t leaf,
+    uint32_t subleaf,
+    uint32_t* eax,
+    uint32_t* ebx,
+    uint32_t* ecx,
+    uint32_t* edx)
+{
+    if (!eax || !ebx || !ecx || !edx)
+        return OE_INVALID_PARAMETER;
+
+    if (leaf >= OE_CPUID_LEAF_COUNT || !oe_is_emulated_cpuid_leaf(leaf))
+        return OE_UNSUPPORTED;
+
+    // For leaf 4 of cpuid, only subleaf of 0 is emulated
+    if ((leaf == 4) && (subleaf != 0))
+        return OE_UNSUPPORTED;
+
+    *eax = _cpuid_table[leaf][OE_CPUID_RAX];
+    *ebx = _cpuid_table[leaf][OE_CPUID_RBX];
+    *ecx = _cpuid_table[leaf][OE_CPUID_RCX];
+    *edx = _cpuid_table[leaf][OE_CPUID_RDX];
+    return OE_OK;
 }
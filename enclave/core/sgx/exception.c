@@ -214,16 +214,84 @@ static struct
 **
 **==============================================================================
 */
+static oe_emulated_exception_stats_t _emulated_exception_stats;
+
+static void _count_emulated_exception(uint64_t address)
+{
+    oe_emulated_exception_stats_t* stats = &_emulated_exception_stats;
+
+    __atomic_add_fetch(&stats->emulated, 1, __ATOMIC_RELAXED);
+
+    // Find the site of this address, or claim the first unused one.
+    for (size_t i = 0; i < OE_EMULATED_EXCEPTION_SITES; i++)
+    {
+        uint64_t site =
+            __atomic_load_n(&stats->sites[i].address, __ATOMIC_RELAXED);
+
+        if (site == 0)
+        {
+            __atomic_compare_exchange_n(
+                &stats->sites[i].address,
+                &site,
+                address,
+                false,
+                __ATOMIC_RELAXED,
+                __ATOMIC_RELAXED);
+
+            // site is still 0 if this thread claimed the entry
+            if (site == 0)
+                site = address;
+        }
+
+        if (site == address)
+        {
+            __atomic_add_fetch(&stats->sites[i].count, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+
+    __atomic_add_fetch(&stats->other_sites, 1, __ATOMIC_RELAXED);
+}
+
+void oe_get_emulated_exception_stats(oe_emulated_exception_stats_t* stats)
+{
+    const oe_emulated_exception_stats_t* p = &_emulated_exception_stats;
+
+    if (!stats)
+        return;
+
+    stats->emulated = __atomic_load_n(&p->emulated, __ATOMIC_RELAXED);
+    stats->not_emulated = __atomic_load_n(&p->not_emulated, __ATOMIC_RELAXED);
+
+    for (size_t i = 0; i < OE_EMULATED_EXCEPTION_SITES; i++)
+    {
+        stats->sites[i].address =
+            __atomic_load_n(&p->sites[i].address, __ATOMIC_RELAXED);
+        stats->sites[i].count =
+            __atomic_load_n(&p->sites[i].count, __ATOMIC_RELAXED);
+    }
+
+    stats->other_sites = __atomic_load_n(&p->other_sites, __ATOMIC_RELAXED);
+}
+
 int _emulate_illegal_instruction(sgx_ssa_gpr_t* ssa_gpr)
 {
+    int ret = -1;
+
     // Emulate CPUID
     if (*((uint16_t*)ssa_gpr->rip) == OE_CPUID_OPCODE)
     {
-        return oe_emulate_cpuid(
+        ret = oe_emulate_cpuid(
             &ssa_gpr->rax, &ssa_gpr->rbx, &ssa_gpr->rcx, &ssa_gpr->rdx);
     }
 
-    return -1;
+    if (ret == 0)
+        _count_emulated_exception(ssa_gpr->rip);
+    else
+        __atomic_add_fetch(
+            &_emulated_exception_stats.not_emulated, 1, __ATOMIC_RELAXED);
+
+    return ret;
 }
 
 /*
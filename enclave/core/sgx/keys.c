@@ -3,9 +3,12 @@
 
 #include <openenclave/bits/safecrt.h>
 #include <openenclave/corelibc/stdlib.h>
+#include <openenclave/corelibc/string.h>
 #include <openenclave/enclave.h>
+#include <openenclave/internal/keycache.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/sgxtypes.h>
+#include <openenclave/internal/thread.h>
 #include <openenclave/internal/utils.h>
 #include "asmdefs.h"
 #include "report.h"
@@ -75,6 +78,200 @@ static oe_result_t _get_key_imp(
     return result;
 }
 
+/*
+**==============================================================================
+**
+** Seal key cache
+**
+**     EGETKEY is comparatively expensive and, for a given key request, always
+**     returns the same key for the lifetime of the enclave. Seal keys are
+**     therefore cached by key request after their first derivation. The
+**     default key request attributes (which require an EREPORT) are cached
+**     as well. The cache is a small fixed table inside the enclave image
+**     that is zeroized on eviction and on enclave termination.
+**
+**==============================================================================
+*/
+
+#define OE_SEAL_KEY_CACHE_SIZE 8
+
+typedef struct _seal_key_cache_entry
+{
+    bool in_use;
+    sgx_key_request_t key_request;
+    sgx_key_t key;
+} seal_key_cache_entry_t;
+
+static struct
+{
+    oe_spinlock_t lock;
+    bool atexit_registered;
+    bool have_default_key_request;
+    sgx_key_request_t default_key_request;
+    seal_key_cache_entry_t entries[OE_SEAL_KEY_CACHE_SIZE];
+    size_t next_victim;
+} _seal_key_cache = {OE_SPINLOCK_INITIALIZER};
+
+static uint16_t _seal_policy_to_key_policy(oe_seal_policy_t seal_policy)
+{
+    switch (seal_policy)
+    {
+        case OE_SEAL_POLICY_UNIQUE:
+            return SGX_KEYPOLICY_MRENCLAVE;
+
+        case OE_SEAL_POLICY_PRODUCT:
+            return SGX_KEYPOLICY_MRSIGNER;
+
+        default:
+            return 0;
+    }
+}
+
+/* Called with the cache lock held */
+static void _evict_seal_keys_locked(uint16_t key_policy_mask)
+{
+    for (size_t i = 0; i < OE_SEAL_KEY_CACHE_SIZE; i++)
+    {
+        seal_key_cache_entry_t* entry = &_seal_key_cache.entries[i];
+
+        if (entry->in_use && (entry->key_request.key_policy & key_policy_mask))
+            oe_secure_zero_fill(entry, sizeof(*entry));
+    }
+
+    _seal_key_cache.have_default_key_request = false;
+}
+
+static void _clear_seal_key_cache(void)
+{
+    oe_spin_lock(&_seal_key_cache.lock);
+    _evict_seal_keys_locked(SGX_KEYPOLICY_ALL);
+    oe_spin_unlock(&_seal_key_cache.lock);
+}
+
+static bool _same_key_request(
+    const sgx_key_request_t* a,
+    const sgx_key_request_t* b)
+{
+    return memcmp(a, b, sizeof(sgx_key_request_t)) == 0;
+}
+
+static bool _find_seal_key(
+    const sgx_key_request_t* sgx_key_request,
+    sgx_key_t* sgx_key)
+{
+    bool found = false;
+
+    oe_spin_lock(&_seal_key_cache.lock);
+
+    for (size_t i = 0; i < OE_SEAL_KEY_CACHE_SIZE; i++)
+    {
+        const seal_key_cache_entry_t* entry = &_seal_key_cache.entries[i];
+
+        if (entry->in_use &&
+            _same_key_request(&entry->key_request, sgx_key_request))
+        {
+            *sgx_key = entry->key;
+            found = true;
+            break;
+        }
+    }
+
+    oe_spin_unlock(&_seal_key_cache.lock);
+
+    return found;
+}
+
+static void _add_seal_key(
+    const sgx_key_request_t* sgx_key_request,
+    const sgx_key_t* sgx_key)
+{
+    seal_key_cache_entry_t* entry = NULL;
+    bool register_atexit = false;
+
+    oe_spin_lock(&_seal_key_cache.lock);
+
+    for (size_t i = 0; i < OE_SEAL_KEY_CACHE_SIZE; i++)
+    {
+        seal_key_cache_entry_t* p = &_seal_key_cache.entries[i];
+
+        /* Another thread may have added the same key meanwhile */
+        if (p->in_use && _same_key_request(&p->key_request, sgx_key_request))
+            goto done;
+
+        if (!p->in_use && !entry)
+            entry = p;
+    }
+
+    /* Replace the entries in round-robin order once the table is full */
+    if (!entry)
+    {
+        entry = &_seal_key_cache.entries[_seal_key_cache.next_victim];
+        _seal_key_cache.next_victim =
+            (_seal_key_cache.next_victim + 1) % OE_SEAL_KEY_CACHE_SIZE;
+    }
+
+    entry->key_request = *sgx_key_request;
+    entry->key = *sgx_key;
+    entry->in_use = true;
+
+    if (!_seal_key_cache.atexit_registered)
+    {
+        _seal_key_cache.atexit_registered = true;
+        register_atexit = true;
+    }
+
+done:
+    oe_spin_unlock(&_seal_key_cache.lock);
+
+    if (register_atexit)
+        oe_atexit(_clear_seal_key_cache);
+}
+
+static oe_result_t _get_seal_key(
+    const sgx_key_request_t* sgx_key_request,
+    sgx_key_t* sgx_key)
+{
+    oe_result_t result;
+
+    if (_find_seal_key(sgx_key_request, sgx_key))
+        return OE_OK;
+
+    result = _get_key_imp(sgx_key_request, sgx_key);
+
+    /* Only cache keys that were successfully derived */
+    if (result == OE_OK)
+        _add_seal_key(sgx_key_request, sgx_key);
+
+    return result;
+}
+
+void oe_evict_seal_keys(const oe_seal_policy_t* seal_policy)
+{
+    uint16_t key_policy_mask = SGX_KEYPOLICY_ALL;
+
+    if (seal_policy)
+        key_policy_mask = _seal_policy_to_key_policy(*seal_policy);
+
+    oe_spin_lock(&_seal_key_cache.lock);
+    _evict_seal_keys_locked(key_policy_mask);
+    oe_spin_unlock(&_seal_key_cache.lock);
+}
+
+bool oe_key_info_has_seal_policy(
+    const uint8_t* key_info,
+    size_t key_info_size,
+    oe_seal_policy_t seal_policy)
+{
+    const sgx_key_request_t* sgx_key_request =
+        (const sgx_key_request_t*)key_info;
+
+    if (!key_info || key_info_size != sizeof(sgx_key_request_t))
+        return false;
+
+    return (sgx_key_request->key_policy &
+            _seal_policy_to_key_policy(seal_policy)) != 0;
+}
+
 oe_result_t oe_get_key(
     const sgx_key_request_t* sgx_key_request,
     sgx_key_t* sgx_key)
@@ -119,6 +316,9 @@ oe_result_t oe_get_key(
         return OE_INVALID_PARAMETER;
     }
 
+    if (sgx_key_request->key_name == SGX_KEYSELECT_SEAL)
+        return _get_seal_key(sgx_key_request, sgx_key);
+
     return _get_key_imp(sgx_key_request, sgx_key);
 }
 
@@ -192,9 +392,28 @@ static oe_result_t _get_default_key_request_attributes(
     sgx_key_request_t* sgx_key_request)
 {
     sgx_report_t sgx_report = {{{0}}};
+    bool cached = false;
 
     oe_result_t result;
 
+    // The attributes do not change during the lifetime of the enclave, so
+    // reuse the ones from the previous request if they are still cached.
+    oe_spin_lock(&_seal_key_cache.lock);
+    if (_seal_key_cache.have_default_key_request)
+    {
+        const sgx_key_request_t* p = &_seal_key_cache.default_key_request;
+
+        sgx_key_request->isv_svn = p->isv_svn;
+        memcpy(sgx_key_request->cpu_svn, p->cpu_svn, sizeof(p->cpu_svn));
+        sgx_key_request->attribute_mask = p->attribute_mask;
+        sgx_key_request->misc_attribute_mask = p->misc_attribute_mask;
+        cached = true;
+    }
+    oe_spin_unlock(&_seal_key_cache.lock);
+
+    if (cached)
+        return OE_OK;
+
     // Get a local report of current enclave.
     result = sgx_create_report(NULL, 0, NULL, 0, &sgx_report);
 
@@ -214,6 +433,11 @@ static oe_result_t _get_default_key_request_attributes(
     sgx_key_request->attribute_mask.xfrm = OE_SEALKEY_DEFAULT_XFRMMASK;
     sgx_key_request->misc_attribute_mask = OE_SEALKEY_DEFAULT_MISCMASK;
 
+    oe_spin_lock(&_seal_key_cache.lock);
+    _seal_key_cache.default_key_request = *sgx_key_request;
+    _seal_key_cache.have_default_key_request = true;
+    oe_spin_unlock(&_seal_key_cache.lock);
+
 done:
     return result;
 }
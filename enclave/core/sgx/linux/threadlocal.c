@@ -290,15 +290,27 @@ oe_result_t oe_thread_local_init(td_t* td)
 
         uint64_t tls_data_size = (uint64_t)(fs - tls_start);
 
-        // Initialize the tls data to zero.
-        oe_memset_s(tls_start, tls_data_size, 0, tls_data_size);
-
         // Fetch the .tdata template.
         void* tdata = (uint8_t*)__oe_get_enclave_base() + _tdata_rva;
 
         // Copy the template
         oe_memcpy_s(tls_start, _tdata_size, tdata, _tdata_size);
 
+        // Zero the rest of the tls data (.tbss and alignment padding). The
+        // .tdata part was just overwritten and needs no zeroing.
+        //
+        // This is done eagerly, on the first ECALL that enters the thread
+        // context. With OE_SGX_CONFIG_PERSISTENT_THREAD_LOCALS that is once
+        // per TCS for the life of the enclave, otherwise once per outermost
+        // ECALL. Zeroing .tbss lazily is deliberately not done: nothing
+        // traps the first access to a thread-local, and the area is not
+        // known to be clean when it was used by an earlier ECALL.
+        oe_memset_s(
+            tls_start + _tdata_size,
+            tls_data_size - _tdata_size,
+            0,
+            tls_data_size - _tdata_size);
+
         // Perform thread-local relocations.
         if (!_thread_locals_relocated)
         {
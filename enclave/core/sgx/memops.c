@@ -0,0 +1,428 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "memops.h"
+#include <openenclave/corelibc/string.h>
+#include <openenclave/internal/cpuid.h>
+#include <openenclave/internal/memops.h>
+
+/*
+**==============================================================================
+**
+** Local definitions
+**
+**     memcpy(), memset(), memcmp() and strlen() for SGX enclaves. SSE2 is
+**     part of the x86_64 baseline and is always used. AVX2 and enhanced
+**     REP MOVSB/STOSB (ERMS) are selected by oe_initialize_memops() from the
+**     CPUID leaves cached at enclave initialization. Since those leaves are
+**     provided by the host, AVX2 is only used if XCR0 (which reflects the
+**     XFRM attribute of the enclave) also enables the AVX state.
+**
+**     This file must be compiled without loop pattern recognition (see
+**     CMakeLists.txt), which would turn the loops below back into calls to
+**     memcpy() and memset().
+**
+**==============================================================================
+*/
+
+/* Sizes from which REP MOVSB/STOSB beat the vector loops when ERMS is set */
+#define MEMOPS_REP_MOVSB_THRESHOLD 2048
+#define MEMOPS_REP_STOSB_THRESHOLD 2048
+
+#define CPUID_OSXSAVE_FEATURE 0x08000000u /* leaf 1, ECX bit 27 */
+#define CPUID_AVX_FEATURE 0x10000000u     /* leaf 1, ECX bit 28 */
+#define CPUID_AVX2_FEATURE 0x00000020u    /* leaf 7, EBX bit 5 */
+#define CPUID_ERMS_FEATURE 0x00000200u    /* leaf 7, EBX bit 9 */
+#define XCR0_SSE_AVX_STATE 0x6u           /* XMM and YMM state */
+
+typedef char v16_t __attribute__((__vector_size__(16)));
+typedef char v32_t __attribute__((__vector_size__(32)));
+typedef uint64_t v2u64_t __attribute__((__vector_size__(16)));
+typedef uint64_t v4u64_t __attribute__((__vector_size__(32)));
+
+/* Views of memory that may alias anything and (except v16a_t) be unaligned */
+typedef v16_t v16a_t __attribute__((__may_alias__));
+typedef v16_t v16u_t __attribute__((__may_alias__, __aligned__(1)));
+typedef v32_t v32u_t __attribute__((__may_alias__, __aligned__(1)));
+typedef uint64_t u64u_t __attribute__((__may_alias__, __aligned__(1)));
+typedef uint32_t u32u_t __attribute__((__may_alias__, __aligned__(1)));
+
+/* Paths supported, as found by oe_initialize_memops(), and selected
+ * (OE_MEMOPS_*) */
+static uint32_t _supported_memops;
+static uint32_t _memops;
+
+static uint64_t _xgetbv(uint32_t index)
+{
+    uint32_t eax, edx;
+
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+    return ((uint64_t)edx << 32) | eax;
+}
+
+void oe_initialize_memops(void)
+{
+    uint32_t max_leaf, eax, ebx, ecx, edx;
+    uint32_t memops = 0;
+    bool avx;
+
+    if (oe_cpuid(0, 0, &max_leaf, &ebx, &ecx, &edx) != OE_OK || max_leaf < 7)
+        return;
+
+    if (oe_cpuid(1, 0, &eax, &ebx, &ecx, &edx) != OE_OK)
+        return;
+
+    avx = (ecx & CPUID_OSXSAVE_FEATURE) && (ecx & CPUID_AVX_FEATURE) &&
+          (_xgetbv(0) & XCR0_SSE_AVX_STATE) == XCR0_SSE_AVX_STATE;
+
+    if (oe_cpuid(7, 0, &eax, &ebx, &ecx, &edx) != OE_OK)
+        return;
+
+    if (avx && (ebx & CPUID_AVX2_FEATURE))
+        memops |= OE_MEMOPS_AVX2;
+
+    if (ebx & CPUID_ERMS_FEATURE)
+        memops |= OE_MEMOPS_ERMS;
+
+    _supported_memops = memops;
+    _memops = memops;
+}
+
+uint32_t oe_select_memops(uint32_t memops)
+{
+    _memops = memops & _supported_memops;
+    return _memops;
+}
+
+/*
+**==============================================================================
+**
+** memcpy()
+**
+**     Copies of at least one vector are done with unaligned vector moves,
+**     the last (partial) vector being copied from the end of the buffers so
+**     that no scalar tail is needed. Smaller copies use overlapping scalar
+**     moves in the same way.
+**
+**==============================================================================
+*/
+
+static void _copy_small(unsigned char* d, const unsigned char* s, size_t n)
+{
+    if (n >= 8)
+    {
+        uint64_t head = *(const u64u_t*)s;
+        uint64_t tail = *(const u64u_t*)(s + n - 8);
+
+        *(u64u_t*)d = head;
+        *(u64u_t*)(d + n - 8) = tail;
+    }
+    else if (n >= 4)
+    {
+        uint32_t head = *(const u32u_t*)s;
+        uint32_t tail = *(const u32u_t*)(s + n - 4);
+
+        *(u32u_t*)d = head;
+        *(u32u_t*)(d + n - 4) = tail;
+    }
+    else if (n)
+    {
+        d[0] = s[0];
+        d[n / 2] = s[n / 2];
+        d[n - 1] = s[n - 1];
+    }
+}
+
+/* Requires n >= 16 */
+static void _copy_sse2(unsigned char* d, const unsigned char* s, size_t n)
+{
+    const v16_t tail = *(const v16u_t*)(s + n - 16);
+    unsigned char* const end = d + n - 16;
+
+    for (; n > 64; n -= 64, d += 64, s += 64)
+    {
+        v16_t x0 = *(const v16u_t*)(s + 0);
+        v16_t x1 = *(const v16u_t*)(s + 16);
+        v16_t x2 = *(const v16u_t*)(s + 32);
+        v16_t x3 = *(const v16u_t*)(s + 48);
+
+        *(v16u_t*)(d + 0) = x0;
+        *(v16u_t*)(d + 16) = x1;
+        *(v16u_t*)(d + 32) = x2;
+        *(v16u_t*)(d + 48) = x3;
+    }
+
+    for (; n > 16; n -= 16, d += 16, s += 16)
+        *(v16u_t*)d = *(const v16u_t*)s;
+
+    *(v16u_t*)end = tail;
+}
+
+/* Requires n >= 32 */
+__attribute__((target("avx2"))) static void _copy_avx2(
+    unsigned char* d,
+    const unsigned char* s,
+    size_t n)
+{
+    const v32_t tail = *(const v32u_t*)(s + n - 32);
+    unsigned char* const end = d + n - 32;
+
+    for (; n > 128; n -= 128, d += 128, s += 128)
+    {
+        v32_t y0 = *(const v32u_t*)(s + 0);
+        v32_t y1 = *(const v32u_t*)(s + 32);
+        v32_t y2 = *(const v32u_t*)(s + 64);
+        v32_t y3 = *(const v32u_t*)(s + 96);
+
+        *(v32u_t*)(d + 0) = y0;
+        *(v32u_t*)(d + 32) = y1;
+        *(v32u_t*)(d + 64) = y2;
+        *(v32u_t*)(d + 96) = y3;
+    }
+
+    for (; n > 32; n -= 32, d += 32, s += 32)
+        *(v32u_t*)d = *(const v32u_t*)s;
+
+    *(v32u_t*)end = tail;
+}
+
+void* memcpy(void* OE_RESTRICT dest, const void* OE_RESTRICT src, size_t n)
+{
+    unsigned char* d = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+    const uint32_t memops = _memops;
+
+    if (n < 16)
+        _copy_small(d, s, n);
+    else if ((memops & OE_MEMOPS_ERMS) && n >= MEMOPS_REP_MOVSB_THRESHOLD)
+        __asm__ volatile("rep movsb" : "+D"(d), "+S"(s), "+c"(n) : : "memory");
+    else if ((memops & OE_MEMOPS_AVX2) && n >= 32)
+        _copy_avx2(d, s, n);
+    else
+        _copy_sse2(d, s, n);
+
+    return dest;
+}
+
+/*
+**==============================================================================
+**
+** memset()
+**
+**==============================================================================
+*/
+
+static void _set_small(unsigned char* d, uint64_t pattern, size_t n)
+{
+    if (n >= 8)
+    {
+        *(u64u_t*)d = pattern;
+        *(u64u_t*)(d + n - 8) = pattern;
+    }
+    else if (n >= 4)
+    {
+        *(u32u_t*)d = (uint32_t)pattern;
+        *(u32u_t*)(d + n - 4) = (uint32_t)pattern;
+    }
+    else if (n)
+    {
+        d[0] = (unsigned char)pattern;
+        d[n / 2] = (unsigned char)pattern;
+        d[n - 1] = (unsigned char)pattern;
+    }
+}
+
+/* Requires n >= 16 */
+static void _set_sse2(unsigned char* d, uint64_t pattern, size_t n)
+{
+    const v16_t x = (v16_t)(v2u64_t){pattern, pattern};
+    unsigned char* const end = d + n - 16;
+
+    for (; n > 64; n -= 64, d += 64)
+    {
+        *(v16u_t*)(d + 0) = x;
+        *(v16u_t*)(d + 16) = x;
+        *(v16u_t*)(d + 32) = x;
+        *(v16u_t*)(d + 48) = x;
+    }
+
+    for (; n > 16; n -= 16, d += 16)
+        *(v16u_t*)d = x;
+
+    *(v16u_t*)end = x;
+}
+
+/* Requires n >= 32 */
+__attribute__((target("avx2"))) static void _set_avx2(
+    unsigned char* d,
+    uint64_t pattern,
+    size_t n)
+{
+    const v32_t y = (v32_t)(v4u64_t){pattern, pattern, pattern, pattern};
+    unsigned char* const end = d + n - 32;
+
+    for (; n > 128; n -= 128, d += 128)
+    {
+        *(v32u_t*)(d + 0) = y;
+        *(v32u_t*)(d + 32) = y;
+        *(v32u_t*)(d + 64) = y;
+        *(v32u_t*)(d + 96) = y;
+    }
+
+    for (; n > 32; n -= 32, d += 32)
+        *(v32u_t*)d = y;
+
+    *(v32u_t*)end = y;
+}
+
+void* memset(void* dest, int c, size_t n)
+{
+    unsigned char* d = (unsigned char*)dest;
+    const uint64_t pattern = 0x0101010101010101ULL * (unsigned char)c;
+    const uint32_t memops = _memops;
+
+    if (n < 16)
+        _set_small(d, pattern, n);
+    else if ((memops & OE_MEMOPS_ERMS) && n >= MEMOPS_REP_STOSB_THRESHOLD)
+        __asm__ volatile("rep stosb"
+                         : "+D"(d), "+c"(n)
+                         : "a"((unsigned char)c)
+                         : "memory");
+    else if ((memops & OE_MEMOPS_AVX2) && n >= 32)
+        _set_avx2(d, pattern, n);
+    else
+        _set_sse2(d, pattern, n);
+
+    return dest;
+}
+
+/*
+**==============================================================================
+**
+** memcmp()
+**
+**     Compares a vector at a time. The masks below have one bit set for
+**     each differing byte, the lowest of which decides the result.
+**
+**==============================================================================
+*/
+
+static int _compare_at(
+    const unsigned char* l,
+    const unsigned char* r,
+    uint32_t mask)
+{
+    const unsigned int i = (unsigned int)__builtin_ctz(mask);
+
+    return l[i] - r[i];
+}
+
+static uint32_t _diff_mask_sse2(const unsigned char* l, const unsigned char* r)
+{
+    const v16_t x = *(const v16u_t*)l;
+    const v16_t y = *(const v16u_t*)r;
+
+    return (uint32_t)__builtin_ia32_pmovmskb128((v16_t)(x == y)) ^ 0xFFFFu;
+}
+
+/* Requires n >= 32 */
+__attribute__((target("avx2"))) static int _compare_avx2(
+    const unsigned char* l,
+    const unsigned char* r,
+    size_t n)
+{
+    uint32_t mask;
+
+    for (;;)
+    {
+        const v32_t x = *(const v32u_t*)l;
+        const v32_t y = *(const v32u_t*)r;
+
+        mask = ~(uint32_t)__builtin_ia32_pmovmskb256((v32_t)(x == y));
+        if (mask)
+            return _compare_at(l, r, mask);
+
+        if (n == 32)
+            return 0;
+
+        /* Compare the last (partial) vector from the end of the buffers */
+        if (n < 64)
+        {
+            l += n - 32;
+            r += n - 32;
+            n = 32;
+            continue;
+        }
+
+        l += 32;
+        r += 32;
+        n -= 32;
+    }
+}
+
+int memcmp(const void* vl, const void* vr, size_t n)
+{
+    const unsigned char* l = (const unsigned char*)vl;
+    const unsigned char* r = (const unsigned char*)vr;
+    uint32_t mask;
+
+    if ((_memops & OE_MEMOPS_AVX2) && n >= 32)
+        return _compare_avx2(l, r, n);
+
+    for (; n >= 16; n -= 16, l += 16, r += 16)
+    {
+        if ((mask = _diff_mask_sse2(l, r)))
+            return _compare_at(l, r, mask);
+    }
+
+    for (; n && *l == *r; n--, l++, r++)
+        ;
+
+    return n ? *l - *r : 0;
+}
+
+/*
+**==============================================================================
+**
+** strlen()
+**
+**     Scans aligned 16-byte blocks for the terminator. An aligned block never
+**     crosses a page boundary, so reading the bytes of the first block that
+**     precede the string (or of the last block that follow the terminator)
+**     cannot fault.
+**
+**==============================================================================
+*/
+
+static uint32_t _zero_mask_sse2(const char* p)
+{
+    const v16_t x = *(const v16a_t*)p;
+
+    return (uint32_t)__builtin_ia32_pmovmskb128((v16_t)(x == (v16_t){0}));
+}
+
+size_t oe_strlen(const char* s)
+{
+    const size_t offset = (uintptr_t)s & 15;
+    const char* p = s - offset;
+    uint32_t mask = _zero_mask_sse2(p) >> offset;
+
+    if (mask)
+        return (size_t)__builtin_ctz(mask);
+
+    for (;;)
+    {
+        p += 16;
+
+        if ((mask = _zero_mask_sse2(p)))
+            return (size_t)(p - s) + (size_t)__builtin_ctz(mask);
+    }
+}
+
+/* Standard-C name used by oelibc and enclave applications */
+size_t strlen(const char* s);
+
+size_t strlen(const char* s)
+{
+    return oe_strlen(s);
+}
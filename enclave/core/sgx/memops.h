@@ -0,0 +1,12 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_MEMOPS_ENCLAVE_H
+#define _OE_MEMOPS_ENCLAVE_H
+
+/* Select the memcpy/memset/memcmp/strlen implementations from the cached
+ * CPUID leaves. Must be called after oe_initialize_cpuid(). Until then the
+ * baseline (SSE2) implementations are used. */
+void oe_initialize_memops(void);
+
+#endif /* _OE_MEMOPS_ENCLAVE_H */
@@ -19,6 +19,8 @@
 
 #define TD_FROM_TCS (4 * OE_PAGE_SIZE)
 
+extern volatile const oe_sgx_enclave_properties_t oe_enclave_properties_sgx;
+
 OE_STATIC_ASSERT(OE_OFFSETOF(td_t, magic) == td_magic);
 OE_STATIC_ASSERT(OE_OFFSETOF(td_t, depth) == td_depth);
 OE_STATIC_ASSERT(OE_OFFSETOF(td_t, host_rcx) == td_host_rcx);
@@ -59,6 +61,13 @@ oe_thread_data_t* oe_get_thread_data()
     return &(td->base);
 }
 
+/* Whether the thread-local storage outlives outermost ECALLs */
+static bool _has_persistent_thread_locals(void)
+{
+    return oe_enclave_properties_sgx.config.flags &
+           OE_SGX_CONFIG_PERSISTENT_THREAD_LOCALS;
+}
+
 /*
 **==============================================================================
 **
@@ -88,12 +97,13 @@ void td_push_callsite(td_t* td, Callsite* callsite)
 **==============================================================================
 */
 
-void td_pop_callsite(td_t* td)
+void td_pop_callsite(td_t* td, bool release_thread_locals)
 {
     if (!td->callsites)
         oe_abort();
 
-    if (td->depth == 1)
+    if (td->depth == 1 &&
+        (release_thread_locals || !_has_persistent_thread_locals()))
     {
         // The outermost ecall is about to return.
         // Clear the thread-local storage.
@@ -101,7 +111,8 @@ void td_pop_callsite(td_t* td)
     }
     else
     {
-        // Nested ecall returning.
+        // Nested ecall returning, or outermost ecall returning in an enclave
+        // that keeps the thread-local storage (and the td_t) initialized.
         td->callsites = td->callsites->next;
         --td->depth;
     }
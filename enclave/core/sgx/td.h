@@ -64,7 +64,7 @@ struct _callsite
 
 void td_push_callsite(td_t* td, Callsite* ec);
 
-void td_pop_callsite(td_t* td);
+void td_pop_callsite(td_t* td, bool release_thread_locals);
 
 td_t* td_from_tcs(void* tcs);
 
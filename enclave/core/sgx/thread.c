@@ -3,6 +3,7 @@
 
 #include "thread.h"
 #include <openenclave/bits/safecrt.h>
+#include <openenclave/corelibc/stdlib.h>
 #include <openenclave/corelibc/string.h>
 #include <openenclave/enclave.h>
 #include <openenclave/internal/calls.h>
@@ -133,6 +134,110 @@ bool oe_thread_equal(oe_thread_t thread1, oe_thread_t thread2)
     return thread1 == thread2;
 }
 
+/*
+**==============================================================================
+**
+** oe_thread_create()
+**
+**     Each request gets an identifier that the host passes back to
+**     oe_thread_start_ecall(). The function and argument to run stay in the
+**     enclave, and an identifier is accepted only once.
+**
+**==============================================================================
+*/
+
+typedef struct _thread_start
+{
+    struct _thread_start* next;
+    uint64_t id;
+    void (*start_routine)(void*);
+    void* arg;
+} thread_start_t;
+
+static thread_start_t* _thread_starts;
+static uint64_t _next_thread_start_id = 1;
+static oe_spinlock_t _thread_starts_lock = OE_SPINLOCK_INITIALIZER;
+
+/* Remove the request with the given identifier from the list */
+static thread_start_t* _take_thread_start(uint64_t id)
+{
+    thread_start_t* start = NULL;
+
+    oe_spin_lock(&_thread_starts_lock);
+
+    for (thread_start_t** link = &_thread_starts; *link;
+         link = &(*link)->next)
+    {
+        if ((*link)->id == id)
+        {
+            start = *link;
+            *link = start->next;
+            break;
+        }
+    }
+
+    oe_spin_unlock(&_thread_starts_lock);
+
+    return start;
+}
+
+oe_result_t oe_thread_create(void (*start_routine)(void*), void* arg)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_result_t retval = OE_UNEXPECTED;
+    thread_start_t* start = NULL;
+    uint64_t id;
+
+    if (!start_routine)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!(start = (thread_start_t*)oe_malloc(sizeof(thread_start_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    start->start_routine = start_routine;
+    start->arg = arg;
+
+    /* Publish the request before the host can act on it */
+    oe_spin_lock(&_thread_starts_lock);
+    id = start->id = _next_thread_start_id++;
+    start->next = _thread_starts;
+    _thread_starts = start;
+    oe_spin_unlock(&_thread_starts_lock);
+
+    if (oe_thread_create_ocall(&retval, oe_get_enclave(), id) != OE_OK ||
+        retval != OE_OK)
+    {
+        /* The host may have started the thread anyway */
+        if ((start = _take_thread_start(id)))
+        {
+            oe_free(start);
+            OE_RAISE(retval == OE_OK ? OE_FAILURE : retval);
+        }
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+void oe_thread_start_ecall(uint64_t id)
+{
+    thread_start_t* start = _take_thread_start(id);
+    void (*start_routine)(void*);
+    void* arg;
+
+    /* Ignore identifiers that were not issued or were already used */
+    if (!start)
+        return;
+
+    start_routine = start->start_routine;
+    arg = start->arg;
+    oe_free(start);
+
+    start_routine(arg);
+}
+
 /*
 **==============================================================================
 **
@@ -7,6 +7,8 @@
 #include <openenclave/corelibc/string.h>
 #include <openenclave/internal/defs.h>
 
+/* The SGX implementation of oe_strlen() is in sgx/memops.c */
+#if !defined(__x86_64__)
 size_t oe_strlen(const char* s)
 {
     const char* p = s;
@@ -30,6 +32,7 @@ size_t oe_strlen(const char* s)
     /* Unreachable */
     return 0;
 }
+#endif
 
 int oe_strcmp(const char* s1, const char* s2)
 {
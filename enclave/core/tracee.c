@@ -11,8 +11,10 @@
 #include <openenclave/corelibc/string.h>
 #include <openenclave/enclave.h>
 #include <openenclave/internal/calls.h>
+#include <openenclave/internal/logring.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/sgxtypes.h>
+#include <openenclave/internal/thread.h>
 #include <openenclave/internal/trace.h>
 #include <openenclave/internal/utils.h>
 #include "tee_t.h"
@@ -38,6 +40,147 @@ const char* get_filename_from_path(const char* path)
     return path;
 }
 
+/*
+**==============================================================================
+**
+** Log rings
+**
+**     The host may pass an array of rings (see logring.h) to
+**     oe_log_init_ecall(). A thread claims a ring on its first log message
+**     and from then on appends its messages to it; a host thread drains the
+**     rings in batches. Each ring has a single producer, its thread, so
+**     appending needs no lock. The enclave keeps its own copy of the head and
+**     only uses the tail written by the host to compute the free space; a
+**     tail that makes no sense is treated as a full ring.
+**
+**     Messages are dropped (and counted) when the ring is full. Threads that
+**     find no free ring, and messages logged while the thread is already
+**     appending (e.g. from an exception handler), use oe_log_ocall().
+**
+**==============================================================================
+*/
+
+typedef struct _log_ring_slot
+{
+    /* The thread owning the ring (set once) */
+    oe_thread_t thread;
+
+    /* Non-zero while the thread is appending to the ring */
+    uint32_t busy;
+
+    uint64_t head;
+    uint64_t dropped;
+} log_ring_slot_t;
+
+static oe_log_ring_t* _log_rings;
+static size_t _log_ring_count;
+static log_ring_slot_t _log_ring_slots[OE_LOG_RING_COUNT_MAX];
+
+static void _init_log_rings(oe_log_ring_t* rings, size_t count)
+{
+    size_t size;
+
+    if (!rings || count == 0 || count > OE_LOG_RING_COUNT_MAX)
+        return;
+
+    if (oe_safe_mul_sizet(count, sizeof(oe_log_ring_t), &size) != OE_OK ||
+        !oe_is_outside_enclave(rings, size))
+        return;
+
+    _log_rings = rings;
+    _log_ring_count = count;
+}
+
+/* Find (or claim) the ring of the calling thread and mark it busy */
+static size_t _acquire_log_ring(void)
+{
+    oe_thread_t self = oe_thread_self();
+
+    for (size_t i = 0; i < _log_ring_count; i++)
+    {
+        log_ring_slot_t* slot = &_log_ring_slots[i];
+        oe_thread_t owner = __atomic_load_n(&slot->thread, __ATOMIC_ACQUIRE);
+
+        if (owner == 0 &&
+            __atomic_compare_exchange_n(
+                &slot->thread,
+                &owner,
+                self,
+                false,
+                __ATOMIC_ACQ_REL,
+                __ATOMIC_ACQUIRE))
+        {
+            owner = self;
+        }
+
+        if (owner == self)
+        {
+            if (slot->busy)
+                break;
+
+            slot->busy = 1;
+            return i;
+        }
+    }
+
+    return OE_SIZE_MAX;
+}
+
+/* Append a message of the given size (including the null terminator) to the
+ * ring of the calling thread. Returns false if there is no such ring. */
+static bool _append_to_log_ring(
+    oe_log_level_t level,
+    const char* message,
+    size_t size)
+{
+    const uint64_t ring_size = OE_LOG_RING_SIZE;
+    size_t index = _acquire_log_ring();
+    log_ring_slot_t* slot;
+    oe_log_ring_t* ring;
+    uint64_t head, tail, offset, padding, record_size;
+    oe_log_record_t record;
+
+    if (index == OE_SIZE_MAX)
+        return false;
+
+    slot = &_log_ring_slots[index];
+    ring = &_log_rings[index];
+    head = slot->head;
+    tail = ring->tail;
+    offset = head % ring_size;
+    record_size = oe_round_up_to_multiple(
+        sizeof(oe_log_record_t) + size, OE_LOG_RECORD_ALIGNMENT);
+    padding = (ring_size - offset < record_size) ? ring_size - offset : 0;
+
+    if (tail > head || head - tail > ring_size ||
+        ring_size - (head - tail) < padding + record_size)
+    {
+        ring->dropped = ++slot->dropped;
+        goto done;
+    }
+
+    if (padding)
+    {
+        record.level = OE_LOG_RECORD_PADDING;
+        record.size = (uint32_t)(padding - sizeof(oe_log_record_t));
+        memcpy(&ring->data[offset], &record, sizeof(record));
+        offset = 0;
+    }
+
+    record.level = (uint32_t)level;
+    record.size = (uint32_t)size;
+    memcpy(&ring->data[offset], &record, sizeof(record));
+    memcpy(&ring->data[offset + sizeof(record)], message, size);
+
+    /* Publish the record after its contents */
+    slot->head = head + padding + record_size;
+    __atomic_store_n(&ring->head, slot->head, __ATOMIC_RELEASE);
+
+done:
+    slot->busy = 0;
+    return true;
+}
+
 /*
 **==============================================================================
 **
@@ -49,7 +192,11 @@ const char* get_filename_from_path(const char* path)
 **==============================================================================
 */
 
-void oe_log_init_ecall(const char* enclave_path, uint32_t log_level)
+void oe_log_init_ecall(
+    const char* enclave_path,
+    uint32_t log_level,
+    void* log_rings,
+    size_t log_ring_count)
 {
     const char* filename;
 
@@ -65,6 +212,9 @@ void oe_log_init_ecall(const char* enclave_path, uint32_t log_level)
     }
 
     _debug_allowed_enclave = is_enclave_debug_allowed();
+
+    if (_debug_allowed_enclave)
+        _init_log_rings((oe_log_ring_t*)log_rings, log_ring_count);
 }
 
 oe_result_t oe_log(oe_log_level_t level, const char* fmt, ...)
@@ -115,8 +265,18 @@ oe_result_t oe_log(oe_log_level_t level, const char* fmt, ...)
     if (n < 0)
         goto done;
 
-    if (oe_log_ocall(level, message) != OE_OK)
-        goto done;
+    if (!_append_to_log_ring(level, message, oe_strlen(message) + 1))
+    {
+        if (oe_log_ocall(level, message) != OE_OK)
+            goto done;
+    }
+    else if (level == OE_LOG_LEVEL_FATAL)
+    {
+        /* The enclave may be about to abort: have the host write the
+         * message now */
+        if (oe_log_flush_ocall() != OE_OK)
+            goto done;
+    }
 
     result = OE_OK;
 
@@ -3,51 +3,158 @@
 
 #include "random_internal.h"
 #include <mbedtls/entropy.h>
+#include <mbedtls/platform.h>
+#include <openenclave/corelibc/stdlib.h>
 #include <openenclave/enclave.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/random.h>
 #include <openenclave/internal/thread.h>
+#include <openenclave/internal/utils.h>
 
 /*
 **==============================================================================
 **
 ** Local definitions
 **
+**     Each enclave thread owns a private CTR-DRBG instance (and a private
+**     entropy context used to seed it). Since an enclave thread is bound to
+**     a TCS for its lifetime, the thread identifier returned by
+**     oe_thread_self() is stable across ECALLs and is used as the key of the
+**     instance. Instances are created on first use by each thread and are
+**     only ever prepended to the list, so lookups need no lock. Only the
+**     owning thread ever touches an instance, so generation never contends
+**     with other threads.
+**
+**     All instances are zeroized and released on enclave termination.
+**
 **==============================================================================
 */
 
-static mbedtls_ctr_drbg_context _drbg;
-static mbedtls_entropy_context _entropy;
+/* Number of generate requests between automatic reseeds of an instance */
+#define OE_DRBG_RESEED_INTERVAL 4096
+
+typedef struct _drbg_instance drbg_instance_t;
+
+struct _drbg_instance
+{
+    /* Thread that owns this instance */
+    oe_thread_t owner;
+
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_entropy_context entropy;
+
+    drbg_instance_t* next;
+};
+
+static drbg_instance_t* _instances;
+static oe_once_t _atexit_once = OE_ONCE_INIT;
+
+static void _free_instances(void)
+{
+    drbg_instance_t* p =
+        __atomic_exchange_n(&_instances, NULL, __ATOMIC_ACQ_REL);
+
+    while (p)
+    {
+        drbg_instance_t* next = p->next;
+
+        mbedtls_ctr_drbg_free(&p->drbg);
+        mbedtls_entropy_free(&p->entropy);
+        oe_secure_zero_fill(p, sizeof(*p));
+        mbedtls_free(p);
+
+        p = next;
+    }
+}
+
+static void _register_atexit(void)
+{
+    oe_atexit(_free_instances);
+}
 
-static oe_result_t _seed_entropy_source()
+static drbg_instance_t* _find_instance(oe_thread_t owner)
+{
+    drbg_instance_t* p = __atomic_load_n(&_instances, __ATOMIC_ACQUIRE);
+
+    for (; p; p = p->next)
+    {
+        if (p->owner == owner)
+            return p;
+    }
+
+    return NULL;
+}
+
+static oe_result_t _new_instance(oe_thread_t owner, drbg_instance_t** instance)
 {
     oe_result_t result = OE_UNEXPECTED;
+    drbg_instance_t* p = NULL;
+    int rc;
+
+    if (!(p = mbedtls_calloc(1, sizeof(drbg_instance_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    p->owner = owner;
+    mbedtls_ctr_drbg_init(&p->drbg);
+    mbedtls_entropy_init(&p->entropy);
+
+    /* Seed independently from oe_get_entropy() (via mbedtls_hardware_poll)
+     * and personalize with the owner so that no two instances share a
+     * derivation input even if the entropy source misbehaves. */
+    rc = mbedtls_ctr_drbg_seed(
+        &p->drbg,
+        mbedtls_entropy_func,
+        &p->entropy,
+        (const unsigned char*)&owner,
+        sizeof(owner));
+    if (rc != 0)
+        OE_RAISE_MSG(OE_CRYPTO_ERROR, "rc = 0x%x\n", rc);
 
-    mbedtls_ctr_drbg_init(&_drbg);
-    mbedtls_entropy_init(&_entropy);
+    mbedtls_ctr_drbg_set_reseed_interval(&p->drbg, OE_DRBG_RESEED_INTERVAL);
 
-    OE_CHECK((oe_result_t)mbedtls_ctr_drbg_seed(
-        &_drbg, mbedtls_entropy_func, &_entropy, NULL, 0));
+    oe_once(&_atexit_once, _register_atexit);
 
+    /* Publish the instance (other threads may be inserting concurrently) */
+    p->next = __atomic_load_n(&_instances, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(
+        &_instances, &p->next, p, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+
+    *instance = p;
+    p = NULL;
     result = OE_OK;
 
 done:
+
+    if (p)
+    {
+        mbedtls_ctr_drbg_free(&p->drbg);
+        mbedtls_entropy_free(&p->entropy);
+        oe_secure_zero_fill(p, sizeof(*p));
+        mbedtls_free(p);
+    }
+
     return result;
 }
 
-static oe_result_t _seed_result = OE_UNEXPECTED;
-static oe_once_t _seed_once = OE_ONCE_INIT;
-
-/* Wrapper to set file-scope _seed_result */
-static void _seed_entropy_source_once()
+static oe_result_t _get_instance(drbg_instance_t** instance)
 {
-    _seed_result = _seed_entropy_source();
+    oe_thread_t self = oe_thread_self();
+
+    if ((*instance = _find_instance(self)))
+        return OE_OK;
+
+    return _new_instance(self, instance);
 }
 
 mbedtls_ctr_drbg_context* oe_mbedtls_get_drbg()
 {
-    oe_once(&_seed_once, _seed_entropy_source_once);
-    return (_seed_result == OE_OK) ? &_drbg : NULL;
+    drbg_instance_t* instance;
+
+    if (_get_instance(&instance) != OE_OK)
+        return NULL;
+
+    return &instance->drbg;
 }
 
 /*
@@ -61,18 +168,29 @@ mbedtls_ctr_drbg_context* oe_mbedtls_get_drbg()
 oe_result_t oe_random_internal(void* data, size_t size)
 {
     oe_result_t result = OE_UNEXPECTED;
+    drbg_instance_t* instance;
+    unsigned char* p = (unsigned char*)data;
     int rc;
 
-    /* Seed the entropy source on the first call */
+    /* Seed this thread's instance on its first call */
+    OE_CHECK(_get_instance(&instance));
+
+    /* Generate random data. mbedtls limits the size of a single request, so
+     * larger requests are split (each chunk counts towards reseeding). */
+    while (size)
     {
-        oe_once(&_seed_once, _seed_entropy_source_once);
-        OE_CHECK(_seed_result);
-    }
+        size_t n = size;
 
-    /* Generate random data (synchronize access to _drbg instance) */
-    rc = mbedtls_ctr_drbg_random(&_drbg, data, size);
-    if (rc != 0)
-        OE_RAISE_MSG(OE_CRYPTO_ERROR, "rc = 0x%x\n", rc);
+        if (n > MBEDTLS_CTR_DRBG_MAX_REQUEST)
+            n = MBEDTLS_CTR_DRBG_MAX_REQUEST;
+
+        rc = mbedtls_ctr_drbg_random(&instance->drbg, p, n);
+        if (rc != 0)
+            OE_RAISE_MSG(OE_CRYPTO_ERROR, "rc = 0x%x\n", rc);
+
+        p += n;
+        size -= n;
+    }
 
     result = OE_OK;
 done:
@@ -6,6 +6,8 @@
 
 #include <mbedtls/ctr_drbg.h>
 
+/* Returns the CTR-DRBG instance owned by the calling thread. The instance
+ * must not be shared with other threads. */
 mbedtls_ctr_drbg_context* oe_mbedtls_get_drbg();
 
 #endif /* _CRYPTO_ENCLAVE_RANDOM_H */
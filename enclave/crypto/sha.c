@@ -59,6 +59,27 @@ done:
     return result;
 }
 
+oe_result_t oe_sha256_copy(
+    oe_sha256_context_t* dest,
+    const oe_sha256_context_t* src)
+{
+    oe_result_t result = OE_INVALID_PARAMETER;
+    oe_sha256_context_impl_t* dest_impl = (oe_sha256_context_impl_t*)dest;
+    const oe_sha256_context_impl_t* src_impl =
+        (const oe_sha256_context_impl_t*)src;
+
+    if (!dest || !src)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    mbedtls_sha256_init(&dest_impl->ctx);
+    mbedtls_sha256_clone(&dest_impl->ctx, &src_impl->ctx);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 oe_result_t oe_sha256_final(oe_sha256_context_t* context, OE_SHA256* sha256)
 {
     oe_result_t result = OE_INVALID_PARAMETER;
@@ -77,3 +98,19 @@ oe_result_t oe_sha256_final(oe_sha256_context_t* context, OE_SHA256* sha256)
 done:
     return result;
 }
+
+oe_result_t oe_sha256_free(oe_sha256_context_t* context)
+{
+    oe_result_t result = OE_INVALID_PARAMETER;
+    oe_sha256_context_impl_t* impl = (oe_sha256_context_impl_t*)context;
+
+    if (!context)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    mbedtls_sha256_free(&impl->ctx);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
@@ -1,8 +1,11 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <openenclave/bits/safemath.h>
 #include <openenclave/host.h>
 #include <openenclave/internal/raise.h>
+#include <openenclave/internal/utils.h>
+#include <stdlib.h>
 
 #include "calls.h"
 
@@ -131,3 +134,231 @@ oe_result_t oe_call_enclave_function(
         output_buffer_size,
         output_bytes_written);
 }
+
+/*
+**==============================================================================
+**
+** oe_call_enclave_functions()
+**
+** Call several enclave functions of the default function table with one
+** enclave entry.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_call_enclave_functions(
+    oe_enclave_t* enclave,
+    oe_enclave_function_call_t* calls,
+    size_t num_calls)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_call_enclave_functions_args_t args = {NULL, num_calls};
+    size_t size;
+
+    /* Reject invalid parameters */
+    if (!enclave || (!calls && num_calls))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (num_calls == 0)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    OE_CHECK(oe_safe_mul_sizet(num_calls, sizeof(*args.calls), &size));
+
+    if (!(args.calls = (oe_call_enclave_function_args_t*)malloc(size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    for (size_t i = 0; i < num_calls; i++)
+    {
+        args.calls[i].table_id = OE_UINT64_MAX;
+        args.calls[i].function_id = calls[i].function_id;
+        args.calls[i].input_buffer = calls[i].input_buffer;
+        args.calls[i].input_buffer_size = calls[i].input_buffer_size;
+        args.calls[i].output_buffer = calls[i].output_buffer;
+        args.calls[i].output_buffer_size = calls[i].output_buffer_size;
+        args.calls[i].output_bytes_written = 0;
+        args.calls[i].result = OE_UNEXPECTED;
+    }
+
+    /* Perform the ECALL */
+    {
+        uint64_t arg_out = 0;
+
+        OE_CHECK(oe_ecall(
+            enclave,
+            OE_ECALL_CALL_ENCLAVE_FUNCTIONS,
+            (uint64_t)&args,
+            &arg_out));
+        OE_CHECK((oe_result_t)arg_out);
+    }
+
+    for (size_t i = 0; i < num_calls; i++)
+    {
+        calls[i].result = args.calls[i].result;
+        calls[i].output_bytes_written =
+            (calls[i].result == OE_OK) ? args.calls[i].output_bytes_written
+                                       : 0;
+    }
+
+    result = OE_OK;
+
+done:
+    free(args.calls);
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_allocate_ecall_buffer()
+** oe_free_ecall_buffer()
+**
+**     Each thread has an arena from which the marshalling buffers of its
+**     ECALLs are carved. Buffers are never freed individually: the arena is
+**     rewound once all its buffers are freed, which happens at the end of
+**     each outermost ECALL (ECALLs nested in OCALLs allocate further into
+**     the arena). Buffers that do not fit come from malloc().
+**
+**==============================================================================
+*/
+
+#define ECALL_ARENA_ALIGNMENT 16
+
+typedef struct _ecall_arena
+{
+    size_t size;
+    size_t offset;
+    size_t count;
+    size_t padding;
+    /* Followed by size bytes */
+} ecall_arena_t;
+
+OE_STATIC_ASSERT(sizeof(ecall_arena_t) % ECALL_ARENA_ALIGNMENT == 0);
+
+/* Set by oe_set_ecall_buffer_size() and read by every ECALL thread */
+#if defined(_WIN32)
+static volatile LONG64 _ecall_arena_size = 64 * 1024;
+#else
+static volatile size_t _ecall_arena_size = 64 * 1024;
+#endif
+static oe_once_type _ecall_arena_once = OE_H_ONCE_INITIALIZER;
+static oe_thread_key _ecall_arena_key;
+static bool _ecall_arena_key_created;
+
+static void _create_ecall_arena_key(void)
+{
+    _ecall_arena_key_created =
+        oe_thread_key_create(&_ecall_arena_key, free) == 0;
+}
+
+static uint8_t* _ecall_arena_data(ecall_arena_t* arena)
+{
+    return (uint8_t*)(arena + 1);
+}
+
+oe_result_t oe_set_ecall_buffer_size(size_t size)
+{
+    if (size > OE_MAX_ECALL_BUFFER_SIZE)
+        return OE_INVALID_PARAMETER;
+
+    size = oe_round_up_to_multiple(size, ECALL_ARENA_ALIGNMENT);
+
+#if defined(_WIN32)
+    InterlockedExchange64(&_ecall_arena_size, (LONG64)size);
+#else
+    __atomic_store_n(&_ecall_arena_size, size, __ATOMIC_RELAXED);
+#endif
+    return OE_OK;
+}
+
+/* Get the arena of the calling thread, (re)creating it if it is idle and
+ * does not have the requested size. */
+static ecall_arena_t* _get_ecall_arena(void)
+{
+    ecall_arena_t* arena;
+#if defined(_WIN32)
+    size_t size = (size_t)InterlockedOr64(&_ecall_arena_size, 0);
+#else
+    size_t size = __atomic_load_n(&_ecall_arena_size, __ATOMIC_RELAXED);
+#endif
+
+    oe_once(&_ecall_arena_once, _create_ecall_arena_key);
+
+    if (!_ecall_arena_key_created)
+        return NULL;
+
+    arena = (ecall_arena_t*)oe_thread_getspecific(_ecall_arena_key);
+
+    if (arena && arena->count == 0 && arena->size != size)
+    {
+        oe_thread_setspecific(_ecall_arena_key, NULL);
+        free(arena);
+        arena = NULL;
+    }
+
+    if (!arena && size)
+    {
+        if (!(arena = (ecall_arena_t*)malloc(sizeof(ecall_arena_t) + size)))
+            return NULL;
+
+        arena->size = size;
+        arena->offset = 0;
+        arena->count = 0;
+
+        if (oe_thread_setspecific(_ecall_arena_key, arena) != 0)
+        {
+            free(arena);
+            return NULL;
+        }
+    }
+
+    return arena;
+}
+
+void* oe_allocate_ecall_buffer(size_t size)
+{
+    ecall_arena_t* arena = _get_ecall_arena();
+
+    /* The arena size and offset are multiples of the alignment, so the
+     * rounded-up size also fits. */
+    if (arena && size && size <= arena->size - arena->offset)
+    {
+        uint8_t* buffer = _ecall_arena_data(arena) + arena->offset;
+
+        arena->offset +=
+            oe_round_up_to_multiple(size, ECALL_ARENA_ALIGNMENT);
+        arena->count++;
+        return buffer;
+    }
+
+    return malloc(size);
+}
+
+void oe_free_ecall_buffer(void* buffer)
+{
+    ecall_arena_t* arena = NULL;
+    uint8_t* data;
+
+    if (!buffer)
+        return;
+
+    if (_ecall_arena_key_created)
+        arena = (ecall_arena_t*)oe_thread_getspecific(_ecall_arena_key);
+
+    if (arena)
+    {
+        data = _ecall_arena_data(arena);
+
+        if ((uint8_t*)buffer >= data && (uint8_t*)buffer < data + arena->size)
+        {
+            if (--arena->count == 0)
+                arena->offset = 0;
+
+            return;
+        }
+    }
+
+    free(buffer);
+}
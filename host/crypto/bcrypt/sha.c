@@ -61,6 +61,31 @@ done:
     return result;
 }
 
+oe_result_t oe_sha256_copy(
+    oe_sha256_context_t* dest,
+    const oe_sha256_context_t* src)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_sha256_context_impl_t* dest_impl = (oe_sha256_context_impl_t*)dest;
+    const oe_sha256_context_impl_t* src_impl =
+        (const oe_sha256_context_impl_t*)src;
+
+    if (!dest || !src)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    NTSTATUS status = BCryptDuplicateHash(
+        src_impl->handle, &dest_impl->handle, NULL, 0, 0);
+
+    if (!BCRYPT_SUCCESS(status))
+        OE_RAISE_MSG(
+            OE_CRYPTO_ERROR, "BCryptDuplicateHash failed (err=%#x)\n", status);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 oe_result_t oe_sha256_final(oe_sha256_context_t* context, OE_SHA256* sha256)
 {
     oe_result_t result = OE_UNEXPECTED;
@@ -81,3 +106,30 @@ oe_result_t oe_sha256_final(oe_sha256_context_t* context, OE_SHA256* sha256)
 done:
     return result;
 }
+
+oe_result_t oe_sha256_free(oe_sha256_context_t* context)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_sha256_context_impl_t* impl = (oe_sha256_context_impl_t*)context;
+
+    if (!context)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (impl->handle)
+    {
+        NTSTATUS status = BCryptDestroyHash(impl->handle);
+
+        if (!BCRYPT_SUCCESS(status))
+            OE_RAISE_MSG(
+                OE_CRYPTO_ERROR,
+                "BCryptDestroyHash failed (err=%#x)\n",
+                status);
+
+        impl->handle = NULL;
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
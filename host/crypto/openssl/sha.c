@@ -54,6 +54,24 @@ done:
     return result;
 }
 
+oe_result_t oe_sha256_copy(
+    oe_sha256_context_t* dest,
+    const oe_sha256_context_t* src)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!dest || !src)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* The OpenSSL context holds no pointers, so it is copied as is */
+    memcpy(dest, src, sizeof(oe_sha256_context_impl_t));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 oe_result_t oe_sha256_final(oe_sha256_context_t* context, OE_SHA256* sha256)
 {
     oe_result_t result = OE_UNEXPECTED;
@@ -70,3 +88,17 @@ oe_result_t oe_sha256_final(oe_sha256_context_t* context, OE_SHA256* sha256)
 done:
     return result;
 }
+
+oe_result_t oe_sha256_free(oe_sha256_context_t* context)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!context)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* The OpenSSL context holds no resources */
+    result = OE_OK;
+
+done:
+    return result;
+}
@@ -171,10 +171,12 @@ int oe_mutex_destroy(oe_mutex* mutex);
  * a key for accessing it.
  *
  * @param key Set this key to refer to the newly allocated TSD entry.
+ * @param destructor If not null, called with the non-null value of the entry
+ *        when a thread exits.
  *
  * @return Returns zero on success.
  */
-int oe_thread_key_create(oe_thread_key* key);
+int oe_thread_key_create(oe_thread_key* key, void (*destructor)(void* value));
 
 /**
  * Delete a key for accessing thread-specific data.
@@ -82,9 +82,9 @@ int oe_mutex_destroy(oe_mutex* Lock)
 **==============================================================================
 */
 
-int oe_thread_key_create(oe_thread_key* key)
+int oe_thread_key_create(oe_thread_key* key, void (*destructor)(void* value))
 {
-    return pthread_key_create(key, NULL);
+    return pthread_key_create(key, destructor);
 }
 
 int oe_thread_key_delete(oe_thread_key key)
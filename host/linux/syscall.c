@@ -11,13 +11,17 @@
 #include <openenclave/internal/syscall/types.h>
 #include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/poll.h>
+#include <sys/sendfile.h>
 #include <sys/signal.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/uio.h>
 #include <sys/utsname.h>
 #include <unistd.h>
@@ -152,6 +156,150 @@ oe_off_t oe_syscall_lseek_ocall(oe_host_fd_t fd, oe_off_t offset, int whence)
     return lseek((int)fd, offset, whence);
 }
 
+ssize_t oe_syscall_pread_ocall(
+    oe_host_fd_t fd,
+    void* buf,
+    size_t count,
+    oe_off_t offset)
+{
+    errno = 0;
+
+    return pread((int)fd, buf, count, offset);
+}
+
+ssize_t oe_syscall_pwrite_ocall(
+    oe_host_fd_t fd,
+    const void* buf,
+    size_t count,
+    oe_off_t offset)
+{
+    errno = 0;
+
+    return pwrite((int)fd, buf, count, offset);
+}
+
+ssize_t oe_syscall_preadv_ocall(
+    oe_host_fd_t fd,
+    void* iov_buf,
+    int iovcnt,
+    size_t iov_buf_size,
+    oe_off_t offset)
+{
+    struct oe_iovec* iov = (struct oe_iovec*)iov_buf;
+    ssize_t ret = -1;
+    ssize_t size_read;
+
+    OE_UNUSED(iov_buf_size);
+
+    errno = 0;
+
+    if ((!iov && iovcnt) || iovcnt < 0 || iovcnt > OE_IOV_MAX)
+    {
+        errno = EINVAL;
+        goto done;
+    }
+
+    /* Handle zero data case. */
+    if (!iov || iovcnt == 0)
+    {
+        ret = 0;
+        goto done;
+    }
+
+    {
+        _relocate_iov_bases(iov, iovcnt, (ptrdiff_t)iov_buf);
+
+        size_read = preadv((int)fd, (struct iovec*)iov, iovcnt, offset);
+
+        _relocate_iov_bases(iov, iovcnt, -(ptrdiff_t)iov_buf);
+    }
+
+    ret = size_read;
+
+done:
+    return ret;
+}
+
+ssize_t oe_syscall_pwritev_ocall(
+    oe_host_fd_t fd,
+    const void* iov_buf,
+    int iovcnt,
+    size_t iov_buf_size,
+    oe_off_t offset)
+{
+    ssize_t ret = -1;
+    ssize_t size_written;
+    struct oe_iovec* iov = (struct oe_iovec*)iov_buf;
+
+    OE_UNUSED(iov_buf_size);
+
+    errno = 0;
+
+    if ((!iov && iovcnt) || iovcnt < 0 || iovcnt > OE_IOV_MAX)
+    {
+        errno = EINVAL;
+        goto done;
+    }
+
+    /* Handle zero data case. */
+    if (!iov || iovcnt == 0)
+    {
+        ret = 0;
+        goto done;
+    }
+
+    _relocate_iov_bases(iov, iovcnt, (ptrdiff_t)iov_buf);
+    size_written = pwritev((int)fd, (struct iovec*)iov, iovcnt, offset);
+
+    ret = size_written;
+
+done:
+    return ret;
+}
+
+ssize_t oe_syscall_sendfile_ocall(
+    oe_host_fd_t out_fd,
+    oe_host_fd_t in_fd,
+    oe_off_t* offset,
+    size_t count)
+{
+    errno = 0;
+
+    return sendfile((int)out_fd, (int)in_fd, (off_t*)offset, count);
+}
+
+ssize_t oe_syscall_copy_file_range_ocall(
+    oe_host_fd_t fd_in,
+    oe_off_t* off_in,
+    oe_host_fd_t fd_out,
+    oe_off_t* off_out,
+    size_t len,
+    unsigned int flags)
+{
+    errno = 0;
+
+    /* Older C libraries have no copy_file_range() wrapper. */
+#if defined(SYS_copy_file_range)
+    return syscall(
+        SYS_copy_file_range,
+        (int)fd_in,
+        (loff_t*)off_in,
+        (int)fd_out,
+        (loff_t*)off_out,
+        len,
+        flags);
+#else
+    OE_UNUSED(fd_in);
+    OE_UNUSED(off_in);
+    OE_UNUSED(fd_out);
+    OE_UNUSED(off_out);
+    OE_UNUSED(len);
+    OE_UNUSED(flags);
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
 int oe_syscall_close_ocall(oe_host_fd_t fd)
 {
     errno = 0;
@@ -792,175 +940,90 @@ int oe_syscall_kill_ocall(int pid, int signum)
 **==============================================================================
 */
 
-#define GETADDRINFO_HANDLE_MAGIC 0xed11d13a
-
-typedef struct _getaddrinfo_handle
-{
-    uint32_t magic;
-    struct addrinfo* res;
-    struct addrinfo* next;
-} getaddrinfo_handle_t;
-
-static getaddrinfo_handle_t* _cast_getaddrinfo_handle(void* handle_)
+/* The size of the record for an addrinfo structure. */
+static size_t _addrinfo_record_size(const struct addrinfo* p)
 {
-    getaddrinfo_handle_t* handle = (getaddrinfo_handle_t*)handle_;
+    size_t size = sizeof(struct oe_addrinfo_record) + p->ai_addrlen;
 
-    if (!handle || handle->magic != GETADDRINFO_HANDLE_MAGIC || !handle->res)
-        return NULL;
+    if (p->ai_canonname)
+        size += strlen(p->ai_canonname) + 1;
 
-    return handle;
+    return (size + OE_ADDRINFO_RECORD_ALIGN - 1) &
+           ~((size_t)OE_ADDRINFO_RECORD_ALIGN - 1);
 }
 
-int oe_syscall_getaddrinfo_open_ocall(
+int oe_syscall_getaddrinfo_ocall(
     const char* node,
     const char* service,
     const struct oe_addrinfo* hints,
-    uint64_t* handle_out)
+    void* buf,
+    size_t buf_size,
+    size_t* buf_size_out)
 {
     int ret = EAI_FAIL;
-    getaddrinfo_handle_t* handle = NULL;
+    struct addrinfo* res = NULL;
+    size_t size = 0;
 
     errno = 0;
 
-    if (handle_out)
-        *handle_out = 0;
+    if (buf_size_out)
+        *buf_size_out = 0;
 
-    if (!handle_out)
+    if (!buf_size_out || (!buf && buf_size))
     {
         ret = EAI_SYSTEM;
         errno = EINVAL;
         goto done;
     }
 
-    if (!(handle = calloc(1, sizeof(getaddrinfo_handle_t))))
-    {
-        ret = EAI_MEMORY;
-        goto done;
-    }
-
-    ret =
-        getaddrinfo(node, service, (const struct addrinfo*)hints, &handle->res);
-
-    if (ret == 0)
-    {
-        handle->magic = GETADDRINFO_HANDLE_MAGIC;
-        handle->next = handle->res;
-        *handle_out = (uint64_t)handle;
-        handle = NULL;
-    }
-
-done:
-
-    if (handle)
-        free(handle);
-
-    return ret;
-}
+    ret = getaddrinfo(node, service, (const struct addrinfo*)hints, &res);
 
-int oe_syscall_getaddrinfo_read_ocall(
-    uint64_t handle_,
-    int* ai_flags,
-    int* ai_family,
-    int* ai_socktype,
-    int* ai_protocol,
-    oe_socklen_t ai_addrlen_in,
-    oe_socklen_t* ai_addrlen,
-    struct oe_sockaddr* ai_addr,
-    size_t ai_canonnamelen_in,
-    size_t* ai_canonnamelen,
-    char* ai_canonname)
-{
-    int ret = -1;
-    getaddrinfo_handle_t* handle = _cast_getaddrinfo_handle((void*)handle_);
+    if (ret != 0)
+        goto done;
 
-    errno = 0;
+    for (const struct addrinfo* p = res; p; p = p->ai_next)
+        size += _addrinfo_record_size(p);
 
-    if (!handle || !ai_flags || !ai_family || !ai_socktype || !ai_protocol ||
-        !ai_addrlen || !ai_canonnamelen)
-    {
-        errno = EINVAL;
-        goto done;
-    }
+    /* The enclave calls again with a buffer of this size. */
+    *buf_size_out = size;
 
-    if (!ai_addr && ai_addrlen_in)
+    if (size > buf_size)
     {
-        errno = EINVAL;
+        ret = EAI_OVERFLOW;
         goto done;
     }
 
-    if (!ai_canonname && ai_canonnamelen_in)
-    {
-        errno = EINVAL;
-        goto done;
-    }
+    memset(buf, 0, size);
 
-    if (handle->next)
+    for (const struct addrinfo* p = res; p; p = p->ai_next)
     {
-        struct addrinfo* p = handle->next;
+        struct oe_addrinfo_record* record = (struct oe_addrinfo_record*)buf;
+        uint8_t* data = (uint8_t*)(record + 1);
 
-        *ai_flags = p->ai_flags;
-        *ai_family = p->ai_family;
-        *ai_socktype = p->ai_socktype;
-        *ai_protocol = p->ai_protocol;
-        *ai_addrlen = p->ai_addrlen;
+        record->ai_flags = p->ai_flags;
+        record->ai_family = p->ai_family;
+        record->ai_socktype = p->ai_socktype;
+        record->ai_protocol = p->ai_protocol;
+        record->ai_addrlen = p->ai_addrlen;
+        memcpy(data, p->ai_addr, p->ai_addrlen);
 
         if (p->ai_canonname)
-            *ai_canonnamelen = strlen(p->ai_canonname) + 1;
-        else
-            *ai_canonnamelen = 0;
-
-        if (*ai_addrlen > ai_addrlen_in)
-        {
-            errno = ENAMETOOLONG;
-            goto done;
-        }
-
-        if (*ai_canonnamelen > ai_canonnamelen_in)
         {
-            errno = ENAMETOOLONG;
-            goto done;
+            record->ai_canonnamelen = (uint32_t)strlen(p->ai_canonname) + 1;
+            memcpy(
+                data + p->ai_addrlen,
+                p->ai_canonname,
+                record->ai_canonnamelen);
         }
 
-        memcpy(ai_addr, p->ai_addr, *ai_addrlen);
-
-        if (p->ai_canonname)
-            memcpy(ai_canonname, p->ai_canonname, *ai_canonnamelen);
-
-        handle->next = handle->next->ai_next;
-
-        ret = 0;
-        goto done;
-    }
-    else
-    {
-        /* Done */
-        ret = 1;
-        goto done;
+        buf = (uint8_t*)buf + _addrinfo_record_size(p);
     }
 
 done:
-    return ret;
-}
-
-int oe_syscall_getaddrinfo_close_ocall(uint64_t handle_)
-{
-    int ret = -1;
-    getaddrinfo_handle_t* handle = _cast_getaddrinfo_handle((void*)handle_);
-
-    errno = 0;
-
-    if (!handle)
-    {
-        errno = EINVAL;
-        goto done;
-    }
 
-    freeaddrinfo(handle->res);
-    free(handle);
-
-    ret = 0;
+    if (res)
+        freeaddrinfo(res);
 
-done:
     return ret;
 }
 
@@ -986,16 +1049,22 @@ int oe_syscall_getnameinfo_ocall(
 **==============================================================================
 */
 
-#define MAX_EPOLLS 64
 #define WAKEFD_MAGIC 0x8700666859244b71
+#define EPOLL_REGISTRY_MIN_BUCKETS 16
 
+/* Each epoll instance created by the enclave watches an eventfd that
+ * oe_syscall_epoll_wake_ocall() signals to interrupt its waiters. The
+ * instances are found by their epoll descriptor in a hash table that
+ * doubles its number of buckets as it fills up. */
 typedef struct _epoll
 {
+    struct _epoll* next;
     int epfd;
-    int wakefds[2];
+    int wakefd;
 } epoll_t;
 
-static epoll_t _epolls[MAX_EPOLLS];
+static epoll_t** _epoll_buckets;
+static size_t _num_epoll_buckets;
 static size_t _num_epolls;
 static pthread_spinlock_t _epolls_lock;
 static pthread_once_t _epolls_once = PTHREAD_ONCE_INIT;
@@ -1005,11 +1074,77 @@ static void _init_epolls_lock(void)
     pthread_spin_init(&_epolls_lock, PTHREAD_PROCESS_PRIVATE);
 }
 
+static size_t _epoll_bucket(int epfd, size_t num_buckets)
+{
+    return (size_t)(unsigned int)epfd & (num_buckets - 1);
+}
+
+/* Double the number of buckets. Called with _epolls_lock held. */
+static int _grow_epoll_registry(void)
+{
+    size_t num_buckets = _num_epoll_buckets * 2;
+    epoll_t** buckets;
+
+    if (num_buckets < EPOLL_REGISTRY_MIN_BUCKETS)
+        num_buckets = EPOLL_REGISTRY_MIN_BUCKETS;
+
+    if (!(buckets = (epoll_t**)calloc(num_buckets, sizeof(epoll_t*))))
+        return -1;
+
+    for (size_t i = 0; i < _num_epoll_buckets; i++)
+    {
+        epoll_t* next;
+
+        for (epoll_t* epoll = _epoll_buckets[i]; epoll; epoll = next)
+        {
+            const size_t index = _epoll_bucket(epoll->epfd, num_buckets);
+
+            next = epoll->next;
+            epoll->next = buckets[index];
+            buckets[index] = epoll;
+        }
+    }
+
+    free(_epoll_buckets);
+    _epoll_buckets = buckets;
+    _num_epoll_buckets = num_buckets;
+
+    return 0;
+}
+
+/* Return the wake descriptor of an epoll instance, or -1 if the instance
+ * was not created by oe_syscall_epoll_create1_ocall(). */
+static int _get_epoll_wakefd(int epfd)
+{
+    int wakefd = -1;
+
+    pthread_spin_lock(&_epolls_lock);
+
+    if (_num_epoll_buckets)
+    {
+        const size_t index = _epoll_bucket(epfd, _num_epoll_buckets);
+
+        for (epoll_t* epoll = _epoll_buckets[index]; epoll; epoll = epoll->next)
+        {
+            if (epoll->epfd == epfd)
+            {
+                wakefd = epoll->wakefd;
+                break;
+            }
+        }
+    }
+
+    pthread_spin_unlock(&_epolls_lock);
+
+    return wakefd;
+}
+
 oe_host_fd_t oe_syscall_epoll_create1_ocall(int flags)
 {
     int ret = -1;
     int epfd = -1;
-    int wakefds[2] = {-1, -1};
+    int wakefd = -1;
+    epoll_t* epoll = NULL;
     errno = 0;
 
     pthread_once(&_epolls_once, _init_epolls_lock);
@@ -1017,7 +1152,7 @@ oe_host_fd_t oe_syscall_epoll_create1_ocall(int flags)
     if ((epfd = epoll_create1(flags)) == -1)
         goto done;
 
-    if (pipe(wakefds) == -1)
+    if ((wakefd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1)
         goto done;
 
     /* Watch for events on the wake file descriptor. */
@@ -1028,24 +1163,35 @@ oe_host_fd_t oe_syscall_epoll_create1_ocall(int flags)
         event.events = EPOLLIN;
         event.data.u64 = WAKEFD_MAGIC;
 
-        if ((epoll_ctl(epfd, EPOLL_CTL_ADD, wakefds[0], &event)) == -1)
+        if ((epoll_ctl(epfd, EPOLL_CTL_ADD, wakefd, &event)) == -1)
             goto done;
     }
 
-    /* Inject entry for this epoll into the epolls array. */
+    if (!(epoll = (epoll_t*)malloc(sizeof(epoll_t))))
+    {
+        errno = ENOMEM;
+        goto done;
+    }
+
+    epoll->epfd = epfd;
+    epoll->wakefd = wakefd;
+
+    /* Add this epoll instance to the registry. */
     {
+        size_t index;
+
         pthread_spin_lock(&_epolls_lock);
 
-        if (_num_epolls == MAX_EPOLLS)
+        if (_num_epolls >= _num_epoll_buckets && _grow_epoll_registry() != 0)
         {
             errno = ENOMEM;
             pthread_spin_unlock(&_epolls_lock);
             goto done;
         }
 
-        _epolls[_num_epolls].epfd = epfd;
-        _epolls[_num_epolls].wakefds[0] = wakefds[0];
-        _epolls[_num_epolls].wakefds[1] = wakefds[1];
+        index = _epoll_bucket(epfd, _num_epoll_buckets);
+        epoll->next = _epoll_buckets[index];
+        _epoll_buckets[index] = epoll;
         _num_epolls++;
 
         pthread_spin_unlock(&_epolls_lock);
@@ -1053,19 +1199,18 @@ oe_host_fd_t oe_syscall_epoll_create1_ocall(int flags)
 
     ret = epfd;
     epfd = -1;
-    wakefds[0] = -1;
-    wakefds[1] = -1;
+    wakefd = -1;
+    epoll = NULL;
 
 done:
 
     if (epfd != -1)
         close(epfd);
 
-    if (wakefds[0] != -1)
-        close(wakefds[0]);
+    if (wakefd != -1)
+        close(wakefd);
 
-    if (wakefds[1] != -1)
-        close(wakefds[1]);
+    free(epoll);
 
     return ret;
 }
@@ -1102,27 +1247,11 @@ int oe_syscall_epoll_wait_ocall(
         }
     }
 
-    /* Read the word that oe_syscall_epoll_wake_ocall() wrote. */
+    /* Reset the counter that oe_syscall_epoll_wake_ocall() incremented. */
     if (found_wake_event)
     {
-        int fd = -1;
-        uint64_t c;
-
-        /* Find the read descriptor for the wakefds[] pipe. */
-        {
-            pthread_spin_lock(&_epolls_lock);
-
-            for (size_t i = 0; i < _num_epolls; i++)
-            {
-                if (_epolls[i].epfd == epfd)
-                {
-                    fd = _epolls[i].wakefds[0];
-                    break;
-                }
-            }
-
-            pthread_spin_unlock(&_epolls_lock);
-        }
+        const int fd = _get_epoll_wakefd((int)epfd);
+        uint64_t count;
 
         if (fd == -1)
         {
@@ -1130,7 +1259,9 @@ int oe_syscall_epoll_wait_ocall(
             goto done;
         }
 
-        if (read(fd, &c, sizeof(c)) != sizeof(c) || c != WAKEFD_MAGIC)
+        /* Another waiter may have reset the counter already */
+        if (read(fd, &count, sizeof(count)) != sizeof(count) &&
+            errno != EAGAIN)
         {
             goto done;
         }
@@ -1150,34 +1281,27 @@ done:
     return ret;
 }
 
-int oe_syscall_epoll_wake_ocall(void)
+int oe_syscall_epoll_wake_ocall(int64_t epfd)
 {
     int ret = -1;
-    int fd = -1;
+    int fd;
+    const uint64_t count = 1;
+
+    errno = 0;
 
     pthread_once(&_epolls_once, _init_epolls_lock);
 
-    /* Find the write end of the wake pipe. */
+    if ((fd = _get_epoll_wakefd((int)epfd)) == -1)
     {
-        pthread_spin_lock(&_epolls_lock);
-
-        for (size_t i = 0; i < _num_epolls; i++)
-        {
-            fd = _epolls[i].wakefds[1];
-            break;
-        }
-
-        pthread_spin_unlock(&_epolls_lock);
+        errno = EBADF;
+        goto done;
     }
 
-    if (fd != -1)
-    {
-        const uint64_t c = WAKEFD_MAGIC;
-
-        if (write(fd, &c, sizeof(c)) != sizeof(c))
-            goto done;
-    }
+    /* EAGAIN means the counter is saturated, so a wakeup is pending */
+    if (write(fd, &count, sizeof(count)) != sizeof(count) && errno != EAGAIN)
+        goto done;
 
+    errno = 0;
     ret = 0;
 
 done:
@@ -1195,38 +1319,78 @@ int oe_syscall_epoll_ctl_ocall(
     return epoll_ctl((int)epfd, op, (int)fd, (struct epoll_event*)event);
 }
 
+int oe_syscall_epoll_ctl_wait_ocall(
+    int64_t epfd,
+    struct oe_epoll_change* changes,
+    size_t num_changes,
+    struct oe_epoll_event* events,
+    unsigned int maxevents,
+    int timeout)
+{
+    /* Apply the changes in order, recording the result of each. */
+    for (size_t i = 0; i < num_changes; i++)
+    {
+        struct oe_epoll_change* change = &changes[i];
+
+        errno = 0;
+
+        if (epoll_ctl(
+                (int)epfd,
+                change->op,
+                (int)change->fd,
+                (struct epoll_event*)&change->event) == 0)
+            change->error = 0;
+        else
+            change->error = errno;
+    }
+
+    /* The enclave flushes a full change list without waiting. */
+    if (maxevents == 0)
+    {
+        errno = 0;
+        return 0;
+    }
+
+    return oe_syscall_epoll_wait_ocall(epfd, events, maxevents, timeout);
+}
+
 int oe_syscall_epoll_close_ocall(oe_host_fd_t epfd)
 {
-    int fd0 = -1;
-    int fd1 = -1;
+    epoll_t* epoll = NULL;
     errno = 0;
 
     pthread_once(&_epolls_once, _init_epolls_lock);
 
-    /* Close both ends of the wakefd pipe and remove the epoll_t struct. */
+    /* Remove the epoll instance from the registry. */
     {
         pthread_spin_lock(&_epolls_lock);
 
-        for (size_t i = 0; i < _num_epolls; i++)
+        if (_num_epoll_buckets)
         {
-            if (_epolls[i].epfd == epfd)
+            const size_t index =
+                _epoll_bucket((int)epfd, _num_epoll_buckets);
+
+            for (epoll_t** link = &_epoll_buckets[index]; *link;
+                 link = &(*link)->next)
             {
-                fd0 = _epolls[i].wakefds[0];
-                fd1 = _epolls[i].wakefds[1];
-                _epolls[i] = _epolls[_num_epolls - 1];
-                _num_epolls--;
-                break;
+                if ((*link)->epfd == epfd)
+                {
+                    epoll = *link;
+                    *link = epoll->next;
+                    _num_epolls--;
+                    break;
+                }
             }
         }
 
         pthread_spin_unlock(&_epolls_lock);
     }
 
-    if (fd0 != -1)
-        close(fd0);
-
-    if (fd1 != -1)
-        close(fd1);
+    if (epoll)
+    {
+        close(epoll->wakefd);
+        free(epoll);
+    }
 
     return close((int)epfd);
 }
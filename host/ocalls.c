@@ -8,6 +8,10 @@
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/trace.h>
 
+#if defined(__x86_64__) || defined(_M_X64)
+#include "sgx/enclave.h"
+#endif
+
 #include "ocalls.h"
 #include "tee_u.h"
 
@@ -32,6 +36,22 @@ void oe_log_ocall(uint32_t log_level, const char* message)
     oe_log_message(true, (oe_log_level_t)log_level, message);
 }
 
+void oe_log_flush_ocall(void)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    /* Drain only the rings of the calling enclave (enclaves have no rings
+     * on other architectures) */
+    ThreadBinding* binding = GetThreadBinding();
+    oe_enclave_t* enclave = NULL;
+
+    if (binding)
+        enclave = oe_query_enclave_instance((void*)binding->tcs);
+
+    if (enclave)
+        oe_log_enclave_flush(enclave);
+#endif
+}
+
 void oe_write_ocall(int device, const char* str, size_t maxlen)
 {
     if (str && (device == 0 || device == 1))
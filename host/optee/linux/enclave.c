@@ -524,6 +524,20 @@ oe_result_t oe_ecall(
         result = _handle_call_enclave_function(
             enclave, (oe_call_enclave_function_args_t*)arg_in);
     }
+    else if (func == OE_ECALL_CALL_ENCLAVE_FUNCTIONS)
+    {
+        /* Each call is a separate invocation of the TA */
+        oe_call_enclave_functions_args_t* args =
+            (oe_call_enclave_functions_args_t*)arg_in;
+
+        for (size_t i = 0; i < args->num_calls; i++)
+        {
+            args->calls[i].result =
+                _handle_call_enclave_function(enclave, &args->calls[i]);
+        }
+
+        result = OE_OK;
+    }
     else
     {
         result = _handle_call_builtin_function(enclave, func, arg_in, arg_out);
@@ -564,3 +578,15 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
 done:
     return result;
 }
+
+oe_result_t oe_set_enclave_pool_size(
+    const char* path,
+    uint32_t flags,
+    size_t count)
+{
+    OE_UNUSED(path);
+    OE_UNUSED(flags);
+    OE_UNUSED(count);
+
+    return OE_UNSUPPORTED;
+}
@@ -98,4 +98,8 @@ uint32_t oe_remove_enclave_instance(oe_enclave_t* enclave);
 #ifndef __ASSEMBLER__
 oe_enclave_t* oe_query_enclave_instance(void* tcs);
 #endif
+
+#ifndef __ASSEMBLER__
+void oe_set_enclave_index_enabled(bool enabled);
+#endif
 #endif /* _ASMDEFS_H */
@@ -59,7 +59,7 @@ static oe_thread_key _thread_binding_key;
 #if defined(USE_TLS_FOR_THREADING_BINDING)
 static void _create_thread_binding_key(void)
 {
-    oe_thread_key_create(&_thread_binding_key);
+    oe_thread_key_create(&_thread_binding_key, NULL);
 }
 #endif
 
@@ -359,7 +359,9 @@ static const char* oe_ecall_str(oe_func_t ecall)
         "DESTRUCTOR",
         "INIT_ENCLAVE",
         "CALL_ENCLAVE_FUNCTION",
-        "VIRTUAL_EXCEPTION_HANDLER"
+        "VIRTUAL_EXCEPTION_HANDLER",
+        "RELEASE_THREAD_LOCALS",
+        "CALL_ENCLAVE_FUNCTIONS"
     };
     // clang-format on
 
@@ -563,6 +565,30 @@ int __oe_dispatch_ocall(
 **==============================================================================
 */
 
+/* Bind the calling host thread to an available ThreadBinding (the enclave
+ * lock must be held) */
+static void* _bind_tcs(
+    oe_enclave_t* enclave,
+    ThreadBinding* binding,
+    oe_thread thread)
+{
+    void* tcs = (void*)binding->tcs;
+
+    binding->flags |= _OE_THREAD_BUSY;
+    binding->thread = thread;
+    binding->count = 1;
+
+    /* Set into TSD so asynchronous exceptions can get it */
+    _set_thread_binding(binding);
+    assert(GetThreadBinding() == binding);
+
+    /* Notify the debugger runtime */
+    if (enclave->debug && enclave->debug_enclave != NULL)
+        oe_debug_push_thread_binding(enclave->debug_enclave, (sgx_tcs_t*)tcs);
+
+    return tcs;
+}
+
 static void* _assign_tcs(oe_enclave_t* enclave)
 {
     void* tcs = NULL;
@@ -598,19 +624,7 @@ static void* _assign_tcs(oe_enclave_t* enclave)
 
                 if (!(binding->flags & _OE_THREAD_BUSY))
                 {
-                    binding->flags |= _OE_THREAD_BUSY;
-                    binding->thread = thread;
-                    binding->count = 1;
-                    tcs = (void*)binding->tcs;
-
-                    /* Set into TSD so asynchronous exceptions can get it */
-                    _set_thread_binding(binding);
-                    assert(GetThreadBinding() == binding);
-
-                    /* Notify the debugger runtime */
-                    if (enclave->debug && enclave->debug_enclave != NULL)
-                        oe_debug_push_thread_binding(
-                            enclave->debug_enclave, (sgx_tcs_t*)tcs);
+                    tcs = _bind_tcs(enclave, binding, thread);
                     break;
                 }
             }
@@ -740,6 +754,78 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** oe_release_thread_locals()
+**
+**     Perform an OE_ECALL_RELEASE_THREAD_LOCALS ECALL on every available
+**     enclave thread context, in turn. Enclaves that keep their thread-local
+**     storage across ECALLs destroy it on return from this ECALL. This has
+**     to happen on each thread context (rather than in the destructor ECALL)
+**     since thread-local destructors run on the thread that owns the storage.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_release_thread_locals(oe_enclave_t* enclave)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_thread thread = oe_thread_self();
+
+    if (!enclave)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* The calling thread must not already be bound to a thread context */
+    if (GetThreadBinding())
+        OE_RAISE(OE_UNEXPECTED);
+
+    for (size_t i = 0; i < enclave->num_bindings; i++)
+    {
+        ThreadBinding* binding = &enclave->bindings[i];
+        void* tcs = NULL;
+        oe_code_t code_out = 0;
+        uint16_t func_out = 0;
+        uint16_t result_out = 0;
+        uint64_t arg_out = 0;
+
+        /* Skip thread contexts that are in use */
+        oe_mutex_lock(&enclave->lock);
+        if (!(binding->flags & _OE_THREAD_BUSY))
+            tcs = _bind_tcs(enclave, binding, thread);
+        oe_mutex_unlock(&enclave->lock);
+
+        if (!tcs)
+            continue;
+
+        result = _do_eenter(
+            enclave,
+            tcs,
+            OE_AEP_ADDRESS,
+            OE_CODE_ECALL,
+            OE_ECALL_RELEASE_THREAD_LOCALS,
+            0,
+            &code_out,
+            &func_out,
+            &result_out,
+            &arg_out);
+
+        _release_tcs(enclave, tcs);
+
+        OE_CHECK(result);
+
+        if (code_out != OE_CODE_ERET)
+            OE_RAISE(OE_UNEXPECTED);
+
+        OE_CHECK((oe_result_t)result_out);
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 /*
 **==============================================================================
 **
@@ -5,6 +5,7 @@
 
 #if defined(__linux__)
 #include <errno.h>
+#include <pthread.h>
 #include <sys/mman.h>
 
 #define get_fullpath(path) realpath(path, NULL)
@@ -48,6 +49,8 @@ static char* get_fullpath(const char* path)
 #include <openenclave/internal/trace.h>
 #include <openenclave/internal/utils.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 #include "../memalign.h"
 #include "cpuid.h"
 #include "enclave.h"
@@ -87,8 +90,8 @@ static oe_result_t _add_filled_pages(
     bool extend)
 {
     oe_page_t page;
+    const uint64_t flags = SGX_SECINFO_REG | SGX_SECINFO_R | SGX_SECINFO_W;
     oe_result_t result = OE_UNEXPECTED;
-    size_t i;
 
     /* Reject invalid parameters */
     if (!context || !enclave_addr || !vaddr)
@@ -107,16 +110,15 @@ static oe_result_t _add_filled_pages(
         memset(&page, 0, sizeof(page));
 
     /* Add the pages */
-    for (i = 0; i < npages; i++)
-    {
-        uint64_t addr = enclave_addr + *vaddr;
-        uint64_t src = (uint64_t)&page;
-        uint64_t flags = SGX_SECINFO_REG | SGX_SECINFO_R | SGX_SECINFO_W;
-
-        OE_CHECK(oe_sgx_load_enclave_data(
-            context, enclave_addr, addr, src, flags, extend));
-        (*vaddr) += OE_PAGE_SIZE;
-    }
+    OE_CHECK(oe_sgx_load_enclave_pages(
+        context,
+        enclave_addr,
+        enclave_addr + *vaddr,
+        (uint64_t)&page,
+        npages,
+        flags,
+        extend));
+    (*vaddr) += npages * OE_PAGE_SIZE;
 
     result = OE_OK;
 
@@ -428,6 +430,17 @@ oe_result_t oe_sgx_validate_enclave_properties(
         goto done;
     }
 
+    if (!oe_sgx_is_valid_config_flags(properties->config.flags))
+    {
+        if (field_name)
+            *field_name = "config.flags";
+        OE_TRACE_ERROR(
+            "oe_sgx_is_valid_config_flags failed: flags = %x\n",
+            properties->config.flags);
+        result = OE_FAILURE;
+        goto done;
+    }
+
     if (!oe_sgx_is_valid_num_heap_pages(
             properties->header.size_settings.num_heap_pages))
     {
@@ -492,6 +505,354 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** Enclave image cache
+**
+**     The images loaded to create enclaves are kept, keyed by the full path,
+**     device, inode, modification time (to the nanosecond where available)
+**     and size of their file, so that creating another enclave from an
+**     unchanged file does not read and parse it again.
+**     Building an enclave patches its image, so a cached image is used by
+**     one build at a time, and the properties it was loaded with are put
+**     back before each build.
+**
+**     Measurement-only builds (as done to sign an enclave) also keep the
+**     measurement prefix of the image (see oe_sgx_load_context_t) in a table
+**     keyed by the file and the enclave size, so that measuring the image
+**     again with other properties, such as another heap size or number of
+**     TCSs, starts from the saved hash state. The table is shared by all the
+**     cached images of a file, as concurrent builds each take their own.
+**
+**==============================================================================
+*/
+
+#define OE_IMAGE_CACHE_SIZE 8
+#define OE_MEASUREMENT_PREFIXES 16
+
+/* The version of an image file that an image was loaded from */
+typedef struct _image_file_id
+{
+    uint64_t dev;
+    uint64_t ino;
+    int64_t mtime;
+    int64_t mtime_nsec;
+    int64_t size;
+} image_file_id_t;
+
+typedef struct _image_cache_entry
+{
+    struct _image_cache_entry* next;
+    char* path;
+    image_file_id_t id;
+    bool in_use;
+    oe_enclave_image_t image;
+    oe_sgx_enclave_properties_t properties;
+} image_cache_entry_t;
+
+typedef struct _measurement_prefix
+{
+    /* The full path of the image file, or null if unused */
+    char* path;
+    image_file_id_t id;
+
+    /* The size that ECREATE was measured with */
+    uint64_t enclave_size;
+    size_t num_pages;
+    oe_sha256_context_t hash_context;
+} measurement_prefix_t;
+
+/* Both guarded by _image_cache_lock */
+static image_cache_entry_t* _image_cache;
+static measurement_prefix_t _measurement_prefixes[OE_MEASUREMENT_PREFIXES];
+static size_t _next_measurement_prefix;
+static oe_mutex _image_cache_lock = OE_H_MUTEX_INITIALIZER;
+
+static void _get_image_file_id(const struct stat* st, image_file_id_t* id)
+{
+    id->dev = (uint64_t)st->st_dev;
+    id->ino = (uint64_t)st->st_ino;
+    id->mtime = (int64_t)st->st_mtime;
+#if defined(__linux__)
+    id->mtime_nsec = (int64_t)st->st_mtim.tv_nsec;
+#else
+    id->mtime_nsec = 0;
+#endif
+    id->size = (int64_t)st->st_size;
+}
+
+static bool _same_image_file_id(
+    const image_file_id_t* id1,
+    const image_file_id_t* id2)
+{
+    return id1->dev == id2->dev && id1->ino == id2->ino &&
+           id1->mtime == id2->mtime && id1->mtime_nsec == id2->mtime_nsec &&
+           id1->size == id2->size;
+}
+
+static void _free_image_cache_entry(image_cache_entry_t* entry)
+{
+    oe_unload_enclave_image(&entry->image);
+    free(entry->path);
+    free(entry);
+}
+
+/* Take an idle cached image of the file, or load and cache a new one. Returns
+ * null if the image cannot be cached, in which case the caller loads it. */
+static image_cache_entry_t* _acquire_cached_image(const char* path)
+{
+    image_cache_entry_t* entry = NULL;
+    image_cache_entry_t* stale = NULL;
+    image_cache_entry_t** link;
+    char* fullpath = NULL;
+    struct stat st;
+    image_file_id_t id;
+
+    if (stat(path, &st) != 0 || !(fullpath = get_fullpath(path)))
+        goto done;
+
+    _get_image_file_id(&st, &id);
+
+    oe_mutex_lock(&_image_cache_lock);
+
+    for (link = &_image_cache; *link;)
+    {
+        image_cache_entry_t* p = *link;
+
+        if (strcmp(p->path, fullpath) == 0 && !p->in_use)
+        {
+            if (!_same_image_file_id(&p->id, &id))
+            {
+                /* The file changed since this image was loaded */
+                *link = p->next;
+                p->next = stale;
+                stale = p;
+                continue;
+            }
+
+            if (!entry)
+            {
+                /* Move the entry to the front of the list */
+                *link = p->next;
+                entry = p;
+                continue;
+            }
+        }
+
+        link = &p->next;
+    }
+
+    if (entry)
+    {
+        entry->in_use = true;
+        entry->next = _image_cache;
+        _image_cache = entry;
+    }
+
+    oe_mutex_unlock(&_image_cache_lock);
+
+    while (stale)
+    {
+        image_cache_entry_t* next = stale->next;
+        _free_image_cache_entry(stale);
+        stale = next;
+    }
+
+    if (!entry)
+    {
+        if (!(entry = (image_cache_entry_t*)calloc(1, sizeof(*entry))))
+            goto done;
+
+        if (oe_load_enclave_image(path, &entry->image) != OE_OK)
+        {
+            free(entry);
+            entry = NULL;
+            goto done;
+        }
+
+        memcpy(
+            &entry->properties,
+            entry->image.image_base + entry->image.oeinfo_rva,
+            sizeof(entry->properties));
+        entry->path = fullpath;
+        entry->id = id;
+        entry->in_use = true;
+        fullpath = NULL;
+
+        oe_mutex_lock(&_image_cache_lock);
+        entry->next = _image_cache;
+        _image_cache = entry;
+        oe_mutex_unlock(&_image_cache_lock);
+    }
+    else
+    {
+        /* Undo the patching done by the previous build */
+        memcpy(
+            entry->image.image_base + entry->image.oeinfo_rva,
+            &entry->properties,
+            sizeof(entry->properties));
+    }
+
+done:
+    free(fullpath);
+    return entry;
+}
+
+/* Return an image taken by _acquire_cached_image(). The images of failed
+ * builds are dropped, and so are the least recently used idle images when
+ * the cache is full. */
+static void _release_cached_image(image_cache_entry_t* entry, bool keep)
+{
+    image_cache_entry_t* evicted = NULL;
+    image_cache_entry_t** link;
+    size_t count = 0;
+
+    oe_mutex_lock(&_image_cache_lock);
+
+    entry->in_use = false;
+
+    for (link = &_image_cache; *link;)
+    {
+        image_cache_entry_t* p = *link;
+
+        if (!p->in_use &&
+            ((p == entry && !keep) || count >= OE_IMAGE_CACHE_SIZE))
+        {
+            *link = p->next;
+            p->next = evicted;
+            evicted = p;
+            continue;
+        }
+
+        count++;
+        link = &p->next;
+    }
+
+    oe_mutex_unlock(&_image_cache_lock);
+
+    while (evicted)
+    {
+        image_cache_entry_t* next = evicted->next;
+        _free_image_cache_entry(evicted);
+        evicted = next;
+    }
+}
+
+/* Restore the measurement prefix saved for the image and enclave size, if
+ * any. Otherwise have the build save it, and set *save. Called after ECREATE
+ * is measured, with the image taken from the cache. */
+static oe_result_t _begin_measurement_prefix(
+    const image_cache_entry_t* entry,
+    oe_sgx_load_context_t* context,
+    uint64_t enclave_size,
+    bool* save)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const oe_enclave_image_t* image = &entry->image;
+    bool locked = false;
+
+    *save = false;
+
+    context->prefix.enabled = true;
+    context->prefix.oeinfo_start =
+        oe_round_down_to_page_size(image->oeinfo_rva);
+    context->prefix.oeinfo_end = oe_round_up_to_page_size(
+        image->oeinfo_rva + sizeof(oe_sgx_enclave_properties_t));
+
+    oe_mutex_lock(&_image_cache_lock);
+    locked = true;
+
+    for (size_t i = 0; i < OE_MEASUREMENT_PREFIXES; i++)
+    {
+        const measurement_prefix_t* p = &_measurement_prefixes[i];
+
+        if (p->path && p->enclave_size == enclave_size &&
+            _same_image_file_id(&p->id, &entry->id) &&
+            strcmp(p->path, entry->path) == 0)
+        {
+            /* Replace the hash of ECREATE with the saved one */
+            OE_CHECK(oe_sha256_free(&context->hash_context));
+            OE_CHECK(oe_sha256_copy(&context->hash_context, &p->hash_context));
+            context->prefix.num_pages = p->num_pages;
+            context->prefix.complete = true;
+            result = OE_OK;
+            goto done;
+        }
+    }
+
+    *save = true;
+    result = OE_OK;
+
+done:
+    if (locked)
+        oe_mutex_unlock(&_image_cache_lock);
+
+    return result;
+}
+
+/* Keep the measurement prefix saved by a build, if it succeeded, in place of
+ * the least recently saved one. */
+static void _end_measurement_prefix(
+    const image_cache_entry_t* entry,
+    oe_sgx_load_context_t* context,
+    uint64_t enclave_size,
+    bool keep)
+{
+    measurement_prefix_t* prefix = NULL;
+    char* path = NULL;
+
+    if (!context->prefix.complete)
+        return;
+
+    if (keep && !(path = oe_strdup(entry->path)))
+        keep = false;
+
+    oe_mutex_lock(&_image_cache_lock);
+
+    /* A concurrent build of the same image may have kept it already */
+    for (size_t i = 0; keep && i < OE_MEASUREMENT_PREFIXES; i++)
+    {
+        const measurement_prefix_t* p = &_measurement_prefixes[i];
+
+        if (p->path && p->enclave_size == enclave_size &&
+            _same_image_file_id(&p->id, &entry->id) &&
+            strcmp(p->path, entry->path) == 0)
+        {
+            keep = false;
+        }
+    }
+
+    if (keep)
+    {
+        prefix = &_measurement_prefixes[_next_measurement_prefix];
+        _next_measurement_prefix =
+            (_next_measurement_prefix + 1) % OE_MEASUREMENT_PREFIXES;
+
+        if (prefix->path)
+        {
+            oe_sha256_free(&prefix->hash_context);
+            free(prefix->path);
+        }
+
+        /* The table takes over the hash state of the build */
+        prefix->path = path;
+        prefix->id = entry->id;
+        prefix->enclave_size = enclave_size;
+        prefix->num_pages = context->prefix.num_pages;
+        prefix->hash_context = context->prefix.hash_context;
+        path = NULL;
+    }
+
+    oe_mutex_unlock(&_image_cache_lock);
+
+    if (!keep)
+        oe_sha256_free(&context->prefix.hash_context);
+
+    memset(&context->prefix.hash_context, 0, sizeof(oe_sha256_context_t));
+    free(path);
+}
+
 oe_result_t oe_sgx_build_enclave(
     oe_sgx_load_context_t* context,
     const char* path,
@@ -503,10 +864,12 @@ oe_result_t oe_sgx_build_enclave(
     size_t enclave_size = 0;
     uint64_t enclave_addr = 0;
     oe_enclave_image_t oeimage;
+    image_cache_entry_t* cached_image = NULL;
     void* ecall_data = NULL;
     size_t image_size;
     uint64_t vaddr = 0;
     oe_sgx_enclave_properties_t props;
+    bool save_prefix = false;
 
     memset(&oeimage, 0, sizeof(oeimage));
 
@@ -527,8 +890,12 @@ oe_result_t oe_sgx_build_enclave(
     if (!context || !path || !enclave)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    /* Load the elf object */
-    if (oe_load_enclave_image(path, &oeimage) != OE_OK)
+    /* Load the elf object, or take it from the image cache */
+    cached_image = _acquire_cached_image(path);
+
+    if (cached_image)
+        oeimage = cached_image->image;
+    else if (oe_load_enclave_image(path, &oeimage) != OE_OK)
         OE_RAISE(OE_FAILURE);
 
     // If the **properties** parameter is non-null, use those properties.
@@ -574,6 +941,9 @@ oe_result_t oe_sgx_build_enclave(
     // Set the XFRM field
     props.config.xfrm = context->attributes.xfrm;
 
+    enclave->persistent_thread_locals =
+        (props.config.flags & OE_SGX_CONFIG_PERSISTENT_THREAD_LOCALS) != 0;
+
     /* Calculate the size of image */
     OE_CHECK(oeimage.calculate_size(&oeimage, &image_size));
 
@@ -584,6 +954,11 @@ oe_result_t oe_sgx_build_enclave(
     /* Perform the ECREATE operation */
     OE_CHECK(oe_sgx_create_enclave(context, enclave_size, &enclave_addr));
 
+    /* Reuse or save the measurement prefix of the image */
+    if (cached_image && context->type == OE_SGX_LOAD_TYPE_MEASURE)
+        OE_CHECK(_begin_measurement_prefix(
+            cached_image, context, enclave_size, &save_prefix));
+
     /* Save the enclave base address, size, and text address */
     enclave->addr = enclave_addr;
     enclave->size = enclave_size;
@@ -620,7 +995,14 @@ done:
     if (ecall_data)
         free(ecall_data);
 
-    oe_unload_enclave_image(&oeimage);
+    if (save_prefix)
+        _end_measurement_prefix(
+            cached_image, context, enclave_size, result == OE_OK);
+
+    if (cached_image)
+        _release_cached_image(cached_image, result == OE_OK);
+    else
+        oe_unload_enclave_image(&oeimage);
 
     return result;
 }
@@ -640,12 +1022,9 @@ done:
 **     - Obtains a launch token (EINITKEY) from the Intel(R) launch enclave (LE)
 **        for EINIT.
 */
-oe_result_t oe_create_enclave(
+static oe_result_t _create_enclave(
     const char* enclave_path,
-    oe_enclave_type_t enclave_type,
     uint32_t flags,
-    const void* config,
-    uint32_t config_size,
     const oe_ocall_func_t* ocall_table,
     uint32_t ocall_table_size,
     oe_enclave_t** enclave_out)
@@ -656,16 +1035,6 @@ oe_result_t oe_create_enclave(
 
     _initialize_enclave_host();
 
-    if (enclave_out)
-        *enclave_out = NULL;
-
-    /* Check parameters */
-    if (!enclave_path || !enclave_out ||
-        ((enclave_type != OE_ENCLAVE_TYPE_SGX) &&
-         (enclave_type != OE_ENCLAVE_TYPE_AUTO)) ||
-        (flags & OE_ENCLAVE_FLAG_RESERVED) || config || config_size > 0)
-        OE_RAISE(OE_INVALID_PARAMETER);
-
     /* Allocate and zero-fill the enclave structure */
     if (!(enclave = (oe_enclave_t*)calloc(1, sizeof(oe_enclave_t))))
         OE_RAISE(OE_OUT_OF_MEMORY);
@@ -770,6 +1139,393 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** Enclave pools
+**
+**     A pool keeps enclaves built and initialized ahead of time for an
+**     enclave image and creation flags (see oe_set_enclave_pool_size()).
+**     The first oe_create_enclave() call for the image gives the pool its
+**     OCALL table; the pool then hands out its enclaves to the calls made
+**     with that table. Each enclave handed out is replaced by a host thread
+**     that builds a new one. The builder threads are joined once done, and
+**     shrinking a pool waits for all of them. Enclaves built from an image
+**     file that changed since are terminated instead of handed out.
+**
+**==============================================================================
+*/
+
+typedef enum _enclave_pool_builder_state
+{
+    OE_ENCLAVE_POOL_BUILDER_FREE,
+    OE_ENCLAVE_POOL_BUILDER_RUNNING,
+    OE_ENCLAVE_POOL_BUILDER_DONE,
+    OE_ENCLAVE_POOL_BUILDER_JOINING,
+} enclave_pool_builder_state_t;
+
+typedef struct _enclave_pool_builder
+{
+    struct _enclave_pool* pool;
+    enclave_pool_builder_state_t state;
+#if defined(_WIN32)
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+} enclave_pool_builder_t;
+
+typedef struct _pooled_enclave
+{
+    oe_enclave_t* enclave;
+
+    /* The version of the image file the enclave was built from */
+    image_file_id_t id;
+} pooled_enclave_t;
+
+typedef struct _enclave_pool
+{
+    struct _enclave_pool* next;
+    char* path;
+    uint32_t flags;
+    bool has_ocall_table;
+    const oe_ocall_func_t* ocall_table;
+    uint32_t ocall_table_size;
+
+    /* Number of enclaves to keep ready */
+    size_t count;
+
+    /* Number of enclaves being built */
+    size_t pending;
+
+    pooled_enclave_t enclaves[OE_MAX_ENCLAVE_POOL_SIZE];
+    size_t num_enclaves;
+
+    /* The threads building enclaves, not yet joined */
+    enclave_pool_builder_t builders[OE_MAX_ENCLAVE_POOL_SIZE];
+} enclave_pool_t;
+
+/* Pools are never freed, so the threads refilling them can use them after
+ * the lock is released */
+static enclave_pool_t* _enclave_pools;
+static oe_mutex _enclave_pools_lock = OE_H_MUTEX_INITIALIZER;
+
+static enclave_pool_t* _find_enclave_pool(const char* fullpath, uint32_t flags)
+{
+    for (enclave_pool_t* pool = _enclave_pools; pool; pool = pool->next)
+    {
+        if (pool->flags == flags && strcmp(pool->path, fullpath) == 0)
+            return pool;
+    }
+
+    return NULL;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI _enclave_pool_thread(LPVOID arg)
+#else
+static void* _enclave_pool_thread(void* arg)
+#endif
+{
+    enclave_pool_builder_t* builder = (enclave_pool_builder_t*)arg;
+    enclave_pool_t* pool = builder->pool;
+    oe_enclave_t* enclave = NULL;
+    struct stat st;
+    image_file_id_t id = {0};
+
+    /* The path, flags and OCALL table of a pool do not change once set. The
+     * file is identified before it is loaded, so that a change made during
+     * the build makes the enclave stale. */
+    if (stat(pool->path, &st) != 0 ||
+        _create_enclave(
+            pool->path,
+            pool->flags,
+            pool->ocall_table,
+            pool->ocall_table_size,
+            &enclave) != OE_OK)
+        enclave = NULL;
+
+    if (enclave)
+        _get_image_file_id(&st, &id);
+
+    oe_mutex_lock(&_enclave_pools_lock);
+    pool->pending--;
+    if (enclave && pool->num_enclaves < pool->count)
+    {
+        pool->enclaves[pool->num_enclaves].enclave = enclave;
+        pool->enclaves[pool->num_enclaves].id = id;
+        pool->num_enclaves++;
+        enclave = NULL;
+    }
+    oe_mutex_unlock(&_enclave_pools_lock);
+
+    /* The pool was shrunk while the enclave was being built */
+    if (enclave)
+        oe_terminate_enclave(enclave);
+
+    oe_mutex_lock(&_enclave_pools_lock);
+    if (builder->state == OE_ENCLAVE_POOL_BUILDER_RUNNING)
+        builder->state = OE_ENCLAVE_POOL_BUILDER_DONE;
+    oe_mutex_unlock(&_enclave_pools_lock);
+
+#if defined(_WIN32)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static void _join_enclave_pool_builder(enclave_pool_builder_t* builder)
+{
+#if defined(_WIN32)
+    WaitForSingleObject(builder->thread, INFINITE);
+    CloseHandle(builder->thread);
+#else
+    pthread_join(builder->thread, NULL);
+#endif
+}
+
+/* Join the builders that are done, and start building the enclaves missing
+ * from the pool. Called with _enclave_pools_lock held. */
+static void _refill_enclave_pool(enclave_pool_t* pool)
+{
+    enclave_pool_builder_t* builder = pool->builders;
+    enclave_pool_builder_t* end = builder + OE_MAX_ENCLAVE_POOL_SIZE;
+
+    for (enclave_pool_builder_t* b = pool->builders; b != end; b++)
+    {
+        /* These only have to return */
+        if (b->state == OE_ENCLAVE_POOL_BUILDER_DONE)
+        {
+            _join_enclave_pool_builder(b);
+            b->state = OE_ENCLAVE_POOL_BUILDER_FREE;
+        }
+    }
+
+    if (!pool->has_ocall_table)
+        return;
+
+    while (pool->num_enclaves + pool->pending < pool->count)
+    {
+        /* Builders being joined by oe_set_enclave_pool_size() may still
+         * hold the slots */
+        while (builder != end && builder->state != OE_ENCLAVE_POOL_BUILDER_FREE)
+            builder++;
+
+        if (builder == end)
+            break;
+
+        builder->pool = pool;
+        builder->state = OE_ENCLAVE_POOL_BUILDER_RUNNING;
+
+#if defined(_WIN32)
+        builder->thread =
+            CreateThread(NULL, 0, _enclave_pool_thread, builder, 0, NULL);
+
+        if (!builder->thread)
+#else
+        if (pthread_create(
+                &builder->thread, NULL, _enclave_pool_thread, builder) != 0)
+#endif
+        {
+            builder->state = OE_ENCLAVE_POOL_BUILDER_FREE;
+            break;
+        }
+
+        pool->pending++;
+    }
+}
+
+/* Take a ready enclave from the pool of the given image and flags, if any.
+ * Enclaves built from an earlier version of the image file are terminated
+ * and rebuilt. */
+static oe_enclave_t* _take_pooled_enclave(
+    const char* enclave_path,
+    uint32_t flags,
+    const oe_ocall_func_t* ocall_table,
+    uint32_t ocall_table_size)
+{
+    oe_enclave_t* enclave = NULL;
+    enclave_pool_t* pool = NULL;
+    char* fullpath = NULL;
+    struct stat st;
+    image_file_id_t id = {0};
+    bool have_id = false;
+    oe_enclave_t* stale[OE_MAX_ENCLAVE_POOL_SIZE];
+    size_t num_stale = 0;
+
+    if (stat(enclave_path, &st) == 0)
+    {
+        _get_image_file_id(&st, &id);
+        have_id = true;
+    }
+
+    oe_mutex_lock(&_enclave_pools_lock);
+
+    if (_enclave_pools && (fullpath = get_fullpath(enclave_path)))
+        pool = _find_enclave_pool(fullpath, flags);
+
+    if (pool && !pool->has_ocall_table)
+    {
+        pool->ocall_table = ocall_table;
+        pool->ocall_table_size = ocall_table_size;
+        pool->has_ocall_table = true;
+    }
+
+    if (pool && pool->ocall_table == ocall_table &&
+        pool->ocall_table_size == ocall_table_size)
+    {
+        while (!enclave && pool->num_enclaves > 0)
+        {
+            pooled_enclave_t* p = &pool->enclaves[--pool->num_enclaves];
+
+            if (have_id && _same_image_file_id(&p->id, &id))
+                enclave = p->enclave;
+            else
+                stale[num_stale++] = p->enclave;
+        }
+
+        _refill_enclave_pool(pool);
+    }
+
+    oe_mutex_unlock(&_enclave_pools_lock);
+
+    for (size_t i = 0; i < num_stale; i++)
+        oe_terminate_enclave(stale[i]);
+
+    free(fullpath);
+
+    return enclave;
+}
+
+oe_result_t oe_set_enclave_pool_size(
+    const char* enclave_path,
+    uint32_t flags,
+    size_t count)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    enclave_pool_t* pool;
+    char* fullpath = NULL;
+    oe_enclave_t* excess[OE_MAX_ENCLAVE_POOL_SIZE];
+    size_t num_excess = 0;
+    enclave_pool_builder_t* joining[OE_MAX_ENCLAVE_POOL_SIZE];
+    size_t num_joining = 0;
+    bool locked = false;
+
+    if (!enclave_path || (flags & OE_ENCLAVE_FLAG_RESERVED) ||
+        count > OE_MAX_ENCLAVE_POOL_SIZE)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!(fullpath = get_fullpath(enclave_path)))
+        OE_RAISE(OE_NOT_FOUND);
+
+    oe_mutex_lock(&_enclave_pools_lock);
+    locked = true;
+
+    if (!(pool = _find_enclave_pool(fullpath, flags)))
+    {
+        if (!(pool = (enclave_pool_t*)calloc(1, sizeof(enclave_pool_t))))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        pool->path = fullpath;
+        pool->flags = flags;
+        fullpath = NULL;
+
+        pool->next = _enclave_pools;
+        _enclave_pools = pool;
+    }
+
+    /* Wait for the enclaves being built for a larger pool. They are
+     * terminated if the pool is full once built. */
+    if (count < pool->count)
+    {
+        for (size_t i = 0; i < OE_MAX_ENCLAVE_POOL_SIZE; i++)
+        {
+            enclave_pool_builder_t* builder = &pool->builders[i];
+
+            if (builder->state == OE_ENCLAVE_POOL_BUILDER_RUNNING ||
+                builder->state == OE_ENCLAVE_POOL_BUILDER_DONE)
+            {
+                builder->state = OE_ENCLAVE_POOL_BUILDER_JOINING;
+                joining[num_joining++] = builder;
+            }
+        }
+    }
+
+    pool->count = count;
+
+    if (num_joining)
+    {
+        oe_mutex_unlock(&_enclave_pools_lock);
+
+        for (size_t i = 0; i < num_joining; i++)
+            _join_enclave_pool_builder(joining[i]);
+
+        oe_mutex_lock(&_enclave_pools_lock);
+
+        for (size_t i = 0; i < num_joining; i++)
+            joining[i]->state = OE_ENCLAVE_POOL_BUILDER_FREE;
+    }
+
+    /* Another call may have changed the size meanwhile */
+    while (pool->num_enclaves > pool->count)
+        excess[num_excess++] = pool->enclaves[--pool->num_enclaves].enclave;
+
+    _refill_enclave_pool(pool);
+
+    result = OE_OK;
+
+done:
+    if (locked)
+        oe_mutex_unlock(&_enclave_pools_lock);
+
+    for (size_t i = 0; i < num_excess; i++)
+        oe_terminate_enclave(excess[i]);
+
+    free(fullpath);
+
+    return result;
+}
+
+oe_result_t oe_create_enclave(
+    const char* enclave_path,
+    oe_enclave_type_t enclave_type,
+    uint32_t flags,
+    const void* config,
+    uint32_t config_size,
+    const oe_ocall_func_t* ocall_table,
+    uint32_t ocall_table_size,
+    oe_enclave_t** enclave_out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (enclave_out)
+        *enclave_out = NULL;
+
+    /* Check parameters */
+    if (!enclave_path || !enclave_out ||
+        ((enclave_type != OE_ENCLAVE_TYPE_SGX) &&
+         (enclave_type != OE_ENCLAVE_TYPE_AUTO)) ||
+        (flags & OE_ENCLAVE_FLAG_RESERVED) || config || config_size > 0)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Hand out a pre-built enclave if this image has a pool */
+    if ((*enclave_out = _take_pooled_enclave(
+             enclave_path, flags, ocall_table, ocall_table_size)))
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    OE_CHECK(_create_enclave(
+        enclave_path, flags, ocall_table, ocall_table_size, enclave_out));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
 {
     oe_result_t result = OE_UNEXPECTED;
@@ -778,8 +1534,24 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
     if (!enclave || enclave->magic != ENCLAVE_MAGIC)
         OE_RAISE(OE_INVALID_PARAMETER);
 
+    /* Do not start the enclave threads still waiting for a thread context */
+    oe_cancel_enclave_threads(enclave);
+
+    /* Destroy the thread-local storage that the enclave threads kept across
+     * ECALLs before the global destructors run */
+    result = OE_OK;
+    if (enclave->persistent_thread_locals)
+        result = oe_release_thread_locals(enclave);
+
     /* Call the enclave destructor */
-    OE_CHECK(oe_ecall(enclave, OE_ECALL_DESTRUCTOR, 0, NULL));
+    if (result == OE_OK)
+        result = oe_ecall(enclave, OE_ECALL_DESTRUCTOR, 0, NULL);
+
+    /* Write what the enclave logged, even if it crashed or failed to release
+     * its thread-local storage, and stop collecting its log */
+    oe_log_enclave_fini(enclave);
+
+    OE_CHECK(result);
 
     if (enclave->debug_enclave)
     {
@@ -124,6 +124,14 @@ struct _oe_enclave
 
     /* Meta-data needed by debugrt  */
     oe_debug_enclave_t* debug_enclave;
+
+    /* Whether enclave threads keep their thread-local storage across ECALLs
+     * (OE_SGX_CONFIG_PERSISTENT_THREAD_LOCALS) */
+    bool persistent_thread_locals;
+
+    /* Threads of this enclave that the thread pool is in the middle of
+     * starting with oe_thread_start_ecall(), guarded by the pool lock */
+    size_t num_starting_threads;
 };
 
 // Static asserts for consistency with
@@ -146,4 +154,13 @@ OE_STATIC_ASSERT(
 /* Get the event for the given TCS */
 EnclaveEvent* GetEnclaveEvent(oe_enclave_t* enclave, uint64_t tcs);
 
+/* Release the thread-local storage kept by each idle enclave thread context
+ * (see OE_SGX_CONFIG_PERSISTENT_THREAD_LOCALS) */
+oe_result_t oe_release_thread_locals(oe_enclave_t* enclave);
+
+/* Drop the requests of the enclave to start threads (see oe_thread_create())
+ * that no host thread has taken yet, and wait for the threads that host
+ * threads are starting to return */
+void oe_cancel_enclave_threads(oe_enclave_t* enclave);
+
 #endif /* _OE_HOST_ENCLAVE_H */
@@ -5,8 +5,15 @@
 #include <openenclave/host.h>
 #include <openenclave/internal/queue.h>
 #include <openenclave/internal/trace.h>
+#include <stdlib.h>
 #include "enclave.h"
 
+#if defined(__linux__)
+#include <sched.h>
+#elif defined(_WIN32)
+#include <Windows.h>
+#endif
+
 static OE_LIST_HEAD(EnclaveListHead, _enclave_entry) oe_enclave_list_head;
 static oe_mutex oe_enclave_list_lock = OE_H_MUTEX_INITIALIZER;
 
@@ -16,6 +23,227 @@ typedef struct _enclave_entry
     oe_enclave_t* enclave;
 } EnclaveEntry;
 
+/*
+**==============================================================================
+**
+** Enclave address index
+**
+**     oe_query_enclave_instance() is called by the host exception handler for
+**     every asynchronous exit, possibly from signal context and from many
+**     threads at once. It must neither block nor allocate. Lookups therefore
+**     use an immutable array of the enclave address ranges sorted by base
+**     address, which is rebuilt under oe_enclave_list_lock whenever an
+**     enclave is added or removed, and published by swapping a pointer.
+**
+**     Readers announce themselves in one of two counters, selected by the
+**     current phase. After publishing a new index, the writer flips the phase
+**     twice, each time waiting for the counter of the previous phase to
+**     drain, before freeing the old index. New readers always register in
+**     the current phase, so writers cannot be starved. This also guarantees
+**     that an enclave found by a reader is not freed before the reader is
+**     done with it, since the enclave is removed from the index before it is
+**     terminated.
+**
+**==============================================================================
+*/
+
+typedef struct _enclave_range
+{
+    uint64_t start;
+    uint64_t end;
+    oe_enclave_t* enclave;
+} EnclaveRange;
+
+typedef struct _enclave_index
+{
+    size_t count;
+    EnclaveRange* ranges;
+} EnclaveIndex;
+
+static EnclaveIndex* volatile _enclave_index;
+
+/* Cleared by tests to exercise the fallback of oe_query_enclave_instance().
+ * Guarded by oe_enclave_list_lock. */
+static bool _index_enabled = true;
+
+#if defined(_WIN32)
+static volatile LONG64 _readers[2];
+static volatile LONG _reader_phase;
+#else
+static volatile int64_t _readers[2];
+static volatile int32_t _reader_phase;
+#endif
+
+static EnclaveIndex* _load_index(void)
+{
+#if defined(_WIN32)
+    return (EnclaveIndex*)InterlockedCompareExchangePointer(
+        (PVOID volatile*)&_enclave_index, NULL, NULL);
+#else
+    return __atomic_load_n(&_enclave_index, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static EnclaveIndex* _exchange_index(EnclaveIndex* index)
+{
+#if defined(_WIN32)
+    return (EnclaveIndex*)InterlockedExchangePointer(
+        (PVOID volatile*)&_enclave_index, index);
+#else
+    return __atomic_exchange_n(&_enclave_index, index, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static uint32_t _enter_reader(void)
+{
+#if defined(_WIN32)
+    uint32_t phase = (uint32_t)InterlockedOr(&_reader_phase, 0);
+    InterlockedIncrement64(&_readers[phase]);
+#else
+    uint32_t phase =
+        (uint32_t)__atomic_load_n(&_reader_phase, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&_readers[phase], 1, __ATOMIC_SEQ_CST);
+#endif
+    return phase;
+}
+
+static void _leave_reader(uint32_t phase)
+{
+#if defined(_WIN32)
+    InterlockedDecrement64(&_readers[phase]);
+#else
+    __atomic_sub_fetch(&_readers[phase], 1, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/* Flip the reader phase and wait for the readers of the previous phase */
+static void _flip_reader_phase(void)
+{
+#if defined(_WIN32)
+    LONG phase = InterlockedOr(&_reader_phase, 0);
+    InterlockedExchange(&_reader_phase, 1 - phase);
+
+    while (InterlockedOr64(&_readers[phase], 0) != 0)
+        SwitchToThread();
+#else
+    int32_t phase = __atomic_load_n(&_reader_phase, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&_reader_phase, 1 - phase, __ATOMIC_SEQ_CST);
+
+    while (__atomic_load_n(&_readers[phase], __ATOMIC_SEQ_CST) != 0)
+        sched_yield();
+#endif
+}
+
+/* Wait until no reader can still be using a previously published index. A
+ * reader may have sampled the phase before an earlier flip and registered in
+ * either counter, so both phases are drained in turn. */
+static void _wait_for_readers(void)
+{
+    _flip_reader_phase();
+    _flip_reader_phase();
+}
+
+static int _compare_ranges(const void* p1, const void* p2)
+{
+    const EnclaveRange* r1 = (const EnclaveRange*)p1;
+    const EnclaveRange* r2 = (const EnclaveRange*)p2;
+
+    if (r1->start < r2->start)
+        return -1;
+
+    return r1->start > r2->start ? 1 : 0;
+}
+
+/* Rebuild and publish the index. Called with oe_enclave_list_lock held. If
+ * the index is disabled or cannot be allocated, no index is published and
+ * lookups fall back to scanning the enclave list under the lock. */
+static void _update_index(void)
+{
+    EnclaveIndex* index = NULL;
+    EnclaveIndex* old_index = NULL;
+    EnclaveEntry* tmp;
+    size_t count = 0;
+
+    OE_LIST_FOREACH(tmp, &oe_enclave_list_head, next_entry)
+    {
+        count++;
+    }
+
+    /* Allocate the index and its ranges in one block */
+    if (_index_enabled)
+    {
+        index = (EnclaveIndex*)calloc(
+            1, sizeof(EnclaveIndex) + count * sizeof(EnclaveRange));
+        if (index == NULL)
+            OE_TRACE_ERROR("calloc for EnclaveIndex failed\n");
+    }
+
+    if (index)
+    {
+        index->ranges = (EnclaveRange*)(index + 1);
+
+        OE_LIST_FOREACH(tmp, &oe_enclave_list_head, next_entry)
+        {
+            EnclaveRange* range = &index->ranges[index->count++];
+
+            range->start = tmp->enclave->addr;
+            range->end = tmp->enclave->addr + tmp->enclave->size;
+            range->enclave = tmp->enclave;
+        }
+
+        qsort(
+            index->ranges,
+            index->count,
+            sizeof(EnclaveRange),
+            _compare_ranges);
+    }
+
+    old_index = _exchange_index(index);
+    _wait_for_readers();
+    free(old_index);
+}
+
+/* Find the enclave whose address range contains ADDR */
+static oe_enclave_t* _find_enclave(const EnclaveIndex* index, uint64_t addr)
+{
+    size_t lo = 0;
+    size_t hi = index->count;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        const EnclaveRange* range = &index->ranges[mid];
+
+        if (addr < range->start)
+            hi = mid;
+        else if (addr >= range->end)
+            lo = mid + 1;
+        else
+            return range->enclave;
+    }
+
+    return NULL;
+}
+
+/*
+**==============================================================================
+**
+** oe_set_enclave_index_enabled()
+**
+**     Enable or disable the enclave address index, for tests. While it is
+**     disabled, oe_query_enclave_instance() scans the enclave list.
+**
+**==============================================================================
+*/
+
+void oe_set_enclave_index_enabled(bool enabled)
+{
+    oe_mutex_lock(&oe_enclave_list_lock);
+    _index_enabled = enabled;
+    _update_index();
+    oe_mutex_unlock(&oe_enclave_list_lock);
+}
+
 /*
 **==============================================================================
 **
@@ -67,6 +295,9 @@ uint32_t oe_push_enclave_instance(oe_enclave_t* enclave)
     // Insert to the beginning of the list.
     OE_LIST_INSERT_HEAD(&oe_enclave_list_head, new_entry, next_entry);
 
+    // Make the enclave visible to oe_query_enclave_instance().
+    _update_index();
+
     // Return success.
     ret = 0;
 
@@ -125,6 +356,10 @@ uint32_t oe_remove_enclave_instance(oe_enclave_t* enclave)
         }
     }
 
+    // Stop handing out the enclave before it is terminated.
+    if (ret == 0)
+        _update_index();
+
 cleanup:
     if (locked)
     {
@@ -153,7 +388,8 @@ cleanup:
 **==============================================================================
 */
 
-oe_enclave_t* oe_query_enclave_instance(void* tcs)
+/* Find the owner of the TCS by scanning the enclave list under the lock */
+static oe_enclave_t* _query_enclave_instance_locked(void* tcs)
 {
     oe_enclave_t* ret = NULL;
     bool locked = false;
@@ -195,6 +431,40 @@ cleanup:
         }
     }
 
+    return ret;
+}
+
+oe_enclave_t* oe_query_enclave_instance(void* tcs)
+{
+    oe_enclave_t* ret = NULL;
+    EnclaveIndex* index;
+    uint32_t phase = _enter_reader();
+
+    // Find the enclave whose address range contains the TCS and check that
+    // the TCS is indeed one of its thread control structures.
+    if ((index = _load_index()))
+    {
+        oe_enclave_t* enclave = _find_enclave(index, (uint64_t)tcs);
+
+        if (enclave)
+        {
+            for (size_t i = 0; i < enclave->num_bindings; i++)
+            {
+                if (enclave->bindings[i].tcs == (uint64_t)tcs)
+                {
+                    ret = enclave;
+                    break;
+                }
+            }
+        }
+    }
+
+    _leave_reader(phase);
+
+    // No index was published (no enclave yet, or out of memory).
+    if (!index)
+        ret = _query_enclave_instance_locked(tcs);
+
     if (!ret)
         OE_TRACE_ERROR("tcs=0x%x\n", tcs);
 
@@ -692,6 +692,194 @@ static void _dump_load_enclave_data(
 
 #endif /* defined(OE_TRACE_MEASURE) */
 
+/* Set the access permissions of pages of a simulated enclave */
+static oe_result_t _protect_simulated_pages(
+    uint64_t addr,
+    size_t size,
+    uint64_t flags)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    int prot = _make_memory_protect_param(flags, true /*simulate*/);
+
+    if ((uint32_t)prot > OE_INT_MAX)
+        OE_RAISE_MSG(OE_FAILURE, "Unexpected page protections: %#x", prot);
+
+#if defined(__linux__)
+    if (mprotect((void*)addr, size, prot) != 0)
+        OE_RAISE_MSG(
+            OE_FAILURE, "mprotect failed (addr=%#x, prot=%#x)", addr, prot);
+#elif defined(_WIN32)
+    DWORD old;
+    if (!VirtualProtect((LPVOID)addr, size, prot, &old))
+        OE_RAISE_MSG(
+            OE_FAILURE,
+            "VirtualProtect failed (addr=%#x, prot=%#x)",
+            addr,
+            prot);
+#endif
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/* Add SIZE bytes of pages at ADDR, copied from SRC, to a hardware enclave */
+static oe_result_t _add_enclave_pages(
+    oe_sgx_load_context_t* context,
+    uint64_t addr,
+    uint64_t src,
+    size_t size,
+    uint64_t flags,
+    bool extend)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+#if defined(OE_USE_LIBSGX)
+
+    OE_UNUSED(context);
+
+    int protect = _make_memory_protect_param(flags, false /*not simulate*/);
+    if (!extend)
+        protect |= ENCLAVE_PAGE_UNVALIDATED;
+
+    uint32_t enclave_error;
+    if (enclave_load_data(
+            (void*)addr,
+            size,
+            (const void*)src,
+            (uint32_t)protect,
+            &enclave_error) != size)
+        OE_RAISE_MSG(
+            OE_PLATFORM_ERROR,
+            "enclave_load_data failed (addr=%#x, prot=%#x, err=%#x)",
+            addr,
+            protect,
+            enclave_error);
+
+#elif defined(__linux__)
+
+    /* Ask the Linux SGX driver to add the pages to the enclave. The driver
+       adds one page per request. sgxioctl internally traces any driver
+       returned error */
+    for (size_t offset = 0; offset < size; offset += OE_PAGE_SIZE)
+    {
+        if (sgx_ioctl_enclave_add_page(
+                context->dev, addr + offset, src + offset, flags, extend) != 0)
+            OE_RAISE(OE_IOCTL_FAILED);
+    }
+
+#elif defined(_WIN32)
+
+    OE_UNUSED(context);
+
+    /* Ask the OS to add the pages to the enclave */
+    SIZE_T num_bytes = 0;
+    DWORD enclave_error;
+
+    DWORD protect = _make_memory_protect_param(flags, false /*not simulate*/);
+    if (!extend)
+        protect |= PAGE_ENCLAVE_UNVALIDATED;
+
+    if (!LoadEnclaveData(
+            GetCurrentProcess(),
+            (LPVOID)addr,
+            (LPCVOID)src,
+            size,
+            protect,
+            NULL,
+            0,
+            &num_bytes,
+            &enclave_error))
+    {
+        OE_RAISE_MSG(
+            OE_PLATFORM_ERROR,
+            "LoadEnclaveData failed (addr=%#x, prot=%#x, err=%#x)",
+            addr,
+            protect,
+            enclave_error);
+    }
+
+#endif
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/* Check that [ADDR, ADDR+SIZE) lies within the simulated enclave */
+static bool _within_simulated_enclave(
+    const oe_sgx_load_context_t* context,
+    uint64_t addr,
+    size_t size)
+{
+    const uint64_t start = (uint64_t)context->sim.addr;
+
+    return addr >= start && size <= context->sim.size &&
+           addr - start <= context->sim.size - size;
+}
+
+static bool _is_zero_page(uint64_t src)
+{
+    const uint64_t* p = (const uint64_t*)src;
+
+    for (size_t i = 0; i < OE_PAGE_SIZE / sizeof(uint64_t); i++)
+    {
+        if (p[i])
+            return false;
+    }
+
+    return true;
+}
+
+/* Follow the measurement prefix of the image (see oe_sgx_load_context_t).
+ * Sets *measured if the page is part of a restored prefix, whose pages are
+ * already in the hash. */
+static oe_result_t _track_measurement_prefix(
+    oe_sgx_load_context_t* context,
+    uint64_t vaddr,
+    bool* measured)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    *measured = false;
+
+    if (!context->prefix.enabled)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    if (context->prefix.complete)
+    {
+        if (context->prefix.count < context->prefix.num_pages)
+        {
+            context->prefix.count++;
+            *measured = true;
+        }
+    }
+    else if (
+        vaddr >= context->prefix.oeinfo_start &&
+        vaddr < context->prefix.oeinfo_end)
+    {
+        /* Save the hash before the first page holding the properties */
+        OE_CHECK(oe_sha256_copy(
+            &context->prefix.hash_context, &context->hash_context));
+        context->prefix.num_pages = context->prefix.count;
+        context->prefix.complete = true;
+    }
+    else
+    {
+        context->prefix.count++;
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 oe_result_t oe_sgx_load_enclave_data(
     oe_sgx_load_context_t* context,
     uint64_t base,
@@ -701,8 +889,9 @@ oe_result_t oe_sgx_load_enclave_data(
     bool extend)
 {
     oe_result_t result = OE_UNEXPECTED;
+    bool measured = false;
 
-    if (!context || !base || !addr || !src || !flags)
+    if (!context || !base || !addr || !src || !flags || addr < base)
         OE_RAISE(OE_INVALID_PARAMETER);
 
     if (context->state != OE_SGX_LOAD_STATE_ENCLAVE_CREATED)
@@ -718,9 +907,14 @@ oe_result_t oe_sgx_load_enclave_data(
 
 #endif /* defined(OE_TRACE_MEASURE) */
 
+    OE_CHECK(_track_measurement_prefix(context, addr - base, &measured));
+
     /* Measure this operation */
-    OE_CHECK(oe_sgx_measure_load_enclave_data(
-        &context->hash_context, base, addr, src, flags, extend));
+    if (!measured)
+    {
+        OE_CHECK(oe_sgx_measure_load_enclave_data(
+            &context->hash_context, base, addr, src, flags, extend));
+    }
 
     if (context->type == OE_SGX_LOAD_TYPE_MEASURE)
     {
@@ -732,9 +926,7 @@ oe_result_t oe_sgx_load_enclave_data(
     {
         /* Simulate enclave add page */
         /* Verify that page is within enclave boundaries */
-        if ((void*)addr < context->sim.addr ||
-            (uint8_t*)addr >
-                (uint8_t*)context->sim.addr + context->sim.size - OE_PAGE_SIZE)
+        if (!_within_simulated_enclave(context, addr, OE_PAGE_SIZE))
             OE_RAISE_MSG(
                 OE_FAILURE, "Page is NOT within enclave boundaries", NULL);
 
@@ -743,97 +935,130 @@ oe_result_t oe_sgx_load_enclave_data(
             (uint8_t*)addr, OE_PAGE_SIZE, (uint8_t*)src, OE_PAGE_SIZE));
 
         /* Set page access permissions */
-        {
-            int prot = _make_memory_protect_param(flags, true /*simulate*/);
-
-            if ((uint32_t)prot > OE_INT_MAX)
-                OE_RAISE_MSG(
-                    OE_FAILURE, "Unexpected page protections: %#x", prot);
-
-#if defined(__linux__)
-            if (mprotect((void*)addr, OE_PAGE_SIZE, prot) != 0)
-                OE_RAISE_MSG(
-                    OE_FAILURE,
-                    "mprotect failed (addr=%#x, prot=%#x)",
-                    addr,
-                    prot);
-#elif defined(_WIN32)
-            DWORD old;
-            if (!VirtualProtect((LPVOID)addr, OE_PAGE_SIZE, prot, &old))
-                OE_RAISE_MSG(
-                    OE_FAILURE,
-                    "VirtualProtect failed (addr=%#x, prot=%#x)",
-                    addr,
-                    prot);
-#endif
-        }
+        OE_CHECK(_protect_simulated_pages(addr, OE_PAGE_SIZE, flags));
     }
     else
     {
-#if defined(OE_USE_LIBSGX)
+        OE_CHECK(_add_enclave_pages(
+            context, addr, src, OE_PAGE_SIZE, flags, extend));
+    }
 
-        int protect = _make_memory_protect_param(flags, false /*not simulate*/);
-        if (!extend)
-            protect |= ENCLAVE_PAGE_UNVALIDATED;
+    result = OE_OK;
 
-        uint32_t enclave_error;
-        if (enclave_load_data(
-                (void*)addr,
-                OE_PAGE_SIZE,
-                (const void*)src,
-                (uint32_t)protect,
-                &enclave_error) != OE_PAGE_SIZE)
-            OE_RAISE_MSG(
-                OE_PLATFORM_ERROR,
-                "enclave_load_data failed (addr=%#x, prot=%#x, err=%#x)",
-                addr,
-                protect,
-                enclave_error);
+done:
+    return result;
+}
 
-#elif defined(__linux__)
+/* The maximum number of pages handed to the platform in a single request by
+ * oe_sgx_load_enclave_pages() */
+#define OE_SGX_LOAD_CHUNK_PAGES 256
 
-        /* Ask the Linux SGX driver to add a page to the enclave
-           sgxioctl internally traces any driver returned error */
-        if (sgx_ioctl_enclave_add_page(
-                context->dev, addr, src, flags, extend) != 0)
-            OE_RAISE(OE_IOCTL_FAILED);
+oe_result_t oe_sgx_load_enclave_pages(
+    oe_sgx_load_context_t* context,
+    uint64_t base,
+    uint64_t addr,
+    uint64_t src,
+    size_t npages,
+    uint64_t flags,
+    bool extend)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint8_t* chunk = NULL;
+    uint64_t size;
 
-#elif defined(_WIN32)
+    if (!context || !base || !addr || !src || !flags)
+        OE_RAISE(OE_INVALID_PARAMETER);
 
-        /* Ask the OS to add a page to the enclave */
-        SIZE_T num_bytes = 0;
-        DWORD enclave_error;
+    if (context->state != OE_SGX_LOAD_STATE_ENCLAVE_CREATED)
+        OE_RAISE(OE_INVALID_PARAMETER);
 
-        DWORD protect =
-            _make_memory_protect_param(flags, false /*not simulate*/);
-        if (!extend)
-            protect |= PAGE_ENCLAVE_UNVALIDATED;
+    /* ADDR must be page aligned */
+    if (addr % OE_PAGE_SIZE)
+        OE_RAISE(OE_INVALID_PARAMETER);
 
-        if (!LoadEnclaveData(
-                GetCurrentProcess(),
-                (LPVOID)addr,
-                (LPCVOID)src,
-                OE_PAGE_SIZE,
-                protect,
-                NULL,
-                0,
-                &num_bytes,
-                &enclave_error))
-        {
+    OE_CHECK(oe_safe_mul_u64(npages, OE_PAGE_SIZE, &size));
+
+    /* Measure the pages. The measurement is defined per EADD and EEXTEND,
+     * so each page is still measured separately. */
+    for (size_t i = 0; i < npages; i++)
+    {
+        uint64_t page_addr = addr + i * OE_PAGE_SIZE;
+
+#if defined(OE_TRACE_MEASURE)
+
+        _dump_load_enclave_data(page_addr - base, flags, src, extend);
+
+#endif /* defined(OE_TRACE_MEASURE) */
+
+        OE_CHECK(oe_sgx_measure_load_enclave_data(
+            &context->hash_context, base, page_addr, src, flags, extend));
+    }
+
+    if (context->type == OE_SGX_LOAD_TYPE_MEASURE || npages == 0)
+    {
+        /* EADD has no further action in measurement mode */
+        result = OE_OK;
+        goto done;
+    }
+    else if (oe_sgx_is_simulation_load_context(context))
+    {
+        /* Verify that the pages are within enclave boundaries */
+        if (!_within_simulated_enclave(context, addr, size))
             OE_RAISE_MSG(
-                OE_PLATFORM_ERROR,
-                "LoadEnclaveData failed (addr=%#x, prot=%#x, err=%#x)",
-                addr,
-                protect,
-                enclave_error);
+                OE_FAILURE, "Pages are NOT within enclave boundaries", NULL);
+
+        /* The simulated enclave memory is freshly mapped and zero-filled,
+         * so zero pages are not copied (which also leaves them unpopulated
+         * until the enclave touches them) */
+        if (!_is_zero_page(src))
+        {
+            for (size_t i = 0; i < npages; i++)
+            {
+                OE_CHECK(oe_memcpy_s(
+                    (uint8_t*)addr + i * OE_PAGE_SIZE,
+                    OE_PAGE_SIZE,
+                    (uint8_t*)src,
+                    OE_PAGE_SIZE));
+            }
         }
 
-#endif
+        /* Set the access permissions of the whole range at once */
+        OE_CHECK(_protect_simulated_pages(addr, size, flags));
+    }
+    else
+    {
+        const size_t chunk_pages = npages < OE_SGX_LOAD_CHUNK_PAGES
+                                       ? npages
+                                       : OE_SGX_LOAD_CHUNK_PAGES;
+
+        /* Replicate the page into a chunk, so that each platform request
+         * adds many pages */
+        if (!(chunk = oe_memalign(OE_PAGE_SIZE, chunk_pages * OE_PAGE_SIZE)))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        for (size_t i = 0; i < chunk_pages; i++)
+            memcpy(chunk + i * OE_PAGE_SIZE, (void*)src, OE_PAGE_SIZE);
+
+        for (size_t i = 0; i < npages; i += chunk_pages)
+        {
+            size_t n = npages - i < chunk_pages ? npages - i : chunk_pages;
+
+            OE_CHECK(_add_enclave_pages(
+                context,
+                addr + i * OE_PAGE_SIZE,
+                (uint64_t)chunk,
+                n * OE_PAGE_SIZE,
+                flags,
+                extend));
+        }
     }
 
     result = OE_OK;
 
 done:
+    if (chunk)
+        oe_memalign_free(chunk);
+
     return result;
 }
 
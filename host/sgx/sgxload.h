@@ -37,6 +37,22 @@ oe_result_t oe_sgx_load_enclave_data(
     uint64_t flags,
     bool extend);
 
+/**
+ * Add a range of pages with identical contents and permissions to the enclave.
+ *
+ * This is equivalent to calling oe_sgx_load_enclave_data() for each of the
+ * **npages** pages starting at **addr**, with **src** pointing to the contents
+ * of a single page, but batches the work done by the platform.
+ */
+oe_result_t oe_sgx_load_enclave_pages(
+    oe_sgx_load_context_t* context,
+    uint64_t base,
+    uint64_t addr,
+    uint64_t src,
+    size_t npages,
+    uint64_t flags,
+    bool extend);
+
 oe_result_t oe_sgx_initialize_enclave(
     oe_sgx_load_context_t* context,
     uint64_t addr,
@@ -6,6 +6,7 @@
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/sgxtypes.h>
 #include <openenclave/internal/trace.h>
+#include <string.h>
 
 static void _measure_zeros(oe_sha256_context_t* context, size_t size)
 {
@@ -26,26 +27,40 @@ static void _measure_zeros(oe_sha256_context_t* context, size_t size)
     }
 }
 
+/* EEXTEND measures a page in 256-byte chunks, each preceded by a 64-byte
+ * header ("EEXTEND", the chunk offset and zero padding) */
+#define EEXTEND_CHUNK_SIZE 256
+#define EEXTEND_HEADER_SIZE 64
+#define EEXTEND_CHUNKS_PER_PAGE (OE_PAGE_SIZE / EEXTEND_CHUNK_SIZE)
+
 static void _measure_eextend(
     oe_sha256_context_t* context,
     uint64_t vaddr,
     uint64_t flags,
     const void* page)
 {
+    uint8_t buf[EEXTEND_CHUNKS_PER_PAGE *
+                (EEXTEND_HEADER_SIZE + EEXTEND_CHUNK_SIZE)];
+    uint8_t* p = buf;
     uint64_t pgoff = 0;
-    const uint64_t CHUNK_SIZE = 256;
     OE_UNUSED(flags);
 
-    /* Write this page one chunk at a time */
-    for (pgoff = 0; pgoff < OE_PAGE_SIZE; pgoff += CHUNK_SIZE)
+    /* Lay out the measured stream for the whole page so that it is hashed
+     * with a single update rather than several small ones per chunk */
+    for (pgoff = 0; pgoff < OE_PAGE_SIZE; pgoff += EEXTEND_CHUNK_SIZE)
     {
         const uint64_t moffset = vaddr + pgoff;
 
-        oe_sha256_update(context, "EEXTEND", 8);
-        oe_sha256_update(context, &moffset, sizeof(moffset));
-        _measure_zeros(context, 48);
-        oe_sha256_update(context, (const uint8_t*)page + pgoff, CHUNK_SIZE);
+        memcpy(p, "EEXTEND", 8);
+        memcpy(p + 8, &moffset, sizeof(moffset));
+        memset(p + 16, 0, EEXTEND_HEADER_SIZE - 16);
+        p += EEXTEND_HEADER_SIZE;
+
+        memcpy(p, (const uint8_t*)page + pgoff, EEXTEND_CHUNK_SIZE);
+        p += EEXTEND_CHUNK_SIZE;
     }
+
+    oe_sha256_update(context, buf, sizeof(buf));
 }
 
 oe_result_t oe_sgx_measure_create_enclave(
@@ -0,0 +1,291 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/trace.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#include "enclave.h"
+#include "sgx_u.h"
+
+/*
+**==============================================================================
+**
+** Enclave thread pool
+**
+**     Runs the threads the enclaves start with oe_thread_create_ocall(). A
+**     request is queued and taken by an idle worker, or by a new worker if
+**     none is idle. The worker enters the enclave with
+**     oe_thread_start_ecall() and retries while the enclave has no free
+**     thread context. Idle workers exit after OE_THREAD_POOL_IDLE_MSEC.
+**     oe_cancel_enclave_threads() drops the queued requests of an enclave
+**     and waits for the workers still in oe_thread_start_ecall() for it.
+**
+**==============================================================================
+*/
+
+#define OE_THREAD_POOL_IDLE_MSEC 1000
+#define OE_THREAD_POOL_RETRY_MSEC 1
+
+typedef struct _thread_request
+{
+    struct _thread_request* next;
+    oe_enclave_t* enclave;
+    uint64_t id;
+} thread_request_t;
+
+static thread_request_t* _queue_head;
+static thread_request_t* _queue_tail;
+static size_t _queue_length;
+static size_t _num_idle_workers;
+
+#if defined(_WIN32)
+static SRWLOCK _pool_lock = SRWLOCK_INIT;
+static CONDITION_VARIABLE _pool_cond = CONDITION_VARIABLE_INIT;
+static CONDITION_VARIABLE _started_cond = CONDITION_VARIABLE_INIT;
+#define _lock_pool() AcquireSRWLockExclusive(&_pool_lock)
+#define _unlock_pool() ReleaseSRWLockExclusive(&_pool_lock)
+#define _signal_pool() WakeConditionVariable(&_pool_cond)
+#define _wait_started() \
+    SleepConditionVariableSRW(&_started_cond, &_pool_lock, INFINITE, 0)
+#define _broadcast_started() WakeAllConditionVariable(&_started_cond)
+#else
+static pthread_mutex_t _pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _pool_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t _started_cond = PTHREAD_COND_INITIALIZER;
+#define _lock_pool() pthread_mutex_lock(&_pool_lock)
+#define _unlock_pool() pthread_mutex_unlock(&_pool_lock)
+#define _signal_pool() pthread_cond_signal(&_pool_cond)
+#define _wait_started() pthread_cond_wait(&_started_cond, &_pool_lock)
+#define _broadcast_started() pthread_cond_broadcast(&_started_cond)
+#endif
+
+/* Wait for a request to be queued. Returns false on timeout. Called with the
+ * pool lock held. */
+static bool _wait_for_request(void)
+{
+#if defined(_WIN32)
+    if (!SleepConditionVariableSRW(
+            &_pool_cond, &_pool_lock, OE_THREAD_POOL_IDLE_MSEC, 0))
+        return GetLastError() != ERROR_TIMEOUT;
+#else
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += OE_THREAD_POOL_IDLE_MSEC / 1000;
+
+    if (pthread_cond_timedwait(&_pool_cond, &_pool_lock, &deadline) ==
+        ETIMEDOUT)
+        return false;
+#endif
+
+    return true;
+}
+
+static void _sleep_msec(uint32_t msec)
+{
+#if defined(_WIN32)
+    Sleep(msec);
+#else
+    const struct timespec interval = {0, msec * 1000 * 1000};
+    nanosleep(&interval, NULL);
+#endif
+}
+
+/* Queue a request. Called with the pool lock held. */
+static void _push_request(thread_request_t* request)
+{
+    request->next = NULL;
+
+    if (_queue_tail)
+        _queue_tail->next = request;
+    else
+        _queue_head = request;
+
+    _queue_tail = request;
+    _queue_length++;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI _worker_thread(LPVOID arg)
+#else
+static void* _worker_thread(void* arg)
+#endif
+{
+    OE_UNUSED(arg);
+
+    _lock_pool();
+
+    for (;;)
+    {
+        thread_request_t* request;
+        oe_enclave_t* enclave;
+        oe_result_t result;
+
+        while (!_queue_head)
+        {
+            bool signaled;
+
+            _num_idle_workers++;
+            signaled = _wait_for_request();
+            _num_idle_workers--;
+
+            if (!signaled && !_queue_head)
+                goto done;
+        }
+
+        request = _queue_head;
+        if (!(_queue_head = request->next))
+            _queue_tail = NULL;
+        _queue_length--;
+
+        /* Keep oe_cancel_enclave_threads() from returning, and the enclave
+         * from being terminated, until the ECALL returns */
+        enclave = request->enclave;
+        enclave->num_starting_threads++;
+
+        _unlock_pool();
+
+        result = oe_thread_start_ecall(enclave, request->id);
+
+        _lock_pool();
+
+        if (--enclave->num_starting_threads == 0)
+            _broadcast_started();
+
+        if (result == OE_OUT_OF_THREADS)
+        {
+            /* Queue the request again so that oe_cancel_enclave_threads()
+             * can still drop it */
+            _push_request(request);
+            _unlock_pool();
+            _sleep_msec(OE_THREAD_POOL_RETRY_MSEC);
+            _lock_pool();
+            continue;
+        }
+
+        if (result != OE_OK)
+            OE_TRACE_ERROR(
+                "oe_thread_start_ecall() failed: %s", oe_result_str(result));
+
+        free(request);
+    }
+
+done:
+    _unlock_pool();
+
+#if defined(_WIN32)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+/* Start a worker. Called with the pool lock held. */
+static bool _start_worker(void)
+{
+#if defined(_WIN32)
+    HANDLE thread = CreateThread(NULL, 0, _worker_thread, NULL, 0, NULL);
+
+    if (!thread)
+        return false;
+
+    CloseHandle(thread);
+#else
+    pthread_t thread;
+
+    if (pthread_create(&thread, NULL, _worker_thread, NULL) != 0)
+        return false;
+
+    pthread_detach(thread);
+#endif
+
+    return true;
+}
+
+oe_result_t oe_thread_create_ocall(oe_enclave_t* enclave, uint64_t id)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    thread_request_t* request = NULL;
+    bool locked = false;
+
+    if (!enclave)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!(request = (thread_request_t*)malloc(sizeof(thread_request_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    request->enclave = enclave;
+    request->id = id;
+
+    _lock_pool();
+    locked = true;
+
+    /* Each queued request has a worker of its own, as enclave threads may
+     * wait for each other */
+    if (_num_idle_workers <= _queue_length && !_start_worker())
+        OE_RAISE(OE_OUT_OF_THREADS);
+
+    _push_request(request);
+    request = NULL;
+    _signal_pool();
+
+    result = OE_OK;
+
+done:
+    if (locked)
+        _unlock_pool();
+
+    free(request);
+
+    return result;
+}
+
+void oe_cancel_enclave_threads(oe_enclave_t* enclave)
+{
+    thread_request_t* requests = NULL;
+
+    _lock_pool();
+
+    for (thread_request_t** link = &_queue_head; *link;)
+    {
+        thread_request_t* request = *link;
+
+        if (request->enclave == enclave)
+        {
+            *link = request->next;
+            _queue_length--;
+            request->next = requests;
+            requests = request;
+            continue;
+        }
+
+        _queue_tail = request;
+        link = &request->next;
+    }
+
+    if (!_queue_head)
+        _queue_tail = NULL;
+
+    while (enclave->num_starting_threads)
+        _wait_started();
+
+    _unlock_pool();
+
+    while (requests)
+    {
+        thread_request_t* next = requests->next;
+        free(requests);
+        requests = next;
+    }
+}
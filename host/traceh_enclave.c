@@ -1,8 +1,14 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <openenclave/internal/atomic.h>
 #include <openenclave/internal/calls.h>
+#include <openenclave/internal/logring.h>
 #include <openenclave/internal/trace.h>
+#include <openenclave/internal/utils.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #if defined(__x86_64__) || defined(_M_X64)
 #include "sgx/enclave.h"
@@ -16,15 +22,328 @@
 #error "Open Enclave is not supported on this architecture."
 #endif
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#include "hostthread.h"
+#include "memalign.h"
 #include "tee_u.h"
 
 /*
  * This file is separated from traceh.c since the host verification library
  * should not depend on ECALLS.
  */
+
+/*
+**==============================================================================
+**
+** Log drains
+**
+**     Each enclave thread context gets a ring (see logring.h) to which the
+**     enclave appends its log messages. A single host thread writes the
+**     messages in the rings of all enclaves every OE_LOG_DRAIN_INTERVAL_MSEC
+**     while any enclave has rings. The messages of an enclave are also
+**     written when it logs a fatal message and when it is terminated.
+**
+**==============================================================================
+*/
+
+#define OE_LOG_DRAIN_INTERVAL_MSEC 10
+
+typedef struct _log_drain
+{
+    struct _log_drain* next;
+    oe_enclave_t* enclave;
+    oe_log_ring_t* rings;
+    size_t ring_count;
+
+    /* Dropped message counts already reported, per ring */
+    uint64_t dropped[OE_LOG_RING_COUNT_MAX];
+
+    /* Serializes the draining of the rings */
+    oe_mutex lock;
+} log_drain_t;
+
+static log_drain_t* _log_drains;
+static oe_mutex _log_drains_lock = OE_H_MUTEX_INITIALIZER;
+
+/* The thread draining _log_drains, started with the first drain and stopped
+ * with the last one. Starting and stopping it are serialized by
+ * _log_drain_thread_lock, which is taken before _log_drains_lock. */
+static oe_mutex _log_drain_thread_lock = OE_H_MUTEX_INITIALIZER;
+static bool _log_drain_thread_running;
+static volatile uint64_t _log_drain_thread_stop;
+#if defined(_WIN32)
+static HANDLE _log_drain_thread_handle;
+#else
+static pthread_t _log_drain_thread_handle;
+#endif
+
+static void _drain_log_ring(log_drain_t* drain, size_t index)
+{
+    oe_log_ring_t* ring = &drain->rings[index];
+    uint64_t head = oe_atomic_load_acquire(&ring->head);
+    uint64_t tail = ring->tail;
+    uint64_t dropped = ring->dropped;
+
+    /* The enclave cannot have more than a ring's worth of records pending
+     * unless it corrupted the indices */
+    if (head > tail && head - tail > OE_LOG_RING_SIZE)
+        head = tail + OE_LOG_RING_SIZE;
+
+    while (tail < head)
+    {
+        const uint64_t offset = tail % OE_LOG_RING_SIZE;
+        const oe_log_record_t* record =
+            (const oe_log_record_t*)&ring->data[offset];
+        const char* message = (const char*)(record + 1);
+        const uint64_t room = OE_LOG_RING_SIZE - offset - sizeof(*record);
+
+        /* Stop at a malformed record (the enclave wrote it) */
+        if (record->size > room)
+        {
+            tail = head;
+            break;
+        }
+
+        if (record->level != OE_LOG_RECORD_PADDING &&
+            record->level < OE_LOG_LEVEL_MAX && record->size > 0 &&
+            message[record->size - 1] == '\0')
+        {
+            oe_log_message(true, (oe_log_level_t)record->level, message);
+        }
+
+        tail += oe_round_up_to_multiple(
+            sizeof(*record) + record->size, OE_LOG_RECORD_ALIGNMENT);
+    }
+
+    oe_atomic_store_release(&ring->tail, tail);
+
+    if (dropped > drain->dropped[index])
+    {
+        char message[128];
+
+        snprintf(
+            message,
+            sizeof(message),
+            "%llu enclave log messages dropped (log ring %zu full)\n",
+            (unsigned long long)(dropped - drain->dropped[index]),
+            index);
+        oe_log_message(true, OE_LOG_LEVEL_WARNING, message);
+        drain->dropped[index] = dropped;
+    }
+}
+
+static void _drain_log_rings(log_drain_t* drain)
+{
+    oe_mutex_lock(&drain->lock);
+
+    for (size_t i = 0; i < drain->ring_count; i++)
+        _drain_log_ring(drain, i);
+
+    oe_mutex_unlock(&drain->lock);
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI _log_drain_thread(LPVOID arg)
+#else
+static void* _log_drain_thread(void* arg)
+#endif
+{
+    OE_UNUSED(arg);
+
+    while (!oe_atomic_load_acquire(&_log_drain_thread_stop))
+    {
+#if defined(_WIN32)
+        Sleep(OE_LOG_DRAIN_INTERVAL_MSEC);
+#else
+        const struct timespec interval = {
+            0, OE_LOG_DRAIN_INTERVAL_MSEC * 1000 * 1000};
+        nanosleep(&interval, NULL);
+#endif
+
+        oe_mutex_lock(&_log_drains_lock);
+
+        for (log_drain_t* p = _log_drains; p; p = p->next)
+            _drain_log_rings(p);
+
+        oe_mutex_unlock(&_log_drains_lock);
+    }
+
+#if defined(_WIN32)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+/* Start the drain thread unless it is running (_log_drain_thread_lock must
+ * be held) */
+static bool _start_log_drain_thread(void)
+{
+    if (_log_drain_thread_running)
+        return true;
+
+    oe_atomic_store_release(&_log_drain_thread_stop, 0);
+
+#if defined(_WIN32)
+    _log_drain_thread_handle =
+        CreateThread(NULL, 0, _log_drain_thread, NULL, 0, NULL);
+    if (!_log_drain_thread_handle)
+        return false;
+#else
+    if (pthread_create(
+            &_log_drain_thread_handle, NULL, _log_drain_thread, NULL) != 0)
+        return false;
+#endif
+
+    _log_drain_thread_running = true;
+    return true;
+}
+
+/* Stop the drain thread if it is running (_log_drain_thread_lock must be
+ * held) */
+static void _stop_log_drain_thread(void)
+{
+    if (!_log_drain_thread_running)
+        return;
+
+    oe_atomic_store_release(&_log_drain_thread_stop, 1);
+#if defined(_WIN32)
+    WaitForSingleObject(_log_drain_thread_handle, INFINITE);
+    CloseHandle(_log_drain_thread_handle);
+#else
+    pthread_join(_log_drain_thread_handle, NULL);
+#endif
+
+    _log_drain_thread_running = false;
+}
+
+static void _free_log_drain(log_drain_t* drain)
+{
+    oe_mutex_destroy(&drain->lock);
+    oe_memalign_free(drain->rings);
+    free(drain);
+}
+
+/* Create the rings and have the drain thread write them. Returns null if
+ * the enclave should log through OCALLs only. */
+static log_drain_t* _create_log_drain(oe_enclave_t* enclave)
+{
+    log_drain_t* drain = NULL;
+    size_t ring_count = 0;
+
+#if defined(__x86_64__) || defined(_M_X64)
+    /* Only debug enclaves log */
+    if (enclave->debug)
+        ring_count = enclave->num_bindings;
+#endif
+
+    if (ring_count == 0 || _log_level == OE_LOG_LEVEL_NONE)
+        return NULL;
+
+    if (ring_count > OE_LOG_RING_COUNT_MAX)
+        ring_count = OE_LOG_RING_COUNT_MAX;
+
+    if (!(drain = (log_drain_t*)calloc(1, sizeof(log_drain_t))))
+        return NULL;
+
+    drain->enclave = enclave;
+    drain->ring_count = ring_count;
+
+    if (!(drain->rings = (oe_log_ring_t*)oe_memalign(
+              OE_PAGE_SIZE, ring_count * sizeof(oe_log_ring_t))))
+    {
+        free(drain);
+        return NULL;
+    }
+
+    memset(drain->rings, 0, ring_count * sizeof(oe_log_ring_t));
+    oe_mutex_init(&drain->lock);
+
+    oe_mutex_lock(&_log_drain_thread_lock);
+
+    if (!_start_log_drain_thread())
+    {
+        oe_mutex_unlock(&_log_drain_thread_lock);
+        _free_log_drain(drain);
+        return NULL;
+    }
+
+    oe_mutex_lock(&_log_drains_lock);
+    drain->next = _log_drains;
+    _log_drains = drain;
+    oe_mutex_unlock(&_log_drains_lock);
+
+    oe_mutex_unlock(&_log_drain_thread_lock);
+
+    return drain;
+}
+
 oe_result_t oe_log_enclave_init(oe_enclave_t* enclave)
 {
+    log_drain_t* drain;
+
     initialize_log_config();
 
-    return oe_log_init_ecall(enclave, enclave->path, _log_level);
+    drain = _create_log_drain(enclave);
+
+    return oe_log_init_ecall(
+        enclave,
+        enclave->path,
+        _log_level,
+        drain ? drain->rings : NULL,
+        drain ? drain->ring_count : 0);
+}
+
+void oe_log_enclave_flush(oe_enclave_t* enclave)
+{
+    oe_mutex_lock(&_log_drains_lock);
+
+    for (log_drain_t* p = _log_drains; p; p = p->next)
+    {
+        if (!enclave || p->enclave == enclave)
+            _drain_log_rings(p);
+    }
+
+    oe_mutex_unlock(&_log_drains_lock);
+}
+
+void oe_log_enclave_fini(oe_enclave_t* enclave)
+{
+    log_drain_t* drain = NULL;
+    bool last = false;
+
+    oe_mutex_lock(&_log_drain_thread_lock);
+    oe_mutex_lock(&_log_drains_lock);
+
+    for (log_drain_t** p = &_log_drains; *p; p = &(*p)->next)
+    {
+        if ((*p)->enclave == enclave)
+        {
+            drain = *p;
+            *p = drain->next;
+            break;
+        }
+    }
+
+    last = (_log_drains == NULL);
+
+    oe_mutex_unlock(&_log_drains_lock);
+
+    /* The drain thread no longer sees the drain once it is unlinked */
+    if (drain && last)
+        _stop_log_drain_thread();
+
+    oe_mutex_unlock(&_log_drain_thread_lock);
+
+    if (!drain)
+        return;
+
+    _drain_log_rings(drain);
+    _free_log_drain(drain);
 }
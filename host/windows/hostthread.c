@@ -103,28 +103,65 @@ int oe_mutex_destroy(oe_mutex* Lock)
 **==============================================================================
 */
 
-int oe_thread_key_create(oe_thread_key* key)
+/* Keys with a destructor use fiber-local storage since, unlike TLS, it calls
+ * the destructor when a thread exits. Their index is tagged with
+ * _FLS_KEY_FLAG; the other keys keep using TLS. */
+#define _FLS_KEY_FLAG 0x80000000
+
+int oe_thread_key_create(oe_thread_key* key, void (*destructor)(void* value))
 {
     oe_thread_key k;
-    k = TlsAlloc();
-    if (k == TLS_OUT_OF_INDEXES)
+
+    if (!destructor)
+    {
+        k = TlsAlloc();
+        if (k == TLS_OUT_OF_INDEXES)
+            return 1;
+
+        if (k & _FLS_KEY_FLAG)
+        {
+            TlsFree(k);
+            return 1;
+        }
+
+        *key = k;
+        return 0;
+    }
+
+    k = FlsAlloc((PFLS_CALLBACK_FUNCTION)destructor);
+    if (k == FLS_OUT_OF_INDEXES)
         return 1;
 
-    *key = k;
+    if (k & _FLS_KEY_FLAG)
+    {
+        FlsFree(k);
+        return 1;
+    }
+
+    *key = k | _FLS_KEY_FLAG;
     return 0;
 }
 
 int oe_thread_key_delete(oe_thread_key key)
 {
+    if (key & _FLS_KEY_FLAG)
+        return !FlsFree(key & ~_FLS_KEY_FLAG);
+
     return !TlsFree(key);
 }
 
 int oe_thread_setspecific(oe_thread_key key, void* value)
 {
+    if (key & _FLS_KEY_FLAG)
+        return !FlsSetValue(key & ~_FLS_KEY_FLAG, value);
+
     return !TlsSetValue(key, value);
 }
 
 void* oe_thread_getspecific(oe_thread_key key)
 {
+    if (key & _FLS_KEY_FLAG)
+        return FlsGetValue(key & ~_FLS_KEY_FLAG);
+
     return TlsGetValue(key);
 }
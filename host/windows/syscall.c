@@ -208,6 +208,64 @@ oe_off_t oe_syscall_lseek_ocall(oe_host_fd_t fd, oe_off_t offset, int whence)
     PANIC;
 }
 
+ssize_t oe_syscall_sendfile_ocall(
+    oe_host_fd_t out_fd,
+    oe_host_fd_t in_fd,
+    oe_off_t* offset,
+    size_t count)
+{
+    PANIC;
+}
+
+ssize_t oe_syscall_copy_file_range_ocall(
+    oe_host_fd_t fd_in,
+    oe_off_t* off_in,
+    oe_host_fd_t fd_out,
+    oe_off_t* off_out,
+    size_t len,
+    unsigned int flags)
+{
+    PANIC;
+}
+
+ssize_t oe_syscall_pread_ocall(
+    oe_host_fd_t fd,
+    void* buf,
+    size_t count,
+    oe_off_t offset)
+{
+    PANIC;
+}
+
+ssize_t oe_syscall_pwrite_ocall(
+    oe_host_fd_t fd,
+    const void* buf,
+    size_t count,
+    oe_off_t offset)
+{
+    PANIC;
+}
+
+ssize_t oe_syscall_preadv_ocall(
+    oe_host_fd_t fd,
+    void* iov_buf,
+    int iovcnt,
+    size_t iov_buf_size,
+    oe_off_t offset)
+{
+    PANIC;
+}
+
+ssize_t oe_syscall_pwritev_ocall(
+    oe_host_fd_t fd,
+    const void* iov_buf,
+    int iovcnt,
+    size_t iov_buf_size,
+    oe_off_t offset)
+{
+    PANIC;
+}
+
 int oe_syscall_close_ocall(oe_host_fd_t fd)
 {
     return _close(fd);
@@ -561,32 +619,13 @@ int oe_syscall_kill_ocall(int pid, int signum)
 **==============================================================================
 */
 
-int oe_syscall_getaddrinfo_open_ocall(
+int oe_syscall_getaddrinfo_ocall(
     const char* node,
     const char* service,
     const struct oe_addrinfo* hints,
-    uint64_t* handle_out)
-{
-    PANIC;
-}
-
-int oe_syscall_getaddrinfo_read_ocall(
-    uint64_t handle_,
-    int* ai_flags,
-    int* ai_family,
-    int* ai_socktype,
-    int* ai_protocol,
-    oe_socklen_t ai_addrlen_in,
-    oe_socklen_t* ai_addrlen,
-    struct oe_sockaddr* ai_addr,
-    size_t ai_canonnamelen_in,
-    size_t* ai_canonnamelen,
-    char* ai_canonname)
-{
-    PANIC;
-}
-
-int oe_syscall_getaddrinfo_close_ocall(uint64_t handle_)
+    void* buf,
+    size_t buf_size,
+    size_t* buf_size_out)
 {
     PANIC;
 }
@@ -625,7 +664,7 @@ int oe_syscall_epoll_wait_ocall(
     PANIC;
 }
 
-int oe_syscall_epoll_wake_ocall(void)
+int oe_syscall_epoll_wake_ocall(int64_t epfd)
 {
     PANIC;
 }
@@ -639,6 +678,17 @@ int oe_syscall_epoll_ctl_ocall(
     PANIC;
 }
 
+int oe_syscall_epoll_ctl_wait_ocall(
+    int64_t epfd,
+    struct oe_epoll_change* changes,
+    size_t num_changes,
+    struct oe_epoll_event* events,
+    unsigned int maxevents,
+    int timeout)
+{
+    PANIC;
+}
+
 int oe_syscall_epoll_close_ocall(oe_host_fd_t epfd)
 {
     PANIC;
@@ -25,6 +25,19 @@ OE_EXTERNC_BEGIN
  */
 #define OE_HOST_FILE_SYSTEM "oe_host_file_system"
 
+/**
+ * Name of the in-enclave RAM file system (passed to **mount()** as the
+ * **filesystemtype** parameter).
+ */
+#define OE_RAM_FILE_SYSTEM "oe_ram_file_system"
+
+/**
+ * Name of the protected file system, which keeps files encrypted and
+ * integrity protected on the host (passed to **mount()** as the
+ * **filesystemtype** parameter).
+ */
+#define OE_SGX_FILE_SYSTEM "oe_sgx_file_system"
+
 OE_EXTERNC_END
 
 #endif /* _OE_BITS_FS_H */
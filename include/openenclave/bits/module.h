@@ -63,6 +63,29 @@ oe_result_t oe_load_module_host_socket_interface(void);
  */
 oe_result_t oe_load_module_host_resolver(void);
 
+/**
+ * Configure the cache of getaddrinfo() results.
+ *
+ * The enclave can keep the results of getaddrinfo() so that resolving the
+ * same name again does not ask the host. Failures saying that the name does
+ * not exist (EAI_NONAME and EAI_NODATA) can be kept as well. Other failures
+ * are never cached. When the cache is full, the least recently used entry is
+ * evicted. The cache is disabled by default.
+ *
+ * @param max_entries The maximum number of cached results. Zero disables
+ * the cache and empties it.
+ * @param positive_ttl How long successful results are kept, in
+ * milliseconds. Zero does not cache them.
+ * @param negative_ttl How long failures are kept, in milliseconds. Zero does
+ * not cache them.
+ *
+ * @retval OE_OK The cache was successfully configured.
+ */
+oe_result_t oe_set_resolver_cache(
+    size_t max_entries,
+    uint32_t positive_ttl,
+    uint32_t negative_ttl);
+
 /**
  * Load the event polling (epoll) module.
  *
@@ -74,6 +97,34 @@ oe_result_t oe_load_module_host_resolver(void);
  * @retval OE_FAILURE Module failed to load.
  */
 oe_result_t oe_load_module_host_epoll(void);
+
+/**
+ * Load the RAM file system module.
+ *
+ * This function loads the RAM file system module which keeps files in
+ * enclave memory. Once loaded, it can be mounted with **mount()** using
+ * **OE_RAM_FILE_SYSTEM** as the file system type. The data parameter of
+ * **mount()** may limit the size of the file system, e.g. "size=64m".
+ *
+ * @retval OE_OK The module was successfully loaded.
+ * @retval OE_FAILURE Module failed to load.
+ */
+oe_result_t oe_load_module_ram_file_system(void);
+
+/**
+ * Load the protected file system module.
+ *
+ * This function loads the protected file system module, and the host file
+ * system module that it stores files with. Once loaded, it can be mounted
+ * with **mount()** using **OE_SGX_FILE_SYSTEM** as the file system type.
+ * Files are sealed with a key derived from the seal key of the enclave. The
+ * data parameter of **mount()** selects the seal key policy of new files,
+ * "policy=unique" or "policy=product" (the default).
+ *
+ * @retval OE_OK The module was successfully loaded.
+ * @retval OE_FAILURE Module failed to load.
+ */
+oe_result_t oe_load_module_sgx_file_system(void);
 OE_EXTERNC_END
 
 #endif /* _OE_BITS_MODULE_H */
@@ -61,6 +61,14 @@ typedef struct _oe_enclave_properties_header
     HEAP_PAGE_COUNT,        \
     STACK_PAGE_COUNT,       \
     TCS_COUNT)
+#define OE_SET_ENCLAVE_SGX_EX( \
+    PRODUCT_ID,                \
+    SECURITY_VERSION,          \
+    ALLOW_DEBUG,               \
+    HEAP_PAGE_COUNT,           \
+    STACK_PAGE_COUNT,          \
+    TCS_COUNT,                 \
+    FLAGS)
 #endif
 
 #if __aarch64__
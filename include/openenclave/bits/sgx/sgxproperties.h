@@ -33,13 +33,22 @@ typedef struct _oe_sgx_enclave_image_info_t
 #define OE_SGX_FLAGS_MODE64BIT 0x0000000000000004ULL
 #define OE_SGX_SIGSTRUCT_SIZE 1808
 
+// oe_sgx_enclave_config_t.flags (Open Enclave runtime options, which are
+// not part of the SGX attributes)
+
+/* Keep the thread-local storage of each enclave thread across outermost
+ * ECALLs. Thread-local objects are then constructed once per TCS and
+ * destroyed when the enclave is terminated, rather than every time an
+ * outermost ECALL returns. */
+#define OE_SGX_CONFIG_PERSISTENT_THREAD_LOCALS 0x00000001U
+
 typedef struct oe_sgx_enclave_config_t
 {
     uint16_t product_id;
     uint16_t security_version;
 
-    /* Padding to make packed and unpacked size the same */
-    uint32_t padding;
+    /* (OE_SGX_CONFIG_PERSISTENT_THREAD_LOCALS) */
+    uint32_t flags;
 
     /* (OE_SGX_FLAGS_DEBUG | OE_SGX_FLAGS_MODE64BIT) */
     uint64_t attributes;
@@ -95,7 +104,7 @@ typedef struct _oe_sgx_enclave_properties
  * the enclave
  * @param TCS_COUNT Number of concurrent threads in an enclave to support
  */
-// Note: disable clang-format since it badly misformats this macro
+// Note: disable clang-format since it badly misformats these macros
 // clang-format off
 
 #define OE_SET_ENCLAVE_SGX(                                               \
@@ -105,6 +114,33 @@ typedef struct _oe_sgx_enclave_properties
     HEAP_PAGE_COUNT,                                                      \
     STACK_PAGE_COUNT,                                                     \
     TCS_COUNT)                                                            \
+    OE_SET_ENCLAVE_SGX_EX(                                                \
+        PRODUCT_ID,                                                       \
+        SECURITY_VERSION,                                                 \
+        ALLOW_DEBUG,                                                      \
+        HEAP_PAGE_COUNT,                                                  \
+        STACK_PAGE_COUNT,                                                 \
+        TCS_COUNT,                                                        \
+        0)
+
+/**
+ * Defines the SGX properties for an enclave, including Open Enclave runtime
+ * options.
+ *
+ * This macro is used instead of OE_SET_ENCLAVE_SGX, and takes the same
+ * parameters followed by:
+ *
+ * @param FLAGS Bitwise OR of OE_SGX_CONFIG_* runtime options, for example
+ * OE_SGX_CONFIG_PERSISTENT_THREAD_LOCALS
+ */
+#define OE_SET_ENCLAVE_SGX_EX(                                            \
+    PRODUCT_ID,                                                           \
+    SECURITY_VERSION,                                                     \
+    ALLOW_DEBUG,                                                          \
+    HEAP_PAGE_COUNT,                                                      \
+    STACK_PAGE_COUNT,                                                     \
+    TCS_COUNT,                                                            \
+    FLAGS)                                                                \
     OE_INFO_SECTION_BEGIN                                                 \
     volatile const oe_sgx_enclave_properties_t oe_enclave_properties_sgx = \
     {                                                                     \
@@ -123,7 +159,7 @@ typedef struct _oe_sgx_enclave_properties
         {                                                                 \
             .product_id = PRODUCT_ID,                                     \
             .security_version = SECURITY_VERSION,                         \
-            .padding = 0,                                                 \
+            .flags = FLAGS,                                               \
             .attributes = OE_MAKE_ATTRIBUTES(ALLOW_DEBUG)                 \
         },                                                                \
         .image_info =                                                     \
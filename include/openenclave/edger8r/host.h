@@ -66,6 +66,56 @@ oe_result_t oe_call_enclave_function(
     size_t output_buffer_size,
     size_t* output_bytes_written);
 
+/**
+ * An enclave function call made by oe_call_enclave_functions().
+ */
+typedef struct _oe_enclave_function_call
+{
+    /** The id of the enclave function to call. */
+    uint64_t function_id;
+
+    /** Buffer containing the input data. */
+    const void* input_buffer;
+
+    /** Size of the input data buffer. */
+    size_t input_buffer_size;
+
+    /** Buffer where the outputs of the enclave function are written to. */
+    void* output_buffer;
+
+    /** Size of the output buffer. */
+    size_t output_buffer_size;
+
+    /** [out] Number of bytes written in the output buffer. */
+    size_t output_bytes_written;
+
+    /** [out] The result of the call, as returned by
+     * oe_call_enclave_function(). */
+    oe_result_t result;
+} oe_enclave_function_call_t;
+
+/**
+ * Perform several high-level enclave function calls (ECALLs) with a single
+ * enclave entry.
+ *
+ * The calls are made in order, as oe_call_enclave_function() would make
+ * them, and the outcome of each is stored in its **result** and
+ * **output_bytes_written** fields. A failed call does not stop the
+ * following ones.
+ *
+ * @param enclave The enclave to call.
+ * @param calls The calls to make.
+ * @param num_calls The number of calls.
+ *
+ * @return OE_OK if the calls were made (see their **result** fields).
+ * @return OE_INVALID_PARAMETER a parameter is invalid.
+ * @return OE_OUT_OF_MEMORY there is not enough memory.
+ */
+oe_result_t oe_call_enclave_functions(
+    oe_enclave_t* enclave,
+    oe_enclave_function_call_t* calls,
+    size_t num_calls);
+
 /**
  * Placeholder.
  */
@@ -78,6 +128,27 @@ oe_result_t oe_switchless_call_enclave_function(
     size_t output_buffer_size,
     size_t* output_bytes_written);
 
+/**
+ * Allocate a buffer for marshalling the arguments of an ECALL.
+ *
+ * The buffer comes from a per-thread buffer if it fits (see
+ * oe_set_ecall_buffer_size()) and from malloc() otherwise. It is aligned
+ * like a malloc() result and must be freed with oe_free_ecall_buffer() on
+ * the same thread.
+ *
+ * @param size The size of the buffer in bytes.
+ *
+ * @return The buffer, or NULL if it could not be allocated.
+ */
+void* oe_allocate_ecall_buffer(size_t size);
+
+/**
+ * Free a buffer allocated by oe_allocate_ecall_buffer().
+ *
+ * @param buffer The buffer to free. May be NULL.
+ */
+void oe_free_ecall_buffer(void* buffer);
+
 OE_EXTERNC_END
 
 #endif // _OE_EDGER8R_HOST_H
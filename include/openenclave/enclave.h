@@ -577,6 +577,30 @@ oe_result_t oe_get_seal_key_v2(
  */
 void oe_free_seal_key(uint8_t* key_buffer, uint8_t* key_info);
 
+/**
+ * Evicts the keys derived with the specified policy from the enclave key
+ * cache.
+ *
+ * Seal keys, and the asymmetric keys derived from them, are cached inside
+ * the enclave after they are first derived, so that subsequent requests for
+ * the same key do not derive it again. Evicted keys are zeroized and are
+ * derived again on their next use.
+ *
+ * @param seal_policy The policy of the keys to evict.
+ *
+ * @retval OE_OK The keys were successfully evicted.
+ * @retval OE_INVALID_PARAMETER **seal_policy** is invalid.
+ */
+oe_result_t oe_evict_cached_keys_by_policy(oe_seal_policy_t seal_policy);
+
+/**
+ * Evicts all the keys from the enclave key cache. Evicted keys are zeroized
+ * and are derived again on their next use.
+ *
+ * See oe_evict_cached_keys_by_policy().
+ */
+void oe_evict_cached_keys(void);
+
 /**
  * Obtains the enclave handle.
  *
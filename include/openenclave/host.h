@@ -122,6 +122,39 @@ oe_result_t oe_create_enclave(
  */
 oe_result_t oe_terminate_enclave(oe_enclave_t* enclave);
 
+/**
+ * Keeps enclaves built ahead of time for oe_create_enclave() to return.
+ *
+ * Once a pool size is set for an enclave image and creation flags, the
+ * first **oe_create_enclave()** call for them creates its enclave as usual
+ * and host threads start building and initializing **count** more enclaves
+ * in the background. Later calls with the same image, flags and OCALL table
+ * return one of these enclaves, and a replacement is built in the
+ * background.
+ *
+ * Enclaves are not returned to the pool when they are terminated, as the
+ * memory of a used enclave cannot be reset to its measured contents.
+ *
+ * @param path The path of the enclave image file.
+ * @param flags The flags the enclaves are created with.
+ * @param count The number of enclaves to keep ready, at most
+ * OE_MAX_ENCLAVE_POOL_SIZE. Zero terminates the enclaves in the pool. When
+ * the pool shrinks, this function also waits for the enclaves being built,
+ * and terminates those that do not fit.
+ *
+ * @retval OE_OK The size of the pool was set.
+ * @retval OE_INVALID_PARAMETER One or more parameters is invalid.
+ * @retval OE_NOT_FOUND The enclave image file was not found.
+ * @retval OE_UNSUPPORTED Pools are not supported on this platform.
+ */
+oe_result_t oe_set_enclave_pool_size(
+    const char* path,
+    uint32_t flags,
+    size_t count);
+
+/** The largest size accepted by oe_set_enclave_pool_size(). */
+#define OE_MAX_ENCLAVE_POOL_SIZE 64
+
 #if (OE_API_VERSION < 2)
 #error "Only OE_API_VERSION of 2 is supported"
 #else
@@ -317,6 +350,26 @@ void oe_free_key(
     uint8_t* key_info,
     size_t key_info_size);
 
+/**
+ * Sets the size of the per-thread buffer used to marshal ECALL arguments.
+ *
+ * The ECALL wrappers generated by oeedger8r carve their marshalling buffers
+ * out of a buffer owned by the calling thread, and use malloc() only for
+ * calls whose arguments do not fit. Each thread allocates its buffer on its
+ * first ECALL and frees it when it exits. The new size applies to a thread's
+ * buffer the next time the thread makes an ECALL.
+ *
+ * @param size The size of the buffer in bytes (64 KB by default). Zero makes
+ * all ECALLs use malloc().
+ *
+ * @retval OE_OK The size was set.
+ * @retval OE_INVALID_PARAMETER **size** exceeds OE_MAX_ECALL_BUFFER_SIZE.
+ */
+oe_result_t oe_set_ecall_buffer_size(size_t size);
+
+/** The largest size accepted by oe_set_ecall_buffer_size(). */
+#define OE_MAX_ECALL_BUFFER_SIZE (16 * 1024 * 1024)
+
 OE_EXTERNC_END
 
 #endif /* _OE_HOST_H */
@@ -38,4 +38,30 @@ OE_INLINE uint64_t oe_atomic_decrement(volatile uint64_t* x)
 #endif
 }
 
+/* Load **x** so that later memory accesses are not ordered before it */
+OE_INLINE uint64_t oe_atomic_load_acquire(const volatile uint64_t* x)
+{
+#if defined(__GNUC__)
+    return __atomic_load_n(x, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+    /* Volatile accesses have acquire/release semantics on x64 */
+    return *x;
+#else
+#error "unsupported"
+#endif
+}
+
+/* Store **value** in **x** so that earlier memory accesses are not ordered
+ * after it */
+OE_INLINE void oe_atomic_store_release(volatile uint64_t* x, uint64_t value)
+{
+#if defined(__GNUC__)
+    __atomic_store_n(x, value, __ATOMIC_RELEASE);
+#elif defined(_MSC_VER)
+    *x = value;
+#else
+#error "unsupported"
+#endif
+}
+
 #endif /* _OE_ATOMIC_H */
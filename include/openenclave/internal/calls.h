@@ -75,6 +75,8 @@ typedef enum _oe_func
     OE_ECALL_INIT_ENCLAVE,
     OE_ECALL_CALL_ENCLAVE_FUNCTION,
     OE_ECALL_VIRTUAL_EXCEPTION_HANDLER,
+    OE_ECALL_RELEASE_THREAD_LOCALS,
+    OE_ECALL_CALL_ENCLAVE_FUNCTIONS,
     /* Caution: always add new ECALL function numbers here */
     OE_ECALL_MAX,
 
@@ -198,6 +200,23 @@ typedef struct _oe_call_enclave_function_args
     oe_result_t result;
 } oe_call_enclave_function_args_t;
 
+/*
+**==============================================================================
+**
+** oe_call_enclave_functions_args_t
+**
+**     The argument of OE_ECALL_CALL_ENCLAVE_FUNCTIONS: an array of calls to
+**     make with one enclave entry.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_call_enclave_functions_args
+{
+    oe_call_enclave_function_args_t* calls;
+    size_t num_calls;
+} oe_call_enclave_functions_args_t;
+
 /*
 **==============================================================================
 **
@@ -5,6 +5,10 @@
 #define _OE_CPUID_H
 
 #include <openenclave/bits/defs.h>
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
 
 #define OE_CPUID_OPCODE 0xA20F
 #define OE_CPUID_LEAF_COUNT 8
@@ -31,4 +35,67 @@ OE_INLINE bool oe_is_emulated_cpuid_leaf(uint32_t leaf)
     return (leaf == 0) || (leaf == 1) || (leaf == 4) || (leaf == 7);
 }
 
+/**
+ * Get CPUID information inside the enclave without executing CPUID.
+ *
+ * The CPUID instruction is illegal inside an SGX enclave, and executing it
+ * costs an asynchronous exit and a round trip through the host exception
+ * handler before it is emulated. This function returns the same values as
+ * the emulation, directly from the CPUID leaves cached at enclave
+ * initialization. Only the leaves for which oe_is_emulated_cpuid_leaf()
+ * returns true are available, and only subleaf 0 of leaf 4.
+ *
+ * @param leaf The CPUID leaf (EAX).
+ * @param subleaf The CPUID subleaf (ECX).
+ * @param eax, ebx, ecx, edx Receive the CPUID results.
+ *
+ * @retval OE_OK The leaf is cached and the results were returned.
+ * @retval OE_UNSUPPORTED The leaf (or subleaf) is not cached.
+ * @retval OE_INVALID_PARAMETER An output parameter is NULL.
+ */
+oe_result_t oe_cpuid(
+    uint32_t leaf,
+    uint32_t subleaf,
+    uint32_t* eax,
+    uint32_t* ebx,
+    uint32_t* ecx,
+    uint32_t* edx);
+
+#define OE_EMULATED_EXCEPTION_SITES 16
+
+/**
+ * Counters of the illegal instruction exceptions (such as CPUID) handled by
+ * the enclave first-pass exception handler, used to locate code that still
+ * traps frequently.
+ */
+typedef struct _oe_emulated_exception_stats
+{
+    /* Number of exceptions that were emulated */
+    uint64_t emulated;
+
+    /* Number of illegal instruction exceptions that could not be emulated
+     * and were passed to the vectored exception handlers */
+    uint64_t not_emulated;
+
+    /* Emulated exceptions by instruction address, in order of first
+     * occurrence (unused entries have a zero address) */
+    struct
+    {
+        uint64_t address;
+        uint64_t count;
+    } sites[OE_EMULATED_EXCEPTION_SITES];
+
+    /* Emulated exceptions at addresses that did not fit in sites */
+    uint64_t other_sites;
+} oe_emulated_exception_stats_t;
+
+/**
+ * Get a snapshot of the emulated exception counters of the enclave.
+ *
+ * @param stats Receives the counters.
+ */
+void oe_get_emulated_exception_stats(oe_emulated_exception_stats_t* stats);
+
+OE_EXTERNC_END
+
 #endif /* _OE_CPUID_H */
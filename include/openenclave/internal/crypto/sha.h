@@ -52,6 +52,22 @@ oe_result_t oe_sha256_update(
     const void* data,
     size_t size);
 
+/**
+ * Copies the state of a SHA-256 context
+ *
+ * This function initializes **dest** to the state of **src**, so that the
+ * hash of data sharing a common prefix can be computed by hashing the prefix
+ * once and extending copies of the context.
+ *
+ * @param dest handle of context to be initialized
+ * @param src handle of context to be copied
+ *
+ * @return OE_OK upon success
+ */
+oe_result_t oe_sha256_copy(
+    oe_sha256_context_t* dest,
+    const oe_sha256_context_t* src);
+
 /**
  * Computes the final SHA-256 hash
  *
@@ -66,6 +82,41 @@ oe_result_t oe_sha256_update(
  */
 oe_result_t oe_sha256_final(oe_sha256_context_t* context, OE_SHA256* sha256);
 
+/**
+ * Frees the resources held by a SHA-256 context
+ *
+ * This function frees a context initialized by oe_sha256_init() or
+ * oe_sha256_copy(), whether or not it was finalized. The context may not be
+ * used afterwards.
+ *
+ * @param context handle of context to be freed
+ *
+ * @return OE_OK upon success
+ */
+oe_result_t oe_sha256_free(oe_sha256_context_t* context);
+
+/**
+ * Computes the SHA-256 hashes of several independent messages
+ *
+ * This function computes the SHA-256 hash of each of the **count** messages
+ * described by **data** and **sizes** and writes it to the corresponding
+ * element of **hashes**. It is equivalent to calling oe_sha256_init(),
+ * oe_sha256_update() and oe_sha256_final() for each message, but lets the
+ * implementation process the messages together.
+ *
+ * @param data array of pointers to the messages to be hashed
+ * @param sizes array of the sizes of the messages
+ * @param count number of messages
+ * @param hashes array where the hashes are written
+ *
+ * @return OE_OK upon success
+ */
+oe_result_t oe_sha256_multi(
+    const void* const* data,
+    const size_t* sizes,
+    size_t count,
+    OE_SHA256* hashes);
+
 OE_EXTERNC_END
 
 #endif /* _OE_SHA_H */
@@ -0,0 +1,43 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_KEYCACHE_H
+#define _OE_KEYCACHE_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+#include <openenclave/enclave.h>
+
+OE_EXTERNC_BEGIN
+
+/**
+ * Evict seal keys from the enclave key cache.
+ *
+ * Seal keys returned by oe_get_seal_key_by_policy_v2() and
+ * oe_get_seal_key_v2() are cached inside the enclave after they are first
+ * derived. This function zeroizes and drops the cached keys, so that they
+ * are derived again by the platform on next use.
+ *
+ * @param seal_policy If non-NULL, only evict the keys derived with this
+ * policy. Otherwise evict all keys.
+ */
+void oe_evict_seal_keys(const oe_seal_policy_t* seal_policy);
+
+/**
+ * Check whether the key described by the given key information is derived
+ * with the given seal policy.
+ *
+ * @param key_info The enclave-specific key information.
+ * @param key_info_size The size of the **key_info** buffer.
+ * @param seal_policy The seal policy.
+ *
+ * @returns true if **key_info** is valid and uses **seal_policy**.
+ */
+bool oe_key_info_has_seal_policy(
+    const uint8_t* key_info,
+    size_t key_info_size,
+    oe_seal_policy_t seal_policy);
+
+OE_EXTERNC_END
+
+#endif /* _OE_KEYCACHE_H */
@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_LOGRING_H
+#define _OE_LOGRING_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+/*
+**==============================================================================
+**
+** oe_log_ring_t
+**
+**     A buffer in host memory through which one enclave thread passes its log
+**     messages to the host without an OCALL per message. The enclave appends
+**     records and advances the head; a host thread reads the records and
+**     advances the tail. Both are byte counts since the ring was created, so
+**     head - tail is the number of bytes in use.
+**
+**     Each record is an oe_log_record_t followed by a null-terminated message,
+**     padded to OE_LOG_RECORD_ALIGNMENT bytes. Records do not wrap around the
+**     end of the data: the enclave fills the rest of the data with a record
+**     of level OE_LOG_RECORD_PADDING instead.
+**
+**==============================================================================
+*/
+
+/* The number of data bytes in a ring (a power of two) */
+#define OE_LOG_RING_SIZE (32 * 1024)
+
+/* The maximum number of rings passed to an enclave */
+#define OE_LOG_RING_COUNT_MAX 32
+
+#define OE_LOG_RECORD_ALIGNMENT 8
+
+/* The level of the record that skips to the end of the data */
+#define OE_LOG_RECORD_PADDING 0xffffffff
+
+typedef struct _oe_log_record
+{
+    /* The oe_log_level_t of the message, or OE_LOG_RECORD_PADDING */
+    uint32_t level;
+
+    /* The size of the message, including the null terminator */
+    uint32_t size;
+} oe_log_record_t;
+
+typedef struct _oe_log_ring
+{
+    /* Bytes written by the enclave */
+    volatile uint64_t head;
+
+    /* Bytes consumed by the host (on another cache line than head) */
+    OE_ALIGNED(64) volatile uint64_t tail;
+
+    /* Messages the enclave dropped because the ring was full */
+    OE_ALIGNED(64) volatile uint64_t dropped;
+
+    OE_ALIGNED(64) uint8_t data[OE_LOG_RING_SIZE];
+} oe_log_ring_t;
+
+OE_EXTERNC_END
+
+#endif /* _OE_LOGRING_H */
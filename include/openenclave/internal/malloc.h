@@ -19,6 +19,13 @@ typedef void (*oe_allocation_failure_callback_t)(
 void oe_set_allocation_failure_callback(
     oe_allocation_failure_callback_t function);
 
+/* Releases memory cached by the runtime back to the heap. Called when an
+ * allocation fails; returns true if memory was released, in which case the
+ * allocation is retried once. */
+typedef bool (*oe_memory_reclaim_callback_t)(void);
+
+void oe_set_memory_reclaim_callback(oe_memory_reclaim_callback_t function);
+
 typedef struct _oe_malloc_stats
 {
     uint64_t peak_system_bytes;
@@ -0,0 +1,24 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_INTERNAL_MEMOPS_H
+#define _OE_INTERNAL_MEMOPS_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+/* The optional paths of memcpy(), memset(), memcmp() and strlen() in SGX
+ * enclaves. The SSE2 paths are always available. */
+#define OE_MEMOPS_AVX2 0x1
+#define OE_MEMOPS_ERMS 0x2
+
+/* Select the optional paths to use, among those that the processor supports,
+ * so that tests can exercise each of them. By default all the supported
+ * paths are used. Returns the paths selected. */
+uint32_t oe_select_memops(uint32_t memops);
+
+OE_EXTERNC_END
+
+#endif /* _OE_INTERNAL_MEMOPS_H */
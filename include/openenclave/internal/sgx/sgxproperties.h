@@ -42,4 +42,10 @@ OE_INLINE bool oe_sgx_is_valid_attributes(uint64_t x)
     return true;
 }
 
+OE_INLINE bool oe_sgx_is_valid_config_flags(uint32_t x)
+{
+    /* Check for illegal bits */
+    return !(x & ~OE_SGX_CONFIG_PERSISTENT_THREAD_LOCALS);
+}
+
 #endif /* _OE_INTERNAL_SGX_PROPERTIES_H */
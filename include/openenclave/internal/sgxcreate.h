@@ -62,6 +62,31 @@ struct _oe_sgx_load_context
 
     /* Hash context used to measure enclave as it is loaded */
     oe_sha256_context_t hash_context;
+
+    /* The measurement of ECREATE and of the image pages added before the
+     * first page holding the enclave properties does not depend on the
+     * properties (other than through the enclave size), so measurement-only
+     * builds of an image save it and reuse it (see oe_sgx_build_enclave()).
+     * Only oe_sgx_load_enclave_data() takes part, since the image pages are
+     * added one at a time. */
+    struct
+    {
+        bool enabled;
+
+        /* Range of the pages holding the properties, relative to the base */
+        uint64_t oeinfo_start;
+        uint64_t oeinfo_end;
+
+        /* Whether the prefix has been saved, or restored to hash_context */
+        bool complete;
+
+        /* Pages added so far, and the number in the prefix once complete */
+        size_t count;
+        size_t num_pages;
+
+        /* The state of hash_context at the end of the prefix */
+        oe_sha256_context_t hash_context;
+    } prefix;
 };
 
 oe_result_t oe_sgx_initialize_load_context(
@@ -20,10 +20,15 @@ typedef enum _oe_fd_type
     OE_FD_TYPE_FILE,
     OE_FD_TYPE_SOCKET,
     OE_FD_TYPE_EPOLL,
+    OE_FD_TYPE_EVENTFD,
+    OE_FD_TYPE_PIPE,
 } oe_fd_type_t;
 
 typedef struct _oe_fd oe_fd_t;
 
+/* See <openenclave/internal/syscall/waitqueue.h>. */
+struct _oe_wait_queue;
+
 /* Common operations on file-descriptor objects. */
 typedef struct _oe_fd_ops
 {
@@ -44,6 +49,13 @@ typedef struct _oe_fd_ops
     int (*close)(oe_fd_t* desc);
 
     oe_host_fd_t (*get_host_fd)(oe_fd_t* desc);
+
+    /* Only for descriptors without a host descriptor, which poll() and
+     * epoll_wait() check in the enclave: return the ready events
+     * (OE_POLLIN, OE_POLLOUT, ...) and the queue that is woken when they
+     * may change. NULL otherwise. A caller that gets the queue must add a
+     * waiter to it and remove it with oe_wait_queue_remove(). */
+    short (*poll)(oe_fd_t* desc, struct _oe_wait_queue** queue);
 } oe_fd_ops_t;
 
 /* File operations. */
@@ -54,6 +66,26 @@ typedef struct _oe_file_ops
 
     oe_off_t (*lseek)(oe_fd_t* file, oe_off_t offset, int whence);
 
+    ssize_t (*pread)(oe_fd_t* file, void* buf, size_t count, oe_off_t offset);
+
+    ssize_t (*pwrite)(
+        oe_fd_t* file,
+        const void* buf,
+        size_t count,
+        oe_off_t offset);
+
+    ssize_t (*preadv)(
+        oe_fd_t* file,
+        const struct oe_iovec* iov,
+        int iovcnt,
+        oe_off_t offset);
+
+    ssize_t (*pwritev)(
+        oe_fd_t* file,
+        const struct oe_iovec* iov,
+        int iovcnt,
+        oe_off_t offset);
+
     int (*getdents64)(oe_fd_t* file, struct oe_dirent* dirp, uint32_t count);
 } oe_file_ops_t;
 
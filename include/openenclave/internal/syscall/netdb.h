@@ -50,6 +50,22 @@ OE_EXTERNC_BEGIN
 #undef __OE_ADDRINFO
 #undef __OE_SOCKADDR
 
+/* oe_syscall_getaddrinfo_ocall() packs its results into one buffer as a
+ * sequence of these records. Each is followed by ai_addrlen bytes of address
+ * and ai_canonnamelen bytes of zero-terminated canonical name, and padded to
+ * a multiple of OE_ADDRINFO_RECORD_ALIGN bytes. */
+struct oe_addrinfo_record
+{
+    int32_t ai_flags;
+    int32_t ai_family;
+    int32_t ai_socktype;
+    int32_t ai_protocol;
+    uint32_t ai_addrlen;
+    uint32_t ai_canonnamelen;
+};
+
+#define OE_ADDRINFO_RECORD_ALIGN 8
+
 int oe_getaddrinfo(
     const char* node,
     const char* service,
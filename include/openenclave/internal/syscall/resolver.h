@@ -49,6 +49,18 @@ typedef struct _oe_resolver
 
 int oe_register_resolver(oe_resolver_t* resolver);
 
+/* Build an addrinfo list from the records packed by the host (see struct
+ * oe_addrinfo_record). The buffer is checked, so it may come from the host.
+ * Returns 0 or an OE_EAI_* error. */
+int oe_unpack_addrinfo(
+    const void* buf,
+    size_t size,
+    struct oe_addrinfo** res);
+
+/* The number of oe_getaddrinfo() calls answered by the resolver cache (see
+ * oe_set_resolver_cache()). */
+uint64_t oe_get_resolver_cache_hits(void);
+
 OE_EXTERNC_END
 
 #endif /* _OE_SYSCALL_RESOLVER_H */
@@ -23,6 +23,15 @@ OE_EXTERNC_BEGIN
 #define OE_EPOLL_CTL_DEL 2
 #define OE_EPOLL_CTL_MOD 3
 
+/* Non-standard oe_epoll_create1() flag. oe_epoll_ctl() checks the change
+ * against the file descriptors it already knows and records it, and the
+ * recorded changes reach the host with the next oe_epoll_wait(). A change
+ * that the host rejects is reported by a later oe_epoll_wait() as an
+ * OE_EPOLLERR event with the data of the file descriptor, which is no longer
+ * watched afterwards. File descriptors should be removed with
+ * OE_EPOLL_CTL_DEL before they are closed. */
+#define OE_EPOLL_DEFER_CTL 0x40000000
+
 enum OE_EPOLL_EVENTS
 {
     OE_EPOLLIN = 0x001,
@@ -52,6 +61,22 @@ enum OE_EPOLL_EVENTS
 #include <openenclave/internal/syscall/sys/bits/epoll_event.h>
 #undef __OE_EPOLL_EVENT
 
+/* A change recorded by oe_epoll_ctl() on an OE_EPOLL_DEFER_CTL instance. */
+struct oe_epoll_change
+{
+    /* The host file descriptor. */
+    int64_t fd;
+
+    /* OE_EPOLL_CTL_ADD, OE_EPOLL_CTL_MOD or OE_EPOLL_CTL_DEL. */
+    int op;
+
+    /* Set by the host to zero or to the errno of its epoll_ctl(). */
+    int error;
+
+    /* The events, with data.fd set to the enclave file descriptor. */
+    struct oe_epoll_event event;
+};
+
 int oe_epoll_create(int size);
 
 int oe_epoll_create1(int flags);
@@ -71,6 +96,10 @@ int oe_epoll_pwait(
     int timeout,
     const oe_sigset_t* sigmask);
 
+/* Interrupt the threads waiting on the given epoll instance. Their
+ * oe_epoll_wait() fails with OE_EINTR unless other events are ready. */
+int oe_epoll_wake(int epfd);
+
 OE_EXTERNC_END
 
 #endif /* _OE_SYS_EPOLL_H */
@@ -0,0 +1,25 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_SYSCALL_SYS_EVENTFD_H
+#define _OE_SYSCALL_SYS_EVENTFD_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+// clang-format off
+#define OE_EFD_SEMAPHORE 00000001
+#define OE_EFD_NONBLOCK  00004000
+#define OE_EFD_CLOEXEC   02000000
+// clang-format on
+
+typedef uint64_t oe_eventfd_t;
+
+/* Create an eventfd that is kept in the enclave. */
+int oe_eventfd(unsigned int initval, int flags);
+
+OE_EXTERNC_END
+
+#endif /* _OE_SYSCALL_SYS_EVENTFD_H */
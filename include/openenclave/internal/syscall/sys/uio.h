@@ -6,6 +6,7 @@
 
 #include <openenclave/bits/defs.h>
 #include <openenclave/bits/types.h>
+#include <openenclave/corelibc/bits/types.h>
 
 OE_EXTERNC_BEGIN
 
@@ -19,6 +20,18 @@ ssize_t oe_readv(int fd, const struct oe_iovec* iov, int iovcnt);
 
 ssize_t oe_writev(int fd, const struct oe_iovec* iov, int iovcnt);
 
+ssize_t oe_preadv(
+    int fd,
+    const struct oe_iovec* iov,
+    int iovcnt,
+    oe_off_t offset);
+
+ssize_t oe_pwritev(
+    int fd,
+    const struct oe_iovec* iov,
+    int iovcnt,
+    oe_off_t offset);
+
 OE_EXTERNC_END
 
 #endif /* _OE_SYSCALL_SYS_UIO_H */
@@ -43,6 +43,18 @@ ssize_t oe_write(int fd, const void* buf, size_t count);
 
 oe_off_t oe_lseek(int fd, oe_off_t offset, int whence);
 
+ssize_t oe_pread(int fd, void* buf, size_t count, oe_off_t offset);
+
+ssize_t oe_pwrite(int fd, const void* buf, size_t count, oe_off_t offset);
+
+ssize_t oe_copy_file_range(
+    int fd_in,
+    oe_off_t* off_in,
+    int fd_out,
+    oe_off_t* off_out,
+    size_t len,
+    unsigned int flags);
+
 int oe_truncate(const char* path, oe_off_t length);
 
 int oe_truncate_d(uint64_t devid, const char* path, oe_off_t length);
@@ -77,6 +89,11 @@ int oe_dup(int fd);
 
 int oe_dup2(int fd, int newfd);
 
+/* Create a pipe that is kept in the enclave. */
+int oe_pipe(int pipefd[2]);
+
+int oe_pipe2(int pipefd[2], int flags);
+
 oe_pid_t oe_getpid(void);
 
 oe_pid_t oe_getppid(void);
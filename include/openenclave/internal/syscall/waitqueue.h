@@ -0,0 +1,87 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_SYSCALL_WAITQUEUE_H
+#define _OE_SYSCALL_WAITQUEUE_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+#include <openenclave/internal/syscall/fd.h>
+#include <openenclave/internal/syscall/types.h>
+#include <openenclave/internal/thread.h>
+
+OE_EXTERNC_BEGIN
+
+/* A thread waiting for enclave-internal descriptors (see oe_fd_ops_t.poll)
+ * to become ready. The thread sleeps on the host, in a wait that includes
+ * the wake instance of the waiter, so it can wait for host descriptors at
+ * the same time. */
+typedef struct _oe_waiter
+{
+    /* A host epoll instance that only watches its wake eventfd. It belongs
+     * to this waiter until oe_waiter_destroy(). */
+    oe_host_fd_t wake_fd;
+
+    /* Set by the first oe_wait_queue_wake() that wakes this waiter. */
+    uint64_t woken;
+
+    /* Set when the wake instance has been reset since it was woken. */
+    bool reset;
+} oe_waiter_t;
+
+/* Links a waiter into the queue of a descriptor. */
+typedef struct _oe_wait_link
+{
+    struct _oe_wait_link* prev;
+    struct _oe_wait_link* next;
+    struct _oe_wait_queue* queue;
+    oe_waiter_t* waiter;
+} oe_wait_link_t;
+
+/* The waiters of an enclave-internal descriptor. Zero-filled when empty. */
+typedef struct _oe_wait_queue
+{
+    oe_mutex_t lock;
+    oe_wait_link_t* head;
+
+    /* If set, poll() takes a reference to the object that holds the queue
+     * for each waiter, since the last descriptor of the object may be
+     * closed while the waiter sleeps. oe_wait_queue_remove() drops it
+     * through this function. */
+    void (*release)(struct _oe_wait_queue* queue);
+} oe_wait_queue_t;
+
+/* Take a wake instance for the calling thread. A waiter is woken once, so a
+ * thread that waits again after a wakeup needs a new one. */
+int oe_waiter_init(oe_waiter_t* waiter);
+
+/* Give the wake instance back. The waiter must not be in any queue. */
+void oe_waiter_destroy(oe_waiter_t* waiter);
+
+/* Sleep on the host until the waiter is woken or the timeout (in
+ * milliseconds, or -1) expires. Returns 0, or -1 with oe_errno set. */
+int oe_waiter_sleep(oe_waiter_t* waiter, int timeout);
+
+/* Add a waiter to a queue. A thread adds itself to the queues of the
+ * descriptors it waits for, checks them, and only then sleeps, so that no
+ * wakeup is lost. */
+void oe_wait_queue_add(
+    oe_wait_queue_t* queue,
+    oe_wait_link_t* link,
+    oe_waiter_t* waiter);
+
+/* Remove a waiter from the queue, and drop the reference to the queue that
+ * poll() took for it. The queue may be freed on return. */
+void oe_wait_queue_remove(oe_wait_link_t* link);
+
+/* Wake the waiters of a queue, after the events of its descriptor may have
+ * changed. This only makes an OCALL if a thread waits. */
+void oe_wait_queue_wake(oe_wait_queue_t* queue);
+
+/* Block until one of the given events is ready on an enclave-internal
+ * descriptor. For the blocking operations of such descriptors. */
+int oe_fd_wait(oe_fd_t* desc, short events);
+
+OE_EXTERNC_END
+
+#endif // _OE_SYSCALL_WAITQUEUE_H
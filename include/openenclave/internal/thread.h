@@ -52,6 +52,26 @@ oe_thread_t oe_thread_self(void);
  */
 bool oe_thread_equal(oe_thread_t thread1, oe_thread_t thread2);
 
+/**
+ * Run a function on a new enclave thread.
+ *
+ * This function asks the host to have one of its threads enter the enclave
+ * on a free thread context (TCS) and call **start_routine(arg)** there. It
+ * returns once the host has accepted the request, without waiting for the
+ * function to start. The new thread occupies a thread context until
+ * **start_routine** returns.
+ *
+ * @param start_routine The function to run on the new thread.
+ * @param arg The argument passed to **start_routine**.
+ *
+ * @returns OE_OK The host accepted the request.
+ * @returns OE_INVALID_PARAMETER **start_routine** is null.
+ * @returns OE_OUT_OF_MEMORY The request could not be allocated.
+ * @returns OE_UNSUPPORTED The platform cannot start enclave threads.
+ *
+ */
+oe_result_t oe_thread_create(void (*start_routine)(void*), void* arg);
+
 typedef uint32_t oe_once_t;
 
 /**
@@ -29,6 +29,15 @@ extern oe_log_level_t _log_level;
 
 #if !defined(OE_BUILD_ENCLAVE)
 oe_result_t oe_log_enclave_init(oe_enclave_t* enclave);
+
+/* Write the messages the enclave has logged but the host has not yet
+ * written, for all enclaves if **enclave** is null */
+void oe_log_enclave_flush(oe_enclave_t* enclave);
+
+/* Flush the log of the enclave and release the resources used to collect it.
+ * Called when the enclave is terminated. */
+void oe_log_enclave_fini(oe_enclave_t* enclave);
+
 void oe_log_message(bool is_enclave, oe_log_level_t level, const char* message);
 #endif
 
@@ -8,7 +8,9 @@
 #include <openenclave/internal/pthreadhooks.h>
 #include <openenclave/internal/sgxtypes.h>
 #include <openenclave/internal/thread.h>
+#include <errno.h>
 #include <pthread.h>
+#include <stdlib.h>
 
 #ifdef pthread_equal
 #undef pthread_equal
@@ -50,9 +52,12 @@ OE_STATIC_ASSERT(sizeof(pthread_rwlock_t) >= sizeof(oe_rwlock_t));
 
 static __thread struct __pthread _pthread_self = {.locale = C_LOCALE};
 
+/* The pthread_t of a thread started by pthread_create() */
+static __thread pthread_t _pthread_created;
+
 pthread_t __pthread_self()
 {
-    return &_pthread_self;
+    return _pthread_created ? _pthread_created : &_pthread_self;
 }
 
 OE_WEAK_ALIAS(__pthread_self, pthread_self);
@@ -64,6 +69,152 @@ void oe_register_pthread_hooks(oe_pthread_hooks_t* pthread_hooks)
     _pthread_hooks = pthread_hooks;
 }
 
+/*
+**==============================================================================
+**
+** Enclave threads
+**
+**     Unless pthread hooks are registered, pthread_create() runs the thread
+**     on a host thread that enters the enclave on a free thread context (see
+**     oe_thread_create()). The pthread_t of such a thread points to an
+**     enclave_thread_t, and pthread_join() and pthread_detach() synchronize
+**     with the thread through its mutex and condition variable.
+**
+**==============================================================================
+*/
+
+typedef struct _enclave_thread
+{
+    struct __pthread base;
+    void* (*start_routine)(void*);
+    void* arg;
+    void* retval;
+    oe_mutex_t mutex;
+    oe_cond_t cond;
+    bool exited;
+    bool detached;
+} enclave_thread_t;
+
+static void _free_enclave_thread(enclave_thread_t* thread)
+{
+    oe_cond_destroy(&thread->cond);
+    oe_mutex_destroy(&thread->mutex);
+    free(thread);
+}
+
+static void _enclave_thread_start(void* arg)
+{
+    enclave_thread_t* thread = (enclave_thread_t*)arg;
+    void* retval;
+    bool detached;
+
+    _pthread_created = &thread->base;
+    retval = thread->start_routine(thread->arg);
+    _pthread_created = NULL;
+
+    oe_mutex_lock(&thread->mutex);
+    thread->retval = retval;
+    thread->exited = true;
+    detached = thread->detached;
+    oe_cond_broadcast(&thread->cond);
+    oe_mutex_unlock(&thread->mutex);
+
+    if (detached)
+        _free_enclave_thread(thread);
+}
+
+static int _create_enclave_thread(
+    pthread_t* thread_out,
+    const pthread_attr_t* attr,
+    void* (*start_routine)(void*),
+    void* arg)
+{
+    enclave_thread_t* thread;
+    oe_result_t result;
+
+    if (!thread_out || !start_routine)
+        return EINVAL;
+
+    if (!(thread = (enclave_thread_t*)calloc(1, sizeof(enclave_thread_t))))
+        return EAGAIN;
+
+    thread->base.self = &thread->base;
+    thread->base.locale = C_LOCALE;
+    thread->start_routine = start_routine;
+    thread->arg = arg;
+    thread->detached = attr && attr->_a_detach == PTHREAD_CREATE_DETACHED;
+    oe_mutex_init(&thread->mutex);
+    oe_cond_init(&thread->cond);
+
+    /* Set the output first, as the thread may exit before this returns */
+    *thread_out = &thread->base;
+
+    if ((result = oe_thread_create(_enclave_thread_start, thread)) != OE_OK)
+    {
+        _free_enclave_thread(thread);
+        return result == OE_UNSUPPORTED ? ENOSYS : EAGAIN;
+    }
+
+    return 0;
+}
+
+static int _join_enclave_thread(pthread_t thread_id, void** retval)
+{
+    enclave_thread_t* thread = (enclave_thread_t*)thread_id;
+
+    if (!thread)
+        return ESRCH;
+
+    if (thread_id == __pthread_self())
+        return EDEADLK;
+
+    oe_mutex_lock(&thread->mutex);
+
+    if (thread->detached)
+    {
+        oe_mutex_unlock(&thread->mutex);
+        return EINVAL;
+    }
+
+    while (!thread->exited)
+        oe_cond_wait(&thread->cond, &thread->mutex);
+
+    oe_mutex_unlock(&thread->mutex);
+
+    if (retval)
+        *retval = thread->retval;
+
+    _free_enclave_thread(thread);
+
+    return 0;
+}
+
+static int _detach_enclave_thread(pthread_t thread_id)
+{
+    enclave_thread_t* thread = (enclave_thread_t*)thread_id;
+    bool exited;
+
+    if (!thread)
+        return ESRCH;
+
+    oe_mutex_lock(&thread->mutex);
+
+    if (thread->detached)
+    {
+        oe_mutex_unlock(&thread->mutex);
+        return EINVAL;
+    }
+
+    thread->detached = true;
+    exited = thread->exited;
+    oe_mutex_unlock(&thread->mutex);
+
+    if (exited)
+        _free_enclave_thread(thread);
+
+    return 0;
+}
+
 int pthread_create(
     pthread_t* thread,
     const pthread_attr_t* attr,
@@ -71,10 +222,7 @@ int pthread_create(
     void* arg)
 {
     if (!_pthread_hooks || !_pthread_hooks->create)
-    {
-        oe_assert("pthread_create(): panic" == NULL);
-        return -1;
-    }
+        return _create_enclave_thread(thread, attr, start_routine, arg);
 
     return _pthread_hooks->create(thread, attr, start_routine, arg);
 }
@@ -82,10 +230,7 @@ int pthread_create(
 int pthread_join(pthread_t thread, void** retval)
 {
     if (!_pthread_hooks || !_pthread_hooks->join)
-    {
-        oe_assert("pthread_join(): panic" == NULL);
-        return -1;
-    }
+        return _join_enclave_thread(thread, retval);
 
     return _pthread_hooks->join(thread, retval);
 }
@@ -93,10 +238,7 @@ int pthread_join(pthread_t thread, void** retval)
 int pthread_detach(pthread_t thread)
 {
     if (!_pthread_hooks || !_pthread_hooks->detach)
-    {
-        oe_assert("pthread_detach(): panic" == NULL);
-        return -1;
-    }
+        return _detach_enclave_thread(thread);
 
     return _pthread_hooks->detach(thread);
 }
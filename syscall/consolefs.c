@@ -325,6 +325,78 @@ done:
     return ret;
 }
 
+static ssize_t _consolefs_pread(
+    oe_fd_t* file_,
+    void* buf,
+    size_t count,
+    oe_off_t offset)
+{
+    ssize_t ret = -1;
+
+    OE_UNUSED(file_);
+    OE_UNUSED(buf);
+    OE_UNUSED(count);
+    OE_UNUSED(offset);
+    OE_RAISE_ERRNO(OE_ESPIPE);
+
+done:
+    return ret;
+}
+
+static ssize_t _consolefs_pwrite(
+    oe_fd_t* file_,
+    const void* buf,
+    size_t count,
+    oe_off_t offset)
+{
+    ssize_t ret = -1;
+
+    OE_UNUSED(file_);
+    OE_UNUSED(buf);
+    OE_UNUSED(count);
+    OE_UNUSED(offset);
+    OE_RAISE_ERRNO(OE_ESPIPE);
+
+done:
+    return ret;
+}
+
+static ssize_t _consolefs_preadv(
+    oe_fd_t* file_,
+    const struct oe_iovec* iov,
+    int iovcnt,
+    oe_off_t offset)
+{
+    ssize_t ret = -1;
+
+    OE_UNUSED(file_);
+    OE_UNUSED(iov);
+    OE_UNUSED(iovcnt);
+    OE_UNUSED(offset);
+    OE_RAISE_ERRNO(OE_ESPIPE);
+
+done:
+    return ret;
+}
+
+static ssize_t _consolefs_pwritev(
+    oe_fd_t* file_,
+    const struct oe_iovec* iov,
+    int iovcnt,
+    oe_off_t offset)
+{
+    ssize_t ret = -1;
+
+    OE_UNUSED(file_);
+    OE_UNUSED(iov);
+    OE_UNUSED(iovcnt);
+    OE_UNUSED(offset);
+    OE_RAISE_ERRNO(OE_ESPIPE);
+
+done:
+    return ret;
+}
+
 static int _consolefs_close(oe_fd_t* file_)
 {
     int ret = -1;
@@ -376,6 +448,10 @@ static oe_file_ops_t _ops = {
     .fd.close = _consolefs_close,
     .fd.get_host_fd = _consolefs_gethostfd,
     .lseek = _consolefs_lseek,
+    .pread = _consolefs_pread,
+    .pwrite = _consolefs_pwrite,
+    .preadv = _consolefs_preadv,
+    .pwritev = _consolefs_pwritev,
     .getdents64 = _consolefs_getdents64,
 };
 
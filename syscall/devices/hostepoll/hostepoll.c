@@ -16,7 +16,10 @@
 #include <openenclave/internal/syscall/iov.h>
 #include <openenclave/internal/syscall/raise.h>
 #include <openenclave/internal/syscall/sys/ioctl.h>
+#include <openenclave/internal/syscall/sys/poll.h>
+#include <openenclave/internal/syscall/waitqueue.h>
 #include <openenclave/internal/thread.h>
+#include <openenclave/internal/time.h>
 #include <openenclave/internal/trace.h>
 #include <openenclave/internal/utils.h>
 #include "syscall_t.h"
@@ -24,6 +27,10 @@
 /* The map allocation grows in multiples of the chunk size. */
 #define MAP_CHUNK_SIZE 1024
 
+/* The number of changes an OE_EPOLL_DEFER_CTL instance records before it
+ * flushes them to the host without waiting. */
+#define MAX_CHANGES 64
+
 #define DEVICE_MAGIC 0x4504f4c
 #define EPOLL_MAGIC 0x708f5a51
 
@@ -35,6 +42,12 @@ typedef struct _mapping
 
     /* The event parameter from epoll_ctl(). */
     struct oe_epoll_event event;
+
+    /* Set for an enclave-internal file, which the host does not see. */
+    bool enclave;
+
+    /* Set when an OE_EPOLLONESHOT enclave-internal file has fired. */
+    bool disabled;
 } mapping_t;
 
 /* The epoll device. */
@@ -61,6 +74,33 @@ typedef struct _epoll
     size_t map_size;
     size_t map_capacity;
 
+    /* Set by OE_EPOLL_DEFER_CTL. */
+    bool defer_ctl;
+
+    /* Changes recorded by epoll_ctl() for the next epoll_wait(). */
+    struct oe_epoll_change changes[MAX_CHANGES];
+    size_t num_changes;
+
+    /* Set while a thread is sending the recorded changes to the host. */
+    bool flushing;
+
+    /* OE_EPOLLERR events for the changes that the host rejected. */
+    struct oe_epoll_event errors[MAX_CHANGES];
+    size_t num_errors;
+
+    /* The number of mappings for enclave-internal files. */
+    size_t num_enclave;
+
+    /* Changed by every epoll_ctl() on an enclave-internal file. */
+    uint64_t version;
+
+    /* Waiters that must see changes to the enclave-internal files. */
+    oe_wait_queue_t queue;
+
+    /* Set when the next epoll_wait() that finds enclave-internal events
+     * should also look at the host. */
+    bool host_turn;
+
     /* Synchronizes access to this structure. */
     oe_spinlock_t lock;
 } epoll_t;
@@ -139,6 +179,23 @@ static mapping_t* _map_find(epoll_t* epoll, int fd)
     return NULL;
 }
 
+/* Remove the mapping for the given file descriptor. */
+static bool _map_remove(epoll_t* epoll, int fd)
+{
+    for (size_t i = 0; i < epoll->map_size; i++)
+    {
+        if (epoll->map[i].fd == fd)
+        {
+            /* Swap with last element of array. */
+            epoll->map[i] = epoll->map[--epoll->map_size];
+            return true;
+        }
+    }
+
+    /* Not found */
+    return false;
+}
+
 /* Called by oe_epoll_create1(). */
 static oe_fd_t* _epoll_create1(oe_device_t* device_, int32_t flags)
 {
@@ -155,8 +212,12 @@ static oe_fd_t* _epoll_create1(oe_device_t* device_, int32_t flags)
     if (!(epoll = oe_calloc(1, sizeof(epoll_t))))
         OE_RAISE_ERRNO(OE_ENOMEM);
 
-    if (oe_syscall_epoll_create1_ocall(&retval, flags) != OE_OK)
+    /* The host does not know about OE_EPOLL_DEFER_CTL. */
+    if (oe_syscall_epoll_create1_ocall(
+            &retval, flags & ~OE_EPOLL_DEFER_CTL) != OE_OK)
+    {
         OE_RAISE_ERRNO(OE_EINVAL);
+    }
 
     if (retval < 0)
         goto done;
@@ -165,6 +226,7 @@ static oe_fd_t* _epoll_create1(oe_device_t* device_, int32_t flags)
     epoll->base.ops.epoll = _get_epoll_ops();
     epoll->magic = EPOLL_MAGIC;
     epoll->host_fd = retval;
+    epoll->defer_ctl = (flags & OE_EPOLL_DEFER_CTL) != 0;
 
     ret = &epoll->base;
     epoll = NULL;
@@ -352,102 +414,534 @@ static int _epoll_ctl_del(epoll_t* epoll, int fd)
     /* Delete the mapping. */
     if (retval == 0)
     {
-        bool found = false;
+        bool found;
 
         oe_spin_lock(&epoll->lock);
+        found = _map_remove(epoll, fd);
+        oe_spin_unlock(&epoll->lock);
+
+        if (!found)
+            OE_RAISE_ERRNO(OE_ENOENT);
+    }
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** Deferred changes
+**
+**     An OE_EPOLL_DEFER_CTL instance updates its mappings when epoll_ctl() is
+**     called but only records the change for the host. The next epoll_wait()
+**     sends the recorded changes with the wait in a single OCALL if it does
+**     not block, or in an OCALL of their own before the wait otherwise, and
+**     the host reports the result of each change. A rejected change removes
+**     the mapping and becomes an OE_EPOLLERR event, as kqueue() reports
+**     failed changes with EV_ERROR. Only one thread sends changes at a time,
+**     so the host applies them in the order they were recorded, and it never
+**     blocks meanwhile.
+**
+**==============================================================================
+*/
+
+/* Record a change, merging it with a pending change for the same file.
+ * Returns false if the change list is full. Called with the lock held. */
+static bool _record_change(
+    epoll_t* epoll,
+    int op,
+    int fd,
+    oe_host_fd_t host_fd,
+    const struct oe_epoll_event* event)
+{
+    struct oe_epoll_change* change = NULL;
+
+    for (size_t i = epoll->num_changes; i > 0; i--)
+    {
+        if (epoll->changes[i - 1].event.data.fd == fd)
+        {
+            change = &epoll->changes[i - 1];
+            break;
+        }
+    }
+
+    /* A pending change for a file that reused the fd is not merged. */
+    if (change && change->fd == host_fd)
+    {
+        if (op == OE_EPOLL_CTL_DEL)
         {
-            for (size_t i = 0; epoll->map_size; i++)
+            /* The host never saw the file, so drop the pending add. */
+            if (change->op == OE_EPOLL_CTL_ADD)
             {
-                if (epoll->map[i].fd == fd)
-                {
-                    /* Swap with last element of array. */
-                    epoll->map[i] = epoll->map[--epoll->map_size];
-                    found = true;
-                    break;
-                }
+                struct oe_epoll_change* end =
+                    &epoll->changes[--epoll->num_changes];
+
+                memmove(
+                    change,
+                    change + 1,
+                    (size_t)(end - change) * sizeof(*change));
+                return true;
+            }
+
+            change->op = OE_EPOLL_CTL_DEL;
+            return true;
+        }
+
+        /* The host still watches a file with a pending delete. */
+        if (change->op == OE_EPOLL_CTL_DEL)
+            change->op = OE_EPOLL_CTL_MOD;
+
+        change->event.events = event->events;
+        return true;
+    }
+
+    if (epoll->num_changes == MAX_CHANGES)
+        return false;
+
+    change = &epoll->changes[epoll->num_changes++];
+    change->fd = host_fd;
+    change->op = op;
+    change->error = 0;
+    change->event.events = event ? event->events : 0;
+    change->event.data.u64 = 0;
+    change->event.data.fd = fd;
+
+    return true;
+}
+
+/* Move up to maxevents error events into events. Called with the lock held.
+ */
+static int _take_errors(
+    epoll_t* epoll,
+    struct oe_epoll_event* events,
+    size_t maxevents)
+{
+    size_t n = epoll->num_errors < maxevents ? epoll->num_errors : maxevents;
+
+    memcpy(events, epoll->errors, n * sizeof(*events));
+    epoll->num_errors -= n;
+    memmove(
+        epoll->errors, epoll->errors + n, epoll->num_errors * sizeof(*events));
+
+    return (int)n;
+}
+
+/* Turn the changes that the host rejected into error events, and let the
+ * next thread send its changes. Called with the lock held. */
+static void _finish_changes(
+    epoll_t* epoll,
+    const struct oe_epoll_change* changes,
+    size_t num_changes)
+{
+    for (size_t i = 0; i < num_changes; i++)
+    {
+        const struct oe_epoll_change* change = &changes[i];
+        const int fd = change->event.data.fd;
+        const mapping_t* mapping;
+
+        /* The host cannot fail to forget a file. */
+        if (change->error == 0 || change->op == OE_EPOLL_CTL_DEL)
+            continue;
+
+        if (!(mapping = _map_find(epoll, fd)))
+            continue;
+
+        if (epoll->num_errors < MAX_CHANGES)
+        {
+            struct oe_epoll_event* error = &epoll->errors[epoll->num_errors++];
+
+            error->events = OE_EPOLLERR;
+            error->data.u64 = mapping->event.data.u64;
+        }
+        else
+        {
+            OE_TRACE_ERROR(
+                "epoll_ctl(%d) on the host failed: %d", fd, change->error);
+        }
+
+        _map_remove(epoll, fd);
+
+        /* The host still watches a file whose modification failed. */
+        if (change->op == OE_EPOLL_CTL_MOD)
+            _record_change(epoll, OE_EPOLL_CTL_DEL, fd, change->fd, NULL);
+    }
+
+    epoll->flushing = false;
+}
+
+/* Send the recorded changes to the host and wait for up to maxevents events.
+ * A maxevents of zero only sends the changes. Returns the number of events.
+ */
+static int _flush_changes(
+    epoll_t* epoll,
+    struct oe_epoll_event* events,
+    int maxevents,
+    int timeout)
+{
+    int ret = -1;
+    struct oe_epoll_change changes[MAX_CHANGES];
+    size_t num_changes = 0;
+    int retval = -1;
+    oe_result_t result = OE_OK;
+
+    oe_errno = 0;
+
+    for (;;)
+    {
+        oe_spin_lock(&epoll->lock);
+
+        /* Report the rejected changes before waiting again. */
+        if (maxevents > 0 && epoll->num_errors)
+        {
+            ret = _take_errors(epoll, events, (size_t)maxevents);
+            oe_spin_unlock(&epoll->lock);
+            goto done;
+        }
+
+        /* While another thread sends changes, later ones must wait for it
+         * so that they reach the host after those. It does not block in the
+         * host while the flag is set (see below), so this is short. */
+        if (!epoll->flushing || !epoll->num_changes)
+            break;
+
+        oe_spin_unlock(&epoll->lock);
+        OE_CPU_RELAX();
+    }
+
+    if (!epoll->flushing)
+    {
+        num_changes = epoll->num_changes;
+        memcpy(changes, epoll->changes, num_changes * sizeof(*changes));
+        epoll->num_changes = 0;
+        epoll->flushing = num_changes != 0;
+    }
+
+    oe_spin_unlock(&epoll->lock);
+
+    if (maxevents == 0 && num_changes == 0)
+    {
+        ret = 0;
+        goto done;
+    }
+
+    /* The host applies the changes before it waits, but other threads only
+     * learn that from the reply. So a wait that may block sends the changes
+     * on their own first. */
+    if (num_changes && maxevents > 0 && timeout != 0)
+    {
+        if (oe_syscall_epoll_ctl_wait_ocall(
+                &retval, epoll->host_fd, changes, num_changes, NULL, 0, 0) !=
+            OE_OK)
+        {
+            /* The host may have applied the changes, so forget the
+             * mappings. */
+            for (size_t i = 0; i < num_changes; i++)
+                changes[i].error = OE_EINVAL;
+        }
+
+        oe_spin_lock(&epoll->lock);
+        {
+            _finish_changes(epoll, changes, num_changes);
+
+            if (epoll->num_errors)
+            {
+                ret = _take_errors(epoll, events, (size_t)maxevents);
+                oe_spin_unlock(&epoll->lock);
+                goto done;
             }
         }
         oe_spin_unlock(&epoll->lock);
 
-        if (!found)
+        num_changes = 0;
+    }
+
+    if (num_changes)
+    {
+        result = oe_syscall_epoll_ctl_wait_ocall(
+            &retval,
+            epoll->host_fd,
+            changes,
+            num_changes,
+            events,
+            (unsigned int)maxevents,
+            timeout);
+    }
+    else
+    {
+        result = oe_syscall_epoll_wait_ocall(
+            &retval, epoll->host_fd, events, (unsigned int)maxevents, timeout);
+    }
+
+    if (result != OE_OK)
+    {
+        /* The host may have applied the changes, so forget the mappings. */
+        for (size_t i = 0; i < num_changes; i++)
+            changes[i].error = OE_EINVAL;
+
+        oe_errno = OE_EINVAL;
+        retval = -1;
+    }
+
+    if (retval > maxevents)
+    {
+        oe_errno = OE_EINVAL;
+        retval = -1;
+    }
+
+    oe_spin_lock(&epoll->lock);
+    {
+        int n = 0;
+
+        if (num_changes)
+            _finish_changes(epoll, changes, num_changes);
+
+        /* Map the events to the data of the mappings. Events for files whose
+         * delete is still pending are dropped. */
+        for (int i = 0; i < retval; i++)
+        {
+            const mapping_t* mapping;
+
+            if ((mapping = _map_find(epoll, events[i].data.fd)))
+            {
+                events[n].events = events[i].events;
+                events[n].data.u64 = mapping->event.data.u64;
+                n++;
+            }
+        }
+
+        if (retval >= 0 || (maxevents > 0 && epoll->num_errors))
+        {
+            if (maxevents > n)
+                n += _take_errors(epoll, events + n, (size_t)(maxevents - n));
+
+            oe_errno = 0;
+            ret = n;
+        }
+    }
+    oe_spin_unlock(&epoll->lock);
+
+done:
+    return ret;
+}
+
+/* Called by oe_epoll_ctl() for an OE_EPOLL_DEFER_CTL instance. */
+static int _epoll_ctl_defer(
+    epoll_t* epoll,
+    int op,
+    int fd,
+    struct oe_epoll_event* event)
+{
+    int ret = -1;
+    oe_fd_t* desc;
+    oe_host_fd_t host_fd;
+    bool locked = false;
+
+    oe_errno = 0;
+
+    /* Check parameters. */
+    if (op != OE_EPOLL_CTL_ADD && op != OE_EPOLL_CTL_MOD &&
+        op != OE_EPOLL_CTL_DEL)
+    {
+        OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+    if (op != OE_EPOLL_CTL_DEL && !event)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(desc = oe_fdtable_get(fd, OE_FD_TYPE_ANY)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    /* Get the host fd for the fd. */
+    if ((host_fd = desc->ops.fd.get_host_fd(desc)) == -1)
+        OE_RAISE_ERRNO(oe_errno);
+
+    for (;;)
+    {
+        mapping_t* mapping;
+
+        oe_spin_lock(&epoll->lock);
+        locked = true;
+
+        mapping = _map_find(epoll, fd);
+
+        if (op == OE_EPOLL_CTL_ADD)
+        {
+            if (mapping)
+                OE_RAISE_ERRNO(OE_EEXIST);
+
+            if (_map_reserve(epoll, epoll->map_size + 1) != 0)
+                OE_RAISE_ERRNO(OE_ENOMEM);
+        }
+        else if (!mapping)
+        {
             OE_RAISE_ERRNO(OE_ENOENT);
+        }
+
+        if (_record_change(epoll, op, fd, host_fd, event))
+            break;
+
+        /* The change list is full. */
+        oe_spin_unlock(&epoll->lock);
+        locked = false;
+
+        if (_flush_changes(epoll, NULL, 0, 0) == -1)
+            OE_RAISE_ERRNO(oe_errno);
+    }
+
+    switch (op)
+    {
+        case OE_EPOLL_CTL_ADD:
+        {
+            epoll->map[epoll->map_size].fd = fd;
+            epoll->map[epoll->map_size].event = *event;
+            epoll->map_size++;
+            break;
+        }
+
+        case OE_EPOLL_CTL_MOD:
+        {
+            _map_find(epoll, fd)->event = *event;
+            break;
+        }
+
+        case OE_EPOLL_CTL_DEL:
+        {
+            _map_remove(epoll, fd);
+            break;
+        }
     }
 
     ret = 0;
 
 done:
+
+    if (locked)
+        oe_spin_unlock(&epoll->lock);
+
     return ret;
 }
 
-/* Called by oe_epoll_ctl(). */
-static int _epoll_ctl(
-    oe_fd_t* epoll_,
+/*
+**==============================================================================
+**
+** Enclave-internal files
+**
+**     Files without a host fd, such as eventfds and pipes, are never given to
+**     the host. epoll_wait() polls them in the enclave and, when none is
+**     ready, sleeps in a host poll() on both the host instance and the wake
+**     instance of a waiter (see waitqueue.h). Their events are always level-
+**     triggered; OE_EPOLLET is ignored, OE_EPOLLONESHOT is honored.
+**
+**==============================================================================
+*/
+
+/* Called by oe_epoll_ctl() for an enclave-internal file. */
+static int _epoll_ctl_enclave(
+    epoll_t* epoll,
     int op,
     int fd,
     struct oe_epoll_event* event)
 {
     int ret = -1;
-    epoll_t* epoll = _cast_epoll(epoll_);
+    mapping_t* mapping;
+    bool locked = false;
 
-    if (!epoll)
+    oe_errno = 0;
+
+    if (op != OE_EPOLL_CTL_DEL && !event)
         OE_RAISE_ERRNO(OE_EINVAL);
 
+    oe_spin_lock(&epoll->lock);
+    locked = true;
+
+    mapping = _map_find(epoll, fd);
+
     switch (op)
     {
         case OE_EPOLL_CTL_ADD:
         {
-            ret = _epoll_ctl_add(epoll, fd, event);
-            goto done;
+            if (mapping)
+                OE_RAISE_ERRNO(OE_EEXIST);
+
+            if (_map_reserve(epoll, epoll->map_size + 1) != 0)
+                OE_RAISE_ERRNO(OE_ENOMEM);
+
+            mapping = &epoll->map[epoll->map_size++];
+            mapping->fd = fd;
+            mapping->event = *event;
+            mapping->enclave = true;
+            mapping->disabled = false;
+            epoll->num_enclave++;
+            break;
         }
 
         case OE_EPOLL_CTL_MOD:
         {
-            ret = _epoll_ctl_mod(epoll, fd, event);
-            goto done;
+            if (!mapping || !mapping->enclave)
+                OE_RAISE_ERRNO(OE_ENOENT);
+
+            mapping->event = *event;
+            mapping->disabled = false;
+            break;
         }
 
         case OE_EPOLL_CTL_DEL:
         {
-            ret = _epoll_ctl_del(epoll, fd);
-            goto done;
+            if (!mapping || !mapping->enclave)
+                OE_RAISE_ERRNO(OE_ENOENT);
+
+            _map_remove(epoll, fd);
+            epoll->num_enclave--;
+            break;
         }
 
         default:
-        {
             OE_RAISE_ERRNO(OE_EINVAL);
-            return -1;
-        }
     }
 
+    epoll->version++;
+
+    oe_spin_unlock(&epoll->lock);
+    locked = false;
+
+    /* A sleeping epoll_wait() must look at the new events. */
+    oe_wait_queue_wake(&epoll->queue);
+
     ret = 0;
 
 done:
+
+    if (locked)
+        oe_spin_unlock(&epoll->lock);
+
     return ret;
 }
 
-/* Called by oe_epoll_wait(). */
-static int _epoll_wait(
-    oe_fd_t* epoll_,
+/* Wait for events on the host instance. */
+static int _host_wait(
+    epoll_t* epoll,
     struct oe_epoll_event* events,
     int maxevents,
     int timeout)
 {
     int ret = -1;
     int retval;
-    epoll_t* epoll = _cast_epoll(epoll_);
-    oe_host_fd_t host_epfd = -1;
 
-    if (!epoll || !events || maxevents <= 0)
-        OE_RAISE_ERRNO(OE_EINVAL);
-
-    oe_errno = 0;
-
-    if ((host_epfd = epoll_->ops.fd.get_host_fd(epoll_)) == -1)
-        OE_RAISE_ERRNO(oe_errno);
+    if (epoll->defer_ctl)
+    {
+        ret = _flush_changes(epoll, events, maxevents, timeout);
+        goto done;
+    }
 
     if (oe_syscall_epoll_wait_ocall(
-            &retval, host_epfd, events, (unsigned int)maxevents, timeout) !=
-        OE_OK)
+            &retval,
+            epoll->host_fd,
+            events,
+            (unsigned int)maxevents,
+            timeout) != OE_OK)
     {
         OE_RAISE_ERRNO(OE_EINVAL);
     }
@@ -476,6 +970,375 @@ static int _epoll_wait(
 
     ret = (int)retval;
 
+done:
+    return ret;
+}
+
+/* The enclave-internal files of an instance, as of one version. */
+typedef struct _snapshot
+{
+    mapping_t* mappings;
+    oe_fd_t** descs;
+    oe_wait_link_t* links;
+    size_t size;
+    uint64_t version;
+
+    /* Set if the host watches files or has changes or errors to report. */
+    bool host;
+} snapshot_t;
+
+static void _snapshot_free(snapshot_t* snapshot)
+{
+    oe_free(snapshot->mappings);
+    oe_free(snapshot->descs);
+    oe_free(snapshot->links);
+    memset(snapshot, 0, sizeof(snapshot_t));
+}
+
+static int _snapshot_take(epoll_t* epoll, snapshot_t* snapshot)
+{
+    int ret = -1;
+    size_t n = 0;
+
+    _snapshot_free(snapshot);
+
+    oe_spin_lock(&epoll->lock);
+    {
+        snapshot->size = epoll->num_enclave;
+        snapshot->version = epoll->version;
+        snapshot->host = epoll->map_size > epoll->num_enclave ||
+                         epoll->num_changes || epoll->num_errors;
+
+        if ((snapshot->mappings = oe_calloc(snapshot->size, sizeof(mapping_t))))
+        {
+            for (size_t i = 0; i < epoll->map_size; i++)
+            {
+                if (epoll->map[i].enclave)
+                    snapshot->mappings[n++] = epoll->map[i];
+            }
+        }
+    }
+    oe_spin_unlock(&epoll->lock);
+
+    if (!snapshot->mappings ||
+        !(snapshot->descs = oe_calloc(snapshot->size, sizeof(oe_fd_t*))) ||
+        !(snapshot->links = oe_calloc(snapshot->size, sizeof(oe_wait_link_t))))
+    {
+        OE_RAISE_ERRNO(OE_ENOMEM);
+    }
+
+    /* A closed file has no events; the host forgets closed files too. */
+    for (size_t i = 0; i < snapshot->size; i++)
+    {
+        oe_fd_t* desc;
+
+        if ((desc = oe_fdtable_get(snapshot->mappings[i].fd, OE_FD_TYPE_ANY)) &&
+            desc->ops.fd.get_host_fd(desc) == -1 && desc->ops.fd.poll)
+        {
+            snapshot->descs[i] = desc;
+        }
+    }
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/* Poll the enclave-internal files and return the number of ready ones. With
+ * events, also report up to maxevents of them and disable the ones that fire
+ * with OE_EPOLLONESHOT. */
+static int _poll_enclave(
+    epoll_t* epoll,
+    const snapshot_t* snapshot,
+    struct oe_epoll_event* events,
+    int maxevents)
+{
+    int n = 0;
+
+    for (size_t i = 0; i < snapshot->size; i++)
+    {
+        const mapping_t* mapping = &snapshot->mappings[i];
+        oe_fd_t* desc = snapshot->descs[i];
+        uint32_t revents;
+
+        if (!desc || mapping->disabled)
+            continue;
+
+        revents = (uint16_t)desc->ops.fd.poll(desc, NULL);
+        revents &= mapping->event.events | OE_EPOLLERR | OE_EPOLLHUP;
+
+        if (!revents)
+            continue;
+
+        if (events)
+        {
+            if (n == maxevents)
+                break;
+
+            if (mapping->event.events & OE_EPOLLONESHOT)
+            {
+                mapping_t* current;
+                bool fired = true;
+
+                oe_spin_lock(&epoll->lock);
+                {
+                    /* Another thread may have reported it first. */
+                    if ((current = _map_find(epoll, mapping->fd)) &&
+                        current->enclave && !current->disabled)
+                    {
+                        current->disabled = true;
+                        fired = false;
+                    }
+                }
+                oe_spin_unlock(&epoll->lock);
+
+                if (fired)
+                    continue;
+            }
+
+            events[n].events = revents;
+            events[n].data.u64 = mapping->event.data.u64;
+        }
+
+        n++;
+    }
+
+    return n;
+}
+
+/* Called by _epoll_wait() while the instance has enclave-internal files. */
+static int _epoll_wait_enclave(
+    epoll_t* epoll,
+    struct oe_epoll_event* events,
+    int maxevents,
+    int timeout)
+{
+    int ret = -1;
+    snapshot_t snapshot;
+    uint64_t deadline = 0;
+    bool host_ready = false;
+
+    memset(&snapshot, 0, sizeof(snapshot));
+
+    if (timeout > 0)
+        deadline = oe_get_time() + (uint64_t)timeout;
+
+    for (;;)
+    {
+        int n;
+        int retval;
+        int wait_timeout = timeout;
+        oe_waiter_t waiter;
+        oe_wait_link_t link;
+        struct oe_host_pollfd fds[2];
+
+        if (_snapshot_take(epoll, &snapshot) != 0)
+            OE_RAISE_ERRNO(oe_errno);
+
+        n = _poll_enclave(epoll, &snapshot, events, maxevents);
+
+        if (n || host_ready || timeout == 0)
+        {
+            bool host = snapshot.host || host_ready;
+
+            /* Busy enclave-internal files take turns with the host files. */
+            if (n)
+                host = host && (epoll->host_turn = !epoll->host_turn);
+
+            if (host && n < maxevents)
+            {
+                if ((retval = _host_wait(epoll, events + n, maxevents - n, 0)) <
+                    0)
+                {
+                    /* Such as the OE_EINTR of oe_epoll_wake(). */
+                    if (n == 0)
+                        OE_RAISE_ERRNO(oe_errno);
+                }
+                else
+                {
+                    n += retval;
+                }
+            }
+
+            if (n || timeout == 0)
+            {
+                ret = n;
+                goto done;
+            }
+
+            host_ready = false;
+        }
+
+        if (timeout > 0)
+        {
+            const uint64_t now = oe_get_time();
+
+            if (now >= deadline)
+            {
+                ret = 0;
+                goto done;
+            }
+
+            wait_timeout = (int)(deadline - now);
+        }
+
+        /* Queue the waiter, then check again, so that no change is missed. */
+        if (oe_waiter_init(&waiter) != 0)
+            OE_RAISE_ERRNO(oe_errno);
+
+        oe_wait_queue_add(&epoll->queue, &link, &waiter);
+
+        for (size_t i = 0; i < snapshot.size; i++)
+        {
+            oe_fd_t* desc = snapshot.descs[i];
+            oe_wait_queue_t* queue;
+
+            if (desc)
+            {
+                desc->ops.fd.poll(desc, &queue);
+                oe_wait_queue_add(queue, &snapshot.links[i], &waiter);
+            }
+        }
+
+        oe_spin_lock(&epoll->lock);
+        retval = epoll->version != snapshot.version ||
+                 epoll->num_changes || epoll->num_errors;
+        oe_spin_unlock(&epoll->lock);
+
+        if (retval || _poll_enclave(epoll, &snapshot, NULL, 0))
+        {
+            retval = 0;
+        }
+        else
+        {
+            fds[0].fd = epoll->host_fd;
+            fds[0].events = OE_POLLIN;
+            fds[0].revents = 0;
+            fds[1].fd = waiter.wake_fd;
+            fds[1].events = OE_POLLIN;
+            fds[1].revents = 0;
+
+            if (oe_syscall_poll_ocall(&retval, fds, 2, wait_timeout) != OE_OK)
+            {
+                oe_errno = OE_EINVAL;
+                retval = -1;
+            }
+            else if (retval > 0 && fds[0].revents)
+            {
+                host_ready = true;
+            }
+        }
+
+        for (size_t i = 0; i < snapshot.size; i++)
+        {
+            if (snapshot.descs[i])
+                oe_wait_queue_remove(&snapshot.links[i]);
+        }
+
+        oe_wait_queue_remove(&link);
+        oe_waiter_destroy(&waiter);
+
+        if (retval < 0)
+            OE_RAISE_ERRNO(oe_errno);
+    }
+
+done:
+    _snapshot_free(&snapshot);
+    return ret;
+}
+
+/* Called by oe_epoll_ctl(). */
+static int _epoll_ctl(
+    oe_fd_t* epoll_,
+    int op,
+    int fd,
+    struct oe_epoll_event* event)
+{
+    int ret = -1;
+    epoll_t* epoll = _cast_epoll(epoll_);
+
+    if (!epoll)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* The host cannot watch an enclave-internal file. */
+    {
+        oe_fd_t* desc;
+
+        if (!(desc = oe_fdtable_get(fd, OE_FD_TYPE_ANY)))
+            OE_RAISE_ERRNO(oe_errno);
+
+        if (desc->ops.fd.get_host_fd(desc) == -1 && desc->ops.fd.poll)
+        {
+            ret = _epoll_ctl_enclave(epoll, op, fd, event);
+            goto done;
+        }
+    }
+
+    if (epoll->defer_ctl)
+    {
+        ret = _epoll_ctl_defer(epoll, op, fd, event);
+        goto done;
+    }
+
+    switch (op)
+    {
+        case OE_EPOLL_CTL_ADD:
+        {
+            ret = _epoll_ctl_add(epoll, fd, event);
+            goto done;
+        }
+
+        case OE_EPOLL_CTL_MOD:
+        {
+            ret = _epoll_ctl_mod(epoll, fd, event);
+            goto done;
+        }
+
+        case OE_EPOLL_CTL_DEL:
+        {
+            ret = _epoll_ctl_del(epoll, fd);
+            goto done;
+        }
+
+        default:
+        {
+            OE_RAISE_ERRNO(OE_EINVAL);
+            return -1;
+        }
+    }
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/* Called by oe_epoll_wait(). */
+static int _epoll_wait(
+    oe_fd_t* epoll_,
+    struct oe_epoll_event* events,
+    int maxevents,
+    int timeout)
+{
+    int ret = -1;
+    epoll_t* epoll = _cast_epoll(epoll_);
+    size_t num_enclave;
+
+    if (!epoll || !events || maxevents <= 0)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    oe_errno = 0;
+
+    oe_spin_lock(&epoll->lock);
+    num_enclave = epoll->num_enclave;
+    oe_spin_unlock(&epoll->lock);
+
+    if (num_enclave)
+        ret = _epoll_wait_enclave(epoll, events, maxevents, timeout);
+    else
+        ret = _host_wait(epoll, events, maxevents, timeout);
+
 done:
 
     return ret;
@@ -750,6 +1613,10 @@ static int _epoll_dup(oe_fd_t* epoll_, oe_fd_t** new_epoll_out)
     if (!epoll)
         OE_RAISE_ERRNO(OE_EINVAL);
 
+    /* The duplicate shares the host instance, so it must see the changes. */
+    if (epoll->defer_ctl && _flush_changes(epoll, NULL, 0, 0) == -1)
+        OE_RAISE_ERRNO(oe_errno);
+
     /* Call host: */
     {
         if (oe_syscall_dup_ocall(&retval, epoll->host_fd) != OE_OK)
@@ -768,6 +1635,8 @@ static int _epoll_dup(oe_fd_t* epoll_, oe_fd_t** new_epoll_out)
         new_epoll->base.ops.epoll = _get_epoll_ops();
         new_epoll->magic = EPOLL_MAGIC;
         new_epoll->host_fd = retval;
+        new_epoll->defer_ctl = epoll->defer_ctl;
+        new_epoll->num_enclave = epoll->num_enclave;
 
         if (epoll->map && epoll->map_size)
         {
@@ -638,6 +638,131 @@ done:
     return ret;
 }
 
+static ssize_t _hostfs_pread(
+    oe_fd_t* desc,
+    void* buf,
+    size_t count,
+    oe_off_t offset)
+{
+    ssize_t ret = -1;
+    file_t* file = _cast_file(desc);
+
+    if (!file || (count && !buf) || offset < 0)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* Call the host to perform the pread(). */
+    if (oe_syscall_pread_ocall(&ret, file->host_fd, buf, count, offset) !=
+        OE_OK)
+    {
+        OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+done:
+    return ret;
+}
+
+static ssize_t _hostfs_pwrite(
+    oe_fd_t* desc,
+    const void* buf,
+    size_t count,
+    oe_off_t offset)
+{
+    ssize_t ret = -1;
+    file_t* file = _cast_file(desc);
+
+    if (!file || (count && !buf) || offset < 0)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* Call the host to perform the pwrite(). */
+    if (oe_syscall_pwrite_ocall(&ret, file->host_fd, buf, count, offset) !=
+        OE_OK)
+    {
+        OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+done:
+    return ret;
+}
+
+static ssize_t _hostfs_preadv(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt,
+    oe_off_t offset)
+{
+    ssize_t ret = -1;
+    file_t* file = _cast_file(desc);
+    void* buf = NULL;
+    size_t buf_size = 0;
+
+    if (!file || (!iov && iovcnt) || iovcnt < 0 || iovcnt > OE_IOV_MAX ||
+        offset < 0)
+    {
+        OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+    /* Flatten the IO vector into contiguous heap memory. */
+    if (oe_iov_pack(iov, iovcnt, &buf, &buf_size) != 0)
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    /* Call the host. */
+    if (oe_syscall_preadv_ocall(
+            &ret, file->host_fd, buf, iovcnt, buf_size, offset) != OE_OK)
+    {
+        OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+    /* Synchronize data read with IO vector. */
+    if (ret > 0)
+    {
+        if (oe_iov_sync(iov, iovcnt, buf, buf_size) != 0)
+            OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+done:
+
+    if (buf)
+        oe_free(buf);
+
+    return ret;
+}
+
+static ssize_t _hostfs_pwritev(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt,
+    oe_off_t offset)
+{
+    ssize_t ret = -1;
+    file_t* file = _cast_file(desc);
+    void* buf = NULL;
+    size_t buf_size = 0;
+
+    if (!file || (!iov && iovcnt) || iovcnt < 0 || iovcnt > OE_IOV_MAX ||
+        offset < 0)
+    {
+        OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+    /* Flatten the IO vector into contiguous heap memory. */
+    if (oe_iov_pack(iov, iovcnt, &buf, &buf_size) != 0)
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    /* Call the host. */
+    if (oe_syscall_pwritev_ocall(
+            &ret, file->host_fd, buf, iovcnt, buf_size, offset) != OE_OK)
+    {
+        OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+done:
+
+    if (buf)
+        oe_free(buf);
+
+    return ret;
+}
+
 /* Perform rewinddir on a dir struct. */
 static int _hostfs_rewinddir(oe_fd_t* desc)
 {
@@ -1200,6 +1325,10 @@ static oe_file_ops_t _file_ops =
     .fd.close = _hostfs_close,
     .fd.get_host_fd = _hostfs_get_host_fd,
     .lseek = _hostfs_lseek,
+    .pread = _hostfs_pread,
+    .pwrite = _hostfs_pwrite,
+    .preadv = _hostfs_preadv,
+    .pwritev = _hostfs_pwritev,
     .getdents64 = _hostfs_getdents64,
 };
 // clang-format on
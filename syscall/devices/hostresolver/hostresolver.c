@@ -70,6 +70,12 @@ done:
     return ret;
 }
 
+/* Large enough for the results of most names, so that one OCALL suffices. */
+#define ADDRINFO_BUF_SIZE 4096
+
+/* Bounds the buffer that the host can make the enclave allocate. */
+#define ADDRINFO_BUF_SIZE_MAX (1024 * 1024)
+
 static int _hostresolver_getaddrinfo(
     oe_resolver_t* resolver,
     const char* node,
@@ -78,10 +84,8 @@ static int _hostresolver_getaddrinfo(
     struct oe_addrinfo** res)
 {
     int ret = OE_EAI_FAIL;
-    uint64_t handle = 0;
-    struct oe_addrinfo* head = NULL;
-    struct oe_addrinfo* tail = NULL;
-    struct oe_addrinfo* p = NULL;
+    void* buf = NULL;
+    size_t buf_size = ADDRINFO_BUF_SIZE;
 
     OE_UNUSED(resolver);
 
@@ -94,156 +98,56 @@ static int _hostresolver_getaddrinfo(
         OE_RAISE_ERRNO(OE_EINVAL);
     }
 
-    /* Get the handle for enumerating addrinfo structures. */
-    {
-        int retval = OE_EAI_FAIL;
-
-        if (oe_syscall_getaddrinfo_open_ocall(
-                &retval, node, service, hints, &handle) != OE_OK)
-        {
-            ret = OE_EAI_SYSTEM;
-            OE_RAISE_ERRNO(OE_EINVAL);
-        }
-
-        if (!handle)
-        {
-            ret = retval;
-            goto done;
-        }
-    }
-
-    /* Enumerate addrinfo structures. */
+    /* The host packs all the results into the buffer. It reports the size it
+     * needs if the buffer is too small, and the results may change between
+     * calls, so retry with a larger buffer until they fit. */
     for (;;)
     {
-        int retval = 0;
-        size_t canonnamelen = 0;
+        int retval = OE_EAI_FAIL;
+        size_t size = 0;
 
-        if (!(p = oe_calloc(1, sizeof(struct oe_addrinfo))))
+        if (!(buf = oe_malloc(buf_size)))
         {
             ret = OE_EAI_MEMORY;
             goto done;
         }
 
-        /* Determine required size ai_addr and ai_canonname buffers. */
-        if (oe_syscall_getaddrinfo_read_ocall(
-                &retval,
-                handle,
-                &p->ai_flags,
-                &p->ai_family,
-                &p->ai_socktype,
-                &p->ai_protocol,
-                p->ai_addrlen,
-                &p->ai_addrlen,
-                NULL,
-                canonnamelen,
-                &canonnamelen,
-                NULL) != OE_OK)
+        if (oe_syscall_getaddrinfo_ocall(
+                &retval, node, service, hints, buf, buf_size, &size) != OE_OK)
         {
             ret = OE_EAI_SYSTEM;
             OE_RAISE_ERRNO(OE_EINVAL);
         }
 
-        /* If this is the final element in the enumeration. */
-        if (retval == 1)
-            break;
-
-        /* Expecting that addr and canonname buffers were too small. */
-        if (retval != -1 || oe_errno != OE_ENAMETOOLONG)
+        if (retval == OE_EAI_OVERFLOW && size > buf_size &&
+            size <= ADDRINFO_BUF_SIZE_MAX)
         {
-            ret = OE_EAI_SYSTEM;
-            OE_RAISE_ERRNO(oe_errno);
+            oe_free(buf);
+            buf = NULL;
+            buf_size = size;
+            continue;
         }
 
-        if (p->ai_addrlen && !(p->ai_addr = oe_calloc(1, p->ai_addrlen)))
-        {
-            ret = OE_EAI_MEMORY;
-            goto done;
-        }
-
-        if (canonnamelen && !(p->ai_canonname = oe_calloc(1, canonnamelen)))
+        if (retval != 0)
         {
-            ret = OE_EAI_MEMORY;
+            ret = retval;
             goto done;
         }
 
-        if (oe_syscall_getaddrinfo_read_ocall(
-                &retval,
-                handle,
-                &p->ai_flags,
-                &p->ai_family,
-                &p->ai_socktype,
-                &p->ai_protocol,
-                p->ai_addrlen,
-                &p->ai_addrlen,
-                p->ai_addr,
-                canonnamelen,
-                &canonnamelen,
-                p->ai_canonname) != OE_OK)
+        if (size > buf_size)
         {
             ret = OE_EAI_SYSTEM;
             OE_RAISE_ERRNO(OE_EINVAL);
         }
 
-        /* Append to the list. */
-        if (tail)
-        {
-            tail->ai_next = p;
-            tail = p;
-        }
-        else
-        {
-            head = p;
-            tail = p;
-        }
-
-        p = NULL;
+        ret = oe_unpack_addrinfo(buf, size, res);
+        break;
     }
 
-    /* Close the enumeration. */
-    if (handle)
-    {
-        int retval = -1;
-
-        if (oe_syscall_getaddrinfo_close_ocall(&retval, handle) != OE_OK)
-        {
-            ret = OE_EAI_SYSTEM;
-            OE_RAISE_ERRNO(OE_EINVAL);
-        }
-
-        handle = 0;
-
-        if (retval != 0)
-        {
-            ret = OE_EAI_SYSTEM;
-            OE_RAISE_ERRNO(oe_errno);
-        }
-    }
-
-    /* If the list is empty. */
-    if (!head)
-    {
-        ret = OE_EAI_SYSTEM;
-        OE_RAISE_ERRNO(OE_EINVAL);
-    }
-
-    *res = head;
-    head = NULL;
-    tail = NULL;
-    ret = 0;
-
 done:
 
-    if (handle)
-    {
-        int retval;
-        oe_syscall_getaddrinfo_close_ocall(&retval, handle);
-    }
-
-    if (head)
-        oe_freeaddrinfo(head);
-
-    if (p)
-        oe_freeaddrinfo(p);
+    if (buf)
+        oe_free(buf);
 
     return ret;
 }
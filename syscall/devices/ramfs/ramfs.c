@@ -0,0 +1,2062 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+/*
+**==============================================================================
+**
+** ramfs:
+**
+**     This module implements a file system that keeps its files in enclave
+**     memory, for scratch and temporary files that must not leave the
+**     enclave. Each mount has its own files, which are released once the
+**     file system is unmounted and its last file is closed. To use this
+**     module, the enclave application must:
+**
+**     (1) Link the oeramfs library.
+**     (2) Load the module by calling oe_load_module_ram_file_system().
+**     (3) Mount it, e.g. mount("", "/tmp", OE_RAM_FILE_SYSTEM, 0, NULL).
+**     (4) Use the standard C file I/O functions (e.g., open, read, write).
+**
+**     The data parameter of mount() may be a string of the form
+**     "size=<bytes>[k|m|g]" that limits the memory used by file data.
+**     Writes beyond the limit fail with ENOSPC.
+**
+**     File data is held in page-granular extents that are zero-filled when
+**     allocated, so holes and truncated tails read as zeros. Directory
+**     entries are kept in a hash table keyed by (directory, name), so that
+**     a path lookup costs one probe per component.
+**
+**==============================================================================
+*/
+
+// clang-format off
+#include <openenclave/enclave.h>
+// clang-format on
+
+#include <openenclave/internal/syscall/device.h>
+#include <openenclave/internal/thread.h>
+#include <openenclave/internal/syscall/dirent.h>
+#include <openenclave/internal/syscall/sys/mount.h>
+#include <openenclave/corelibc/stdlib.h>
+#include <openenclave/corelibc/string.h>
+#include <openenclave/internal/syscall/fcntl.h>
+#include <openenclave/internal/syscall/raise.h>
+#include <openenclave/internal/syscall/unistd.h>
+#include <openenclave/internal/defs.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/utils.h>
+#include <openenclave/bits/safecrt.h>
+
+#define FS_MAGIC 0x3d7a61c2
+#define FILE_MAGIC 0x9e0b52d4
+
+/* Mask to extract the access mode: O_RDONLY, O_WRONLY, O_RDWR. */
+#define ACCESS_MODE_MASK 000000003
+
+/* The permission bits of a file mode. */
+#define PERMISSION_MASK 07777
+
+/* Initial number of buckets of the directory entry hash table. */
+#define INDEX_INITIAL_SIZE 64
+
+/* A run of pages holding file data. */
+typedef struct _extent
+{
+    /* Offset of the first byte of this extent within the file. */
+    oe_off_t offset;
+
+    /* Size of this extent in bytes, a multiple of OE_PAGE_SIZE. */
+    size_t size;
+
+    uint8_t* data;
+} extent_t;
+
+struct _dentry;
+
+/* A regular file or a directory. */
+typedef struct _inode
+{
+    uint64_t ino;
+    oe_mode_t mode;
+
+    /* The number of directory entries that refer to this inode. */
+    size_t nlink;
+
+    /* The number of open file descriptions of this inode. */
+    size_t nopen;
+
+    /* Regular files: the file size and the extents, sorted by offset. */
+    oe_off_t size;
+    extent_t* extents;
+    size_t num_extents;
+
+    /* Directories: the parent directory and the entries. */
+    struct _inode* parent;
+    struct _dentry* children;
+    size_t num_children;
+} inode_t;
+
+/* A directory entry. */
+typedef struct _dentry
+{
+    /* The next entry in the same hash table bucket. */
+    struct _dentry* next;
+
+    /* The neighboring entries of the same directory. */
+    struct _dentry* prev_sibling;
+    struct _dentry* next_sibling;
+
+    inode_t* dir;
+    inode_t* inode;
+    uint64_t hash;
+    char name[];
+} dentry_t;
+
+/* The files of one mounted instance. */
+typedef struct _ramfs
+{
+    oe_mutex_t lock;
+
+    /* One for the mount plus one per open file description. */
+    size_t refs;
+
+    inode_t* root;
+    uint64_t next_ino;
+
+    /* Hash table of all directory entries (power of two buckets). */
+    dentry_t** index;
+    size_t index_size;
+    size_t num_dentries;
+
+    /* Bytes of file data allocated, and the limit (zero if unlimited). */
+    size_t num_bytes;
+    size_t max_bytes;
+} ramfs_t;
+
+/* The RAM file system device. */
+typedef struct _device
+{
+    oe_device_t base;
+
+    /* Must be FS_MAGIC. */
+    uint32_t magic;
+
+    /* True if this file system has been mounted. */
+    bool is_mounted;
+
+    /* The parameters that were passed to the mount() function. */
+    struct
+    {
+        unsigned long flags;
+        char target[OE_PATH_MAX];
+    } mount;
+
+    /* The files of this device. */
+    ramfs_t* ramfs;
+} device_t;
+
+/* An open file description, shared by the descriptors that dup() makes. */
+typedef struct _handle
+{
+    ramfs_t* ramfs;
+    inode_t* inode;
+    int flags;
+    oe_off_t offset;
+    size_t refs;
+} handle_t;
+
+/* Created by open(). */
+typedef struct _file
+{
+    oe_fd_t base;
+
+    /* Must be FILE_MAGIC. */
+    uint32_t magic;
+
+    handle_t* handle;
+} file_t;
+
+static oe_file_ops_t _get_file_ops(void);
+
+/* Return true if the file system was mounted as read-only. */
+OE_INLINE bool _is_read_only(const device_t* fs)
+{
+    return fs->mount.flags & OE_MS_RDONLY;
+}
+
+static device_t* _cast_device(const oe_device_t* device)
+{
+    device_t* ret = NULL;
+    device_t* fs = (device_t*)device;
+
+    if (fs == NULL || fs->magic != FS_MAGIC)
+        goto done;
+
+    ret = fs;
+
+done:
+    return ret;
+}
+
+static file_t* _cast_file(const oe_fd_t* desc)
+{
+    file_t* ret = NULL;
+    file_t* file = (file_t*)desc;
+
+    if (file == NULL || file->magic != FILE_MAGIC)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    ret = file;
+
+done:
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** Inodes and the directory entry index. These are called with the lock of
+** the ramfs held.
+**
+**==============================================================================
+*/
+
+static uint64_t _hash(const inode_t* dir, const char* name, size_t len)
+{
+    /* FNV-1a over the directory inode number and the name. */
+    uint64_t hash = 14695981039346656037ULL ^ dir->ino;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= (uint8_t)name[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static dentry_t* _index_find(
+    const ramfs_t* ramfs,
+    const inode_t* dir,
+    const char* name,
+    size_t len)
+{
+    const uint64_t hash = _hash(dir, name, len);
+    dentry_t* p = ramfs->index[hash & (ramfs->index_size - 1)];
+
+    for (; p; p = p->next)
+    {
+        if (p->hash == hash && p->dir == dir &&
+            oe_strncmp(p->name, name, len) == 0 && p->name[len] == '\0')
+        {
+            return p;
+        }
+    }
+
+    return NULL;
+}
+
+/* Double the number of buckets once there are more entries than buckets. A
+ * failed allocation leaves the table as it was, just more crowded. */
+static void _index_grow(ramfs_t* ramfs)
+{
+    const size_t size = ramfs->index_size * 2;
+    dentry_t** index;
+
+    if (ramfs->num_dentries <= ramfs->index_size)
+        return;
+
+    if (!(index = oe_calloc(size, sizeof(dentry_t*))))
+        return;
+
+    for (size_t i = 0; i < ramfs->index_size; i++)
+    {
+        dentry_t* p = ramfs->index[i];
+
+        while (p)
+        {
+            dentry_t* next = p->next;
+            dentry_t** bucket = &index[p->hash & (size - 1)];
+
+            p->next = *bucket;
+            *bucket = p;
+            p = next;
+        }
+    }
+
+    oe_free(ramfs->index);
+    ramfs->index = index;
+    ramfs->index_size = size;
+}
+
+static inode_t* _new_inode(ramfs_t* ramfs, oe_mode_t mode)
+{
+    inode_t* inode;
+
+    if (!(inode = oe_calloc(1, sizeof(inode_t))))
+        return NULL;
+
+    inode->ino = ramfs->next_ino++;
+    inode->mode = mode;
+
+    return inode;
+}
+
+/* Release the data of a regular file from the given extent onwards. */
+static void _free_extents(ramfs_t* ramfs, inode_t* inode, size_t first)
+{
+    while (inode->num_extents > first)
+    {
+        extent_t* extent = &inode->extents[--inode->num_extents];
+
+        ramfs->num_bytes -= extent->size;
+        oe_free(extent->data);
+    }
+
+    if (inode->num_extents == 0)
+    {
+        oe_free(inode->extents);
+        inode->extents = NULL;
+    }
+}
+
+/* Free the inode once it is neither linked nor open. */
+static void _put_inode(ramfs_t* ramfs, inode_t* inode)
+{
+    if (inode->nlink || inode->nopen)
+        return;
+
+    _free_extents(ramfs, inode, 0);
+    oe_free(inode);
+}
+
+/* Add a directory entry. Returns an errno value. */
+static int _link(ramfs_t* ramfs, inode_t* dir, const char* name, inode_t* inode)
+{
+    const size_t len = oe_strlen(name);
+    dentry_t* dentry;
+    dentry_t** bucket;
+
+    if (!(dentry = oe_calloc(1, sizeof(dentry_t) + len + 1)))
+        return OE_ENOMEM;
+
+    dentry->dir = dir;
+    dentry->inode = inode;
+    dentry->hash = _hash(dir, name, len);
+    memcpy(dentry->name, name, len + 1);
+
+    bucket = &ramfs->index[dentry->hash & (ramfs->index_size - 1)];
+    dentry->next = *bucket;
+    *bucket = dentry;
+    ramfs->num_dentries++;
+
+    if ((dentry->next_sibling = dir->children))
+        dir->children->prev_sibling = dentry;
+    dir->children = dentry;
+    dir->num_children++;
+
+    inode->nlink++;
+
+    if (OE_S_ISDIR(inode->mode))
+        inode->parent = dir;
+
+    _index_grow(ramfs);
+
+    return 0;
+}
+
+/* Remove a directory entry, and free its inode if that was the last link
+ * and the inode is not open. */
+static void _unlink(ramfs_t* ramfs, dentry_t* dentry)
+{
+    dentry_t** link = &ramfs->index[dentry->hash & (ramfs->index_size - 1)];
+    inode_t* dir = dentry->dir;
+    inode_t* inode = dentry->inode;
+
+    while (*link != dentry)
+        link = &(*link)->next;
+
+    *link = dentry->next;
+    ramfs->num_dentries--;
+
+    if (dentry->prev_sibling)
+        dentry->prev_sibling->next_sibling = dentry->next_sibling;
+    else
+        dir->children = dentry->next_sibling;
+
+    if (dentry->next_sibling)
+        dentry->next_sibling->prev_sibling = dentry->prev_sibling;
+
+    dir->num_children--;
+
+    /* An open directory that was removed becomes its own parent, so that
+     * ".." never refers to freed memory. */
+    if (OE_S_ISDIR(inode->mode))
+        inode->parent = inode;
+
+    inode->nlink--;
+    oe_free(dentry);
+    _put_inode(ramfs, inode);
+}
+
+/* Resolve an absolute path to a directory entry and its inode. The entry is
+ * NULL for the root. Returns an errno value. */
+static int _lookup(
+    const ramfs_t* ramfs,
+    const char* path,
+    dentry_t** dentry_out,
+    inode_t** inode_out)
+{
+    inode_t* inode = ramfs->root;
+    dentry_t* dentry = NULL;
+    const char* p = path;
+
+    if (*p != '/')
+        return OE_ENOENT;
+
+    while (*p)
+    {
+        const char* name;
+        size_t len;
+
+        while (*p == '/')
+            p++;
+
+        if (!*p)
+            break;
+
+        name = p;
+
+        while (*p && *p != '/')
+            p++;
+
+        len = (size_t)(p - name);
+
+        if (!OE_S_ISDIR(inode->mode))
+            return OE_ENOTDIR;
+
+        if (len > OE_NAME_MAX)
+            return OE_ENAMETOOLONG;
+
+        if (len == 1 && name[0] == '.')
+            continue;
+
+        if (len == 2 && name[0] == '.' && name[1] == '.')
+        {
+            inode = inode->parent;
+            dentry = NULL;
+            continue;
+        }
+
+        if (!(dentry = _index_find(ramfs, inode, name, len)))
+            return OE_ENOENT;
+
+        inode = dentry->inode;
+    }
+
+    /* A trailing slash requires a directory. */
+    if (p > path && p[-1] == '/' && !OE_S_ISDIR(inode->mode))
+        return OE_ENOTDIR;
+
+    if (dentry_out)
+        *dentry_out = dentry;
+
+    *inode_out = inode;
+    return 0;
+}
+
+/* Resolve the directory that contains the last component of an absolute
+ * path, and copy that component to name. Returns an errno value. */
+static int _lookup_parent(
+    const ramfs_t* ramfs,
+    const char* path,
+    inode_t** dir_out,
+    char name[OE_NAME_MAX + 1])
+{
+    char dirpath[OE_PATH_MAX];
+    size_t len;
+    char* slash;
+    int err;
+
+    if ((len = oe_strlcpy(dirpath, path, sizeof(dirpath))) >= sizeof(dirpath))
+        return OE_ENAMETOOLONG;
+
+    while (len > 1 && dirpath[len - 1] == '/')
+        dirpath[--len] = '\0';
+
+    if (!(slash = oe_strrchr(dirpath, '/')))
+        return OE_ENOENT;
+
+    /* The root has no parent. */
+    if (slash[1] == '\0')
+        return OE_EBUSY;
+
+    if (oe_strlen(slash + 1) > OE_NAME_MAX)
+        return OE_ENAMETOOLONG;
+
+    if (oe_strcmp(slash + 1, ".") == 0 || oe_strcmp(slash + 1, "..") == 0)
+        return OE_EINVAL;
+
+    oe_strlcpy(name, slash + 1, OE_NAME_MAX + 1);
+
+    if (slash == dirpath)
+        slash[1] = '\0';
+    else
+        *slash = '\0';
+
+    if ((err = _lookup(ramfs, dirpath, NULL, dir_out)) != 0)
+        return err;
+
+    if (!OE_S_ISDIR((*dir_out)->mode))
+        return OE_ENOTDIR;
+
+    return 0;
+}
+
+/*
+**==============================================================================
+**
+** File data. These are called with the lock of the ramfs held.
+**
+**==============================================================================
+*/
+
+static size_t _capacity(const inode_t* inode)
+{
+    const extent_t* last;
+
+    if (inode->num_extents == 0)
+        return 0;
+
+    last = &inode->extents[inode->num_extents - 1];
+    return (size_t)last->offset + last->size;
+}
+
+/* Return the index of the extent that holds the byte at offset. */
+static size_t _find_extent(const inode_t* inode, oe_off_t offset)
+{
+    size_t lo = 0;
+    size_t hi = inode->num_extents;
+
+    while (hi - lo > 1)
+    {
+        const size_t mid = lo + (hi - lo) / 2;
+
+        if (inode->extents[mid].offset <= offset)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/* Grow the extents of a regular file to hold size bytes. The capacity is
+ * doubled where the limit allows, so that a file written sequentially ends
+ * up with a logarithmic number of extents. Returns an errno value. */
+static int _reserve(ramfs_t* ramfs, inode_t* inode, size_t size)
+{
+    const size_t capacity = _capacity(inode);
+    size_t needed;
+    size_t grow;
+    uint8_t* data;
+    extent_t* extents;
+
+    if (size <= capacity)
+        return 0;
+
+    needed = oe_round_up_to_multiple(size - capacity, OE_PAGE_SIZE);
+    grow = capacity > needed ? capacity : needed;
+
+    if (ramfs->max_bytes)
+    {
+        if (needed > ramfs->max_bytes - ramfs->num_bytes)
+            return OE_ENOSPC;
+
+        if (grow > ramfs->max_bytes - ramfs->num_bytes)
+            grow = needed;
+    }
+
+    /* The pages are zeroed, which is what holes and extensions read. */
+    if (!(data = oe_calloc(1, grow)))
+    {
+        if (grow == needed || !(data = oe_calloc(1, grow = needed)))
+            return OE_ENOSPC;
+    }
+
+    extents = oe_realloc(
+        inode->extents, (inode->num_extents + 1) * sizeof(extent_t));
+
+    if (!extents)
+    {
+        oe_free(data);
+        return OE_ENOMEM;
+    }
+
+    extents[inode->num_extents].offset = (oe_off_t)capacity;
+    extents[inode->num_extents].size = grow;
+    extents[inode->num_extents].data = data;
+    inode->extents = extents;
+    inode->num_extents++;
+    ramfs->num_bytes += grow;
+
+    return 0;
+}
+
+/* Copy count bytes between buf and the file at offset, which must lie within
+ * the extents. */
+static void _copy(
+    inode_t* inode,
+    oe_off_t offset,
+    uint8_t* buf,
+    size_t count,
+    bool to_file)
+{
+    size_t i = _find_extent(inode, offset);
+
+    while (count)
+    {
+        const extent_t* extent = &inode->extents[i++];
+        const size_t start = (size_t)(offset - extent->offset);
+        size_t n = extent->size - start;
+
+        if (n > count)
+            n = count;
+
+        if (to_file)
+            memcpy(extent->data + start, buf, n);
+        else
+            memcpy(buf, extent->data + start, n);
+
+        buf += n;
+        offset += (oe_off_t)n;
+        count -= n;
+    }
+}
+
+static ssize_t _read_data(
+    inode_t* inode,
+    void* buf,
+    size_t count,
+    oe_off_t offset)
+{
+    size_t n;
+
+    if (offset >= inode->size)
+        return 0;
+
+    n = (size_t)(inode->size - offset);
+
+    if (n > count)
+        n = count;
+
+    if (n > OE_SSIZE_MAX)
+        n = OE_SSIZE_MAX;
+
+    _copy(inode, offset, buf, n, false);
+
+    return (ssize_t)n;
+}
+
+/* Returns the number of bytes written or minus an errno value. */
+static ssize_t _write_data(
+    ramfs_t* ramfs,
+    inode_t* inode,
+    const void* buf,
+    size_t count,
+    oe_off_t offset)
+{
+    oe_off_t end;
+    int err;
+
+    if (count > OE_SSIZE_MAX || (oe_off_t)count > OE_INT64_MAX - offset)
+        return -OE_EFBIG;
+
+    end = offset + (oe_off_t)count;
+
+    if ((err = _reserve(ramfs, inode, (size_t)end)) != 0)
+        return -err;
+
+    _copy(inode, offset, (uint8_t*)buf, count, true);
+
+    if (end > inode->size)
+        inode->size = end;
+
+    return (ssize_t)count;
+}
+
+/* Returns an errno value. */
+static int _truncate(ramfs_t* ramfs, inode_t* inode, oe_off_t length)
+{
+    if (length > inode->size)
+    {
+        int err;
+
+        /* Bytes past the end are always zero, so only reserve. */
+        if ((err = _reserve(ramfs, inode, (size_t)length)) != 0)
+            return err;
+    }
+    else if (length < inode->size)
+    {
+        size_t first = inode->num_extents;
+
+        while (first && inode->extents[first - 1].offset >= length)
+            first--;
+
+        _free_extents(ramfs, inode, first);
+
+        /* Zero the tail of the last extent so that bytes past the end stay
+         * zero. */
+        if (inode->num_extents)
+        {
+            const extent_t* last = &inode->extents[inode->num_extents - 1];
+            const size_t start = (size_t)(length - last->offset);
+            size_t end = (size_t)(inode->size - last->offset);
+
+            if (end > last->size)
+                end = last->size;
+
+            memset(last->data + start, 0, end - start);
+        }
+    }
+
+    inode->size = length;
+
+    return 0;
+}
+
+/*
+**==============================================================================
+**
+** Mounted instances.
+**
+**==============================================================================
+*/
+
+static ramfs_t* _new_ramfs(size_t max_bytes)
+{
+    ramfs_t* ret = NULL;
+    ramfs_t* ramfs = NULL;
+
+    if (!(ramfs = oe_calloc(1, sizeof(ramfs_t))))
+        goto done;
+
+    ramfs->refs = 1;
+    ramfs->next_ino = 1;
+    ramfs->max_bytes = max_bytes;
+    ramfs->index_size = INDEX_INITIAL_SIZE;
+
+    if (!(ramfs->index = oe_calloc(ramfs->index_size, sizeof(dentry_t*))))
+        goto done;
+
+    if (!(ramfs->root = _new_inode(ramfs, OE_S_IFDIR | 0755)))
+        goto done;
+
+    ramfs->root->parent = ramfs->root;
+    ramfs->root->nlink = 1;
+
+    ret = ramfs;
+    ramfs = NULL;
+
+done:
+
+    if (ramfs)
+    {
+        oe_free(ramfs->index);
+        oe_free(ramfs);
+    }
+
+    return ret;
+}
+
+/* Drop a reference and free everything with the last one. By then no file
+ * is open, so each inode is reachable through its directory entries. */
+static void _put_ramfs(ramfs_t* ramfs)
+{
+    bool last;
+
+    oe_mutex_lock(&ramfs->lock);
+    last = --ramfs->refs == 0;
+    oe_mutex_unlock(&ramfs->lock);
+
+    if (!last)
+        return;
+
+    for (size_t i = 0; i < ramfs->index_size; i++)
+    {
+        dentry_t* p = ramfs->index[i];
+
+        while (p)
+        {
+            dentry_t* next = p->next;
+
+            p->inode->nlink--;
+            _put_inode(ramfs, p->inode);
+            oe_free(p);
+            p = next;
+        }
+    }
+
+    oe_free(ramfs->root);
+    oe_free(ramfs->index);
+    oe_free(ramfs);
+}
+
+/* Parse the mount data: NULL, "" or "size=<bytes>[k|m|g]". */
+static int _parse_mount_data(const char* data, size_t* max_bytes)
+{
+    int ret = -1;
+    const char prefix[] = "size=";
+    const char* p;
+    char* end;
+    unsigned long size;
+
+    *max_bytes = 0;
+
+    if (!data || !*data)
+    {
+        ret = 0;
+        goto done;
+    }
+
+    if (oe_strncmp(data, prefix, sizeof(prefix) - 1) != 0)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    p = data + sizeof(prefix) - 1;
+
+    if (*p < '0' || *p > '9')
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    size = oe_strtoul(p, &end, 10);
+
+    switch (*end)
+    {
+        case 'k':
+        case 'K':
+            size = (size <= OE_SIZE_MAX >> 10) ? size << 10 : OE_SIZE_MAX;
+            end++;
+            break;
+        case 'm':
+        case 'M':
+            size = (size <= OE_SIZE_MAX >> 20) ? size << 20 : OE_SIZE_MAX;
+            end++;
+            break;
+        case 'g':
+        case 'G':
+            size = (size <= OE_SIZE_MAX >> 30) ? size << 30 : OE_SIZE_MAX;
+            end++;
+            break;
+    }
+
+    if (*end != '\0' || size == 0)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    *max_bytes = size;
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/* Return the files of the device. The static device is usable through its
+ * device id without being mounted, so its files are made on first use. */
+static ramfs_t* _get_ramfs(device_t* fs)
+{
+    static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+    ramfs_t* ret = NULL;
+
+    oe_spin_lock(&_lock);
+
+    if (!fs->ramfs && !(fs->ramfs = _new_ramfs(0)))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    ret = fs->ramfs;
+
+done:
+    oe_spin_unlock(&_lock);
+    return ret;
+}
+
+/* Called by oe_mount(). */
+static int _ramfs_mount(
+    oe_device_t* device,
+    const char* source,
+    const char* target,
+    const char* filesystemtype,
+    unsigned long flags,
+    const void* data)
+{
+    int ret = -1;
+    device_t* fs = _cast_device(device);
+    size_t max_bytes;
+
+    OE_UNUSED(source);
+
+    /* Fail if required parameters are null. */
+    if (!fs || !target)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* Fail if this file system is already mounted. */
+    if (fs->is_mounted)
+        OE_RAISE_ERRNO(OE_EBUSY);
+
+    /* Cross check the file system type. */
+    if (oe_strcmp(filesystemtype, OE_DEVICE_NAME_RAM_FILE_SYSTEM) != 0)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (_parse_mount_data(data, &max_bytes) != 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    /* Each mount starts out empty. */
+    if (!(fs->ramfs = _new_ramfs(max_bytes)))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    /* Remember whether this is a read-only mount. */
+    fs->mount.flags = flags & OE_MS_RDONLY;
+
+    /* Save the target parameter (checked by the umount2() function). */
+    oe_strlcpy(fs->mount.target, target, sizeof(fs->mount.target));
+
+    /* Set the flag indicating that this file system is mounted. */
+    fs->is_mounted = true;
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/* Called by oe_umount2(). */
+static int _ramfs_umount2(oe_device_t* device, const char* target, int flags)
+{
+    int ret = -1;
+    device_t* fs = _cast_device(device);
+
+    OE_UNUSED(flags);
+
+    /* Fail if any required parameters are null. */
+    if (!fs || !target)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* Fail if this file system is not mounted. */
+    if (!fs->is_mounted)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* Cross check target parameter with the one passed to mount(). */
+    if (oe_strcmp(target, fs->mount.target) != 0)
+        OE_RAISE_ERRNO(OE_ENOENT);
+
+    /* The files live on until the last of them is closed. */
+    _put_ramfs(fs->ramfs);
+    fs->ramfs = NULL;
+
+    /* Clear the cached mount parameters. */
+    oe_memset_s(&fs->mount, sizeof(fs->mount), 0, sizeof(fs->mount));
+
+    fs->is_mounted = false;
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/* Called by oe_mount() to make a copy of this device. */
+static int _ramfs_clone(oe_device_t* device, oe_device_t** new_device)
+{
+    int ret = -1;
+    device_t* fs = _cast_device(device);
+    device_t* new_fs = NULL;
+
+    if (!fs || !new_device)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(new_fs = oe_calloc(1, sizeof(device_t))))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    /* The copy gets its files from mount(). */
+    *new_fs = *fs;
+    new_fs->ramfs = NULL;
+    *new_device = &new_fs->base;
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+static device_t _ramfs;
+
+/* Called by oe_umount() to release this device. */
+static int _ramfs_release(oe_device_t* device)
+{
+    int ret = -1;
+    device_t* fs = _cast_device(device);
+
+    if (!fs)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (fs->ramfs)
+    {
+        _put_ramfs(fs->ramfs);
+        fs->ramfs = NULL;
+    }
+
+    if (fs != &_ramfs)
+        oe_free(fs);
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** Open files.
+**
+**==============================================================================
+*/
+
+static oe_fd_t* _ramfs_open(
+    oe_device_t* device,
+    const char* pathname,
+    int flags,
+    oe_mode_t mode)
+{
+    oe_fd_t* ret = NULL;
+    device_t* fs = _cast_device(device);
+    const int access = flags & ACCESS_MODE_MASK;
+    ramfs_t* ramfs;
+    file_t* file = NULL;
+    handle_t* handle = NULL;
+    inode_t* inode;
+    bool locked = false;
+    int err;
+
+    /* Fail if any required parameters are null. */
+    if (!fs || !pathname)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* Fail if attempting to write to a read-only file system. */
+    if (_is_read_only(fs) &&
+        (access != OE_O_RDONLY || (flags & (OE_O_CREAT | OE_O_TRUNC))))
+    {
+        OE_RAISE_ERRNO(OE_EPERM);
+    }
+
+    if (!(ramfs = _get_ramfs(fs)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (!(file = oe_calloc(1, sizeof(file_t))))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    if (!(handle = oe_calloc(1, sizeof(handle_t))))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    oe_mutex_lock(&ramfs->lock);
+    locked = true;
+
+    if ((err = _lookup(ramfs, pathname, NULL, &inode)) == OE_ENOENT &&
+        (flags & OE_O_CREAT) && !(flags & OE_O_DIRECTORY))
+    {
+        char name[OE_NAME_MAX + 1];
+        inode_t* dir;
+        const oe_mode_t perm = mode & PERMISSION_MASK;
+
+        if ((err = _lookup_parent(ramfs, pathname, &dir, name)) != 0)
+            OE_RAISE_ERRNO(err);
+
+        if (!(inode = _new_inode(ramfs, OE_S_IFREG | perm)))
+            OE_RAISE_ERRNO(OE_ENOMEM);
+
+        if ((err = _link(ramfs, dir, name, inode)) != 0)
+        {
+            oe_free(inode);
+            OE_RAISE_ERRNO(err);
+        }
+    }
+    else if (err != 0)
+    {
+        OE_RAISE_ERRNO(err);
+    }
+    else
+    {
+        if ((flags & OE_O_CREAT) && (flags & OE_O_EXCL))
+            OE_RAISE_ERRNO(OE_EEXIST);
+
+        if ((flags & OE_O_DIRECTORY) && !OE_S_ISDIR(inode->mode))
+            OE_RAISE_ERRNO(OE_ENOTDIR);
+
+        if (OE_S_ISDIR(inode->mode) && access != OE_O_RDONLY)
+            OE_RAISE_ERRNO(OE_EISDIR);
+
+        if ((flags & OE_O_TRUNC) && access != OE_O_RDONLY)
+        {
+            if ((err = _truncate(ramfs, inode, 0)) != 0)
+                OE_RAISE_ERRNO(err);
+        }
+    }
+
+    inode->nopen++;
+    ramfs->refs++;
+
+    handle->ramfs = ramfs;
+    handle->inode = inode;
+    handle->flags = flags;
+    handle->refs = 1;
+
+    file->base.type = OE_FD_TYPE_FILE;
+    file->base.ops.file = _get_file_ops();
+    file->magic = FILE_MAGIC;
+    file->handle = handle;
+
+    ret = &file->base;
+    file = NULL;
+    handle = NULL;
+
+done:
+
+    if (locked)
+        oe_mutex_unlock(&ramfs->lock);
+
+    if (handle)
+        oe_free(handle);
+
+    if (file)
+        oe_free(file);
+
+    return ret;
+}
+
+static int _ramfs_dup(oe_fd_t* desc, oe_fd_t** new_file_out)
+{
+    int ret = -1;
+    file_t* file = _cast_file(desc);
+    file_t* new_file = NULL;
+
+    if (new_file_out)
+        *new_file_out = NULL;
+
+    /* Check parameters. */
+    if (!file || !new_file_out)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(new_file = oe_calloc(1, sizeof(file_t))))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    /* The new descriptor shares the offset and the status flags. */
+    *new_file = *file;
+
+    oe_mutex_lock(&file->handle->ramfs->lock);
+    file->handle->refs++;
+    oe_mutex_unlock(&file->handle->ramfs->lock);
+
+    *new_file_out = &new_file->base;
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/* Check that a handle may be read from or written to, then lock the ramfs.
+ * Returns an errno value. */
+static int _lock_handle(const handle_t* handle, bool write)
+{
+    const int access = handle->flags & ACCESS_MODE_MASK;
+
+    if (OE_S_ISDIR(handle->inode->mode))
+        return OE_EISDIR;
+
+    if (write ? access == OE_O_RDONLY : access == OE_O_WRONLY)
+        return OE_EBADF;
+
+    oe_mutex_lock(&handle->ramfs->lock);
+    return 0;
+}
+
+static ssize_t _ramfs_read(oe_fd_t* desc, void* buf, size_t count)
+{
+    ssize_t ret = -1;
+    file_t* file = _cast_file(desc);
+    handle_t* handle;
+    int err;
+
+    if (!file || (count && !buf))
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    handle = file->handle;
+
+    if ((err = _lock_handle(handle, false)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    ret = _read_data(handle->inode, buf, count, handle->offset);
+    handle->offset += ret;
+
+    oe_mutex_unlock(&handle->ramfs->lock);
+
+done:
+    return ret;
+}
+
+static ssize_t _ramfs_write(oe_fd_t* desc, const void* buf, size_t count)
+{
+    ssize_t ret = -1;
+    file_t* file = _cast_file(desc);
+    handle_t* handle;
+    ssize_t n;
+    int err;
+
+    if (!file || (count && !buf))
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    handle = file->handle;
+
+    if ((err = _lock_handle(handle, true)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    if (handle->flags & OE_O_APPEND)
+        handle->offset = handle->inode->size;
+
+    n = _write_data(handle->ramfs, handle->inode, buf, count, handle->offset);
+
+    if (n >= 0)
+        handle->offset += n;
+
+    oe_mutex_unlock(&handle->ramfs->lock);
+
+    if (n < 0)
+        OE_RAISE_ERRNO((int)-n);
+
+    ret = n;
+
+done:
+    return ret;
+}
+
+/* Transfer an iovec array at offset under a single lock, so that it is
+ * atomic like a single read() or write(). Updates the offset of the handle
+ * if offset is NULL. */
+static ssize_t _transfer_iov(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt,
+    const oe_off_t* offset,
+    bool write)
+{
+    ssize_t ret = -1;
+    file_t* file = _cast_file(desc);
+    handle_t* handle;
+    oe_off_t pos;
+    ssize_t total = 0;
+    ssize_t n = 0;
+    int err;
+
+    if (!file || (!iov && iovcnt) || iovcnt < 0 || iovcnt > OE_IOV_MAX)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (offset && *offset < 0)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    handle = file->handle;
+
+    if ((err = _lock_handle(handle, write)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    if (!offset && write && (handle->flags & OE_O_APPEND))
+        handle->offset = handle->inode->size;
+
+    pos = offset ? *offset : handle->offset;
+
+    for (int i = 0; i < iovcnt; i++)
+    {
+        if (write)
+        {
+            n = _write_data(
+                handle->ramfs,
+                handle->inode,
+                iov[i].iov_base,
+                iov[i].iov_len,
+                pos);
+        }
+        else
+        {
+            n = _read_data(handle->inode, iov[i].iov_base, iov[i].iov_len, pos);
+        }
+
+        if (n < 0)
+            break;
+
+        total += n;
+        pos += n;
+
+        if ((size_t)n < iov[i].iov_len)
+            break;
+    }
+
+    if (!offset)
+        handle->offset = pos;
+
+    oe_mutex_unlock(&handle->ramfs->lock);
+
+    /* Report a failure only if nothing was transferred. */
+    if (n < 0 && total == 0)
+        OE_RAISE_ERRNO((int)-n);
+
+    ret = total;
+
+done:
+    return ret;
+}
+
+static ssize_t _ramfs_readv(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt)
+{
+    return _transfer_iov(desc, iov, iovcnt, NULL, false);
+}
+
+static ssize_t _ramfs_writev(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt)
+{
+    return _transfer_iov(desc, iov, iovcnt, NULL, true);
+}
+
+static ssize_t _ramfs_preadv(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt,
+    oe_off_t offset)
+{
+    return _transfer_iov(desc, iov, iovcnt, &offset, false);
+}
+
+static ssize_t _ramfs_pwritev(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt,
+    oe_off_t offset)
+{
+    return _transfer_iov(desc, iov, iovcnt, &offset, true);
+}
+
+static ssize_t _ramfs_pread(
+    oe_fd_t* desc,
+    void* buf,
+    size_t count,
+    oe_off_t offset)
+{
+    struct oe_iovec iov = {buf, count};
+
+    return _transfer_iov(desc, &iov, 1, &offset, false);
+}
+
+static ssize_t _ramfs_pwrite(
+    oe_fd_t* desc,
+    const void* buf,
+    size_t count,
+    oe_off_t offset)
+{
+    struct oe_iovec iov = {(void*)buf, count};
+
+    return _transfer_iov(desc, &iov, 1, &offset, true);
+}
+
+/* For directories the offset counts entries, which is all that rewinddir()
+ * and telldir() need. */
+static oe_off_t _ramfs_lseek(oe_fd_t* desc, oe_off_t offset, int whence)
+{
+    oe_off_t ret = -1;
+    file_t* file = _cast_file(desc);
+    handle_t* handle;
+    oe_off_t base;
+
+    if (!file)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    handle = file->handle;
+
+    oe_mutex_lock(&handle->ramfs->lock);
+
+    switch (whence)
+    {
+        case OE_SEEK_SET:
+            base = 0;
+            break;
+        case OE_SEEK_CUR:
+            base = handle->offset;
+            break;
+        case OE_SEEK_END:
+            base = handle->inode->size;
+            break;
+        default:
+            base = -1;
+            break;
+    }
+
+    if (base >= 0 && offset >= -base && offset <= OE_INT64_MAX - base)
+        ret = handle->offset = base + offset;
+
+    oe_mutex_unlock(&handle->ramfs->lock);
+
+    if (ret < 0)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+done:
+    return ret;
+}
+
+/* Called by oe_getdents64() to handle the getdents64 system call. The
+ * entries are ".", ".." and then the directory entries, newest first. */
+static int _ramfs_getdents64(
+    oe_fd_t* desc,
+    struct oe_dirent* dirp,
+    unsigned int count)
+{
+    int ret = -1;
+    int bytes = 0;
+    file_t* file = _cast_file(desc);
+    handle_t* handle;
+    inode_t* dir;
+    const dentry_t* dentry = NULL;
+    unsigned int n = count / sizeof(struct oe_dirent);
+
+    if (!file || !dirp)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    handle = file->handle;
+    dir = handle->inode;
+
+    if (!OE_S_ISDIR(dir->mode))
+        OE_RAISE_ERRNO(OE_ENOTDIR);
+
+    oe_mutex_lock(&handle->ramfs->lock);
+
+    /* Skip the entries before the offset. */
+    if (handle->offset > 2)
+    {
+        dentry = dir->children;
+
+        for (oe_off_t i = 2; dentry && i < handle->offset; i++)
+            dentry = dentry->next_sibling;
+    }
+    else if (handle->offset == 2)
+    {
+        dentry = dir->children;
+    }
+
+    for (unsigned int i = 0; i < n; i++, dirp++)
+    {
+        const inode_t* inode;
+        const char* name;
+
+        if (handle->offset == 0)
+        {
+            inode = dir;
+            name = ".";
+        }
+        else if (handle->offset == 1)
+        {
+            inode = dir->parent;
+            name = "..";
+            dentry = dir->children;
+        }
+        else if (dentry)
+        {
+            inode = dentry->inode;
+            name = dentry->name;
+            dentry = dentry->next_sibling;
+        }
+        else
+        {
+            break;
+        }
+
+        oe_memset_s(dirp, sizeof(*dirp), 0, sizeof(*dirp));
+        dirp->d_ino = inode->ino;
+        dirp->d_off = ++handle->offset;
+        dirp->d_reclen = sizeof(struct oe_dirent);
+        dirp->d_type = OE_S_ISDIR(inode->mode) ? OE_DT_DIR : OE_DT_REG;
+        oe_strlcpy(dirp->d_name, name, sizeof(dirp->d_name));
+        bytes += (int)sizeof(struct oe_dirent);
+    }
+
+    oe_mutex_unlock(&handle->ramfs->lock);
+
+    ret = bytes;
+
+done:
+    return ret;
+}
+
+static int _ramfs_close(oe_fd_t* desc)
+{
+    int ret = -1;
+    file_t* file = _cast_file(desc);
+    handle_t* handle;
+    ramfs_t* ramfs;
+    bool last;
+
+    if (!file)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    handle = file->handle;
+    ramfs = handle->ramfs;
+
+    oe_mutex_lock(&ramfs->lock);
+
+    if ((last = --handle->refs == 0))
+    {
+        handle->inode->nopen--;
+        _put_inode(ramfs, handle->inode);
+    }
+
+    oe_mutex_unlock(&ramfs->lock);
+
+    if (last)
+    {
+        oe_free(handle);
+        _put_ramfs(ramfs);
+    }
+
+    oe_free(file);
+    ret = 0;
+
+done:
+    return ret;
+}
+
+static int _ramfs_ioctl(oe_fd_t* desc, unsigned long request, uint64_t arg)
+{
+    int ret = -1;
+    file_t* file = _cast_file(desc);
+
+    OE_UNUSED(request);
+    OE_UNUSED(arg);
+
+    if (!file)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* RAM files are not terminal devices (see _hostfs_ioctl()). */
+    OE_RAISE_ERRNO(OE_ENOTTY);
+
+done:
+    return ret;
+}
+
+static int _ramfs_fcntl(oe_fd_t* desc, int cmd, uint64_t arg)
+{
+    int ret = -1;
+    file_t* file = _cast_file(desc);
+    const int settable = OE_O_APPEND | OE_O_NONBLOCK;
+    handle_t* handle;
+
+    if (!file)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    handle = file->handle;
+
+    switch (cmd)
+    {
+        /* There is no exec() in an enclave, so FD_CLOEXEC has no effect. */
+        case OE_F_GETFD:
+        case OE_F_SETFD:
+            ret = 0;
+            break;
+
+        case OE_F_GETFL:
+            ret = handle->flags;
+            break;
+
+        case OE_F_SETFL:
+            oe_mutex_lock(&handle->ramfs->lock);
+            handle->flags = (handle->flags & ~settable) | ((int)arg & settable);
+            oe_mutex_unlock(&handle->ramfs->lock);
+            ret = 0;
+            break;
+
+        default:
+            OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+done:
+    return ret;
+}
+
+/* RAM files have no host file descriptor. */
+static oe_host_fd_t _ramfs_get_host_fd(oe_fd_t* desc)
+{
+    OE_UNUSED(desc);
+    return -1;
+}
+
+/*
+**==============================================================================
+**
+** Path operations.
+**
+**==============================================================================
+*/
+
+/* Get the files of a device and lock them. Raises EPERM for writes to a
+ * read-only mount. */
+static ramfs_t* _lock_device(oe_device_t* device, bool write)
+{
+    ramfs_t* ret = NULL;
+    device_t* fs = _cast_device(device);
+    ramfs_t* ramfs;
+
+    if (!fs)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (write && _is_read_only(fs))
+        OE_RAISE_ERRNO(OE_EPERM);
+
+    if (!(ramfs = _get_ramfs(fs)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    oe_mutex_lock(&ramfs->lock);
+    ret = ramfs;
+
+done:
+    return ret;
+}
+
+static int _ramfs_stat(
+    oe_device_t* device,
+    const char* pathname,
+    struct oe_stat* buf)
+{
+    int ret = -1;
+    ramfs_t* ramfs = NULL;
+    inode_t* inode;
+    int err;
+
+    if (buf)
+        oe_memset_s(buf, sizeof(*buf), 0, sizeof(*buf));
+
+    if (!pathname || !buf)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(ramfs = _lock_device(device, false)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if ((err = _lookup(ramfs, pathname, NULL, &inode)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    buf->st_ino = inode->ino;
+    buf->st_nlink = (oe_nlink_t)inode->nlink;
+    buf->st_mode = inode->mode;
+    buf->st_size = inode->size;
+    buf->st_blksize = OE_PAGE_SIZE;
+    buf->st_blocks = (oe_blkcnt_t)(_capacity(inode) / 512);
+
+    ret = 0;
+
+done:
+
+    if (ramfs)
+        oe_mutex_unlock(&ramfs->lock);
+
+    return ret;
+}
+
+static int _ramfs_access(oe_device_t* device, const char* pathname, int mode)
+{
+    int ret = -1;
+    ramfs_t* ramfs = NULL;
+    const uint32_t MASK = (OE_R_OK | OE_W_OK | OE_X_OK);
+    inode_t* inode;
+    int err;
+
+    if (!pathname || ((uint32_t)mode & ~MASK))
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(ramfs = _lock_device(device, false)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if ((err = _lookup(ramfs, pathname, NULL, &inode)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    /* The enclave is the owner of every file. */
+    if (((uint32_t)mode << 6) & ~inode->mode)
+        OE_RAISE_ERRNO(OE_EACCES);
+
+    ret = 0;
+
+done:
+
+    if (ramfs)
+        oe_mutex_unlock(&ramfs->lock);
+
+    return ret;
+}
+
+static int _ramfs_link(
+    oe_device_t* device,
+    const char* oldpath,
+    const char* newpath)
+{
+    int ret = -1;
+    ramfs_t* ramfs = NULL;
+    char name[OE_NAME_MAX + 1];
+    inode_t* inode;
+    inode_t* dir;
+    inode_t* existing;
+    int err;
+
+    if (!oldpath || !newpath)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(ramfs = _lock_device(device, true)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if ((err = _lookup(ramfs, oldpath, NULL, &inode)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    if (OE_S_ISDIR(inode->mode))
+        OE_RAISE_ERRNO(OE_EPERM);
+
+    if ((err = _lookup_parent(ramfs, newpath, &dir, name)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    if (_lookup(ramfs, newpath, NULL, &existing) == 0)
+        OE_RAISE_ERRNO(OE_EEXIST);
+
+    if ((err = _link(ramfs, dir, name, inode)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    ret = 0;
+
+done:
+
+    if (ramfs)
+        oe_mutex_unlock(&ramfs->lock);
+
+    return ret;
+}
+
+static int _ramfs_unlink(oe_device_t* device, const char* pathname)
+{
+    int ret = -1;
+    ramfs_t* ramfs = NULL;
+    dentry_t* dentry;
+    inode_t* inode;
+    int err;
+
+    if (!pathname)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(ramfs = _lock_device(device, true)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if ((err = _lookup(ramfs, pathname, &dentry, &inode)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    if (OE_S_ISDIR(inode->mode))
+        OE_RAISE_ERRNO(OE_EISDIR);
+
+    /* The data stays until the last open file is closed. */
+    _unlink(ramfs, dentry);
+
+    ret = 0;
+
+done:
+
+    if (ramfs)
+        oe_mutex_unlock(&ramfs->lock);
+
+    return ret;
+}
+
+static int _ramfs_rename(
+    oe_device_t* device,
+    const char* oldpath,
+    const char* newpath)
+{
+    int ret = -1;
+    ramfs_t* ramfs = NULL;
+    char name[OE_NAME_MAX + 1];
+    dentry_t* old_dentry;
+    dentry_t* new_dentry = NULL;
+    inode_t* inode;
+    inode_t* dir;
+    inode_t* target;
+    int err;
+
+    if (!oldpath || !newpath)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(ramfs = _lock_device(device, true)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if ((err = _lookup(ramfs, oldpath, &old_dentry, &inode)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    if (!old_dentry)
+        OE_RAISE_ERRNO(OE_EBUSY);
+
+    if ((err = _lookup_parent(ramfs, newpath, &dir, name)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    if ((err = _lookup(ramfs, newpath, &new_dentry, &target)) == 0)
+    {
+        /* Renaming a file to one of its links does nothing. */
+        if (target == inode)
+        {
+            ret = 0;
+            goto done;
+        }
+
+        if (OE_S_ISDIR(inode->mode))
+        {
+            if (!OE_S_ISDIR(target->mode))
+                OE_RAISE_ERRNO(OE_ENOTDIR);
+
+            if (target->num_children)
+                OE_RAISE_ERRNO(OE_ENOTEMPTY);
+        }
+        else if (OE_S_ISDIR(target->mode))
+        {
+            OE_RAISE_ERRNO(OE_EISDIR);
+        }
+    }
+    else if (err != OE_ENOENT)
+    {
+        OE_RAISE_ERRNO(err);
+    }
+    else
+    {
+        new_dentry = NULL;
+    }
+
+    /* A directory cannot be moved into itself. */
+    if (OE_S_ISDIR(inode->mode))
+    {
+        for (const inode_t* p = dir; p != ramfs->root; p = p->parent)
+        {
+            if (p == inode)
+                OE_RAISE_ERRNO(OE_EINVAL);
+        }
+    }
+
+    /* Link first so that the inode is not freed in between. */
+    if ((err = _link(ramfs, dir, name, inode)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    if (new_dentry)
+        _unlink(ramfs, new_dentry);
+
+    _unlink(ramfs, old_dentry);
+
+    if (OE_S_ISDIR(inode->mode))
+        inode->parent = dir;
+
+    ret = 0;
+
+done:
+
+    if (ramfs)
+        oe_mutex_unlock(&ramfs->lock);
+
+    return ret;
+}
+
+static int _ramfs_truncate(
+    oe_device_t* device,
+    const char* path,
+    oe_off_t length)
+{
+    int ret = -1;
+    ramfs_t* ramfs = NULL;
+    inode_t* inode;
+    int err;
+
+    if (!path || length < 0)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(ramfs = _lock_device(device, true)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if ((err = _lookup(ramfs, path, NULL, &inode)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    if (OE_S_ISDIR(inode->mode))
+        OE_RAISE_ERRNO(OE_EISDIR);
+
+    if ((err = _truncate(ramfs, inode, length)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    ret = 0;
+
+done:
+
+    if (ramfs)
+        oe_mutex_unlock(&ramfs->lock);
+
+    return ret;
+}
+
+static int _ramfs_mkdir(
+    oe_device_t* device,
+    const char* pathname,
+    oe_mode_t mode)
+{
+    int ret = -1;
+    ramfs_t* ramfs = NULL;
+    char name[OE_NAME_MAX + 1];
+    inode_t* dir;
+    inode_t* inode;
+    int err;
+
+    if (!pathname)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(ramfs = _lock_device(device, true)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (_lookup(ramfs, pathname, NULL, &inode) == 0)
+        OE_RAISE_ERRNO(OE_EEXIST);
+
+    if ((err = _lookup_parent(ramfs, pathname, &dir, name)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    if (!(inode = _new_inode(ramfs, OE_S_IFDIR | (mode & PERMISSION_MASK))))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    if ((err = _link(ramfs, dir, name, inode)) != 0)
+    {
+        oe_free(inode);
+        OE_RAISE_ERRNO(err);
+    }
+
+    ret = 0;
+
+done:
+
+    if (ramfs)
+        oe_mutex_unlock(&ramfs->lock);
+
+    return ret;
+}
+
+static int _ramfs_rmdir(oe_device_t* device, const char* pathname)
+{
+    int ret = -1;
+    ramfs_t* ramfs = NULL;
+    dentry_t* dentry;
+    inode_t* inode;
+    int err;
+
+    if (!pathname)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(ramfs = _lock_device(device, true)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if ((err = _lookup(ramfs, pathname, &dentry, &inode)) != 0)
+        OE_RAISE_ERRNO(err);
+
+    if (!OE_S_ISDIR(inode->mode))
+        OE_RAISE_ERRNO(OE_ENOTDIR);
+
+    if (!dentry)
+        OE_RAISE_ERRNO(OE_EBUSY);
+
+    if (inode->num_children)
+        OE_RAISE_ERRNO(OE_ENOTEMPTY);
+
+    _unlink(ramfs, dentry);
+
+    ret = 0;
+
+done:
+
+    if (ramfs)
+        oe_mutex_unlock(&ramfs->lock);
+
+    return ret;
+}
+
+// clang-format off
+static oe_file_ops_t _file_ops =
+{
+    .fd.read = _ramfs_read,
+    .fd.write = _ramfs_write,
+    .fd.readv = _ramfs_readv,
+    .fd.writev = _ramfs_writev,
+    .fd.dup = _ramfs_dup,
+    .fd.ioctl = _ramfs_ioctl,
+    .fd.fcntl = _ramfs_fcntl,
+    .fd.close = _ramfs_close,
+    .fd.get_host_fd = _ramfs_get_host_fd,
+    .lseek = _ramfs_lseek,
+    .pread = _ramfs_pread,
+    .pwrite = _ramfs_pwrite,
+    .preadv = _ramfs_preadv,
+    .pwritev = _ramfs_pwritev,
+    .getdents64 = _ramfs_getdents64,
+};
+// clang-format on
+
+static oe_file_ops_t _get_file_ops(void)
+{
+    return _file_ops;
+};
+
+// clang-format off
+static device_t _ramfs =
+{
+    .base.type = OE_DEVICE_TYPE_FILE_SYSTEM,
+    .base.name = OE_DEVICE_NAME_RAM_FILE_SYSTEM,
+    .base.ops.fs =
+    {
+        .base.release = _ramfs_release,
+        .clone = _ramfs_clone,
+        .mount = _ramfs_mount,
+        .umount2 = _ramfs_umount2,
+        .open = _ramfs_open,
+        .stat = _ramfs_stat,
+        .access = _ramfs_access,
+        .link = _ramfs_link,
+        .unlink = _ramfs_unlink,
+        .rename = _ramfs_rename,
+        .truncate = _ramfs_truncate,
+        .mkdir = _ramfs_mkdir,
+        .rmdir = _ramfs_rmdir,
+    },
+    .magic = FS_MAGIC,
+};
+// clang-format on
+
+oe_result_t oe_load_module_ram_file_system(void)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+    static bool _loaded = false;
+
+    oe_spin_lock(&_lock);
+
+    if (!_loaded)
+    {
+        if (oe_device_table_set(OE_DEVID_RAM_FILE_SYSTEM, &_ramfs.base) != 0)
+        {
+            /* Do not propagate errno to caller. */
+            oe_errno = 0;
+            OE_RAISE(OE_FAILURE);
+        }
+
+        _loaded = true;
+    }
+
+    result = OE_OK;
+
+done:
+    oe_spin_unlock(&_lock);
+
+    return result;
+}
@@ -0,0 +1,2302 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+/*
+**==============================================================================
+**
+** sgxfs:
+**
+**     This module implements the protected file system, which keeps files
+**     on the host encrypted and integrity protected with a key that only the
+**     enclave can derive. It is layered on the host file system device, so
+**     paths and directories behave as they do with hostfs. To use this
+**     module, the enclave application must:
+**
+**     (1) Link the oesgxfs and oehostfs libraries.
+**     (2) Load the module by calling oe_load_module_sgx_file_system().
+**     (3) Mount it, e.g. mount("/data", "/", OE_SGX_FILE_SYSTEM, 0, NULL).
+**     (4) Use the standard C file I/O functions (e.g., open, read, write).
+**
+**     The data parameter of mount() may be "policy=unique" or
+**     "policy=product" (the default) to select the seal key policy for files
+**     that the mount creates. Existing files are opened with the key
+**     information stored in their header.
+**
+**     File layout: block 0 holds the header, then each Merkle tree (MHT)
+**     node is followed by the 96 data blocks it authenticates. Blocks are
+**     4 KB and sealed with AES-GCM under a key derived from the seal key and
+**     a random per-file nonce, with a fresh random IV per write. The IV and
+**     tag of each block are kept in its parent MHT node; MHT node m is the
+**     child of node (m - 1) / 32, and the header holds the entry of the
+**     root node and the file size. Tampering with, moving or mixing blocks
+**     is detected when they are read back. Rolling back a whole file to an
+**     older version is not, and neither is a crash in the middle of a
+**     flush recovered: the file then fails to open.
+**
+**     Each open file has a write-back cache of plaintext blocks. Reads that
+**     continue where the last host read stopped are prefetched, and dirty
+**     blocks are sealed together and written with one vectored write per
+**     run of consecutive blocks, when the cache fills up and on close.
+**
+**==============================================================================
+*/
+
+// clang-format off
+#include <openenclave/enclave.h>
+// clang-format on
+
+#include <mbedtls/gcm.h>
+
+#include <openenclave/internal/syscall/device.h>
+#include <openenclave/internal/thread.h>
+#include <openenclave/internal/syscall/sys/mount.h>
+#include <openenclave/corelibc/stdlib.h>
+#include <openenclave/corelibc/string.h>
+#include <openenclave/internal/syscall/fcntl.h>
+#include <openenclave/internal/syscall/raise.h>
+#include <openenclave/internal/syscall/unistd.h>
+#include <openenclave/internal/crypto/hmac.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/utils.h>
+#include <openenclave/bits/safecrt.h>
+
+#define FS_MAGIC 0x51c0e8a7
+#define FILE_MAGIC 0xa2d9461b
+
+/* "OESGXFS1" */
+#define HEADER_MAGIC 0x315346584753454fULL
+#define HEADER_VERSION 1
+
+/* Mask to extract the access mode: O_RDONLY, O_WRONLY, O_RDWR. */
+#define ACCESS_MODE_MASK 000000003
+
+#define BLOCK_SIZE 4096
+#define KEY_SIZE 16
+#define IV_SIZE 12
+#define TAG_SIZE 16
+#define NONCE_SIZE 16
+#define KEY_INFO_MAX 1024
+
+/* The entries of an MHT node: its data blocks and its child nodes. */
+#define DATA_ENTRIES 96
+#define CHILD_ENTRIES 32
+
+/* The number of blocks cached per open file. */
+#define CACHE_SIZE 32
+#define CACHE_BUCKETS 64
+
+/* The most blocks read ahead at once. */
+#define PREFETCH_MAX 8
+
+/* The IV and tag that authenticate a sealed block. */
+typedef struct _entry
+{
+    uint8_t iv[IV_SIZE];
+    uint8_t tag[TAG_SIZE];
+    uint32_t reserved;
+} entry_t;
+
+typedef struct _mht
+{
+    entry_t data[DATA_ENTRIES];
+    entry_t children[CHILD_ENTRIES];
+} mht_t;
+
+OE_STATIC_ASSERT(sizeof(mht_t) == BLOCK_SIZE);
+
+/* Block 0 of a protected file. */
+typedef struct _header
+{
+    /* Authenticated, but stored in the clear. */
+    uint64_t magic;
+    uint32_t version;
+    uint32_t key_info_size;
+    uint8_t key_info[KEY_INFO_MAX];
+    uint8_t nonce[NONCE_SIZE];
+
+    /* The IV and tag of the secret part. */
+    entry_t seal;
+
+    /* Encrypted. */
+    struct
+    {
+        uint64_t size;
+        entry_t root;
+        uint8_t reserved[24];
+    } secret;
+} header_t;
+
+OE_STATIC_ASSERT(sizeof(header_t) <= BLOCK_SIZE);
+
+/* A cached block in plaintext. */
+typedef struct _node
+{
+    /* The least recently used list, most recent first. */
+    struct _node* prev;
+    struct _node* next;
+
+    /* The next node in the same cache bucket. */
+    struct _node* bucket_next;
+
+    /* The block number in the host file. */
+    uint64_t phys;
+
+    /* The number of the data block or MHT node. */
+    uint64_t number;
+    bool is_mht;
+    bool dirty;
+
+    /* The sealed block while a flush is in progress. */
+    uint8_t* cipher;
+
+    union {
+        uint8_t data[BLOCK_SIZE];
+        mht_t mht;
+    } u;
+} node_t;
+
+/* An open protected file, shared by every open() of the same host file. */
+typedef struct _pfile
+{
+    /* The next file in the list of open files. */
+    struct _pfile* next;
+
+    /* Guarded by the lock of the list of open files. */
+    size_t refs;
+
+    /* Identifies the host file. */
+    uint64_t dev;
+    uint64_t ino;
+
+    /* Guards everything below. */
+    oe_mutex_t lock;
+
+    /* The host file, opened through hostfs. */
+    oe_fd_t* host;
+    bool writable;
+
+    /* Set if the header could not be loaded. */
+    bool failed;
+
+    mbedtls_gcm_context gcm;
+
+    /* The header with the secret part in plaintext. */
+    header_t header;
+    bool header_dirty;
+
+    /* The file size, and the number of data blocks sealed on the host. */
+    oe_off_t size;
+    uint64_t disk_blocks;
+
+    node_t* head;
+    node_t* tail;
+    node_t* buckets[CACHE_BUCKETS];
+    size_t num_nodes;
+    size_t num_dirty;
+    bool flushing;
+
+    /* The data block that continues the last read from the host. */
+    uint64_t readahead_next;
+} pfile_t;
+
+/* The protected file system device. */
+typedef struct _device
+{
+    oe_device_t base;
+
+    /* Must be FS_MAGIC. */
+    uint32_t magic;
+
+    /* True if this file system has been mounted. */
+    bool is_mounted;
+
+    /* The parameters that were passed to the mount() function. */
+    struct
+    {
+        unsigned long flags;
+        char target[OE_PATH_MAX];
+    } mount;
+
+    /* The hostfs device mounted along with this one, if mounted. */
+    oe_device_t* hostfs;
+
+    /* The seal key of new files, obtained on first use. */
+    oe_seal_policy_t policy;
+    oe_mutex_t key_lock;
+    uint8_t* seal_key;
+    size_t seal_key_size;
+    uint8_t* key_info;
+    size_t key_info_size;
+} device_t;
+
+/* An open file description, shared by the descriptors that dup() makes. */
+typedef struct _handle
+{
+    pfile_t* pfile;
+    int flags;
+    oe_off_t offset;
+    size_t refs;
+} handle_t;
+
+/* Created by open(). */
+typedef struct _file
+{
+    oe_fd_t base;
+
+    /* Must be FILE_MAGIC. */
+    uint32_t magic;
+
+    handle_t* handle;
+} file_t;
+
+/* The open protected files of all mounts. */
+static pfile_t* _pfiles;
+static oe_mutex_t _pfiles_lock = OE_MUTEX_INITIALIZER;
+
+static const char _key_label[] = OE_SGX_FILE_SYSTEM;
+
+static oe_file_ops_t _get_file_ops(void);
+
+static int _flush(pfile_t* pf);
+
+/* Return true if the file system was mounted as read-only. */
+OE_INLINE bool _is_read_only(const device_t* fs)
+{
+    return fs->mount.flags & OE_MS_RDONLY;
+}
+
+static device_t* _cast_device(const oe_device_t* device)
+{
+    device_t* ret = NULL;
+    device_t* fs = (device_t*)device;
+
+    if (fs == NULL || fs->magic != FS_MAGIC)
+        goto done;
+
+    ret = fs;
+
+done:
+    return ret;
+}
+
+static file_t* _cast_file(const oe_fd_t* desc)
+{
+    file_t* ret = NULL;
+    file_t* file = (file_t*)desc;
+
+    if (file == NULL || file->magic != FILE_MAGIC)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    ret = file;
+
+done:
+    return ret;
+}
+
+/* Return the host file system device under this one. */
+static oe_device_t* _get_hostfs(const device_t* fs)
+{
+    if (fs->hostfs)
+        return fs->hostfs;
+
+    return oe_device_table_get(
+        OE_DEVID_HOST_FILE_SYSTEM, OE_DEVICE_TYPE_FILE_SYSTEM);
+}
+
+/*
+**==============================================================================
+**
+** Sealing.
+**
+**==============================================================================
+*/
+
+static uint64_t _num_blocks(oe_off_t size)
+{
+    return ((uint64_t)size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
+
+static uint64_t _num_groups(uint64_t blocks)
+{
+    return (blocks + DATA_ENTRIES - 1) / DATA_ENTRIES;
+}
+
+static uint64_t _mht_phys(uint64_t mht)
+{
+    return 1 + mht * (1 + DATA_ENTRIES);
+}
+
+static uint64_t _data_phys(uint64_t block)
+{
+    return _mht_phys(block / DATA_ENTRIES) + 1 + block % DATA_ENTRIES;
+}
+
+/* Seal a block. The block number is authenticated along with it. */
+static int _seal_block(
+    pfile_t* pf,
+    entry_t* entry,
+    uint64_t phys,
+    const uint8_t* plain,
+    uint8_t* cipher)
+{
+    int ret = -1;
+
+    if (oe_random(entry->iv, sizeof(entry->iv)) != OE_OK)
+        OE_RAISE_ERRNO(OE_EIO);
+
+    if (mbedtls_gcm_crypt_and_tag(
+            &pf->gcm,
+            MBEDTLS_GCM_ENCRYPT,
+            BLOCK_SIZE,
+            entry->iv,
+            sizeof(entry->iv),
+            (const uint8_t*)&phys,
+            sizeof(phys),
+            plain,
+            cipher,
+            sizeof(entry->tag),
+            entry->tag) != 0)
+    {
+        OE_RAISE_ERRNO(OE_EIO);
+    }
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+static int _open_block(
+    pfile_t* pf,
+    const entry_t* entry,
+    uint64_t phys,
+    const uint8_t* cipher,
+    uint8_t* plain)
+{
+    int ret = -1;
+
+    if (mbedtls_gcm_auth_decrypt(
+            &pf->gcm,
+            BLOCK_SIZE,
+            entry->iv,
+            sizeof(entry->iv),
+            (const uint8_t*)&phys,
+            sizeof(phys),
+            entry->tag,
+            sizeof(entry->tag),
+            cipher,
+            plain) != 0)
+    {
+        OE_RAISE_ERRNO_MSG(OE_EIO, "corrupt block %lu", phys);
+    }
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/* Get the seal key that the device gives to new files. */
+static int _load_seal_key(device_t* fs)
+{
+    int ret = -1;
+
+    oe_mutex_lock(&fs->key_lock);
+
+    if (!fs->seal_key && oe_get_seal_key_by_policy(
+                             fs->policy,
+                             &fs->seal_key,
+                             &fs->seal_key_size,
+                             &fs->key_info,
+                             &fs->key_info_size) != OE_OK)
+    {
+        fs->seal_key = NULL;
+        OE_RAISE_ERRNO(OE_EIO);
+    }
+
+    if (fs->key_info_size > KEY_INFO_MAX)
+        OE_RAISE_ERRNO(OE_EIO);
+
+    ret = 0;
+
+done:
+    oe_mutex_unlock(&fs->key_lock);
+    return ret;
+}
+
+/* Set up the cipher of a file from the seal key its header names. */
+static int _init_cipher(device_t* fs, pfile_t* pf)
+{
+    int ret = -1;
+    const header_t* header = &pf->header;
+    uint8_t* seal_key = NULL;
+    size_t seal_key_size = 0;
+    oe_hmac_sha256_context_t hmac;
+    OE_SHA256 sha;
+    bool own_key = false;
+
+    if (_load_seal_key(fs) != 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (header->key_info_size == fs->key_info_size &&
+        memcmp(header->key_info, fs->key_info, fs->key_info_size) == 0)
+    {
+        seal_key = fs->seal_key;
+        seal_key_size = fs->seal_key_size;
+    }
+    else
+    {
+        if (oe_get_seal_key(
+                header->key_info,
+                header->key_info_size,
+                &seal_key,
+                &seal_key_size) != OE_OK)
+        {
+            OE_RAISE_ERRNO(OE_EIO);
+        }
+
+        own_key = true;
+    }
+
+    /* Each file has its own key, so that blocks cannot move between
+     * files. */
+    if (oe_hmac_sha256_init(&hmac, seal_key, seal_key_size) != OE_OK)
+        OE_RAISE_ERRNO(OE_EIO);
+
+    if (oe_hmac_sha256_update(&hmac, _key_label, sizeof(_key_label)) != OE_OK ||
+        oe_hmac_sha256_update(&hmac, header->nonce, sizeof(header->nonce)) !=
+            OE_OK ||
+        oe_hmac_sha256_final(&hmac, &sha) != OE_OK)
+    {
+        oe_hmac_sha256_free(&hmac);
+        OE_RAISE_ERRNO(OE_EIO);
+    }
+
+    oe_hmac_sha256_free(&hmac);
+
+    if (mbedtls_gcm_setkey(
+            &pf->gcm, MBEDTLS_CIPHER_ID_AES, sha.buf, KEY_SIZE * 8) != 0)
+    {
+        OE_RAISE_ERRNO(OE_EIO);
+    }
+
+    ret = 0;
+
+done:
+    oe_secure_zero_fill(&sha, sizeof(sha));
+
+    if (own_key)
+        oe_free_key(seal_key, seal_key_size, NULL, 0);
+
+    return ret;
+}
+
+/* Make the header of a new file. */
+static int _init_header(device_t* fs, pfile_t* pf)
+{
+    int ret = -1;
+    header_t* header = &pf->header;
+
+    if (_load_seal_key(fs) != 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    header->magic = HEADER_MAGIC;
+    header->version = HEADER_VERSION;
+    header->key_info_size = (uint32_t)fs->key_info_size;
+    memcpy(header->key_info, fs->key_info, fs->key_info_size);
+
+    if (oe_random(header->nonce, sizeof(header->nonce)) != OE_OK)
+        OE_RAISE_ERRNO(OE_EIO);
+
+    if (_init_cipher(fs, pf) != 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    pf->header_dirty = true;
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/* Read and check the header. An empty host file is a new file, which gets
+ * a header when it is first opened for writing. */
+static int _load_header(device_t* fs, pfile_t* pf)
+{
+    int ret = -1;
+    header_t* header = &pf->header;
+    const size_t aad_size = OE_OFFSETOF(header_t, seal);
+    ssize_t n;
+
+    n = pf->host->ops.file.pread(pf->host, header, sizeof(*header), 0);
+
+    if (n < 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (n == 0)
+    {
+        ret = 0;
+        goto done;
+    }
+
+    if ((size_t)n != sizeof(*header) || header->magic != HEADER_MAGIC ||
+        header->version != HEADER_VERSION ||
+        header->key_info_size > KEY_INFO_MAX)
+    {
+        OE_RAISE_ERRNO_MSG(OE_EIO, "not a protected file");
+    }
+
+    if (_init_cipher(fs, pf) != 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (mbedtls_gcm_auth_decrypt(
+            &pf->gcm,
+            sizeof(header->secret),
+            header->seal.iv,
+            sizeof(header->seal.iv),
+            (const uint8_t*)header,
+            aad_size,
+            header->seal.tag,
+            sizeof(header->seal.tag),
+            (const uint8_t*)&header->secret,
+            (uint8_t*)&header->secret) != 0)
+    {
+        OE_RAISE_ERRNO_MSG(OE_EIO, "corrupt header");
+    }
+
+    if (header->secret.size > OE_INT64_MAX)
+        OE_RAISE_ERRNO(OE_EIO);
+
+    pf->size = (oe_off_t)header->secret.size;
+    pf->disk_blocks = _num_blocks(pf->size);
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** The block cache. These are called with the lock of the file held.
+**
+**==============================================================================
+*/
+
+static node_t* _cache_find(const pfile_t* pf, uint64_t phys)
+{
+    node_t* p = pf->buckets[phys % CACHE_BUCKETS];
+
+    while (p && p->phys != phys)
+        p = p->bucket_next;
+
+    return p;
+}
+
+static void _lru_unlink(pfile_t* pf, node_t* node)
+{
+    if (node->prev)
+        node->prev->next = node->next;
+    else
+        pf->head = node->next;
+
+    if (node->next)
+        node->next->prev = node->prev;
+    else
+        pf->tail = node->prev;
+}
+
+static void _lru_push(pfile_t* pf, node_t* node)
+{
+    node->prev = NULL;
+
+    if ((node->next = pf->head))
+        pf->head->prev = node;
+    else
+        pf->tail = node;
+
+    pf->head = node;
+}
+
+static void _cache_insert(pfile_t* pf, node_t* node)
+{
+    node_t** bucket = &pf->buckets[node->phys % CACHE_BUCKETS];
+
+    node->bucket_next = *bucket;
+    *bucket = node;
+    _lru_push(pf, node);
+    pf->num_nodes++;
+}
+
+static void _cache_remove(pfile_t* pf, node_t* node)
+{
+    node_t** link = &pf->buckets[node->phys % CACHE_BUCKETS];
+
+    while (*link != node)
+        link = &(*link)->bucket_next;
+
+    *link = node->bucket_next;
+    _lru_unlink(pf, node);
+    pf->num_nodes--;
+
+    if (node->dirty)
+        pf->num_dirty--;
+
+    oe_secure_zero_fill(node->u.data, sizeof(node->u.data));
+    oe_free(node->cipher);
+    oe_free(node);
+}
+
+static void _mark_dirty(pfile_t* pf, node_t* node)
+{
+    if (!node->dirty)
+    {
+        node->dirty = true;
+        pf->num_dirty++;
+    }
+}
+
+/* Evict clean blocks, least recently used first, until count more fit.
+ * When every block is dirty, flush them first. A flush in progress may
+ * overfill the cache instead. */
+static int _make_room(pfile_t* pf, size_t count)
+{
+    int ret = -1;
+
+    while (pf->num_nodes + count > CACHE_SIZE)
+    {
+        node_t* p = pf->tail;
+
+        while (p && p->dirty)
+            p = p->prev;
+
+        if (p)
+        {
+            _cache_remove(pf, p);
+        }
+        else if (pf->flushing || pf->num_nodes == 0)
+        {
+            break;
+        }
+        else if (_flush(pf) != 0)
+        {
+            OE_RAISE_ERRNO(oe_errno);
+        }
+    }
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+static node_t* _new_node(bool is_mht, uint64_t number)
+{
+    node_t* node;
+
+    if (!(node = oe_calloc(1, sizeof(node_t))))
+        return NULL;
+
+    node->is_mht = is_mht;
+    node->number = number;
+    node->phys = is_mht ? _mht_phys(number) : _data_phys(number);
+
+    return node;
+}
+
+static node_t* _get_node(
+    pfile_t* pf,
+    bool is_mht,
+    uint64_t number,
+    bool overwrite);
+
+/* Return the entry in the parent of a block, loading the parent. */
+static entry_t* _get_entry(pfile_t* pf, bool is_mht, uint64_t number)
+{
+    node_t* parent;
+
+    if (is_mht && number == 0)
+        return &pf->header.secret.root;
+
+    if (is_mht)
+    {
+        const uint64_t index = (number - 1) % CHILD_ENTRIES;
+
+        parent = _get_node(pf, true, (number - 1) / CHILD_ENTRIES, false);
+
+        if (!parent)
+            return NULL;
+
+        return &parent->u.mht.children[index];
+    }
+
+    if (!(parent = _get_node(pf, true, number / DATA_ENTRIES, false)))
+        return NULL;
+
+    return &parent->u.mht.data[number % DATA_ENTRIES];
+}
+
+/* Read count blocks from the host, starting at the given data block or MHT
+ * node, and open them. The data blocks of one MHT node are consecutive in
+ * the host file, so they take a single read. Returns the first block. */
+static node_t* _load(pfile_t* pf, bool is_mht, uint64_t number, size_t count)
+{
+    node_t* ret = NULL;
+    entry_t entries[PREFETCH_MAX];
+    const uint64_t phys = is_mht ? _mht_phys(number) : _data_phys(number);
+    const size_t size = count * BLOCK_SIZE;
+    uint8_t* cipher = NULL;
+    node_t* node = NULL;
+    ssize_t n;
+
+    /* Copy the entries, as making room may evict their MHT node. */
+    for (size_t i = 0; i < count; i++)
+    {
+        const entry_t* entry;
+
+        if (!(entry = _get_entry(pf, is_mht, number + i)))
+            OE_RAISE_ERRNO(oe_errno);
+
+        entries[i] = *entry;
+    }
+
+    if (_make_room(pf, count) != 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (!(cipher = oe_malloc(size)))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    n = pf->host->ops.file.pread(
+        pf->host, cipher, size, (oe_off_t)(phys * BLOCK_SIZE));
+
+    if (n < 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    if ((size_t)n != size)
+        OE_RAISE_ERRNO_MSG(OE_EIO, "short protected file");
+
+    /* Insert the first block last, so that it is the most recent. */
+    for (size_t i = count; i-- > 0;)
+    {
+        const uint8_t* block = cipher + i * BLOCK_SIZE;
+
+        if (!(node = _new_node(is_mht, number + i)))
+            OE_RAISE_ERRNO(OE_ENOMEM);
+
+        if (_open_block(pf, &entries[i], phys + i, block, node->u.data) != 0)
+            OE_RAISE_ERRNO(oe_errno);
+
+        _cache_insert(pf, node);
+        node = NULL;
+    }
+
+    ret = pf->head;
+
+done:
+    oe_free(node);
+    oe_free(cipher);
+    return ret;
+}
+
+/* Return a cached block, loading it if needed. Blocks that are not on the
+ * host yet start out zeroed, and so do blocks that are to be overwritten
+ * as a whole. */
+static node_t* _get_node(
+    pfile_t* pf,
+    bool is_mht,
+    uint64_t number,
+    bool overwrite)
+{
+    node_t* ret = NULL;
+    const uint64_t phys = is_mht ? _mht_phys(number) : _data_phys(number);
+    const bool exists = is_mht ? number < _num_groups(pf->disk_blocks)
+                               : number < pf->disk_blocks;
+    node_t* node;
+
+    if ((node = _cache_find(pf, phys)))
+    {
+        _lru_unlink(pf, node);
+        _lru_push(pf, node);
+        ret = node;
+        goto done;
+    }
+
+    if (!exists || overwrite)
+    {
+        if (_make_room(pf, 1) != 0)
+            OE_RAISE_ERRNO(oe_errno);
+
+        if (!(node = _new_node(is_mht, number)))
+            OE_RAISE_ERRNO(OE_ENOMEM);
+
+        _cache_insert(pf, node);
+        ret = node;
+        goto done;
+    }
+
+    if (is_mht)
+    {
+        ret = _load(pf, true, number, 1);
+    }
+    else
+    {
+        size_t count = 1;
+
+        /* Read ahead when reads from the host are sequential, up to the end
+         * of the MHT node or the first cached block. */
+        if (number == pf->readahead_next)
+        {
+            const uint64_t left = DATA_ENTRIES - number % DATA_ENTRIES;
+
+            while (count < PREFETCH_MAX && count < left &&
+                   number + count < pf->disk_blocks &&
+                   !_cache_find(pf, phys + count))
+            {
+                count++;
+            }
+        }
+
+        pf->readahead_next = number + count;
+        ret = _load(pf, false, number, count);
+    }
+
+done:
+    return ret;
+}
+
+/* Sort by block number, so that runs of consecutive blocks can be found. */
+static void _sort_nodes(node_t** nodes, size_t count)
+{
+    for (size_t i = 1; i < count; i++)
+    {
+        node_t* node = nodes[i];
+        size_t j = i;
+
+        for (; j > 0 && nodes[j - 1]->phys > node->phys; j--)
+            nodes[j] = nodes[j - 1];
+
+        nodes[j] = node;
+    }
+}
+
+/* Write the sealed blocks with one vectored write per run of consecutive
+ * blocks. */
+static int _write_nodes(pfile_t* pf, node_t** nodes, size_t count)
+{
+    int ret = -1;
+    struct oe_iovec* iov = NULL;
+
+    if (!(iov = oe_calloc(OE_IOV_MAX, sizeof(struct oe_iovec))))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    for (size_t i = 0; i < count;)
+    {
+        const uint64_t phys = nodes[i]->phys;
+        size_t n = 0;
+        ssize_t written;
+
+        while (i + n < count && n < OE_IOV_MAX &&
+               nodes[i + n]->phys == phys + n)
+        {
+            iov[n].iov_base = nodes[i + n]->cipher;
+            iov[n].iov_len = BLOCK_SIZE;
+            n++;
+        }
+
+        written = pf->host->ops.file.pwritev(
+            pf->host, iov, (int)n, (oe_off_t)(phys * BLOCK_SIZE));
+
+        if (written < 0)
+            OE_RAISE_ERRNO(oe_errno);
+
+        if ((size_t)written != n * BLOCK_SIZE)
+            OE_RAISE_ERRNO(OE_EIO);
+
+        i += n;
+    }
+
+    ret = 0;
+
+done:
+    oe_free(iov);
+    return ret;
+}
+
+/* Seal a dirty block and record it in its parent. */
+static int _seal_node(pfile_t* pf, node_t* node)
+{
+    int ret = -1;
+    entry_t* entry;
+    uint64_t parent;
+
+    if (!(node->cipher = oe_malloc(BLOCK_SIZE)))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    if (!(entry = _get_entry(pf, node->is_mht, node->number)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (_seal_block(pf, entry, node->phys, node->u.data, node->cipher) != 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    /* Sealing a block changes its parent, which was loaded above. */
+    if (node->is_mht && node->number == 0)
+    {
+        pf->header_dirty = true;
+    }
+    else
+    {
+        if (node->is_mht)
+            parent = _mht_phys((node->number - 1) / CHILD_ENTRIES);
+        else
+            parent = _mht_phys(node->number / DATA_ENTRIES);
+
+        _mark_dirty(pf, _cache_find(pf, parent));
+    }
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/* Write back the dirty blocks and the header. Data blocks are sealed first,
+ * then MHT nodes from the highest number down, as a node is always numbered
+ * above its parent. The header goes last. */
+static int _flush(pfile_t* pf)
+{
+    int ret = -1;
+    const size_t aad_size = OE_OFFSETOF(header_t, seal);
+    node_t** nodes = NULL;
+    size_t count = 0;
+    header_t header;
+    ssize_t n;
+
+    if (!pf->num_dirty && !pf->header_dirty)
+    {
+        ret = 0;
+        goto done;
+    }
+
+    pf->flushing = true;
+
+    for (node_t* p = pf->tail; p; p = p->prev)
+    {
+        if (p->dirty && !p->is_mht && _seal_node(pf, p) != 0)
+            OE_RAISE_ERRNO(oe_errno);
+    }
+
+    for (;;)
+    {
+        node_t* next = NULL;
+
+        for (node_t* p = pf->head; p; p = p->next)
+        {
+            if (p->dirty && p->is_mht && !p->cipher &&
+                (!next || p->number > next->number))
+            {
+                next = p;
+            }
+        }
+
+        if (!next)
+            break;
+
+        if (_seal_node(pf, next) != 0)
+            OE_RAISE_ERRNO(oe_errno);
+    }
+
+    if (pf->num_dirty)
+    {
+        if (!(nodes = oe_calloc(pf->num_dirty, sizeof(node_t*))))
+            OE_RAISE_ERRNO(OE_ENOMEM);
+
+        for (node_t* p = pf->head; p; p = p->next)
+        {
+            if (p->dirty)
+                nodes[count++] = p;
+        }
+
+        _sort_nodes(nodes, count);
+
+        if (_write_nodes(pf, nodes, count) != 0)
+            OE_RAISE_ERRNO(oe_errno);
+    }
+
+    /* The secret part is sealed from pf->header, so update it there */
+    pf->header.secret.size = (uint64_t)pf->size;
+    header = pf->header;
+
+    if (oe_random(header.seal.iv, sizeof(header.seal.iv)) != OE_OK)
+        OE_RAISE_ERRNO(OE_EIO);
+
+    if (mbedtls_gcm_crypt_and_tag(
+            &pf->gcm,
+            MBEDTLS_GCM_ENCRYPT,
+            sizeof(header.secret),
+            header.seal.iv,
+            sizeof(header.seal.iv),
+            (const uint8_t*)&header,
+            aad_size,
+            (const uint8_t*)&pf->header.secret,
+            (uint8_t*)&header.secret,
+            sizeof(header.seal.tag),
+            header.seal.tag) != 0)
+    {
+        OE_RAISE_ERRNO(OE_EIO);
+    }
+
+    n = pf->host->ops.file.pwrite(pf->host, &header, sizeof(header), 0);
+
+    if (n < 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    if ((size_t)n != sizeof(header))
+        OE_RAISE_ERRNO(OE_EIO);
+
+    for (size_t i = 0; i < count; i++)
+        nodes[i]->dirty = false;
+
+    pf->num_dirty = 0;
+    pf->header_dirty = false;
+    pf->disk_blocks = _num_blocks(pf->size);
+
+    ret = 0;
+
+done:
+
+    /* On failure everything stays dirty, and is sealed again next time. */
+    for (node_t* p = pf->head; p; p = p->next)
+    {
+        oe_free(p->cipher);
+        p->cipher = NULL;
+    }
+
+    oe_free(nodes);
+    pf->flushing = false;
+
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** File contents. These are called with the lock of the file held.
+**
+**==============================================================================
+*/
+
+static ssize_t _read_data(pfile_t* pf, void* buf, size_t count, oe_off_t off)
+{
+    ssize_t ret = -1;
+    uint8_t* p = buf;
+    size_t total;
+    size_t done = 0;
+
+    if (off >= pf->size)
+    {
+        ret = 0;
+        goto done;
+    }
+
+    total = (size_t)(pf->size - off);
+
+    if (total > count)
+        total = count;
+
+    if (total > OE_SSIZE_MAX)
+        total = OE_SSIZE_MAX;
+
+    while (done < total)
+    {
+        const uint64_t pos = (uint64_t)off + done;
+        const size_t start = pos % BLOCK_SIZE;
+        size_t n = BLOCK_SIZE - start;
+        const node_t* node;
+
+        if (n > total - done)
+            n = total - done;
+
+        if (!(node = _get_node(pf, false, pos / BLOCK_SIZE, false)))
+        {
+            if (done)
+                break;
+
+            OE_RAISE_ERRNO(oe_errno);
+        }
+
+        memcpy(p + done, node->u.data + start, n);
+        done += n;
+    }
+
+    ret = (ssize_t)done;
+
+done:
+    return ret;
+}
+
+static ssize_t _write_data(
+    pfile_t* pf,
+    const void* buf,
+    size_t count,
+    oe_off_t off)
+{
+    ssize_t ret = -1;
+    const uint8_t* p = buf;
+    size_t done = 0;
+
+    if (count > OE_SSIZE_MAX || (oe_off_t)count > OE_INT64_MAX - off)
+        OE_RAISE_ERRNO(OE_EFBIG);
+
+    while (done < count)
+    {
+        const uint64_t pos = (uint64_t)off + done;
+        const size_t start = pos % BLOCK_SIZE;
+        size_t n = BLOCK_SIZE - start;
+        node_t* node;
+
+        if (n > count - done)
+            n = count - done;
+
+        if (!(node = _get_node(pf, false, pos / BLOCK_SIZE, n == BLOCK_SIZE)))
+        {
+            if (done)
+                break;
+
+            OE_RAISE_ERRNO(oe_errno);
+        }
+
+        memcpy(node->u.data + start, p + done, n);
+        _mark_dirty(pf, node);
+        done += n;
+
+        if ((oe_off_t)(pos + n) > pf->size)
+        {
+            pf->size = (oe_off_t)(pos + n);
+            pf->header_dirty = true;
+        }
+    }
+
+    ret = (ssize_t)done;
+
+done:
+    return ret;
+}
+
+/* Bytes past the end of the file are always zero in the cache and on the
+ * host, so growing a file only changes its size. */
+static int _truncate_data(pfile_t* pf, oe_off_t length)
+{
+    int ret = -1;
+
+    if (length < pf->size)
+    {
+        const uint64_t blocks = _num_blocks(length);
+        const size_t tail = (size_t)(length % BLOCK_SIZE);
+        node_t* node = pf->head;
+
+        /* Drop the cached blocks past the end, and forget that the host has
+         * them, so that they read as zeros if the file grows again. */
+        while (node)
+        {
+            node_t* next = node->next;
+
+            if (node->is_mht ? node->number >= _num_groups(blocks)
+                             : node->number >= blocks)
+            {
+                _cache_remove(pf, node);
+            }
+
+            node = next;
+        }
+
+        if (pf->disk_blocks > blocks)
+            pf->disk_blocks = blocks;
+
+        if (tail)
+        {
+            if (!(node = _get_node(pf, false, blocks - 1, false)))
+                OE_RAISE_ERRNO(oe_errno);
+
+            memset(node->u.data + tail, 0, BLOCK_SIZE - tail);
+            _mark_dirty(pf, node);
+        }
+    }
+
+    pf->size = length;
+    pf->header_dirty = true;
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** Open protected files.
+**
+**==============================================================================
+*/
+
+static void _free_pfile(pfile_t* pf)
+{
+    while (pf->head)
+    {
+        pf->head->dirty = false;
+        _cache_remove(pf, pf->head);
+    }
+
+    if (pf->host)
+        pf->host->ops.fd.close(pf->host);
+
+    mbedtls_gcm_free(&pf->gcm);
+    oe_secure_zero_fill(pf, sizeof(*pf));
+    oe_free(pf);
+}
+
+/* Flush a file, and free it with the last reference. */
+static int _put_pfile(pfile_t* pf)
+{
+    int ret = 0;
+    bool last;
+
+    oe_mutex_lock(&pf->lock);
+
+    if (_flush(pf) != 0)
+        ret = -1;
+
+    oe_mutex_unlock(&pf->lock);
+
+    oe_mutex_lock(&_pfiles_lock);
+
+    if ((last = --pf->refs == 0))
+    {
+        pfile_t** link = &_pfiles;
+
+        while (*link != pf)
+            link = &(*link)->next;
+
+        *link = pf->next;
+    }
+
+    oe_mutex_unlock(&_pfiles_lock);
+
+    if (last)
+        _free_pfile(pf);
+
+    return ret;
+}
+
+/* Open the protected file at a path, or share it if it is already open. */
+static pfile_t* _open_pfile(
+    device_t* fs,
+    const char* pathname,
+    int flags,
+    oe_mode_t mode)
+{
+    pfile_t* ret = NULL;
+    oe_device_t* hostfs;
+    int host_flags = flags & (OE_O_CREAT | OE_O_EXCL | OE_O_NOFOLLOW);
+    bool writable = false;
+    oe_fd_t* host = NULL;
+    struct oe_stat st;
+    pfile_t* pf = NULL;
+    bool is_new = false;
+    int retval = 0;
+
+    if (!(hostfs = _get_hostfs(fs)))
+        OE_RAISE_ERRNO(OE_ENODEV);
+
+    /* Blocks are read to be updated, so writers need read access. Creating
+     * a file writes its header. */
+    if ((flags & ACCESS_MODE_MASK) != OE_O_RDONLY || (flags & OE_O_CREAT))
+    {
+        host_flags |= OE_O_RDWR;
+        writable = true;
+    }
+
+    if (!(host = hostfs->ops.fs.open(hostfs, pathname, host_flags, mode)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (hostfs->ops.fs.stat(hostfs, pathname, &st) != 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (OE_S_ISDIR(st.st_mode))
+        OE_RAISE_ERRNO(OE_EISDIR);
+
+    oe_mutex_lock(&_pfiles_lock);
+
+    for (pf = _pfiles; pf; pf = pf->next)
+    {
+        if (pf->dev == st.st_dev && pf->ino == st.st_ino)
+            break;
+    }
+
+    if (pf)
+    {
+        pf->refs++;
+    }
+    else if ((pf = oe_calloc(1, sizeof(pfile_t))))
+    {
+        mbedtls_gcm_init(&pf->gcm);
+        pf->refs = 1;
+        pf->dev = st.st_dev;
+        pf->ino = st.st_ino;
+        pf->next = _pfiles;
+        _pfiles = pf;
+
+        /* Others wait on the lock until the header is loaded. */
+        oe_mutex_lock(&pf->lock);
+        is_new = true;
+    }
+
+    oe_mutex_unlock(&_pfiles_lock);
+
+    if (!pf)
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    if (!is_new)
+        oe_mutex_lock(&pf->lock);
+
+    if (is_new)
+    {
+        pf->host = host;
+        pf->writable = writable;
+        host = NULL;
+
+        if ((retval = _load_header(fs, pf)) != 0)
+            pf->failed = true;
+    }
+    else if (pf->failed)
+    {
+        oe_errno = OE_EIO;
+        retval = -1;
+    }
+    else if (writable && !pf->writable)
+    {
+        /* The file was opened read-only before, so take over the host file
+         * opened for writing. */
+        oe_fd_t* old = pf->host;
+
+        pf->host = host;
+        pf->writable = true;
+        host = old;
+    }
+
+    if (retval == 0 && writable && pf->header.magic == 0)
+        retval = _init_header(fs, pf);
+
+    oe_mutex_unlock(&pf->lock);
+
+    if (retval != 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    ret = pf;
+    pf = NULL;
+
+done:
+
+    if (pf)
+        _put_pfile(pf);
+
+    if (host)
+        host->ops.fd.close(host);
+
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** Mounts.
+**
+**==============================================================================
+*/
+
+/* Parse the mount data: NULL, "" or "policy=unique|product". */
+static int _parse_mount_data(const char* data, oe_seal_policy_t* policy)
+{
+    int ret = -1;
+
+    *policy = OE_SEAL_POLICY_PRODUCT;
+
+    if (!data || !*data || oe_strcmp(data, "policy=product") == 0)
+        ;
+    else if (oe_strcmp(data, "policy=unique") == 0)
+        *policy = OE_SEAL_POLICY_UNIQUE;
+    else
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/* Called by oe_mount(). */
+static int _sgxfs_mount(
+    oe_device_t* device,
+    const char* source,
+    const char* target,
+    const char* filesystemtype,
+    unsigned long flags,
+    const void* data)
+{
+    int ret = -1;
+    device_t* fs = _cast_device(device);
+    oe_device_t* hostfs;
+    oe_device_t* new_hostfs = NULL;
+
+    /* Fail if required parameters are null. */
+    if (!fs || !source || !target)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* Fail if this file system is already mounted. */
+    if (fs->is_mounted)
+        OE_RAISE_ERRNO(OE_EBUSY);
+
+    /* Cross check the file system type. */
+    if (oe_strcmp(filesystemtype, OE_DEVICE_NAME_SGX_FILE_SYSTEM) != 0)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (_parse_mount_data(data, &fs->policy) != 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    /* Mount a host file system along, to translate the paths. */
+    if (!(hostfs = _get_hostfs(fs)))
+        OE_RAISE_ERRNO(OE_ENODEV);
+
+    if (hostfs->ops.fs.clone(hostfs, &new_hostfs) != 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (new_hostfs->ops.fs.mount(
+            new_hostfs,
+            source,
+            target,
+            OE_DEVICE_NAME_HOST_FILE_SYSTEM,
+            flags,
+            NULL) != 0)
+    {
+        OE_RAISE_ERRNO(oe_errno);
+    }
+
+    fs->hostfs = new_hostfs;
+    new_hostfs = NULL;
+
+    /* Remember whether this is a read-only mount. */
+    fs->mount.flags = flags & OE_MS_RDONLY;
+
+    /* Save the target parameter (checked by the umount2() function). */
+    oe_strlcpy(fs->mount.target, target, sizeof(fs->mount.target));
+
+    /* Set the flag indicating that this file system is mounted. */
+    fs->is_mounted = true;
+
+    ret = 0;
+
+done:
+
+    if (new_hostfs)
+        new_hostfs->ops.device.release(new_hostfs);
+
+    return ret;
+}
+
+/* Called by oe_umount2(). */
+static int _sgxfs_umount2(oe_device_t* device, const char* target, int flags)
+{
+    int ret = -1;
+    device_t* fs = _cast_device(device);
+
+    /* Fail if any required parameters are null. */
+    if (!fs || !target)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* Fail if this file system is not mounted. */
+    if (!fs->is_mounted)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* Cross check target parameter with the one passed to mount(). */
+    if (oe_strcmp(target, fs->mount.target) != 0)
+        OE_RAISE_ERRNO(OE_ENOENT);
+
+    /* Open files keep their host files, and stay usable. */
+    if (fs->hostfs->ops.fs.umount2(fs->hostfs, target, flags) != 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    fs->hostfs->ops.device.release(fs->hostfs);
+    fs->hostfs = NULL;
+
+    /* Clear the cached mount parameters. */
+    oe_memset_s(&fs->mount, sizeof(fs->mount), 0, sizeof(fs->mount));
+
+    fs->is_mounted = false;
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/* Called by oe_mount() to make a copy of this device. */
+static int _sgxfs_clone(oe_device_t* device, oe_device_t** new_device)
+{
+    int ret = -1;
+    device_t* fs = _cast_device(device);
+    device_t* new_fs = NULL;
+
+    if (!fs || !new_device)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(new_fs = oe_calloc(1, sizeof(device_t))))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    /* The copy gets its own host file system and seal key. */
+    new_fs->base = fs->base;
+    new_fs->magic = fs->magic;
+    new_fs->policy = fs->policy;
+    *new_device = &new_fs->base;
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+static device_t _sgxfs;
+
+/* Called by oe_umount() to release this device. */
+static int _sgxfs_release(oe_device_t* device)
+{
+    int ret = -1;
+    device_t* fs = _cast_device(device);
+
+    if (!fs)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (fs->seal_key)
+    {
+        oe_free_key(
+            fs->seal_key, fs->seal_key_size, fs->key_info, fs->key_info_size);
+        fs->seal_key = NULL;
+        fs->key_info = NULL;
+    }
+
+    if (fs != &_sgxfs)
+        oe_free(fs);
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/*
+**==============================================================================
+**
+** Open files.
+**
+**==============================================================================
+*/
+
+static oe_fd_t* _sgxfs_open(
+    oe_device_t* device,
+    const char* pathname,
+    int flags,
+    oe_mode_t mode)
+{
+    oe_fd_t* ret = NULL;
+    device_t* fs = _cast_device(device);
+    const int access = flags & ACCESS_MODE_MASK;
+    oe_device_t* hostfs;
+    file_t* file = NULL;
+    handle_t* handle = NULL;
+    pfile_t* pf = NULL;
+
+    /* Fail if any required parameters are null. */
+    if (!fs || !pathname)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* Fail if attempting to write to a read-only file system. */
+    if (_is_read_only(fs) &&
+        (access != OE_O_RDONLY || (flags & (OE_O_CREAT | OE_O_TRUNC))))
+    {
+        OE_RAISE_ERRNO(OE_EPERM);
+    }
+
+    /* Directories are not protected, so hostfs opens them. */
+    if ((flags & OE_O_DIRECTORY))
+    {
+        if (!(hostfs = _get_hostfs(fs)))
+            OE_RAISE_ERRNO(OE_ENODEV);
+
+        ret = hostfs->ops.fs.open(hostfs, pathname, flags, mode);
+        goto done;
+    }
+
+    if (!(file = oe_calloc(1, sizeof(file_t))))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    if (!(handle = oe_calloc(1, sizeof(handle_t))))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    if (!(pf = _open_pfile(fs, pathname, flags, mode)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if ((flags & OE_O_TRUNC) && access != OE_O_RDONLY)
+    {
+        int retval;
+
+        oe_mutex_lock(&pf->lock);
+        retval = _truncate_data(pf, 0);
+        oe_mutex_unlock(&pf->lock);
+
+        if (retval != 0)
+            OE_RAISE_ERRNO(oe_errno);
+    }
+
+    handle->pfile = pf;
+    handle->flags = flags;
+    handle->refs = 1;
+
+    file->base.type = OE_FD_TYPE_FILE;
+    file->base.ops.file = _get_file_ops();
+    file->magic = FILE_MAGIC;
+    file->handle = handle;
+
+    ret = &file->base;
+    file = NULL;
+    handle = NULL;
+    pf = NULL;
+
+done:
+
+    if (pf)
+        _put_pfile(pf);
+
+    if (handle)
+        oe_free(handle);
+
+    if (file)
+        oe_free(file);
+
+    return ret;
+}
+
+static int _sgxfs_dup(oe_fd_t* desc, oe_fd_t** new_file_out)
+{
+    int ret = -1;
+    file_t* file = _cast_file(desc);
+    file_t* new_file = NULL;
+
+    if (new_file_out)
+        *new_file_out = NULL;
+
+    /* Check parameters. */
+    if (!file || !new_file_out)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(new_file = oe_calloc(1, sizeof(file_t))))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    /* The new descriptor shares the offset and the status flags. */
+    *new_file = *file;
+
+    oe_mutex_lock(&file->handle->pfile->lock);
+    file->handle->refs++;
+    oe_mutex_unlock(&file->handle->pfile->lock);
+
+    *new_file_out = &new_file->base;
+    ret = 0;
+
+done:
+    return ret;
+}
+
+/* Transfer an iovec array at offset under the lock of the file, so that it
+ * is atomic like a single read() or write(). Uses and updates the offset of
+ * the handle if offset is NULL. */
+static ssize_t _transfer_iov(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt,
+    const oe_off_t* offset,
+    bool write)
+{
+    ssize_t ret = -1;
+    file_t* file = _cast_file(desc);
+    handle_t* handle;
+    pfile_t* pf;
+    int access;
+    oe_off_t pos;
+    ssize_t total = 0;
+    ssize_t n = 0;
+
+    if (!file || (!iov && iovcnt) || iovcnt < 0 || iovcnt > OE_IOV_MAX)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (offset && *offset < 0)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    handle = file->handle;
+    pf = handle->pfile;
+    access = handle->flags & ACCESS_MODE_MASK;
+
+    if (write ? access == OE_O_RDONLY : access == OE_O_WRONLY)
+        OE_RAISE_ERRNO(OE_EBADF);
+
+    oe_mutex_lock(&pf->lock);
+
+    if (!offset && write && (handle->flags & OE_O_APPEND))
+        handle->offset = pf->size;
+
+    pos = offset ? *offset : handle->offset;
+
+    for (int i = 0; i < iovcnt; i++)
+    {
+        if (write)
+            n = _write_data(pf, iov[i].iov_base, iov[i].iov_len, pos);
+        else
+            n = _read_data(pf, iov[i].iov_base, iov[i].iov_len, pos);
+
+        if (n < 0)
+            break;
+
+        total += n;
+        pos += n;
+
+        if ((size_t)n < iov[i].iov_len)
+            break;
+    }
+
+    if (!offset)
+        handle->offset = pos;
+
+    oe_mutex_unlock(&pf->lock);
+
+    /* Report a failure only if nothing was transferred. */
+    if (n < 0 && total == 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    ret = total;
+
+done:
+    return ret;
+}
+
+static ssize_t _sgxfs_read(oe_fd_t* desc, void* buf, size_t count)
+{
+    struct oe_iovec iov = {buf, count};
+
+    if (count && !buf)
+    {
+        oe_errno = OE_EINVAL;
+        return -1;
+    }
+
+    return _transfer_iov(desc, &iov, 1, NULL, false);
+}
+
+static ssize_t _sgxfs_write(oe_fd_t* desc, const void* buf, size_t count)
+{
+    struct oe_iovec iov = {(void*)buf, count};
+
+    if (count && !buf)
+    {
+        oe_errno = OE_EINVAL;
+        return -1;
+    }
+
+    return _transfer_iov(desc, &iov, 1, NULL, true);
+}
+
+static ssize_t _sgxfs_readv(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt)
+{
+    return _transfer_iov(desc, iov, iovcnt, NULL, false);
+}
+
+static ssize_t _sgxfs_writev(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt)
+{
+    return _transfer_iov(desc, iov, iovcnt, NULL, true);
+}
+
+static ssize_t _sgxfs_pread(
+    oe_fd_t* desc,
+    void* buf,
+    size_t count,
+    oe_off_t offset)
+{
+    struct oe_iovec iov = {buf, count};
+
+    return _transfer_iov(desc, &iov, 1, &offset, false);
+}
+
+static ssize_t _sgxfs_pwrite(
+    oe_fd_t* desc,
+    const void* buf,
+    size_t count,
+    oe_off_t offset)
+{
+    struct oe_iovec iov = {(void*)buf, count};
+
+    return _transfer_iov(desc, &iov, 1, &offset, true);
+}
+
+static ssize_t _sgxfs_preadv(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt,
+    oe_off_t offset)
+{
+    return _transfer_iov(desc, iov, iovcnt, &offset, false);
+}
+
+static ssize_t _sgxfs_pwritev(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt,
+    oe_off_t offset)
+{
+    return _transfer_iov(desc, iov, iovcnt, &offset, true);
+}
+
+static oe_off_t _sgxfs_lseek(oe_fd_t* desc, oe_off_t offset, int whence)
+{
+    oe_off_t ret = -1;
+    file_t* file = _cast_file(desc);
+    handle_t* handle;
+    oe_off_t base;
+
+    if (!file)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    handle = file->handle;
+
+    oe_mutex_lock(&handle->pfile->lock);
+
+    switch (whence)
+    {
+        case OE_SEEK_SET:
+            base = 0;
+            break;
+        case OE_SEEK_CUR:
+            base = handle->offset;
+            break;
+        case OE_SEEK_END:
+            base = handle->pfile->size;
+            break;
+        default:
+            base = -1;
+            break;
+    }
+
+    if (base >= 0 && offset >= -base && offset <= OE_INT64_MAX - base)
+        ret = handle->offset = base + offset;
+
+    oe_mutex_unlock(&handle->pfile->lock);
+
+    if (ret < 0)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+done:
+    return ret;
+}
+
+/* Directories are opened by hostfs, so this is never a directory. */
+static int _sgxfs_getdents64(
+    oe_fd_t* desc,
+    struct oe_dirent* dirp,
+    unsigned int count)
+{
+    int ret = -1;
+
+    OE_UNUSED(desc);
+    OE_UNUSED(dirp);
+    OE_UNUSED(count);
+
+    OE_RAISE_ERRNO(OE_ENOTDIR);
+
+done:
+    return ret;
+}
+
+static int _sgxfs_close(oe_fd_t* desc)
+{
+    int ret = -1;
+    file_t* file = _cast_file(desc);
+    handle_t* handle;
+    pfile_t* pf;
+    bool last;
+
+    if (!file)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    handle = file->handle;
+    pf = handle->pfile;
+
+    oe_mutex_lock(&pf->lock);
+    last = --handle->refs == 0;
+    oe_mutex_unlock(&pf->lock);
+
+    oe_free(file);
+    ret = 0;
+
+    if (last)
+    {
+        oe_free(handle);
+
+        /* Report a failed write-back, as it loses data. */
+        if (_put_pfile(pf) != 0)
+            OE_RAISE_ERRNO(oe_errno);
+    }
+
+done:
+    return ret;
+}
+
+static int _sgxfs_ioctl(oe_fd_t* desc, unsigned long request, uint64_t arg)
+{
+    int ret = -1;
+    file_t* file = _cast_file(desc);
+
+    OE_UNUSED(request);
+    OE_UNUSED(arg);
+
+    if (!file)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* Protected files are not terminal devices (see _hostfs_ioctl()). */
+    OE_RAISE_ERRNO(OE_ENOTTY);
+
+done:
+    return ret;
+}
+
+static int _sgxfs_fcntl(oe_fd_t* desc, int cmd, uint64_t arg)
+{
+    int ret = -1;
+    file_t* file = _cast_file(desc);
+    const int settable = OE_O_APPEND | OE_O_NONBLOCK;
+    handle_t* handle;
+
+    if (!file)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    handle = file->handle;
+
+    switch (cmd)
+    {
+        /* There is no exec() in an enclave, so FD_CLOEXEC has no effect. */
+        case OE_F_GETFD:
+        case OE_F_SETFD:
+            ret = 0;
+            break;
+
+        case OE_F_GETFL:
+            ret = handle->flags;
+            break;
+
+        case OE_F_SETFL:
+            oe_mutex_lock(&handle->pfile->lock);
+            handle->flags = (handle->flags & ~settable) | ((int)arg & settable);
+            oe_mutex_unlock(&handle->pfile->lock);
+            ret = 0;
+            break;
+
+        default:
+            OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+done:
+    return ret;
+}
+
+/* The host file holds ciphertext, so host-side copies must not use it. */
+static oe_host_fd_t _sgxfs_get_host_fd(oe_fd_t* desc)
+{
+    OE_UNUSED(desc);
+    return -1;
+}
+
+/*
+**==============================================================================
+**
+** Path operations. Except for stat() and truncate(), which need the file
+** size, these are those of hostfs.
+**
+**==============================================================================
+*/
+
+static oe_device_t* _get_hostfs_for(oe_device_t* device, bool write)
+{
+    oe_device_t* ret = NULL;
+    device_t* fs = _cast_device(device);
+
+    if (!fs)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (write && _is_read_only(fs))
+        OE_RAISE_ERRNO(OE_EPERM);
+
+    if (!(ret = _get_hostfs(fs)))
+        OE_RAISE_ERRNO(OE_ENODEV);
+
+done:
+    return ret;
+}
+
+static int _sgxfs_stat(
+    oe_device_t* device,
+    const char* pathname,
+    struct oe_stat* buf)
+{
+    int ret = -1;
+    oe_device_t* hostfs;
+    pfile_t* pf = NULL;
+
+    if (!(hostfs = _get_hostfs_for(device, false)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (hostfs->ops.fs.stat(hostfs, pathname, buf) != 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    /* Report the size of the contents rather than of the host file. */
+    if (OE_S_ISREG(buf->st_mode))
+    {
+        if (!(pf = _open_pfile(_cast_device(device), pathname, OE_O_RDONLY, 0)))
+            OE_RAISE_ERRNO(oe_errno);
+
+        oe_mutex_lock(&pf->lock);
+        buf->st_size = pf->size;
+        oe_mutex_unlock(&pf->lock);
+    }
+
+    ret = 0;
+
+done:
+
+    if (pf)
+        _put_pfile(pf);
+
+    return ret;
+}
+
+static int _sgxfs_truncate(
+    oe_device_t* device,
+    const char* path,
+    oe_off_t length)
+{
+    int ret = -1;
+    pfile_t* pf = NULL;
+    int retval;
+
+    if (!path || length < 0)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!_get_hostfs_for(device, true))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (!(pf = _open_pfile(_cast_device(device), path, OE_O_WRONLY, 0)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    oe_mutex_lock(&pf->lock);
+    retval = _truncate_data(pf, length);
+    oe_mutex_unlock(&pf->lock);
+
+    if (retval != 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    ret = 0;
+
+done:
+
+    if (pf && _put_pfile(pf) != 0)
+        ret = -1;
+
+    return ret;
+}
+
+static int _sgxfs_access(oe_device_t* device, const char* pathname, int mode)
+{
+    int ret = -1;
+    oe_device_t* hostfs;
+
+    if (!(hostfs = _get_hostfs_for(device, false)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    ret = hostfs->ops.fs.access(hostfs, pathname, mode);
+
+done:
+    return ret;
+}
+
+static int _sgxfs_link(
+    oe_device_t* device,
+    const char* oldpath,
+    const char* newpath)
+{
+    int ret = -1;
+    oe_device_t* hostfs;
+
+    if (!(hostfs = _get_hostfs_for(device, true)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    ret = hostfs->ops.fs.link(hostfs, oldpath, newpath);
+
+done:
+    return ret;
+}
+
+static int _sgxfs_unlink(oe_device_t* device, const char* pathname)
+{
+    int ret = -1;
+    oe_device_t* hostfs;
+
+    if (!(hostfs = _get_hostfs_for(device, true)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    ret = hostfs->ops.fs.unlink(hostfs, pathname);
+
+done:
+    return ret;
+}
+
+static int _sgxfs_rename(
+    oe_device_t* device,
+    const char* oldpath,
+    const char* newpath)
+{
+    int ret = -1;
+    oe_device_t* hostfs;
+
+    if (!(hostfs = _get_hostfs_for(device, true)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    ret = hostfs->ops.fs.rename(hostfs, oldpath, newpath);
+
+done:
+    return ret;
+}
+
+static int _sgxfs_mkdir(
+    oe_device_t* device,
+    const char* pathname,
+    oe_mode_t mode)
+{
+    int ret = -1;
+    oe_device_t* hostfs;
+
+    if (!(hostfs = _get_hostfs_for(device, true)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    ret = hostfs->ops.fs.mkdir(hostfs, pathname, mode);
+
+done:
+    return ret;
+}
+
+static int _sgxfs_rmdir(oe_device_t* device, const char* pathname)
+{
+    int ret = -1;
+    oe_device_t* hostfs;
+
+    if (!(hostfs = _get_hostfs_for(device, true)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    ret = hostfs->ops.fs.rmdir(hostfs, pathname);
+
+done:
+    return ret;
+}
+
+// clang-format off
+static oe_file_ops_t _file_ops =
+{
+    .fd.read = _sgxfs_read,
+    .fd.write = _sgxfs_write,
+    .fd.readv = _sgxfs_readv,
+    .fd.writev = _sgxfs_writev,
+    .fd.dup = _sgxfs_dup,
+    .fd.ioctl = _sgxfs_ioctl,
+    .fd.fcntl = _sgxfs_fcntl,
+    .fd.close = _sgxfs_close,
+    .fd.get_host_fd = _sgxfs_get_host_fd,
+    .lseek = _sgxfs_lseek,
+    .pread = _sgxfs_pread,
+    .pwrite = _sgxfs_pwrite,
+    .preadv = _sgxfs_preadv,
+    .pwritev = _sgxfs_pwritev,
+    .getdents64 = _sgxfs_getdents64,
+};
+// clang-format on
+
+static oe_file_ops_t _get_file_ops(void)
+{
+    return _file_ops;
+};
+
+// clang-format off
+static device_t _sgxfs =
+{
+    .base.type = OE_DEVICE_TYPE_FILE_SYSTEM,
+    .base.name = OE_DEVICE_NAME_SGX_FILE_SYSTEM,
+    .base.ops.fs =
+    {
+        .base.release = _sgxfs_release,
+        .clone = _sgxfs_clone,
+        .mount = _sgxfs_mount,
+        .umount2 = _sgxfs_umount2,
+        .open = _sgxfs_open,
+        .stat = _sgxfs_stat,
+        .access = _sgxfs_access,
+        .link = _sgxfs_link,
+        .unlink = _sgxfs_unlink,
+        .rename = _sgxfs_rename,
+        .truncate = _sgxfs_truncate,
+        .mkdir = _sgxfs_mkdir,
+        .rmdir = _sgxfs_rmdir,
+    },
+    .magic = FS_MAGIC,
+    .policy = OE_SEAL_POLICY_PRODUCT,
+};
+// clang-format on
+
+oe_result_t oe_load_module_sgx_file_system(void)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+    static bool _loaded = false;
+
+    /* The protected files are kept by the host file system. */
+    OE_CHECK(oe_load_module_host_file_system());
+
+    oe_spin_lock(&_lock);
+
+    if (!_loaded)
+    {
+        if (oe_device_table_set(OE_DEVID_SGX_FILE_SYSTEM, &_sgxfs.base) != 0)
+        {
+            /* Do not propagate errno to caller. */
+            oe_errno = 0;
+            oe_spin_unlock(&_lock);
+            OE_RAISE(OE_FAILURE);
+        }
+
+        _loaded = true;
+    }
+
+    oe_spin_unlock(&_lock);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
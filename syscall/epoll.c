@@ -124,12 +124,17 @@ done:
     return ret;
 }
 
-int oe_epoll_wake(void)
+int oe_epoll_wake(int epfd)
 {
     int ret = -1;
     int retval;
+    oe_fd_t* epoll;
+
+    if (!(epoll = oe_fdtable_get(epfd, OE_FD_TYPE_EPOLL)))
+        OE_RAISE_ERRNO(oe_errno);
 
-    if (oe_syscall_epoll_wake_ocall(&retval) != OE_OK)
+    if (oe_syscall_epoll_wake_ocall(
+            &retval, epoll->ops.fd.get_host_fd(epoll)) != OE_OK)
         OE_RAISE_ERRNO(OE_EINVAL);
 
     if (retval != 0)
@@ -0,0 +1,438 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+
+#include <openenclave/corelibc/stdlib.h>
+#include <openenclave/corelibc/string.h>
+#include <openenclave/internal/syscall/fcntl.h>
+#include <openenclave/internal/syscall/fd.h>
+#include <openenclave/internal/syscall/fdtable.h>
+#include <openenclave/internal/syscall/iov.h>
+#include <openenclave/internal/syscall/raise.h>
+#include <openenclave/internal/syscall/sys/eventfd.h>
+#include <openenclave/internal/syscall/sys/poll.h>
+#include <openenclave/internal/syscall/waitqueue.h>
+#include <openenclave/internal/thread.h>
+
+/*
+**==============================================================================
+**
+** eventfd
+**
+**     An eventfd kept in the enclave, for threads of the enclave to notify
+**     each other. Reads and writes never leave the enclave, unless they
+**     block or wake a thread that sleeps in read(), poll() or epoll_wait().
+**
+**==============================================================================
+*/
+
+#define MAGIC 0x6d7e0fd1
+
+/* The largest value of the counter. */
+#define COUNTER_MAX 0xfffffffffffffffeULL
+
+/* Shared by the descriptors that dup() makes. */
+typedef struct _eventfd
+{
+    oe_spinlock_t lock;
+
+    /* One per descriptor, and one per waiter in the queue. */
+    size_t refs;
+    uint64_t counter;
+    int flags;
+    oe_wait_queue_t queue;
+} eventfd_t;
+
+typedef struct _file
+{
+    oe_fd_t base;
+    uint32_t magic;
+    eventfd_t* eventfd;
+} file_t;
+
+static oe_fd_ops_t _get_ops(void);
+
+static file_t* _cast_file(const oe_fd_t* desc)
+{
+    file_t* file = (file_t*)desc;
+
+    if (file == NULL || file->magic != MAGIC)
+        return NULL;
+
+    return file;
+}
+
+static void _eventfd_release(eventfd_t* eventfd)
+{
+    bool last;
+
+    oe_spin_lock(&eventfd->lock);
+    last = --eventfd->refs == 0;
+    oe_spin_unlock(&eventfd->lock);
+
+    if (last)
+        oe_free(eventfd);
+}
+
+static void _eventfd_release_queue(oe_wait_queue_t* queue)
+{
+    _eventfd_release(
+        (eventfd_t*)((uint8_t*)queue - OE_OFFSETOF(eventfd_t, queue)));
+}
+
+static short _eventfd_poll(oe_fd_t* desc, oe_wait_queue_t** queue)
+{
+    eventfd_t* eventfd = _cast_file(desc)->eventfd;
+    short events = 0;
+
+    if (queue)
+        *queue = &eventfd->queue;
+
+    oe_spin_lock(&eventfd->lock);
+
+    /* The waiter holds the eventfd until oe_wait_queue_remove(). */
+    if (queue)
+        eventfd->refs++;
+
+    if (eventfd->counter > 0)
+        events |= OE_POLLIN;
+
+    if (eventfd->counter < COUNTER_MAX)
+        events |= OE_POLLOUT;
+
+    oe_spin_unlock(&eventfd->lock);
+
+    return events;
+}
+
+static ssize_t _eventfd_read(oe_fd_t* desc, void* buf, size_t count)
+{
+    ssize_t ret = -1;
+    file_t* file = _cast_file(desc);
+    eventfd_t* eventfd;
+
+    if (!file || !buf || count < sizeof(oe_eventfd_t))
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    eventfd = file->eventfd;
+
+    for (;;)
+    {
+        oe_eventfd_t value = 0;
+        bool nonblock;
+
+        oe_spin_lock(&eventfd->lock);
+        {
+            if (eventfd->counter > 0)
+            {
+                if (eventfd->flags & OE_EFD_SEMAPHORE)
+                    value = 1;
+                else
+                    value = eventfd->counter;
+
+                eventfd->counter -= value;
+            }
+
+            nonblock = (eventfd->flags & OE_O_NONBLOCK) != 0;
+        }
+        oe_spin_unlock(&eventfd->lock);
+
+        if (value)
+        {
+            memcpy(buf, &value, sizeof(value));
+            oe_wait_queue_wake(&eventfd->queue);
+            ret = sizeof(value);
+            break;
+        }
+
+        if (nonblock)
+            OE_RAISE_ERRNO(OE_EAGAIN);
+
+        if (oe_fd_wait(desc, OE_POLLIN) != 0)
+            OE_RAISE_ERRNO(oe_errno);
+    }
+
+done:
+    return ret;
+}
+
+static ssize_t _eventfd_write(oe_fd_t* desc, const void* buf, size_t count)
+{
+    ssize_t ret = -1;
+    file_t* file = _cast_file(desc);
+    eventfd_t* eventfd;
+    oe_eventfd_t value;
+
+    if (!file || !buf || count < sizeof(oe_eventfd_t))
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    eventfd = file->eventfd;
+    memcpy(&value, buf, sizeof(value));
+
+    if (value > COUNTER_MAX)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    for (;;)
+    {
+        bool written = false;
+        bool nonblock;
+
+        oe_spin_lock(&eventfd->lock);
+        {
+            if (value <= COUNTER_MAX - eventfd->counter)
+            {
+                eventfd->counter += value;
+                written = true;
+            }
+
+            nonblock = (eventfd->flags & OE_O_NONBLOCK) != 0;
+        }
+        oe_spin_unlock(&eventfd->lock);
+
+        if (written)
+        {
+            if (value)
+                oe_wait_queue_wake(&eventfd->queue);
+
+            ret = sizeof(value);
+            break;
+        }
+
+        if (nonblock)
+            OE_RAISE_ERRNO(OE_EAGAIN);
+
+        if (oe_fd_wait(desc, OE_POLLOUT) != 0)
+            OE_RAISE_ERRNO(oe_errno);
+    }
+
+done:
+    return ret;
+}
+
+static ssize_t _eventfd_readv(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt)
+{
+    ssize_t ret = -1;
+    void* buf = NULL;
+    size_t buf_size = 0;
+
+    if (!desc || (iovcnt && !iov) || iovcnt < 0 || iovcnt > OE_IOV_MAX)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (oe_iov_pack(iov, iovcnt, &buf, &buf_size) != 0)
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    if ((ret = _eventfd_read(desc, buf, buf_size)) > 0 &&
+        oe_iov_sync(iov, iovcnt, buf, (size_t)ret) != 0)
+    {
+        OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+done:
+    oe_free(buf);
+    return ret;
+}
+
+static ssize_t _eventfd_writev(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt)
+{
+    ssize_t ret = -1;
+    void* buf = NULL;
+    size_t buf_size = 0;
+
+    if (!desc || (iovcnt && !iov) || iovcnt < 0 || iovcnt > OE_IOV_MAX)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (oe_iov_pack(iov, iovcnt, &buf, &buf_size) != 0)
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    ret = _eventfd_write(desc, buf, buf_size);
+
+done:
+    oe_free(buf);
+    return ret;
+}
+
+static oe_fd_t* _new_file(eventfd_t* eventfd)
+{
+    file_t* file;
+
+    if (!(file = oe_calloc(1, sizeof(file_t))))
+        return NULL;
+
+    file->base.type = OE_FD_TYPE_EVENTFD;
+    file->base.ops.fd = _get_ops();
+    file->magic = MAGIC;
+    file->eventfd = eventfd;
+
+    return &file->base;
+}
+
+static int _eventfd_dup(oe_fd_t* desc, oe_fd_t** new_file_out)
+{
+    int ret = -1;
+    file_t* file = _cast_file(desc);
+
+    if (new_file_out)
+        *new_file_out = NULL;
+
+    if (!file || !new_file_out)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(*new_file_out = _new_file(file->eventfd)))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    oe_spin_lock(&file->eventfd->lock);
+    file->eventfd->refs++;
+    oe_spin_unlock(&file->eventfd->lock);
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+static int _eventfd_ioctl(oe_fd_t* desc, unsigned long request, uint64_t arg)
+{
+    int ret = -1;
+
+    OE_UNUSED(request);
+    OE_UNUSED(arg);
+
+    if (!_cast_file(desc))
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* An eventfd is not a terminal device. */
+    OE_RAISE_ERRNO(OE_ENOTTY);
+
+done:
+    return ret;
+}
+
+static int _eventfd_fcntl(oe_fd_t* desc, int cmd, uint64_t arg)
+{
+    int ret = -1;
+    file_t* file = _cast_file(desc);
+    eventfd_t* eventfd;
+
+    if (!file)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    eventfd = file->eventfd;
+
+    switch (cmd)
+    {
+        /* There is no exec() in an enclave, so FD_CLOEXEC has no effect. */
+        case OE_F_GETFD:
+        case OE_F_SETFD:
+            ret = 0;
+            break;
+
+        case OE_F_GETFL:
+            oe_spin_lock(&eventfd->lock);
+            ret = OE_O_RDWR | (eventfd->flags & OE_O_NONBLOCK);
+            oe_spin_unlock(&eventfd->lock);
+            break;
+
+        case OE_F_SETFL:
+            oe_spin_lock(&eventfd->lock);
+            eventfd->flags &= ~OE_O_NONBLOCK;
+            eventfd->flags |= (int)arg & OE_O_NONBLOCK;
+            oe_spin_unlock(&eventfd->lock);
+            ret = 0;
+            break;
+
+        default:
+            OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+done:
+    return ret;
+}
+
+static int _eventfd_close(oe_fd_t* desc)
+{
+    int ret = -1;
+    file_t* file = _cast_file(desc);
+
+    if (!file)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* Threads waiting in poll() or epoll_wait() keep the eventfd. */
+    _eventfd_release(file->eventfd);
+
+    oe_free(file);
+    ret = 0;
+
+done:
+    return ret;
+}
+
+static oe_host_fd_t _eventfd_get_host_fd(oe_fd_t* desc)
+{
+    OE_UNUSED(desc);
+    return -1;
+}
+
+static oe_fd_ops_t _ops = {
+    .read = _eventfd_read,
+    .write = _eventfd_write,
+    .readv = _eventfd_readv,
+    .writev = _eventfd_writev,
+    .dup = _eventfd_dup,
+    .ioctl = _eventfd_ioctl,
+    .fcntl = _eventfd_fcntl,
+    .close = _eventfd_close,
+    .get_host_fd = _eventfd_get_host_fd,
+    .poll = _eventfd_poll,
+};
+
+static oe_fd_ops_t _get_ops(void)
+{
+    return _ops;
+}
+
+int oe_eventfd(unsigned int initval, int flags)
+{
+    int ret = -1;
+    const int supported = OE_EFD_SEMAPHORE | OE_EFD_NONBLOCK | OE_EFD_CLOEXEC;
+    eventfd_t* eventfd = NULL;
+    oe_fd_t* file = NULL;
+    int fd;
+
+    if (flags & ~supported)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(eventfd = oe_calloc(1, sizeof(eventfd_t))))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    eventfd->refs = 1;
+    eventfd->queue.release = _eventfd_release_queue;
+    eventfd->counter = initval;
+    eventfd->flags = flags & (OE_EFD_SEMAPHORE | OE_EFD_NONBLOCK);
+
+    if (!(file = _new_file(eventfd)))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    eventfd = NULL;
+
+    if ((fd = oe_fdtable_assign(file)) == -1)
+        OE_RAISE_ERRNO(oe_errno);
+
+    file = NULL;
+    ret = fd;
+
+done:
+
+    if (file)
+        file->ops.fd.close(file);
+
+    oe_free(eventfd);
+
+    return ret;
+}
@@ -194,6 +194,12 @@ static void _assert_fd(oe_fd_t* desc)
             oe_assert(desc->ops.epoll.epoll_wait);
             break;
         }
+        case OE_FD_TYPE_EVENTFD:
+        case OE_FD_TYPE_PIPE:
+        {
+            oe_assert(desc->ops.fd.poll);
+            break;
+        }
     }
 }
 #endif /* !defined(NDEBUG) */
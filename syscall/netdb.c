@@ -1,22 +1,574 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <openenclave/bits/module.h>
 #include <openenclave/corelibc/stdlib.h>
+#include <openenclave/corelibc/string.h>
 #include <openenclave/internal/syscall/netdb.h>
 #include <openenclave/internal/syscall/raise.h>
 #include <openenclave/internal/syscall/resolver.h>
 #include <openenclave/internal/syscall/sys/socket.h>
 #include <openenclave/internal/thread.h>
+#include <openenclave/internal/time.h>
 #include <openenclave/internal/trace.h>
 
 static oe_resolver_t* _resolver;
 static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
 static bool _installed_atexit_handler = false;
 
+static void _cache_trim(size_t max_entries);
+
 static void _atexit_handler(void)
 {
     if (_resolver)
         _resolver->ops->release(_resolver);
+
+    _cache_trim(0);
+}
+
+/*
+**==============================================================================
+**
+** Resolver cache
+**
+**     Caches the results of oe_getaddrinfo() in the enclave, for enclaves
+**     that resolve the same names over and over. Successful results are kept
+**     packed, as struct oe_addrinfo_record sequences, and unpacked for every
+**     hit, outside the lock: a hit holds a reference to its entry while it
+**     unpacks it. Failures saying that the name does not exist are cached as
+**     well.
+**     The least recently used entry is evicted when the cache is full.
+**     Entries are found through a hash table of the keys.
+**     Expiry is checked with oe_get_time(), so a hit still makes one OCALL,
+**     but the host does not resolve the name.
+**
+**==============================================================================
+*/
+
+#define OE_RESOLVER_CACHE_BUCKETS 64
+
+typedef struct _cache_entry
+{
+    struct _cache_entry* prev;
+    struct _cache_entry* next;
+
+    /* The next entry in the same bucket. */
+    struct _cache_entry* chain;
+
+    /* The key: the arguments of oe_getaddrinfo(). */
+    uint64_t hash;
+    const char* node;
+    const char* service;
+    bool has_hints;
+    int hints[4];
+
+    /* In milliseconds since the Epoch, like oe_get_time(). */
+    uint64_t expires;
+
+    /* Zero, or the OE_EAI_* error of a negative entry. */
+    int error;
+
+    /* The packed results of a positive entry. */
+    const void* data;
+    size_t size;
+
+    /* One for the cache while the entry is in it, plus one per hit being
+     * unpacked. Guarded by the lock. */
+    size_t refs;
+} cache_entry_t;
+
+/* Most recently used first. */
+static cache_entry_t* _cache_head;
+static cache_entry_t* _cache_tail;
+static cache_entry_t* _cache_buckets[OE_RESOLVER_CACHE_BUCKETS];
+static size_t _cache_size;
+static uint64_t _cache_hits;
+static size_t _cache_max_entries;
+static uint32_t _cache_positive_ttl;
+static uint32_t _cache_negative_ttl;
+static oe_spinlock_t _cache_lock = OE_SPINLOCK_INITIALIZER;
+
+static uint64_t _hash_bytes(uint64_t hash, const void* data, size_t size)
+{
+    const uint8_t* p = (const uint8_t*)data;
+
+    /* FNV-1a */
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+static void _get_key(
+    const char* node,
+    const char* service,
+    const struct oe_addrinfo* hints,
+    int key_hints[4],
+    uint64_t* hash)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    const bool has_hints = hints != NULL;
+
+    memset(key_hints, 0, 4 * sizeof(int));
+
+    if (hints)
+    {
+        key_hints[0] = hints->ai_flags;
+        key_hints[1] = hints->ai_family;
+        key_hints[2] = hints->ai_socktype;
+        key_hints[3] = hints->ai_protocol;
+    }
+
+    /* Include the terminators, so that no two keys run together. */
+    if (node)
+        h = _hash_bytes(h, node, oe_strlen(node) + 1);
+
+    h = _hash_bytes(h, "", 1);
+
+    if (service)
+        h = _hash_bytes(h, service, oe_strlen(service) + 1);
+
+    h = _hash_bytes(h, &has_hints, sizeof(has_hints));
+    *hash = _hash_bytes(h, key_hints, 4 * sizeof(int));
+}
+
+static bool _string_equal(const char* s1, const char* s2)
+{
+    if (!s1 || !s2)
+        return s1 == s2;
+
+    return oe_strcmp(s1, s2) == 0;
+}
+
+static cache_entry_t** _cache_bucket(uint64_t hash)
+{
+    return &_cache_buckets[hash % OE_RESOLVER_CACHE_BUCKETS];
+}
+
+/* Find the entry with the given key. Called with the lock held. */
+static cache_entry_t* _cache_find(
+    uint64_t hash,
+    bool has_hints,
+    const int hints[4],
+    const char* node,
+    const char* service)
+{
+    for (cache_entry_t* p = *_cache_bucket(hash); p; p = p->chain)
+    {
+        if (p->hash == hash && p->has_hints == has_hints &&
+            memcmp(p->hints, hints, 4 * sizeof(int)) == 0 &&
+            _string_equal(p->node, node) &&
+            _string_equal(p->service, service))
+        {
+            return p;
+        }
+    }
+
+    return NULL;
+}
+
+static void _cache_unlink(cache_entry_t* entry)
+{
+    if (entry->prev)
+        entry->prev->next = entry->next;
+    else
+        _cache_head = entry->next;
+
+    if (entry->next)
+        entry->next->prev = entry->prev;
+    else
+        _cache_tail = entry->prev;
+}
+
+static void _cache_push_front(cache_entry_t* entry)
+{
+    entry->prev = NULL;
+
+    if ((entry->next = _cache_head))
+        _cache_head->prev = entry;
+    else
+        _cache_tail = entry;
+
+    _cache_head = entry;
+}
+
+static void _cache_insert(cache_entry_t* entry)
+{
+    cache_entry_t** bucket = _cache_bucket(entry->hash);
+
+    entry->chain = *bucket;
+    *bucket = entry;
+    _cache_push_front(entry);
+    _cache_size++;
+}
+
+/* Drop a reference to an entry, freeing it with the last one. Called with
+ * the lock held. */
+static void _cache_release(cache_entry_t* entry)
+{
+    if (--entry->refs == 0)
+        oe_free(entry);
+}
+
+/* Remove an entry and drop the reference of the cache to it. */
+static void _cache_remove(cache_entry_t* entry)
+{
+    cache_entry_t** p = _cache_bucket(entry->hash);
+
+    while (*p != entry)
+        p = &(*p)->chain;
+
+    *p = entry->chain;
+    _cache_unlink(entry);
+    _cache_size--;
+    _cache_release(entry);
+}
+
+/* Evict the least recently used entries down to max_entries. Called with the
+ * lock held. */
+static void _cache_evict(size_t max_entries)
+{
+    while (_cache_size > max_entries)
+        _cache_remove(_cache_tail);
+}
+
+static void _cache_trim(size_t max_entries)
+{
+    oe_spin_lock(&_cache_lock);
+    _cache_evict(max_entries);
+    oe_spin_unlock(&_cache_lock);
+}
+
+/* Look up a cached result. Returns true on a hit, with the result of
+ * oe_getaddrinfo() in ret and res. */
+static bool _cache_get(
+    const char* node,
+    const char* service,
+    const struct oe_addrinfo* hints,
+    uint64_t now,
+    int* ret,
+    struct oe_addrinfo** res)
+{
+    bool hit = false;
+    int key_hints[4];
+    uint64_t hash;
+    cache_entry_t* p;
+    cache_entry_t* held = NULL;
+
+    _get_key(node, service, hints, key_hints, &hash);
+
+    oe_spin_lock(&_cache_lock);
+
+    if (!(p = _cache_find(hash, hints != NULL, key_hints, node, service)))
+        goto done;
+
+    if (now >= p->expires)
+    {
+        _cache_remove(p);
+        goto done;
+    }
+
+    /* Make it the most recently used. */
+    _cache_unlink(p);
+    _cache_push_front(p);
+
+    _cache_hits++;
+    hit = true;
+
+    if (p->error)
+    {
+        *ret = p->error;
+        goto done;
+    }
+
+    /* Keep the entry while its results are unpacked without the lock. */
+    p->refs++;
+    held = p;
+
+done:
+    oe_spin_unlock(&_cache_lock);
+
+    if (held)
+    {
+        *ret = oe_unpack_addrinfo(held->data, held->size, res);
+
+        oe_spin_lock(&_cache_lock);
+        _cache_release(held);
+        oe_spin_unlock(&_cache_lock);
+    }
+
+    return hit;
+}
+
+/* Pack an addrinfo list as the host does. */
+static void* _pack_addrinfo(const struct oe_addrinfo* res, size_t* size_out)
+{
+    const size_t align = OE_ADDRINFO_RECORD_ALIGN;
+    uint8_t* buf;
+    size_t size = 0;
+
+    for (const struct oe_addrinfo* p = res; p; p = p->ai_next)
+    {
+        size += sizeof(struct oe_addrinfo_record) + p->ai_addrlen;
+
+        if (p->ai_canonname)
+            size += oe_strlen(p->ai_canonname) + 1;
+
+        size = (size + align - 1) & ~(align - 1);
+    }
+
+    if (!(buf = oe_calloc(1, size)))
+        return NULL;
+
+    *size_out = size;
+
+    for (const struct oe_addrinfo* p = res; p; p = p->ai_next)
+    {
+        struct oe_addrinfo_record record;
+        size_t n = sizeof(record);
+
+        record.ai_flags = p->ai_flags;
+        record.ai_family = p->ai_family;
+        record.ai_socktype = p->ai_socktype;
+        record.ai_protocol = p->ai_protocol;
+        record.ai_addrlen = p->ai_addrlen;
+        record.ai_canonnamelen = 0;
+
+        memcpy(buf + n, p->ai_addr, p->ai_addrlen);
+        n += p->ai_addrlen;
+
+        if (p->ai_canonname)
+        {
+            record.ai_canonnamelen = (uint32_t)oe_strlen(p->ai_canonname) + 1;
+            memcpy(buf + n, p->ai_canonname, record.ai_canonnamelen);
+            n += record.ai_canonnamelen;
+        }
+
+        memcpy(buf, &record, sizeof(record));
+        buf += (n + align - 1) & ~(align - 1);
+    }
+
+    return buf - size;
+}
+
+/* Cache the result of oe_getaddrinfo(). */
+static void _cache_put(
+    const char* node,
+    const char* service,
+    const struct oe_addrinfo* hints,
+    uint64_t now,
+    int error,
+    const struct oe_addrinfo* res)
+{
+    cache_entry_t* entry = NULL;
+    void* data = NULL;
+    size_t data_size = 0;
+    size_t node_size = node ? oe_strlen(node) + 1 : 0;
+    size_t service_size = service ? oe_strlen(service) + 1 : 0;
+    uint32_t ttl;
+    uint8_t* p;
+
+    oe_spin_lock(&_cache_lock);
+    ttl = error ? _cache_negative_ttl : _cache_positive_ttl;
+    oe_spin_unlock(&_cache_lock);
+
+    if (ttl == 0)
+        goto done;
+
+    if (!error && !(data = _pack_addrinfo(res, &data_size)))
+        goto done;
+
+    /* The key and the results are kept with the entry. */
+    if (!(entry = oe_calloc(
+              1, sizeof(cache_entry_t) + node_size + service_size + data_size)))
+    {
+        goto done;
+    }
+
+    _get_key(node, service, hints, entry->hints, &entry->hash);
+    entry->has_hints = hints != NULL;
+    entry->expires = now + ttl;
+    entry->error = error;
+    entry->size = data_size;
+    entry->refs = 1;
+
+    p = (uint8_t*)(entry + 1);
+
+    if (data_size)
+    {
+        entry->data = memcpy(p, data, data_size);
+        p += data_size;
+    }
+
+    if (node)
+    {
+        entry->node = memcpy(p, node, node_size);
+        p += node_size;
+    }
+
+    if (service)
+        entry->service = memcpy(p, service, service_size);
+
+    oe_spin_lock(&_cache_lock);
+    {
+        /* A thread that missed at the same time may have added it. */
+        cache_entry_t* q = _cache_find(
+            entry->hash, entry->has_hints, entry->hints, node, service);
+
+        if (q)
+            _cache_remove(q);
+
+        if (_cache_max_entries)
+        {
+            _cache_insert(entry);
+            _cache_evict(_cache_max_entries);
+            entry = NULL;
+        }
+    }
+    oe_spin_unlock(&_cache_lock);
+
+done:
+
+    if (data)
+        oe_free(data);
+
+    if (entry)
+        oe_free(entry);
+}
+
+oe_result_t oe_set_resolver_cache(
+    size_t max_entries,
+    uint32_t positive_ttl,
+    uint32_t negative_ttl)
+{
+    oe_spin_lock(&_cache_lock);
+    _cache_max_entries = max_entries;
+    _cache_positive_ttl = positive_ttl;
+    _cache_negative_ttl = negative_ttl;
+    _cache_evict(max_entries);
+    oe_spin_unlock(&_cache_lock);
+
+    return OE_OK;
+}
+
+uint64_t oe_get_resolver_cache_hits(void)
+{
+    uint64_t hits;
+
+    oe_spin_lock(&_cache_lock);
+    hits = _cache_hits;
+    oe_spin_unlock(&_cache_lock);
+
+    return hits;
+}
+
+int oe_unpack_addrinfo(const void* buf, size_t size, struct oe_addrinfo** res)
+{
+    int ret = OE_EAI_FAIL;
+    const uint8_t* p = (const uint8_t*)buf;
+    const uint8_t* end = p + size;
+    struct oe_addrinfo* head = NULL;
+    struct oe_addrinfo* tail = NULL;
+
+    if (res)
+        *res = NULL;
+
+    if (!res || !buf)
+    {
+        ret = OE_EAI_SYSTEM;
+        OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+    while (p != end)
+    {
+        struct oe_addrinfo_record record;
+        struct oe_addrinfo* ai;
+        size_t record_size;
+
+        if ((size_t)(end - p) < sizeof(record))
+        {
+            ret = OE_EAI_SYSTEM;
+            OE_RAISE_ERRNO(OE_EINVAL);
+        }
+
+        memcpy(&record, p, sizeof(record));
+
+        /* Both lengths are 32 bits, so the sum cannot overflow. */
+        record_size = sizeof(record) + (size_t)record.ai_addrlen +
+                      (size_t)record.ai_canonnamelen;
+        record_size = (record_size + OE_ADDRINFO_RECORD_ALIGN - 1) &
+                      ~((size_t)OE_ADDRINFO_RECORD_ALIGN - 1);
+
+        if (record.ai_addrlen > sizeof(struct oe_sockaddr_storage) ||
+            record_size > (size_t)(end - p) ||
+            (record.ai_canonnamelen &&
+             p[sizeof(record) + record.ai_addrlen + record.ai_canonnamelen -
+               1] != '\0'))
+        {
+            ret = OE_EAI_SYSTEM;
+            OE_RAISE_ERRNO(OE_EINVAL);
+        }
+
+        /* The address and canonical name are allocated with the entry. */
+        if (!(ai = oe_calloc(
+                  1,
+                  sizeof(struct oe_addrinfo) + record.ai_addrlen +
+                      record.ai_canonnamelen)))
+        {
+            ret = OE_EAI_MEMORY;
+            goto done;
+        }
+
+        ai->ai_flags = record.ai_flags;
+        ai->ai_family = record.ai_family;
+        ai->ai_socktype = record.ai_socktype;
+        ai->ai_protocol = record.ai_protocol;
+        ai->ai_addrlen = record.ai_addrlen;
+
+        if (record.ai_addrlen)
+        {
+            ai->ai_addr = (struct oe_sockaddr*)(ai + 1);
+            memcpy(ai->ai_addr, p + sizeof(record), record.ai_addrlen);
+        }
+
+        if (record.ai_canonnamelen)
+        {
+            ai->ai_canonname = (char*)(ai + 1) + record.ai_addrlen;
+            memcpy(
+                ai->ai_canonname,
+                p + sizeof(record) + record.ai_addrlen,
+                record.ai_canonnamelen);
+        }
+
+        if (tail)
+            tail->ai_next = ai;
+        else
+            head = ai;
+
+        tail = ai;
+        p += record_size;
+    }
+
+    /* If the list is empty. */
+    if (!head)
+    {
+        ret = OE_EAI_SYSTEM;
+        OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+    *res = head;
+    head = NULL;
+    ret = 0;
+
+done:
+
+    if (head)
+        oe_freeaddrinfo(head);
+
+    return ret;
 }
 
 /* Called by the public oe_load_module_host_resolver() function. */
@@ -64,12 +616,30 @@ int oe_getaddrinfo(
     struct oe_addrinfo** res_out)
 {
     int ret = OE_EAI_FAIL;
-    struct oe_addrinfo* res;
+    struct oe_addrinfo* res = NULL;
     bool locked = false;
+    uint64_t now = 0;
 
     if (res_out)
         *res_out = NULL;
 
+    if (!res_out)
+    {
+        ret = OE_EAI_SYSTEM;
+        OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+    if (__atomic_load_n(&_cache_max_entries, __ATOMIC_RELAXED))
+    {
+        now = oe_get_time();
+
+        if (now != (uint64_t)-1 &&
+            _cache_get(node, service, hints, now, &ret, res_out))
+        {
+            goto done;
+        }
+    }
+
     oe_spin_lock(&_lock);
     locked = true;
 
@@ -81,6 +651,16 @@ int oe_getaddrinfo(
 
     ret = (_resolver->ops->getaddrinfo)(_resolver, node, service, hints, &res);
 
+    oe_spin_unlock(&_lock);
+    locked = false;
+
+    /* Only cache failures that say the name does not exist. */
+    if (now && now != (uint64_t)-1 &&
+        (ret == 0 || ret == OE_EAI_NONAME || ret == OE_EAI_NODATA))
+    {
+        _cache_put(node, service, hints, now, ret, res);
+    }
+
     if (ret == 0)
         *res_out = res;
 
@@ -131,9 +711,15 @@ void oe_freeaddrinfo(struct oe_addrinfo* res)
     for (p = res; p;)
     {
         struct oe_addrinfo* next = p->ai_next;
+        const char* inline_data = (const char*)(p + 1);
+
+        /* oe_unpack_addrinfo() allocates both with the entry. */
+        if ((const char*)p->ai_addr != inline_data)
+            oe_free(p->ai_addr);
+
+        if (p->ai_canonname != inline_data + p->ai_addrlen)
+            oe_free(p->ai_canonname);
 
-        oe_free(p->ai_addr);
-        oe_free(p->ai_canonname);
         oe_free(p);
 
         p = next;
@@ -0,0 +1,583 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+
+#include <openenclave/corelibc/stdlib.h>
+#include <openenclave/corelibc/string.h>
+#include <openenclave/internal/syscall/fcntl.h>
+#include <openenclave/internal/syscall/fd.h>
+#include <openenclave/internal/syscall/fdtable.h>
+#include <openenclave/internal/syscall/iov.h>
+#include <openenclave/internal/syscall/raise.h>
+#include <openenclave/internal/syscall/sys/poll.h>
+#include <openenclave/internal/syscall/unistd.h>
+#include <openenclave/internal/syscall/waitqueue.h>
+#include <openenclave/internal/thread.h>
+
+/*
+**==============================================================================
+**
+** pipe
+**
+**     A pipe kept in the enclave, for threads of the enclave to pass data to
+**     each other. Reads and writes never leave the enclave, unless they
+**     block or wake a thread that sleeps in read(), write(), poll() or
+**     epoll_wait(). Writes of up to PIPE_BUF bytes are atomic. Writing to a
+**     pipe that has no read end fails with EPIPE; there is no SIGPIPE.
+**
+**==============================================================================
+*/
+
+#define MAGIC 0x2f61c0d9
+
+/* The number of bytes a pipe holds. */
+#define PIPE_CAPACITY (64 * 1024)
+
+/* Writes of up to this many bytes are not interleaved with others. */
+#define PIPE_BUF 4096
+
+/* Shared by the two ends. */
+typedef struct _pipe
+{
+    oe_spinlock_t lock;
+
+    /* The number of descriptors of each end. */
+    size_t readers;
+    size_t writers;
+
+    /* One per descriptor, and one per waiter in the queue. */
+    size_t refs;
+
+    /* The O_NONBLOCK flag of each end. */
+    int flags[2];
+
+    /* A ring buffer, allocated by the first write. */
+    uint8_t* buf;
+    size_t start;
+    size_t size;
+
+    oe_wait_queue_t queue;
+} pipe_t;
+
+typedef struct _file
+{
+    oe_fd_t base;
+    uint32_t magic;
+    pipe_t* pipe;
+    bool write_end;
+} file_t;
+
+static oe_fd_ops_t _get_ops(void);
+
+static file_t* _cast_file(const oe_fd_t* desc)
+{
+    file_t* file = (file_t*)desc;
+
+    if (file == NULL || file->magic != MAGIC)
+        return NULL;
+
+    return file;
+}
+
+static void _pipe_release(pipe_t* pipe)
+{
+    bool last;
+
+    oe_spin_lock(&pipe->lock);
+    last = --pipe->refs == 0;
+    oe_spin_unlock(&pipe->lock);
+
+    if (last)
+    {
+        oe_free(pipe->buf);
+        oe_free(pipe);
+    }
+}
+
+static void _pipe_release_queue(oe_wait_queue_t* queue)
+{
+    _pipe_release((pipe_t*)((uint8_t*)queue - OE_OFFSETOF(pipe_t, queue)));
+}
+
+static short _pipe_poll(oe_fd_t* desc, oe_wait_queue_t** queue)
+{
+    file_t* file = _cast_file(desc);
+    pipe_t* pipe = file->pipe;
+    short events = 0;
+
+    if (queue)
+        *queue = &pipe->queue;
+
+    oe_spin_lock(&pipe->lock);
+
+    /* The waiter holds the pipe until oe_wait_queue_remove(). */
+    if (queue)
+        pipe->refs++;
+
+    if (!file->write_end)
+    {
+        if (pipe->size > 0)
+            events |= OE_POLLIN;
+
+        if (pipe->writers == 0)
+            events |= OE_POLLHUP;
+    }
+    else
+    {
+        if (PIPE_CAPACITY - pipe->size >= PIPE_BUF)
+            events |= OE_POLLOUT;
+
+        if (pipe->readers == 0)
+            events |= OE_POLLERR;
+    }
+
+    oe_spin_unlock(&pipe->lock);
+
+    return events;
+}
+
+static ssize_t _pipe_read(oe_fd_t* desc, void* buf, size_t count)
+{
+    ssize_t ret = -1;
+    file_t* file = _cast_file(desc);
+    pipe_t* pipe;
+
+    if (!file || (count && !buf))
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (file->write_end)
+        OE_RAISE_ERRNO(OE_EBADF);
+
+    pipe = file->pipe;
+
+    if (count == 0)
+    {
+        ret = 0;
+        goto done;
+    }
+
+    for (;;)
+    {
+        size_t n = 0;
+        bool eof;
+        bool nonblock;
+
+        oe_spin_lock(&pipe->lock);
+        {
+            while (n < count && pipe->size > 0)
+            {
+                size_t chunk = PIPE_CAPACITY - pipe->start;
+
+                if (chunk > pipe->size)
+                    chunk = pipe->size;
+
+                if (chunk > count - n)
+                    chunk = count - n;
+
+                memcpy((uint8_t*)buf + n, pipe->buf + pipe->start, chunk);
+                pipe->start = (pipe->start + chunk) % PIPE_CAPACITY;
+                pipe->size -= chunk;
+                n += chunk;
+            }
+
+            eof = pipe->writers == 0;
+            nonblock = (pipe->flags[0] & OE_O_NONBLOCK) != 0;
+        }
+        oe_spin_unlock(&pipe->lock);
+
+        if (n || eof)
+        {
+            if (n)
+                oe_wait_queue_wake(&pipe->queue);
+
+            ret = (ssize_t)n;
+            break;
+        }
+
+        if (nonblock)
+            OE_RAISE_ERRNO(OE_EAGAIN);
+
+        if (oe_fd_wait(desc, OE_POLLIN | OE_POLLHUP) != 0)
+            OE_RAISE_ERRNO(oe_errno);
+    }
+
+done:
+    return ret;
+}
+
+static ssize_t _pipe_write(oe_fd_t* desc, const void* buf, size_t count)
+{
+    ssize_t ret = -1;
+    file_t* file = _cast_file(desc);
+    pipe_t* pipe;
+    size_t n = 0;
+
+    if (!file || (count && !buf) || count > OE_SSIZE_MAX)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!file->write_end)
+        OE_RAISE_ERRNO(OE_EBADF);
+
+    pipe = file->pipe;
+
+    for (;;)
+    {
+        size_t written = 0;
+        bool broken;
+        bool nonblock;
+        int err = 0;
+
+        oe_spin_lock(&pipe->lock);
+        {
+            const size_t space = PIPE_CAPACITY - pipe->size;
+
+            broken = pipe->readers == 0;
+            nonblock = (pipe->flags[1] & OE_O_NONBLOCK) != 0;
+
+            if (!pipe->buf && !broken && count > 0 &&
+                !(pipe->buf = oe_malloc(PIPE_CAPACITY)))
+            {
+                err = OE_ENOMEM;
+            }
+
+            /* A small write goes in whole or waits. */
+            if (!broken && !err && (count > PIPE_BUF || count <= space))
+            {
+                while (n < count && pipe->size < PIPE_CAPACITY)
+                {
+                    const size_t end =
+                        (pipe->start + pipe->size) % PIPE_CAPACITY;
+                    size_t chunk = PIPE_CAPACITY - pipe->size;
+
+                    if (chunk > PIPE_CAPACITY - end)
+                        chunk = PIPE_CAPACITY - end;
+
+                    if (chunk > count - n)
+                        chunk = count - n;
+
+                    memcpy(pipe->buf + end, (const uint8_t*)buf + n, chunk);
+                    pipe->size += chunk;
+                    n += chunk;
+                    written += chunk;
+                }
+            }
+        }
+        oe_spin_unlock(&pipe->lock);
+
+        if (written)
+            oe_wait_queue_wake(&pipe->queue);
+
+        if (n == count)
+            break;
+
+        /* Report what was written before the failure, if anything. */
+        if (broken || err || nonblock)
+        {
+            if (n)
+                break;
+
+            if (broken)
+                OE_RAISE_ERRNO(OE_EPIPE);
+
+            OE_RAISE_ERRNO(err ? err : OE_EAGAIN);
+        }
+
+        if (oe_fd_wait(desc, OE_POLLOUT | OE_POLLERR) != 0)
+        {
+            if (n)
+                break;
+
+            OE_RAISE_ERRNO(oe_errno);
+        }
+    }
+
+    ret = (ssize_t)n;
+
+done:
+    return ret;
+}
+
+static ssize_t _pipe_readv(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt)
+{
+    ssize_t ret = -1;
+    void* buf = NULL;
+    size_t buf_size = 0;
+
+    if (!desc || (iovcnt && !iov) || iovcnt < 0 || iovcnt > OE_IOV_MAX)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (oe_iov_pack(iov, iovcnt, &buf, &buf_size) != 0)
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    if ((ret = _pipe_read(desc, buf, buf_size)) > 0 &&
+        oe_iov_sync(iov, iovcnt, buf, (size_t)ret) != 0)
+    {
+        OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+done:
+    oe_free(buf);
+    return ret;
+}
+
+static ssize_t _pipe_writev(
+    oe_fd_t* desc,
+    const struct oe_iovec* iov,
+    int iovcnt)
+{
+    ssize_t ret = -1;
+    void* buf = NULL;
+    size_t buf_size = 0;
+
+    if (!desc || (iovcnt && !iov) || iovcnt < 0 || iovcnt > OE_IOV_MAX)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (oe_iov_pack(iov, iovcnt, &buf, &buf_size) != 0)
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    ret = _pipe_write(desc, buf, buf_size);
+
+done:
+    oe_free(buf);
+    return ret;
+}
+
+static oe_fd_t* _new_file(pipe_t* pipe, bool write_end)
+{
+    file_t* file;
+
+    if (!(file = oe_calloc(1, sizeof(file_t))))
+        return NULL;
+
+    file->base.type = OE_FD_TYPE_PIPE;
+    file->base.ops.fd = _get_ops();
+    file->magic = MAGIC;
+    file->pipe = pipe;
+    file->write_end = write_end;
+
+    return &file->base;
+}
+
+static int _pipe_dup(oe_fd_t* desc, oe_fd_t** new_file_out)
+{
+    int ret = -1;
+    file_t* file = _cast_file(desc);
+
+    if (new_file_out)
+        *new_file_out = NULL;
+
+    if (!file || !new_file_out)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(*new_file_out = _new_file(file->pipe, file->write_end)))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    oe_spin_lock(&file->pipe->lock);
+
+    if (file->write_end)
+        file->pipe->writers++;
+    else
+        file->pipe->readers++;
+
+    file->pipe->refs++;
+
+    oe_spin_unlock(&file->pipe->lock);
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+static int _pipe_ioctl(oe_fd_t* desc, unsigned long request, uint64_t arg)
+{
+    int ret = -1;
+
+    OE_UNUSED(request);
+    OE_UNUSED(arg);
+
+    if (!_cast_file(desc))
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    /* A pipe is not a terminal device. */
+    OE_RAISE_ERRNO(OE_ENOTTY);
+
+done:
+    return ret;
+}
+
+static int _pipe_fcntl(oe_fd_t* desc, int cmd, uint64_t arg)
+{
+    int ret = -1;
+    file_t* file = _cast_file(desc);
+    pipe_t* pipe;
+    int* flags;
+
+    if (!file)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    pipe = file->pipe;
+    flags = &pipe->flags[file->write_end];
+
+    switch (cmd)
+    {
+        /* There is no exec() in an enclave, so FD_CLOEXEC has no effect. */
+        case OE_F_GETFD:
+        case OE_F_SETFD:
+            ret = 0;
+            break;
+
+        case OE_F_GETFL:
+            oe_spin_lock(&pipe->lock);
+            ret = (file->write_end ? OE_O_WRONLY : OE_O_RDONLY) | *flags;
+            oe_spin_unlock(&pipe->lock);
+            break;
+
+        case OE_F_SETFL:
+            oe_spin_lock(&pipe->lock);
+            *flags = (int)arg & OE_O_NONBLOCK;
+            oe_spin_unlock(&pipe->lock);
+            ret = 0;
+            break;
+
+        default:
+            OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+done:
+    return ret;
+}
+
+static int _pipe_close(oe_fd_t* desc)
+{
+    int ret = -1;
+    file_t* file = _cast_file(desc);
+    pipe_t* pipe;
+
+    if (!file)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    pipe = file->pipe;
+
+    oe_spin_lock(&pipe->lock);
+    {
+        if (file->write_end)
+            pipe->writers--;
+        else
+            pipe->readers--;
+    }
+    oe_spin_unlock(&pipe->lock);
+
+    /* The other end sees the hangup. The reference of this descriptor
+     * keeps the pipe until then, and threads waiting in poll() or
+     * epoll_wait() keep it after. */
+    oe_wait_queue_wake(&pipe->queue);
+    _pipe_release(pipe);
+
+    oe_free(file);
+    ret = 0;
+
+done:
+    return ret;
+}
+
+static oe_host_fd_t _pipe_get_host_fd(oe_fd_t* desc)
+{
+    OE_UNUSED(desc);
+    return -1;
+}
+
+static oe_fd_ops_t _ops = {
+    .read = _pipe_read,
+    .write = _pipe_write,
+    .readv = _pipe_readv,
+    .writev = _pipe_writev,
+    .dup = _pipe_dup,
+    .ioctl = _pipe_ioctl,
+    .fcntl = _pipe_fcntl,
+    .close = _pipe_close,
+    .get_host_fd = _pipe_get_host_fd,
+    .poll = _pipe_poll,
+};
+
+static oe_fd_ops_t _get_ops(void)
+{
+    return _ops;
+}
+
+int oe_pipe2(int pipefd[2], int flags)
+{
+    int ret = -1;
+    pipe_t* pipe = NULL;
+    oe_fd_t* files[2] = {NULL, NULL};
+    int fds[2] = {-1, -1};
+
+    if (!pipefd || (flags & ~(OE_O_NONBLOCK | OE_O_CLOEXEC)))
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if (!(pipe = oe_calloc(1, sizeof(pipe_t))))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    pipe->readers = 1;
+    pipe->writers = 1;
+    pipe->refs = 2;
+    pipe->queue.release = _pipe_release_queue;
+    pipe->flags[0] = flags & OE_O_NONBLOCK;
+    pipe->flags[1] = flags & OE_O_NONBLOCK;
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (!(files[i] = _new_file(pipe, i == 1)))
+            OE_RAISE_ERRNO(OE_ENOMEM);
+    }
+
+    /* The ends free the pipe from now on. */
+    pipe = NULL;
+
+    for (int i = 0; i < 2; i++)
+    {
+        if ((fds[i] = oe_fdtable_assign(files[i])) == -1)
+            OE_RAISE_ERRNO(oe_errno);
+    }
+
+    pipefd[0] = fds[0];
+    pipefd[1] = fds[1];
+    files[0] = files[1] = NULL;
+    ret = 0;
+
+done:
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (files[i])
+        {
+            if (fds[i] != -1)
+                oe_fdtable_release(fds[i]);
+
+            files[i]->ops.fd.close(files[i]);
+        }
+        else if (pipe)
+        {
+            /* The end was not created, so it holds no reference. */
+            if (i == 0)
+                pipe->readers--;
+            else
+                pipe->writers--;
+
+            pipe->refs--;
+        }
+    }
+
+    oe_free(pipe);
+
+    return ret;
+}
+
+int oe_pipe(int pipefd[2])
+{
+    return oe_pipe2(pipefd, 0);
+}
@@ -6,22 +6,70 @@
 #include <openenclave/internal/syscall/fdtable.h>
 #include <openenclave/internal/syscall/raise.h>
 #include <openenclave/internal/syscall/sys/poll.h>
+#include <openenclave/internal/syscall/waitqueue.h>
+#include <openenclave/internal/time.h>
 #include "syscall_t.h"
 
+/* Set the revents of the enclave-internal fds and return how many are
+ * ready. The descriptors are looked up again, since another thread may have
+ * closed them while this one slept. */
+static int _poll_enclave_fds(
+    struct oe_pollfd* fds,
+    oe_fd_t** descs,
+    oe_nfds_t nfds)
+{
+    int n = 0;
+
+    for (oe_nfds_t i = 0; i < nfds; i++)
+    {
+        if (descs[i])
+        {
+            const short mask = fds[i].events | OE_POLLERR | OE_POLLHUP;
+            oe_fd_t* desc = oe_fdtable_get(fds[i].fd, OE_FD_TYPE_ANY);
+
+            if (!desc || desc->ops.fd.get_host_fd(desc) != -1 ||
+                !desc->ops.fd.poll)
+            {
+                fds[i].revents = OE_POLLNVAL;
+                n++;
+                continue;
+            }
+
+            descs[i] = desc;
+            fds[i].revents = desc->ops.fd.poll(desc, NULL) & mask;
+
+            if (fds[i].revents)
+                n++;
+        }
+    }
+
+    return n;
+}
+
 int oe_poll(struct oe_pollfd* fds, oe_nfds_t nfds, int timeout)
 {
     int ret = -1;
     int retval = -1;
     struct oe_host_pollfd* host_fds = NULL;
+    oe_nfds_t num_host_fds = 0;
+    oe_fd_t** descs = NULL;
+    oe_wait_link_t* links = NULL;
+    bool have_enclave_fds = false;
+    uint64_t deadline = 0;
     oe_nfds_t i;
 
     if (!fds || nfds == 0)
         OE_RAISE_ERRNO(OE_EINVAL);
 
-    if (!(host_fds = oe_calloc(nfds, sizeof(struct oe_host_pollfd))))
+    /* One more for the wake instance of a waiter. */
+    if (!(host_fds = oe_calloc(nfds + 1, sizeof(struct oe_host_pollfd))))
         OE_RAISE_ERRNO(OE_ENOMEM);
 
-    /* Convert enclave fds to host fds. */
+    if (!(descs = oe_calloc(nfds, sizeof(oe_fd_t*))))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    /* Convert enclave fds to host fds. Enclave-internal fds, which have no
+     * host fd, are polled in the enclave. */
     for (i = 0; i < nfds; i++)
     {
         oe_host_fd_t host_fd;
@@ -31,20 +79,158 @@ int oe_poll(struct oe_pollfd* fds, oe_nfds_t nfds, int timeout)
         if (!(desc = oe_fdtable_get(fds[i].fd, OE_FD_TYPE_ANY)))
             OE_RAISE_ERRNO(OE_EBADF);
 
+        fds[i].revents = 0;
+
         /* Get the host fd for this fd struct. */
         if ((host_fd = desc->ops.fd.get_host_fd(desc)) == -1)
-            OE_RAISE_ERRNO(OE_EBADF);
+        {
+            if (!desc->ops.fd.poll)
+                OE_RAISE_ERRNO(OE_EBADF);
+
+            descs[i] = desc;
+            have_enclave_fds = true;
+            continue;
+        }
 
-        host_fds[i].events = fds[i].events;
-        host_fds[i].fd = host_fd;
+        host_fds[num_host_fds].events = fds[i].events;
+        host_fds[num_host_fds].fd = host_fd;
+        num_host_fds++;
     }
 
-    if (oe_syscall_poll_ocall(&retval, host_fds, nfds, timeout) != OE_OK)
-        OE_RAISE_ERRNO(OE_EINVAL);
+    /* Without enclave-internal fds, this is a single host poll. */
+    if (!have_enclave_fds)
+    {
+        if (oe_syscall_poll_ocall(&retval, host_fds, nfds, timeout) != OE_OK)
+            OE_RAISE_ERRNO(OE_EINVAL);
 
-    /* Update fds[] with any recieved events. */
-    for (i = 0; i < nfds; i++)
-        fds[i].revents = host_fds[i].revents;
+        /* Update fds[] with any recieved events. */
+        for (i = 0; i < nfds; i++)
+            fds[i].revents = host_fds[i].revents;
+
+        ret = retval;
+        goto done;
+    }
+
+    if (!(links = oe_calloc(nfds, sizeof(oe_wait_link_t))))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    if (timeout > 0)
+        deadline = oe_get_time() + (uint64_t)timeout;
+
+    for (;;)
+    {
+        oe_waiter_t waiter;
+        int wait_timeout = timeout;
+
+        if (_poll_enclave_fds(fds, descs, nfds) || timeout == 0)
+        {
+            /* Only look at the host fds, if any, without waiting. */
+            if (num_host_fds)
+                wait_timeout = 0;
+            else
+                break;
+        }
+        else if (timeout > 0)
+        {
+            const uint64_t now = oe_get_time();
+
+            if (now >= deadline)
+                break;
+
+            wait_timeout = (int)(deadline - now);
+        }
+
+        if (wait_timeout == 0)
+        {
+            if (oe_syscall_poll_ocall(&retval, host_fds, num_host_fds, 0) !=
+                OE_OK)
+            {
+                OE_RAISE_ERRNO(OE_EINVAL);
+            }
+
+            if (retval < 0)
+                OE_RAISE_ERRNO(oe_errno);
+
+            break;
+        }
+
+        /* Queue the waiter on every enclave-internal fd, then check them
+         * again, so that a change in between is not missed. */
+        if (oe_waiter_init(&waiter) != 0)
+            OE_RAISE_ERRNO(oe_errno);
+
+        for (i = 0; i < nfds; i++)
+        {
+            oe_wait_queue_t* queue;
+
+            if (descs[i])
+            {
+                descs[i]->ops.fd.poll(descs[i], &queue);
+                oe_wait_queue_add(queue, &links[i], &waiter);
+            }
+        }
+
+        if (!_poll_enclave_fds(fds, descs, nfds))
+        {
+            if (num_host_fds)
+            {
+                host_fds[num_host_fds].fd = waiter.wake_fd;
+                host_fds[num_host_fds].events = OE_POLLIN;
+                host_fds[num_host_fds].revents = 0;
+
+                if (oe_syscall_poll_ocall(
+                        &retval, host_fds, num_host_fds + 1, wait_timeout) !=
+                    OE_OK)
+                {
+                    retval = -1;
+                    oe_errno = OE_EINVAL;
+                }
+            }
+            else
+            {
+                retval = oe_waiter_sleep(&waiter, wait_timeout);
+            }
+        }
+        else
+        {
+            retval = 0;
+        }
+
+        for (i = 0; i < nfds; i++)
+        {
+            if (descs[i])
+                oe_wait_queue_remove(&links[i]);
+        }
+
+        oe_waiter_destroy(&waiter);
+
+        if (retval < 0)
+            OE_RAISE_ERRNO(oe_errno);
+
+        /* Done if a host fd is ready; otherwise check the enclave fds. */
+        if (num_host_fds && retval > 0 &&
+            (retval > 1 || !host_fds[num_host_fds].revents))
+        {
+            _poll_enclave_fds(fds, descs, nfds);
+            break;
+        }
+
+        /* Another thread may have taken what woke this one. */
+        if (_poll_enclave_fds(fds, descs, nfds))
+            break;
+    }
+
+    /* Merge the host revents into fds[]. */
+    retval = 0;
+
+    for (i = 0, num_host_fds = 0; i < nfds; i++)
+    {
+        if (!descs[i])
+            fds[i].revents = host_fds[num_host_fds++].revents;
+
+        if (fds[i].revents)
+            retval++;
+    }
 
     ret = retval;
 
@@ -53,5 +239,11 @@ done:
     if (host_fds)
         oe_free(host_fds);
 
+    if (descs)
+        oe_free(descs);
+
+    if (links)
+        oe_free(links);
+
     return ret;
 }
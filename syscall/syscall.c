@@ -13,10 +13,12 @@
 #include <openenclave/internal/syscall/dirent.h>
 #include <openenclave/internal/syscall/fcntl.h>
 #include <openenclave/internal/syscall/raise.h>
+#include <openenclave/internal/syscall/sys/eventfd.h>
 #include <openenclave/internal/syscall/sys/ioctl.h>
 #include <openenclave/internal/syscall/sys/mount.h>
 #include <openenclave/internal/syscall/sys/poll.h>
 #include <openenclave/internal/syscall/sys/select.h>
+#include <openenclave/internal/syscall/sys/sendfile.h>
 #include <openenclave/internal/syscall/sys/socket.h>
 #include <openenclave/internal/syscall/sys/stat.h>
 #include <openenclave/internal/syscall/sys/syscall.h>
@@ -112,6 +114,69 @@ static long _syscall(
             ret = oe_lseek(fd, off, whence);
             goto done;
         }
+        case OE_SYS_pread64:
+        {
+            int fd = (int)arg1;
+            void* buf = (void*)arg2;
+            size_t count = (size_t)arg3;
+            oe_off_t offset = (oe_off_t)arg4;
+
+            ret = oe_pread(fd, buf, count, offset);
+            goto done;
+        }
+        case OE_SYS_pwrite64:
+        {
+            int fd = (int)arg1;
+            const void* buf = (void*)arg2;
+            size_t count = (size_t)arg3;
+            oe_off_t offset = (oe_off_t)arg4;
+
+            ret = oe_pwrite(fd, buf, count, offset);
+            goto done;
+        }
+        case OE_SYS_preadv:
+        {
+            int fd = (int)arg1;
+            const struct oe_iovec* iov = (const struct oe_iovec*)arg2;
+            int iovcnt = (int)arg3;
+            oe_off_t offset = (oe_off_t)arg4;
+
+            ret = oe_preadv(fd, iov, iovcnt, offset);
+            goto done;
+        }
+        case OE_SYS_pwritev:
+        {
+            int fd = (int)arg1;
+            const struct oe_iovec* iov = (const struct oe_iovec*)arg2;
+            int iovcnt = (int)arg3;
+            oe_off_t offset = (oe_off_t)arg4;
+
+            ret = oe_pwritev(fd, iov, iovcnt, offset);
+            goto done;
+        }
+        case OE_SYS_sendfile:
+        {
+            int out_fd = (int)arg1;
+            int in_fd = (int)arg2;
+            oe_off_t* offset = (oe_off_t*)arg3;
+            size_t count = (size_t)arg4;
+
+            ret = oe_sendfile(out_fd, in_fd, offset, count);
+            goto done;
+        }
+        case OE_SYS_copy_file_range:
+        {
+            int fd_in = (int)arg1;
+            oe_off_t* off_in = (oe_off_t*)arg2;
+            int fd_out = (int)arg3;
+            oe_off_t* off_out = (oe_off_t*)arg4;
+            size_t len = (size_t)arg5;
+            unsigned int flags = (unsigned int)arg6;
+
+            ret = oe_copy_file_range(
+                fd_in, off_in, fd_out, off_out, len, flags);
+            goto done;
+        }
         case OE_SYS_readv:
         {
             int fd = (int)arg1;
@@ -187,6 +252,40 @@ static long _syscall(
             ret = oe_dup2(oldfd, newfd);
             goto done;
         }
+#if defined(OE_SYS_pipe)
+        case OE_SYS_pipe:
+        {
+            int* pipefd = (int*)arg1;
+
+            ret = oe_pipe(pipefd);
+            goto done;
+        }
+#endif
+        case OE_SYS_pipe2:
+        {
+            int* pipefd = (int*)arg1;
+            int flags = (int)arg2;
+
+            ret = oe_pipe2(pipefd, flags);
+            goto done;
+        }
+#if defined(OE_SYS_eventfd)
+        case OE_SYS_eventfd:
+        {
+            unsigned int initval = (unsigned int)arg1;
+
+            ret = oe_eventfd(initval, 0);
+            goto done;
+        }
+#endif
+        case OE_SYS_eventfd2:
+        {
+            unsigned int initval = (unsigned int)arg1;
+            int flags = (int)arg2;
+
+            ret = oe_eventfd(initval, flags);
+            goto done;
+        }
 #if defined(OE_SYS_stat)
         case OE_SYS_stat:
         {
@@ -9,6 +9,7 @@
 #include <openenclave/internal/syscall/device.h>
 #include <openenclave/internal/syscall/fdtable.h>
 #include <openenclave/internal/syscall/raise.h>
+#include <openenclave/internal/syscall/sys/sendfile.h>
 #include <openenclave/internal/syscall/sys/stat.h>
 #include <openenclave/internal/syscall/sys/utsname.h>
 #include <openenclave/internal/syscall/unistd.h>
@@ -501,6 +502,288 @@ done:
     return ret;
 }
 
+/* Positional I/O is only defined on files; sockets and epolls cannot seek. */
+static oe_fd_t* _get_seekable_file(int fd)
+{
+    oe_fd_t* ret = NULL;
+    oe_fd_t* desc;
+
+    if (!(desc = oe_fdtable_get(fd, OE_FD_TYPE_ANY)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (desc->type != OE_FD_TYPE_FILE)
+        OE_RAISE_ERRNO(OE_ESPIPE);
+
+    ret = desc;
+
+done:
+    return ret;
+}
+
+ssize_t oe_pread(int fd, void* buf, size_t count, oe_off_t offset)
+{
+    ssize_t ret = -1;
+    oe_fd_t* file;
+
+    if (!(file = _get_seekable_file(fd)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    ret = file->ops.file.pread(file, buf, count, offset);
+
+done:
+    return ret;
+}
+
+ssize_t oe_pwrite(int fd, const void* buf, size_t count, oe_off_t offset)
+{
+    ssize_t ret = -1;
+    oe_fd_t* file;
+
+    if (!(file = _get_seekable_file(fd)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    ret = file->ops.file.pwrite(file, buf, count, offset);
+
+done:
+    return ret;
+}
+
+ssize_t oe_preadv(
+    int fd,
+    const struct oe_iovec* iov,
+    int iovcnt,
+    oe_off_t offset)
+{
+    ssize_t ret = -1;
+    oe_fd_t* file;
+
+    if (!(file = _get_seekable_file(fd)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    ret = file->ops.file.preadv(file, iov, iovcnt, offset);
+
+done:
+    return ret;
+}
+
+ssize_t oe_pwritev(
+    int fd,
+    const struct oe_iovec* iov,
+    int iovcnt,
+    oe_off_t offset)
+{
+    ssize_t ret = -1;
+    oe_fd_t* file;
+
+    if (!(file = _get_seekable_file(fd)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    ret = file->ops.file.pwritev(file, iov, iovcnt, offset);
+
+done:
+    return ret;
+}
+
+/* The buffer size used to copy between descriptors through the enclave. */
+#define COPY_CHUNK_SIZE (64 * 1024)
+
+/* Write all of buf, returning the number of bytes written before an error. */
+static ssize_t _write_all(
+    oe_fd_t* out,
+    oe_off_t* out_offset,
+    const uint8_t* buf,
+    size_t count)
+{
+    size_t total = 0;
+
+    while (total < count)
+    {
+        ssize_t n;
+
+        if (out_offset)
+        {
+            n = out->ops.file.pwrite(
+                out, buf + total, count - total, *out_offset);
+        }
+        else
+        {
+            n = out->ops.fd.write(out, buf + total, count - total);
+        }
+
+        if (n <= 0)
+            break;
+
+        if (out_offset)
+            *out_offset += n;
+
+        total += (size_t)n;
+    }
+
+    return (ssize_t)total;
+}
+
+/* Copy between descriptors that have no host descriptor through the enclave.
+ * Returns the number of bytes written, or -1 if nothing was written. */
+static ssize_t _copy_through_enclave(
+    oe_fd_t* in,
+    oe_off_t* in_offset,
+    oe_fd_t* out,
+    oe_off_t* out_offset,
+    size_t count)
+{
+    ssize_t ret = -1;
+    uint8_t* buf = NULL;
+    const size_t buf_size = count < COPY_CHUNK_SIZE ? count : COPY_CHUNK_SIZE;
+    size_t total = 0;
+
+    if ((in_offset && in->type != OE_FD_TYPE_FILE) ||
+        (out_offset && out->type != OE_FD_TYPE_FILE))
+    {
+        OE_RAISE_ERRNO(OE_ESPIPE);
+    }
+
+    if (count == 0)
+    {
+        ret = 0;
+        goto done;
+    }
+
+    if (!(buf = oe_malloc(buf_size)))
+        OE_RAISE_ERRNO(OE_ENOMEM);
+
+    while (total < count)
+    {
+        const size_t n = count - total < buf_size ? count - total : buf_size;
+        ssize_t nread;
+        ssize_t nwritten;
+
+        if (in_offset)
+            nread = in->ops.file.pread(in, buf, n, *in_offset);
+        else
+            nread = in->ops.fd.read(in, buf, n);
+
+        if (nread <= 0)
+        {
+            if (nread < 0 && total == 0)
+                goto done;
+
+            break;
+        }
+
+        nwritten = _write_all(out, out_offset, buf, (size_t)nread);
+
+        if (in_offset)
+            *in_offset += nwritten;
+
+        total += (size_t)nwritten;
+
+        if (nwritten < nread)
+        {
+            if (total == 0)
+                goto done;
+
+            break;
+        }
+    }
+
+    oe_errno = 0;
+    ret = (ssize_t)total;
+
+done:
+
+    if (buf)
+        oe_free(buf);
+
+    return ret;
+}
+
+ssize_t oe_sendfile(int out_fd, int in_fd, oe_off_t* offset, size_t count)
+{
+    ssize_t ret = -1;
+    oe_fd_t* in;
+    oe_fd_t* out;
+    oe_host_fd_t in_host_fd;
+    oe_host_fd_t out_host_fd;
+
+    if (!(in = oe_fdtable_get(in_fd, OE_FD_TYPE_ANY)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (!(out = oe_fdtable_get(out_fd, OE_FD_TYPE_ANY)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (offset && *offset < 0)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    in_host_fd = in->ops.fd.get_host_fd(in);
+    out_host_fd = out->ops.fd.get_host_fd(out);
+
+    /* Keep the data on the host when both sides live there. */
+    if (in_host_fd != -1 && out_host_fd != -1)
+    {
+        if (oe_syscall_sendfile_ocall(
+                &ret, out_host_fd, in_host_fd, offset, count) != OE_OK)
+        {
+            OE_RAISE_ERRNO(OE_EINVAL);
+        }
+
+        goto done;
+    }
+
+    ret = _copy_through_enclave(in, offset, out, NULL, count);
+
+done:
+    return ret;
+}
+
+ssize_t oe_copy_file_range(
+    int fd_in,
+    oe_off_t* off_in,
+    int fd_out,
+    oe_off_t* off_out,
+    size_t len,
+    unsigned int flags)
+{
+    ssize_t ret = -1;
+    oe_fd_t* in;
+    oe_fd_t* out;
+    oe_host_fd_t in_host_fd;
+    oe_host_fd_t out_host_fd;
+
+    if (!(in = oe_fdtable_get(fd_in, OE_FD_TYPE_ANY)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    if (!(out = oe_fdtable_get(fd_out, OE_FD_TYPE_ANY)))
+        OE_RAISE_ERRNO(oe_errno);
+
+    /* Only files can be copied and no flags are defined. */
+    if (in->type != OE_FD_TYPE_FILE || out->type != OE_FD_TYPE_FILE || flags)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    if ((off_in && *off_in < 0) || (off_out && *off_out < 0))
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    in_host_fd = in->ops.fd.get_host_fd(in);
+    out_host_fd = out->ops.fd.get_host_fd(out);
+
+    /* Keep the data on the host when both sides live there. */
+    if (in_host_fd != -1 && out_host_fd != -1)
+    {
+        if (oe_syscall_copy_file_range_ocall(
+                &ret, in_host_fd, off_in, out_host_fd, off_out, len, flags) !=
+            OE_OK)
+        {
+            OE_RAISE_ERRNO(OE_EINVAL);
+        }
+
+        goto done;
+    }
+
+    ret = _copy_through_enclave(in, off_in, out, off_out, len);
+
+done:
+    return ret;
+}
+
 ssize_t oe_readv(int fd, const struct oe_iovec* iov, int iovcnt)
 {
     ssize_t ret = -1;
@@ -0,0 +1,231 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+
+#include <openenclave/corelibc/stdlib.h>
+#include <openenclave/internal/syscall/fcntl.h>
+#include <openenclave/internal/syscall/raise.h>
+#include <openenclave/internal/syscall/sys/epoll.h>
+#include <openenclave/internal/syscall/waitqueue.h>
+#include <openenclave/internal/trace.h>
+#include "syscall_t.h"
+
+/*
+**==============================================================================
+**
+** Wait queues
+**
+**     Enclave-internal descriptors, such as eventfds and pipes, keep the
+**     threads that wait for them in wait queues. A waiting thread sleeps on
+**     the host in oe_syscall_epoll_wait_ocall() or oe_syscall_poll_ocall()
+**     with a wake instance: a host epoll instance that watches nothing but
+**     the eventfd that oe_syscall_epoll_wake_ocall() signals. Each sleeping
+**     thread has a wake instance of its own, so that no other thread can
+**     reset it before the thread sees it. The instances are kept in a pool
+**     for the next waiters.
+**
+**==============================================================================
+*/
+
+static oe_host_fd_t* _pool;
+static size_t _pool_size;
+static size_t _pool_capacity;
+static oe_spinlock_t _pool_lock = OE_SPINLOCK_INITIALIZER;
+
+int oe_waiter_init(oe_waiter_t* waiter)
+{
+    int ret = -1;
+    oe_host_fd_t wake_fd = -1;
+
+    if (!waiter)
+        OE_RAISE_ERRNO(OE_EINVAL);
+
+    oe_spin_lock(&_pool_lock);
+
+    if (_pool_size)
+        wake_fd = _pool[--_pool_size];
+
+    oe_spin_unlock(&_pool_lock);
+
+    if (wake_fd == -1)
+    {
+        if (oe_syscall_epoll_create1_ocall(&wake_fd, OE_O_CLOEXEC) != OE_OK)
+            OE_RAISE_ERRNO(OE_EINVAL);
+
+        if (wake_fd == -1)
+            OE_RAISE_ERRNO(oe_errno);
+    }
+
+    waiter->wake_fd = wake_fd;
+    waiter->woken = 0;
+    waiter->reset = false;
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+void oe_waiter_destroy(oe_waiter_t* waiter)
+{
+    bool pooled = false;
+    bool reset = true;
+
+    /* A woken instance stays ready until a host wait resets it. */
+    if (__atomic_load_n(&waiter->woken, __ATOMIC_ACQUIRE) && !waiter->reset)
+        reset = oe_waiter_sleep(waiter, 0) == 0 && waiter->reset;
+
+    if (reset)
+    {
+        oe_spin_lock(&_pool_lock);
+
+        if (_pool_size == _pool_capacity)
+        {
+            const size_t capacity = _pool_capacity ? _pool_capacity * 2 : 8;
+            oe_host_fd_t* pool;
+
+            if ((pool = oe_realloc(_pool, capacity * sizeof(oe_host_fd_t))))
+            {
+                _pool = pool;
+                _pool_capacity = capacity;
+            }
+        }
+
+        if (_pool_size < _pool_capacity)
+        {
+            _pool[_pool_size++] = waiter->wake_fd;
+            pooled = true;
+        }
+
+        oe_spin_unlock(&_pool_lock);
+    }
+
+    /* Close an instance that would wake its next waiter, or that does not
+     * fit in the pool. */
+    if (!pooled)
+    {
+        int retval;
+
+        oe_syscall_epoll_close_ocall(&retval, waiter->wake_fd);
+    }
+
+    waiter->wake_fd = -1;
+}
+
+int oe_waiter_sleep(oe_waiter_t* waiter, int timeout)
+{
+    int ret = -1;
+    int retval;
+    struct oe_epoll_event event;
+
+    if (oe_syscall_epoll_wait_ocall(
+            &retval, waiter->wake_fd, &event, 1, timeout) != OE_OK)
+    {
+        OE_RAISE_ERRNO(OE_EINVAL);
+    }
+
+    /* The host reports a wakeup as an interrupt, after it resets the
+     * instance. Nothing else is watched. */
+    if (retval == -1)
+    {
+        if (oe_errno != OE_EINTR)
+            OE_RAISE_ERRNO(oe_errno);
+
+        waiter->reset = true;
+    }
+
+    ret = 0;
+
+done:
+    return ret;
+}
+
+void oe_wait_queue_add(
+    oe_wait_queue_t* queue,
+    oe_wait_link_t* link,
+    oe_waiter_t* waiter)
+{
+    link->queue = queue;
+    link->waiter = waiter;
+    link->prev = NULL;
+
+    oe_mutex_lock(&queue->lock);
+
+    if ((link->next = queue->head))
+        queue->head->prev = link;
+
+    queue->head = link;
+
+    oe_mutex_unlock(&queue->lock);
+}
+
+void oe_wait_queue_remove(oe_wait_link_t* link)
+{
+    oe_wait_queue_t* queue = link->queue;
+
+    oe_mutex_lock(&queue->lock);
+
+    if (link->prev)
+        link->prev->next = link->next;
+    else
+        queue->head = link->next;
+
+    if (link->next)
+        link->next->prev = link->prev;
+
+    oe_mutex_unlock(&queue->lock);
+
+    if (queue->release)
+        queue->release(queue);
+}
+
+void oe_wait_queue_wake(oe_wait_queue_t* queue)
+{
+    /* The waiters remove themselves under the lock, so they stay valid
+     * while it is held. */
+    oe_mutex_lock(&queue->lock);
+
+    for (oe_wait_link_t* p = queue->head; p; p = p->next)
+    {
+        oe_waiter_t* waiter = p->waiter;
+        int retval;
+
+        /* Wake each waiter once, however many of its queues change. */
+        if (__atomic_exchange_n(&waiter->woken, 1, __ATOMIC_ACQ_REL))
+            continue;
+
+        if (oe_syscall_epoll_wake_ocall(&retval, waiter->wake_fd) != OE_OK ||
+            retval != 0)
+        {
+            OE_TRACE_ERROR("cannot wake instance %ld", waiter->wake_fd);
+        }
+    }
+
+    oe_mutex_unlock(&queue->lock);
+}
+
+int oe_fd_wait(oe_fd_t* desc, short events)
+{
+    int ret = -1;
+    oe_waiter_t waiter;
+    oe_wait_link_t link;
+    oe_wait_queue_t* queue;
+
+    if (oe_waiter_init(&waiter) != 0)
+        OE_RAISE_ERRNO(oe_errno);
+
+    desc->ops.fd.poll(desc, &queue);
+    oe_wait_queue_add(queue, &link, &waiter);
+
+    if (!(desc->ops.fd.poll(desc, NULL) & events))
+        ret = oe_waiter_sleep(&waiter, -1);
+    else
+        ret = 0;
+
+    oe_wait_queue_remove(&link);
+    oe_waiter_destroy(&waiter);
+
+done:
+    return ret;
+}
@@ -144,6 +144,67 @@ bool test_unsupported_cpuid_leaf(uint32_t leaf)
     }
 }
 
+// Test Intent: oe_cpuid() returns the same values as the emulated CPUID
+// instruction without trapping, and the trapping CPUID instructions executed
+// by this test were counted as emulated exceptions.
+bool test_oe_cpuid(
+    uint32_t cpuid_table[OE_CPUID_LEAF_COUNT][OE_CPUID_REG_COUNT])
+{
+    oe_emulated_exception_stats_t before;
+    oe_emulated_exception_stats_t after;
+    uint32_t eax, ebx, ecx, edx;
+
+    oe_get_emulated_exception_stats(&before);
+
+    for (uint32_t i = 0; i < OE_CPUID_LEAF_COUNT; i++)
+    {
+        if (!oe_is_emulated_cpuid_leaf(i))
+        {
+            if (oe_cpuid(i, 0, &eax, &ebx, &ecx, &edx) != OE_UNSUPPORTED)
+                return false;
+            continue;
+        }
+
+        if (oe_cpuid(i, 0, &eax, &ebx, &ecx, &edx) != OE_OK)
+            return false;
+
+        if (eax != cpuid_table[i][OE_CPUID_RAX] ||
+            ebx != cpuid_table[i][OE_CPUID_RBX] ||
+            ecx != cpuid_table[i][OE_CPUID_RCX] ||
+            edx != cpuid_table[i][OE_CPUID_RDX])
+        {
+            oe_host_printf("oe_cpuid() mismatch for leaf %x.\n", i);
+            return false;
+        }
+    }
+
+    if (oe_cpuid(4, 1, &eax, &ebx, &ecx, &edx) != OE_UNSUPPORTED ||
+        oe_cpuid(OE_CPUID_EXTENDED_CPUID_LEAF, 0, &eax, &ebx, &ecx, &edx) !=
+            OE_UNSUPPORTED)
+        return false;
+
+    oe_get_emulated_exception_stats(&after);
+
+    // oe_cpuid() must not have trapped
+    if (after.emulated != before.emulated)
+    {
+        oe_host_printf("oe_cpuid() raised an exception.\n");
+        return false;
+    }
+
+    // The CPUID instructions above (in get_cpuid) were emulated, and the
+    // unsupported leaves were not
+    if (after.emulated == 0 || after.sites[0].address == 0 ||
+        after.not_emulated < 2)
+    {
+        oe_host_printf("Emulated exceptions were not counted.\n");
+        return false;
+    }
+
+    oe_host_printf("test_oe_cpuid: completed successfully.\n");
+    return true;
+}
+
 int enc_test_sigill_handling(
     uint32_t cpuid_table[OE_CPUID_LEAF_COUNT][OE_CPUID_REG_COUNT])
 {
@@ -189,6 +250,11 @@ int enc_test_sigill_handling(
         }
     }
 
+    if (!test_oe_cpuid(cpuid_table))
+    {
+        return -1;
+    }
+
     // Clean up sigill handler
     if (oe_remove_vectored_exception_handler(enc_test_sigill_handler) != OE_OK)
     {
@@ -0,0 +1,358 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <mbedtls/gcm.h>
+#include <openenclave/enclave.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "aes_gcm_t.h"
+
+#define MAX_SIZE (4096 + 7)
+
+static const size_t _sizes[] =
+    {0, 1, 15, 16, 17, 63, 64, 65, 127, 128, 1000, MAX_SIZE};
+static const size_t _iv_sizes[] = {12, 20};
+static const size_t _aad_sizes[] = {0, 13, 70};
+static const unsigned int _key_bits[] = {128, 192, 256};
+
+#define COUNTOF(a) (sizeof(a) / sizeof(a[0]))
+
+static int _setup(
+    mbedtls_gcm_context* ctx,
+    const uint8_t* key,
+    unsigned int key_bits,
+    bool accelerated)
+{
+    mbedtls_gcm_init(ctx);
+
+    if (mbedtls_gcm_setkey(ctx, MBEDTLS_CIPHER_ID_AES, key, key_bits) != 0)
+        return -1;
+
+    return mbedtls_gcm_set_acceleration(ctx, accelerated);
+}
+
+/* Test vectors from "The Galois/Counter Mode of Operation (GCM)" by McGrew
+ * and Viega, in hex. */
+typedef struct _gcm_vector
+{
+    const char* key;
+    const char* iv;
+    const char* aad;
+    const char* plaintext;
+    const char* ciphertext;
+    const char* tag;
+} gcm_vector_t;
+
+static const gcm_vector_t _vectors[] = {
+    /* Test Case 2 (AES-128) */
+    {
+        "00000000000000000000000000000000",
+        "000000000000000000000000",
+        "",
+        "00000000000000000000000000000000",
+        "0388dace60b6a392f328c2b971b2fe78",
+        "ab6e47d42cec13bdf53a67b21257bddf",
+    },
+    /* Test Case 3 (AES-128) */
+    {
+        "feffe9928665731c6d6a8f9467308308",
+        "cafebabefacedbaddecaf888",
+        "",
+        "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+        "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255",
+        "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+        "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985",
+        "4d5c2af327cd64a62cf35abd2ba6fab4",
+    },
+    /* Test Case 4 (AES-128, AAD) */
+    {
+        "feffe9928665731c6d6a8f9467308308",
+        "cafebabefacedbaddecaf888",
+        "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+        "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+        "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+        "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+        "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+        "5bc94fbc3221a5db94fae95ae7121a47",
+    },
+    /* Test Case 6 (AES-128, 60-byte IV) */
+    {
+        "feffe9928665731c6d6a8f9467308308",
+        "9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728"
+        "c3c0c95156809539fcf0e2429a6b525416aedbf5a0de6a57a637b39b",
+        "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+        "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+        "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+        "8ce24998625615b603a033aca13fb894be9112a5c3a211a8ba262a3cca7e2ca7"
+        "01e4a9a4fba43c90ccdcb281d48c7c6fd62875d2aca417034c34aee5",
+        "619cc5aefffe0bfa462af43c1699d050",
+    },
+    /* Test Case 16 (AES-256, AAD) */
+    {
+        "feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308",
+        "cafebabefacedbaddecaf888",
+        "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+        "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+        "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+        "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+        "8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662",
+        "76fc6ece0f4e1768cddf8853bb2d551b",
+    },
+};
+
+static size_t _unhex(const char* hex, uint8_t* buf, size_t size)
+{
+    size_t n = strlen(hex) / 2;
+
+    if (n > size)
+        return 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        unsigned int byte;
+
+        sscanf(hex + 2 * i, "%2x", &byte);
+        buf[i] = (uint8_t)byte;
+    }
+
+    return n;
+}
+
+static int _check_vector(const gcm_vector_t* v, bool accelerated)
+{
+    uint8_t key[32];
+    uint8_t iv[64];
+    uint8_t aad[64];
+    uint8_t plaintext[64];
+    uint8_t ciphertext[64];
+    uint8_t tag[16];
+    uint8_t out[64];
+    uint8_t out_tag[16];
+    mbedtls_gcm_context ctx;
+    const size_t key_size = _unhex(v->key, key, sizeof(key));
+    const size_t iv_size = _unhex(v->iv, iv, sizeof(iv));
+    const size_t aad_size = _unhex(v->aad, aad, sizeof(aad));
+    const size_t size = _unhex(v->plaintext, plaintext, sizeof(plaintext));
+    int ret = -1;
+
+    _unhex(v->ciphertext, ciphertext, sizeof(ciphertext));
+    _unhex(v->tag, tag, sizeof(tag));
+
+    if (_setup(&ctx, key, (unsigned int)key_size * 8, accelerated) != 0)
+        goto done;
+
+    if (mbedtls_gcm_crypt_and_tag(
+            &ctx,
+            MBEDTLS_GCM_ENCRYPT,
+            size,
+            iv,
+            iv_size,
+            aad,
+            aad_size,
+            plaintext,
+            out,
+            sizeof(out_tag),
+            out_tag) != 0)
+        goto done;
+
+    if (memcmp(out, ciphertext, size) != 0 ||
+        memcmp(out_tag, tag, sizeof(tag)) != 0)
+        goto done;
+
+    if (mbedtls_gcm_auth_decrypt(
+            &ctx,
+            size,
+            iv,
+            iv_size,
+            aad,
+            aad_size,
+            tag,
+            sizeof(tag),
+            ciphertext,
+            out) != 0)
+        goto done;
+
+    if (memcmp(out, plaintext, size) != 0)
+        goto done;
+
+    ret = 0;
+
+done:
+    mbedtls_gcm_free(&ctx);
+    return ret;
+}
+
+static int _check(
+    unsigned int key_bits,
+    size_t size,
+    size_t iv_size,
+    size_t aad_size)
+{
+    static uint8_t in[MAX_SIZE];
+    static uint8_t out1[MAX_SIZE];
+    static uint8_t out2[MAX_SIZE];
+    uint8_t key[32];
+    uint8_t iv[32];
+    uint8_t aad[128];
+    uint8_t tag1[16];
+    uint8_t tag2[16];
+    mbedtls_gcm_context fast;
+    mbedtls_gcm_context portable;
+    int ret = -1;
+
+    oe_random(key, sizeof(key));
+    oe_random(iv, sizeof(iv));
+    oe_random(aad, sizeof(aad));
+    oe_random(in, sizeof(in));
+
+    if (_setup(&fast, key, key_bits, true) != 0 ||
+        _setup(&portable, key, key_bits, false) != 0)
+        goto done;
+
+    if (mbedtls_gcm_crypt_and_tag(
+            &fast,
+            MBEDTLS_GCM_ENCRYPT,
+            size,
+            iv,
+            iv_size,
+            aad,
+            aad_size,
+            in,
+            out1,
+            sizeof(tag1),
+            tag1) != 0)
+        goto done;
+
+    if (mbedtls_gcm_crypt_and_tag(
+            &portable,
+            MBEDTLS_GCM_ENCRYPT,
+            size,
+            iv,
+            iv_size,
+            aad,
+            aad_size,
+            in,
+            out2,
+            sizeof(tag2),
+            tag2) != 0)
+        goto done;
+
+    if (memcmp(out1, out2, size) != 0 || memcmp(tag1, tag2, sizeof(tag1)))
+        goto done;
+
+    /* Decrypt in place with the accelerated implementation */
+    if (mbedtls_gcm_auth_decrypt(
+            &fast,
+            size,
+            iv,
+            iv_size,
+            aad,
+            aad_size,
+            tag1,
+            sizeof(tag1),
+            out1,
+            out1) != 0)
+        goto done;
+
+    if (memcmp(out1, in, size) != 0)
+        goto done;
+
+    ret = 0;
+
+done:
+    mbedtls_gcm_free(&fast);
+    mbedtls_gcm_free(&portable);
+    return ret;
+}
+
+int enc_check_gcm()
+{
+    for (size_t v = 0; v < COUNTOF(_vectors); v++)
+        for (int accelerated = 0; accelerated < 2; accelerated++)
+        {
+            if (_check_vector(&_vectors[v], accelerated) != 0)
+            {
+                printf(
+                    "AES-GCM test vector %zu failed: accelerated=%d\n",
+                    v,
+                    accelerated);
+                return -1;
+            }
+        }
+
+    for (size_t k = 0; k < COUNTOF(_key_bits); k++)
+        for (size_t s = 0; s < COUNTOF(_sizes); s++)
+            for (size_t i = 0; i < COUNTOF(_iv_sizes); i++)
+                for (size_t a = 0; a < COUNTOF(_aad_sizes); a++)
+                {
+                    if (_check(
+                            _key_bits[k],
+                            _sizes[s],
+                            _iv_sizes[i],
+                            _aad_sizes[a]) != 0)
+                    {
+                        printf(
+                            "AES-GCM mismatch: key_bits=%u size=%zu iv=%zu "
+                            "aad=%zu\n",
+                            _key_bits[k],
+                            _sizes[s],
+                            _iv_sizes[i],
+                            _aad_sizes[a]);
+                        return -1;
+                    }
+                }
+
+    return 0;
+}
+
+int enc_seal_gcm(bool accelerated, size_t size, size_t iterations)
+{
+    uint8_t key[16];
+    uint8_t iv[12];
+    uint8_t tag[16];
+    uint8_t* buf = NULL;
+    mbedtls_gcm_context ctx;
+    int ret = -1;
+
+    oe_random(key, sizeof(key));
+    oe_random(iv, sizeof(iv));
+
+    if (_setup(&ctx, key, 128, accelerated) != 0)
+        goto done;
+
+    if (!(buf = calloc(1, size)))
+        goto done;
+
+    for (size_t i = 0; i < iterations; i++)
+    {
+        if (mbedtls_gcm_crypt_and_tag(
+                &ctx,
+                MBEDTLS_GCM_ENCRYPT,
+                size,
+                iv,
+                sizeof(iv),
+                NULL,
+                0,
+                buf,
+                buf,
+                sizeof(tag),
+                tag) != 0)
+            goto done;
+    }
+
+    ret = 0;
+
+done:
+    free(buf);
+    mbedtls_gcm_free(&ctx);
+    return ret;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    8192, /* HeapPageCount */
+    1024, /* StackPageCount */
+    1);   /* TCSCount */
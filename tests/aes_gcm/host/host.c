@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/error.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "aes_gcm_u.h"
+
+#define SEAL_SIZE (16 * 1024 * 1024)
+#define SEAL_ITERATIONS 8
+
+static double _now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Report the sealing throughput of one implementation (not checked) */
+static void _benchmark(oe_enclave_t* enclave, bool accelerated)
+{
+    int ret = -1;
+    double start = _now();
+
+    OE_TEST(
+        enc_seal_gcm(
+            enclave, &ret, accelerated, SEAL_SIZE, SEAL_ITERATIONS) == OE_OK);
+    OE_TEST(ret == 0);
+
+    double elapsed = _now() - start;
+    double mb = (double)SEAL_SIZE * SEAL_ITERATIONS / (1024 * 1024);
+
+    printf(
+        "AES-128-GCM %s: %.0f MB in %.3f s (%.1f MB/s)\n",
+        accelerated ? "AES-NI/PCLMULQDQ" : "portable",
+        mb,
+        elapsed,
+        mb / elapsed);
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_enclave_t* enclave = NULL;
+    int ret = -1;
+
+    /* The benchmark takes a while, so ctest does not run it. */
+    const bool benchmark = argc == 3 && strcmp(argv[2], "--benchmark") == 0;
+
+    if (argc != 2 && !benchmark)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH [--benchmark]\n", argv[0]);
+        return 1;
+    }
+
+    const uint32_t flags = oe_get_create_flags();
+
+    if ((result = oe_create_aes_gcm_enclave(
+             argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave)) != OE_OK)
+        oe_put_err("oe_create_enclave(): result=%u", result);
+
+    OE_TEST(enc_check_gcm(enclave, &ret) == OE_OK);
+    OE_TEST(ret == 0);
+
+    if (benchmark)
+    {
+        _benchmark(enclave, false);
+        _benchmark(enclave, true);
+    }
+
+    result = oe_terminate_enclave(enclave);
+    OE_TEST(result == OE_OK);
+
+    printf("=== passed all tests (aes_gcm)\n");
+
+    return 0;
+}
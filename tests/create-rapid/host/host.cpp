@@ -162,5 +162,15 @@ int main(int argc, const char* argv[])
     _test_multithreaded(argv[1], flags, false);
     _test_multithreaded(argv[1], flags, true);
 
+    // Test enclave creation from a pool of pre-built enclaves.
+    OE_TEST(
+        oe_set_enclave_pool_size(
+            argv[1], flags, OE_MAX_ENCLAVE_POOL_SIZE + 1) ==
+        OE_INVALID_PARAMETER);
+    OE_TEST(oe_set_enclave_pool_size(argv[1], flags, 4) == OE_OK);
+    _test_sequential(argv[1], flags, true);
+    _test_multithreaded(argv[1], flags, true);
+    OE_TEST(oe_set_enclave_pool_size(argv[1], flags, 0) == OE_OK);
+
     return 0;
 }
@@ -12,6 +12,75 @@
 #include "hash.h"
 #include "tests.h"
 
+/* Hash of one million repetitions of 'a' (FIPS 180-2 test vector) */
+static OE_SHA256 _MILLION_A_HASH = {{
+    0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92, 0x81, 0xa1, 0xc7,
+    0xe2, 0x84, 0xd7, 0x3e, 0x67, 0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97,
+    0x20, 0x0e, 0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0,
+}};
+
+// Test computation of SHA-256 hash over many blocks in uneven updates.
+static void _test_sha_long(void)
+{
+    char chunk[1000];
+    OE_SHA256 hash = {0};
+    oe_sha256_context_t ctx = {0};
+
+    memset(chunk, 'a', sizeof(chunk));
+
+    OE_TEST(oe_sha256_init(&ctx) == OE_OK);
+    for (size_t i = 0; i < 1000; i++)
+        OE_TEST(oe_sha256_update(&ctx, chunk, sizeof(chunk)) == OE_OK);
+    OE_TEST(oe_sha256_final(&ctx, &hash) == OE_OK);
+    OE_TEST(memcmp(&hash, &_MILLION_A_HASH, sizeof(OE_SHA256)) == 0);
+}
+
+// Test that hashing several messages at once matches hashing them one by one.
+static void _test_sha_multi(void)
+{
+    const void* data[3] = {ALPHABET, ALPHABET + 1, ""};
+    size_t sizes[3] = {strlen(ALPHABET), strlen(ALPHABET) - 1, 0};
+    OE_SHA256 hashes[3] = {{{0}}};
+
+    OE_TEST(oe_sha256_multi(data, sizes, 3, hashes) == OE_OK);
+    OE_TEST(memcmp(&hashes[0], &ALPHABET_HASH, sizeof(OE_SHA256)) == 0);
+
+    for (size_t i = 1; i < 3; i++)
+    {
+        OE_SHA256 hash = {0};
+        oe_sha256_context_t ctx = {0};
+        oe_sha256_init(&ctx);
+        oe_sha256_update(&ctx, data[i], sizes[i]);
+        oe_sha256_final(&ctx, &hash);
+        OE_TEST(memcmp(&hash, &hashes[i], sizeof(OE_SHA256)) == 0);
+    }
+}
+
+// Test that a copied context continues the hash of the original.
+static void _test_sha_copy(void)
+{
+    const size_t half = strlen(ALPHABET) / 2;
+    OE_SHA256 hash = {0};
+    oe_sha256_context_t ctx = {0};
+    oe_sha256_context_t copy = {0};
+
+    OE_TEST(oe_sha256_init(&ctx) == OE_OK);
+    OE_TEST(oe_sha256_update(&ctx, ALPHABET, half) == OE_OK);
+    OE_TEST(oe_sha256_copy(&copy, &ctx) == OE_OK);
+
+    /* Both contexts hash the rest of the string independently */
+    for (size_t i = 0; i < 2; i++)
+    {
+        oe_sha256_context_t* p = i ? &copy : &ctx;
+
+        OE_TEST(
+            oe_sha256_update(p, ALPHABET + half, strlen(ALPHABET) - half) ==
+            OE_OK);
+        OE_TEST(oe_sha256_final(p, &hash) == OE_OK);
+        OE_TEST(memcmp(&hash, &ALPHABET_HASH, sizeof(OE_SHA256)) == 0);
+    }
+}
+
 // Test computation of SHA-256 hash over an ASCII alphabet string.
 void TestSHA(void)
 {
@@ -24,5 +93,9 @@ void TestSHA(void)
     oe_sha256_final(&ctx, &hash);
     OE_TEST(memcmp(&hash, &ALPHABET_HASH, sizeof(OE_SHA256)) == 0);
 
+    _test_sha_long();
+    _test_sha_multi();
+    _test_sha_copy();
+
     printf("=== passed %s()\n", __FUNCTION__);
 }
@@ -0,0 +1,36 @@
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# Licensed under the MIT License.
+
+# Profile the test program with oeprof, in both output formats, and check
+# that the hot enclave function was sampled with its callers.
+#
+# Usage: cmake -DOEPROF=<oeprof> -DARGS=<host;enclave;...> -P check.cmake
+
+execute_process(
+    COMMAND ${OEPROF} -F 499 -o oeprof_test.folded -- ${ARGS}
+    RESULT_VARIABLE result)
+
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "oeprof failed: ${result}")
+endif ()
+
+file(READ oeprof_test.folded folded)
+
+if (NOT folded MATCHES "oeprof_test_enc[^\n]*;enc_spin;spin_outer;spin_inner ")
+    message(FATAL_ERROR "hot function not sampled:\n${folded}")
+endif ()
+
+execute_process(
+    COMMAND ${OEPROF} -F 499 -f pprof -o oeprof_test.pprof -- ${ARGS}
+    RESULT_VARIABLE result)
+
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "oeprof -f pprof failed: ${result}")
+endif ()
+
+# The function names are in the string table of the profile.
+file(STRINGS oeprof_test.pprof strings REGEX "spin_inner")
+
+if (NOT strings)
+    message(FATAL_ERROR "hot function not in pprof profile")
+endif ()
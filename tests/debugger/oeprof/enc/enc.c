@@ -0,0 +1,36 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include "oeprof_test_t.h"
+
+// The test expects nearly all samples in spin_inner(), called through
+// spin_outer(), so both are kept out of line and global.
+OE_NEVER_INLINE uint64_t spin_inner(uint64_t x)
+{
+    for (int i = 0; i < 1000; i++)
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+
+    return x;
+}
+
+OE_NEVER_INLINE uint64_t spin_outer(uint64_t x, uint64_t iterations)
+{
+    for (uint64_t i = 0; i < iterations; i++)
+        x = spin_inner(x);
+
+    return x;
+}
+
+uint64_t enc_spin(uint64_t iterations)
+{
+    return spin_outer(1, iterations);
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    1024, /* HeapPageCount */
+    1024, /* StackPageCount */
+    2);   /* TCSCount */
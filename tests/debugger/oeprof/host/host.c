@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/error.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "oeprof_test_u.h"
+
+// How long to keep the enclave busy for oeprof to sample it.
+#define SPIN_SECONDS 2
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_enclave_t* enclave = NULL;
+    bool simulation_mode = false;
+    time_t end;
+    uint64_t calls = 0;
+
+    if (argc < 2)
+    {
+        fprintf(
+            stderr, "Usage: %s ENCLAVE_PATH [--simulation-mode]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t flags = oe_get_create_flags();
+
+    simulation_mode =
+        (argc == 3 && (strcmp(argv[2], "--simulation-mode") == 0));
+
+    if (simulation_mode)
+    {
+        // Force simulation mode if --simulation-mode is specified.
+        flags |= OE_ENCLAVE_FLAG_SIMULATE;
+    }
+
+    if ((result = oe_create_oeprof_test_enclave(
+             argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave)) != OE_OK)
+        oe_put_err("oe_create_enclave(): result=%u", result);
+
+    end = time(NULL) + SPIN_SECONDS;
+
+    while (time(NULL) < end)
+    {
+        uint64_t x = 0;
+
+        OE_TEST(enc_spin(enclave, &x, 10000) == OE_OK);
+        calls++;
+    }
+
+    result = oe_terminate_enclave(enclave);
+    OE_TEST(result == OE_OK);
+
+    printf(
+        "=== passed all tests (oeprof-test%s, %llu calls)\n",
+        simulation_mode ? "-simulation-mode" : "",
+        (unsigned long long)calls);
+
+    return 0;
+}
@@ -0,0 +1,18 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include "enclave_index_t.h"
+
+int enc_double(int arg)
+{
+    return arg * 2;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    128,  /* HeapPageCount */
+    64,   /* StackPageCount */
+    4);   /* TCSCount */
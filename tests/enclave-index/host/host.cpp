@@ -0,0 +1,128 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/error.h>
+#include <openenclave/internal/tests.h>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include "../../../host/sgx/enclave.h"
+#include "enclave_index_u.h"
+
+// Lookups of oe_query_enclave_instance() run against enclaves being created
+// and terminated, with the lock-free index and with the locked list scan
+// used when no index is published.
+
+const size_t NUM_READERS = 4;
+const size_t NUM_CYCLES = 16;
+
+// The TCSs of the enclave being cycled, which are zero between cycles.
+const size_t NUM_TCS = 4;
+static std::atomic<uint64_t> _cycled_tcs[NUM_TCS];
+static std::atomic<bool> _stop;
+
+static void _lookup_thread(oe_enclave_t* enclave, size_t* num_lookups)
+{
+    while (!_stop)
+    {
+        // The enclave that lives throughout is always found.
+        for (size_t i = 0; i < enclave->num_bindings; i++)
+        {
+            void* tcs = (void*)enclave->bindings[i].tcs;
+            OE_TEST(oe_query_enclave_instance(tcs) == enclave);
+        }
+
+        // The cycled enclave may be gone by the time it is looked up, or
+        // replaced by one mapped at the same address.
+        for (size_t i = 0; i < NUM_TCS; i++)
+        {
+            uint64_t tcs = _cycled_tcs[i];
+
+            if (tcs)
+                OE_TEST(oe_query_enclave_instance((void*)tcs) != enclave);
+        }
+
+        (*num_lookups)++;
+    }
+}
+
+static void _run_lookups(const char* path, oe_enclave_t* enclave)
+{
+    const uint32_t flags = oe_get_create_flags();
+    std::thread readers[NUM_READERS];
+    size_t num_lookups[NUM_READERS] = {0};
+
+    _stop = false;
+
+    for (size_t i = 0; i < NUM_READERS; i++)
+        readers[i] = std::thread(_lookup_thread, enclave, &num_lookups[i]);
+
+    for (size_t i = 0; i < NUM_CYCLES; i++)
+    {
+        oe_enclave_t* other = NULL;
+        int ret = 0;
+
+        OE_TEST(
+            oe_create_enclave_index_enclave(
+                path, OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &other) == OE_OK);
+        OE_TEST(other->num_bindings == NUM_TCS);
+
+        for (size_t j = 0; j < NUM_TCS; j++)
+            _cycled_tcs[j] = other->bindings[j].tcs;
+
+        void* tcs = (void*)other->bindings[0].tcs;
+        OE_TEST(oe_query_enclave_instance(tcs) == other);
+        OE_TEST(enc_double(other, &ret, 21) == OE_OK);
+        OE_TEST(ret == 42);
+
+        for (size_t j = 0; j < NUM_TCS; j++)
+            _cycled_tcs[j] = 0;
+
+        OE_TEST(oe_terminate_enclave(other) == OE_OK);
+    }
+
+    _stop = true;
+
+    for (size_t i = 0; i < NUM_READERS; i++)
+    {
+        readers[i].join();
+        OE_TEST(num_lookups[i] > 0);
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_enclave_t* enclave = NULL;
+    oe_result_t result;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    // No index is published before the first enclave is created.
+    OE_TEST(oe_query_enclave_instance((void*)0x1000) == NULL);
+
+    const uint32_t flags = oe_get_create_flags();
+    if ((result = oe_create_enclave_index_enclave(
+             argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave)) != OE_OK)
+        oe_put_err("oe_create_enclave(): result=%u", result);
+
+    _run_lookups(argv[1], enclave);
+
+    // Without an index, lookups scan the enclave list under its lock.
+    oe_set_enclave_index_enabled(false);
+    _run_lookups(argv[1], enclave);
+    oe_set_enclave_index_enabled(true);
+
+    OE_TEST(
+        oe_query_enclave_instance((void*)enclave->bindings[0].tcs) == enclave);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (enclave-index)\n");
+
+    return 0;
+}
@@ -0,0 +1,20 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/trace.h>
+#include "logring_t.h"
+
+void enc_log_messages(const char* prefix, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        OE_TRACE_INFO("%s %zu\n", prefix, i);
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    1024, /* HeapPageCount */
+    1024, /* StackPageCount */
+    2);   /* TCSCount */
@@ -0,0 +1,95 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "logring_u.h"
+
+#define LOG_FILE "logring_test.log"
+
+/* Message counts: the first fits in the log ring of the enclave thread,
+ * the second does not. */
+#define FEW_MESSAGES 100
+#define MANY_MESSAGES 5000
+
+typedef struct _log_counts
+{
+    size_t few;
+    size_t many;
+    size_t dropped;
+} log_counts_t;
+
+static void _count_messages(log_counts_t* counts)
+{
+    FILE* file = fopen(LOG_FILE, "r");
+    char line[1024];
+
+    OE_TEST(file != NULL);
+    memset(counts, 0, sizeof(*counts));
+
+    while (fgets(line, sizeof(line), file))
+    {
+        const char* p;
+        unsigned long long n;
+
+        if ((p = strstr(line, "few message ")))
+        {
+            /* The messages of one thread are written in order */
+            OE_TEST(strtoull(p + 12, NULL, 10) == counts->few);
+            counts->few++;
+        }
+        else if (strstr(line, "many message "))
+        {
+            counts->many++;
+        }
+        else if (
+            (p = strstr(line, "]")) &&
+            sscanf(p + 1, "%llu enclave log messages dropped", &n) == 1)
+        {
+            counts->dropped += n;
+        }
+    }
+
+    fclose(file);
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_enclave_t* enclave = NULL;
+    log_counts_t counts;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    /* The log configuration is read once, so set it before anything logs */
+    remove(LOG_FILE);
+    setenv("OE_LOG_LEVEL", "INFO", 1);
+    setenv("OE_LOG_DEVICE", LOG_FILE, 1);
+
+    result = oe_create_logring_enclave(
+        argv[1], OE_ENCLAVE_TYPE_SGX, oe_get_create_flags(), NULL, 0, &enclave);
+    OE_TEST(result == OE_OK);
+
+    OE_TEST(enc_log_messages(enclave, "few message", FEW_MESSAGES) == OE_OK);
+    OE_TEST(enc_log_messages(enclave, "many message", MANY_MESSAGES) == OE_OK);
+
+    /* Termination writes what is still in the rings */
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    _count_messages(&counts);
+    OE_TEST(counts.few == FEW_MESSAGES);
+    OE_TEST(counts.many + counts.dropped == MANY_MESSAGES);
+
+    remove(LOG_FILE);
+
+    printf("=== passed all tests (logring)\n");
+
+    return 0;
+}
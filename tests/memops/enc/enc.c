@@ -0,0 +1,256 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/memops.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include <string.h>
+#include "memops_t.h"
+
+/* Largest misalignment of the buffers, plus one */
+#define MAX_OFFSET 32
+
+/* Larger than the REP MOVSB/STOSB thresholds of memops.c (2KB) */
+#define MAX_SIZE 4200
+
+/* Bytes checked after the end of each copy or fill */
+#define GUARD_SIZE 64
+
+#define PAGE_SIZE 4096
+
+#define BUFFER_SIZE (MAX_OFFSET + MAX_SIZE + GUARD_SIZE)
+
+/* Sizes tested with every misalignment: all those below 300, then those
+ * around the vector, loop and REP thresholds */
+static const size_t _large_sizes[] = {
+    511, 512, 513, 1023, 1024, 1025, 2047, 2048, 2049, 2111, 4095, 4096, 4167};
+
+/* Called through pointers so that the compiler cannot expand the calls */
+static void* (*volatile _memcpy)(void*, const void*, size_t) = memcpy;
+static void* (*volatile _memset)(void*, int, size_t) = memset;
+static int (*volatile _memcmp)(const void*, const void*, size_t) = memcmp;
+static size_t (*volatile _strlen)(const char*) = strlen;
+
+/* Filled with patterns that the compiler does not turn into calls to the
+ * routines under test */
+static unsigned char _src[BUFFER_SIZE];
+static unsigned char _dest[BUFFER_SIZE];
+static char _page[2 * PAGE_SIZE] __attribute__((aligned(PAGE_SIZE)));
+
+static size_t _get_size(size_t i)
+{
+    return i < 300 ? i : _large_sizes[i - 300];
+}
+
+static size_t _num_sizes(void)
+{
+    return 300 + OE_COUNTOF(_large_sizes);
+}
+
+static unsigned char _pattern(unsigned char seed, size_t i)
+{
+    return (unsigned char)(seed + i * 7 + (i >> 8));
+}
+
+static void _fill(unsigned char* p, size_t n, unsigned char seed)
+{
+    for (size_t i = 0; i < n; i++)
+        p[i] = _pattern(seed, i);
+}
+
+static void _test_memcpy(void)
+{
+    _fill(_src, BUFFER_SIZE, 1);
+
+    for (size_t k = 0; k < _num_sizes(); k++)
+    {
+        const size_t n = _get_size(k);
+
+        for (size_t so = 0; so < MAX_OFFSET; so++)
+        {
+            for (size_t d = 0; d < MAX_OFFSET; d++)
+            {
+                _fill(_dest, d + n + GUARD_SIZE, 0x80);
+
+                OE_TEST(_memcpy(_dest + d, _src + so, n) == _dest + d);
+
+                for (size_t i = 0; i < d; i++)
+                    OE_TEST(_dest[i] == _pattern(0x80, i));
+
+                for (size_t i = 0; i < n; i++)
+                    OE_TEST(_dest[d + i] == _src[so + i]);
+
+                for (size_t i = d + n; i < d + n + GUARD_SIZE; i++)
+                    OE_TEST(_dest[i] == _pattern(0x80, i));
+            }
+        }
+    }
+}
+
+static void _test_memset(void)
+{
+    /* Only the low byte of the value is used */
+    static const int values[] = {0, 0xA5, 0x17F};
+
+    for (size_t v = 0; v < OE_COUNTOF(values); v++)
+    {
+        const unsigned char c = (unsigned char)values[v];
+
+        for (size_t k = 0; k < _num_sizes(); k++)
+        {
+            const size_t n = _get_size(k);
+
+            for (size_t d = 0; d < MAX_OFFSET; d++)
+            {
+                _fill(_dest, d + n + GUARD_SIZE, 0x40);
+
+                OE_TEST(_memset(_dest + d, values[v], n) == _dest + d);
+
+                for (size_t i = 0; i < d; i++)
+                    OE_TEST(_dest[i] == _pattern(0x40, i));
+
+                for (size_t i = 0; i < n; i++)
+                    OE_TEST(_dest[d + i] == c);
+
+                for (size_t i = d + n; i < d + n + GUARD_SIZE; i++)
+                    OE_TEST(_dest[i] == _pattern(0x40, i));
+            }
+        }
+    }
+}
+
+static int _sign(int x)
+{
+    return (x > 0) - (x < 0);
+}
+
+/* Compare N bytes at the given offsets, with the first difference at POS
+ * (or none if POS >= N) */
+static void _check_memcmp(size_t lo, size_t ro, size_t n, size_t pos)
+{
+    unsigned char* l = _src + lo;
+    unsigned char* r = _dest + ro;
+
+    _fill(l, n + GUARD_SIZE, 5);
+    _fill(r, n + GUARD_SIZE, 5);
+
+    /* Differences past the end are not looked at */
+    l[n] = 1;
+    r[n] = 2;
+
+    if (pos >= n)
+    {
+        OE_TEST(_memcmp(l, r, n) == 0);
+        return;
+    }
+
+    /* Bytes compare as unsigned, and a later difference the other way
+     * must not change the result */
+    l[pos] = 0x80;
+    r[pos] = 0x7F;
+
+    if (pos + 1 < n)
+    {
+        l[n - 1] = 0x00;
+        r[n - 1] = 0xFF;
+    }
+
+    OE_TEST(_sign(_memcmp(l, r, n)) == 1);
+    OE_TEST(_sign(_memcmp(r, l, n)) == -1);
+}
+
+static void _test_memcmp(void)
+{
+    /* Sizes and first differences on both sides of the 16 and 32 byte
+     * vectors, and of the end of the AVX2 loop */
+    static const size_t sizes[] = {0,  1,  2,  15, 16, 17, 31,  32, 33,
+                                   47, 48, 63, 64, 65, 95, 96,  97, 127,
+                                   128, 129, 2047, 2048, 2049};
+    static const size_t positions[] = {
+        0, 1, 14, 15, 16, 17, 30, 31, 32, 33, 47, 63, 64, 65, 96, 127, 128};
+
+    for (size_t k = 0; k < OE_COUNTOF(sizes); k++)
+    {
+        const size_t n = sizes[k];
+
+        for (size_t lo = 0; lo < MAX_OFFSET; lo++)
+        {
+            for (size_t ro = 0; ro < MAX_OFFSET; ro++)
+            {
+                _check_memcmp(lo, ro, n, n);
+
+                for (size_t p = 0; p < OE_COUNTOF(positions); p++)
+                {
+                    if (positions[p] < n)
+                        _check_memcmp(lo, ro, n, positions[p]);
+                }
+
+                if (n)
+                    _check_memcmp(lo, ro, n, n - 1);
+            }
+        }
+    }
+}
+
+static void _test_strlen(void)
+{
+    /* Strings starting at each misalignment, and near the end of the first
+     * page, with the terminator at each offset up to the end of the page */
+    for (size_t i = 0; i < 2 * PAGE_SIZE; i++)
+        _page[i] = (char)('a' + (i & 7));
+
+    for (size_t k = 0; k < 2 * MAX_OFFSET; k++)
+    {
+        const size_t start =
+            k < MAX_OFFSET ? k : PAGE_SIZE - 2 * MAX_OFFSET + k;
+
+        for (size_t end = start; end < PAGE_SIZE; end++)
+        {
+            const char c = _page[end];
+
+            _page[end] = '\0';
+            OE_TEST(_strlen(_page + start) == end - start);
+            _page[end] = c;
+        }
+    }
+}
+
+int enc_test_memops(void)
+{
+    static const uint32_t paths[] = {0,
+                                     OE_MEMOPS_AVX2,
+                                     OE_MEMOPS_ERMS,
+                                     OE_MEMOPS_AVX2 | OE_MEMOPS_ERMS};
+    int num_tested = 0;
+
+    for (size_t i = 0; i < OE_COUNTOF(paths); i++)
+    {
+        if (oe_select_memops(paths[i]) != paths[i])
+        {
+            printf("memops path 0x%x is not supported\n", paths[i]);
+            continue;
+        }
+
+        _test_memcpy();
+        _test_memset();
+        _test_memcmp();
+        _test_strlen();
+
+        printf("memops path 0x%x passed\n", paths[i]);
+        num_tested++;
+    }
+
+    /* Back to all the supported paths */
+    oe_select_memops(OE_MEMOPS_AVX2 | OE_MEMOPS_ERMS);
+
+    return num_tested;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    128,  /* HeapPageCount */
+    64,   /* StackPageCount */
+    1);   /* TCSCount */
@@ -450,3 +450,15 @@ unsigned long long ecall_ret_unsigned_long_long()
 void ecall_ret_void()
 {
 }
+
+int ecall_batch_pointers(
+    int* p_in,
+    int* p_out,
+    int* p_in_out,
+    uint8_t* data,
+    size_t size)
+{
+    *p_out = *p_in + 1;
+    *p_in_out *= 2;
+    return (data && size) ? data[size - 1] : 0;
+}
@@ -98,6 +98,19 @@ int main(int argc, const char* argv[])
 
     test_deepcopy_edl_ecalls(enclave);
 
+    // Repeat some ECALLs with their marshalling buffers coming from malloc()
+    // only, then from a per-thread buffer too small for most of them.
+    OE_TEST(
+        oe_set_ecall_buffer_size(OE_MAX_ECALL_BUFFER_SIZE + 1) ==
+        OE_INVALID_PARAMETER);
+    OE_TEST(oe_set_ecall_buffer_size(0) == OE_OK);
+    test_basic_edl_ecalls(enclave);
+    test_deepcopy_edl_ecalls(enclave);
+    OE_TEST(oe_set_ecall_buffer_size(256) == OE_OK);
+    test_string_edl_ecalls(enclave);
+    test_deepcopy_edl_ecalls(enclave);
+    OE_TEST(oe_set_ecall_buffer_size(64 * 1024) == OE_OK);
+
     test_switchless_edl_ecalls(enclave);
     OE_TEST(test_switchless_edl_ocalls(enclave) == OE_OK);
 done:
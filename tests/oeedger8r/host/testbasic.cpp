@@ -6,6 +6,7 @@
 
 #include <openenclave/host.h>
 #include <openenclave/internal/tests.h>
+#include <stdlib.h>
 #include "all_u.h"
 
 void test_basic_edl_ecalls(oe_enclave_t* enclave)
@@ -52,6 +53,57 @@ void test_basic_edl_ecalls(oe_enclave_t* enclave)
         OE_TEST(ret == 555);
     }
 
+    {
+        ecall_ret_int_batch_call_t calls[3] = {};
+        OE_TEST(ecall_ret_int_batch(enclave, calls, 3) == OE_OK);
+        for (size_t i = 0; i < 3; i++)
+        {
+            OE_TEST(calls[i]._result == OE_OK);
+            OE_TEST(calls[i]._retval == 555);
+        }
+    }
+
+    {
+        /* The input of the second call does not fit in the enclave heap, so
+         * only that call fails */
+        const size_t big_size = 16 * 1024 * 1024;
+        uint8_t* big = (uint8_t*)calloc(1, big_size);
+        uint8_t small[] = {7};
+        int in[3] = {10, 20, 30};
+        int out[3] = {-1, -1, -1};
+        int in_out[3] = {1, 2, 3};
+        ecall_batch_pointers_batch_call_t calls[3] = {};
+
+        OE_TEST(big != NULL);
+        for (size_t i = 0; i < 3; i++)
+        {
+            calls[i].p_in = &in[i];
+            calls[i].p_out = &out[i];
+            calls[i].p_in_out = &in_out[i];
+            calls[i].data = small;
+            calls[i].size = sizeof(small);
+        }
+        calls[1].data = big;
+        calls[1].size = big_size;
+
+        OE_TEST(ecall_batch_pointers_batch(enclave, calls, 3) == OE_OK);
+
+        OE_TEST(calls[0]._result == OE_OK);
+        OE_TEST(calls[0]._retval == 7);
+        OE_TEST(out[0] == 11 && in_out[0] == 2);
+
+        OE_TEST(calls[1]._result == OE_OUT_OF_MEMORY);
+        OE_TEST(out[1] == -1 && in_out[1] == 2);
+
+        OE_TEST(calls[2]._result == OE_OK);
+        OE_TEST(calls[2]._retval == 7);
+        OE_TEST(out[2] == 31 && in_out[2] == 6);
+
+        /* Inputs are not written back */
+        OE_TEST(in[0] == 10 && in[1] == 20 && in[2] == 30);
+        free(big);
+    }
+
     {
         float ret = 0;
         OE_TEST(ecall_ret_float(enclave, &ret) == OE_OK);
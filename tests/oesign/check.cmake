@@ -0,0 +1,88 @@
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# Licensed under the MIT License.
+
+# Sign an enclave with each configuration, one by one and then together in a
+# batch (which reuses the measurement of the image prefix), and check that
+# both ways give the same MRENCLAVE.
+#
+# Usage: cmake -DOESIGN=<oesign> -DENCLAVE=<enclave> -DCONFIGS=<conf;...>
+#     -P check.cmake
+
+execute_process(
+    COMMAND openssl genrsa -out oesign_test.pem -3 3072
+    RESULT_VARIABLE result
+    OUTPUT_QUIET
+    ERROR_QUIET)
+
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "openssl genrsa failed: ${result}")
+endif ()
+
+function (get_mrenclave signed var)
+    execute_process(
+        COMMAND ${OESIGN} dump -e ${signed}
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output)
+
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "oesign dump ${signed} failed: ${result}")
+    endif ()
+
+    if (NOT output MATCHES "mrenclave=([0-9a-f]+)")
+        message(FATAL_ERROR "no mrenclave for ${signed}:\n${output}")
+    endif ()
+
+    set(${var} ${CMAKE_MATCH_1} PARENT_SCOPE)
+endfunction ()
+
+set(batch "")
+set(index 0)
+
+foreach (config ${CONFIGS})
+    execute_process(
+        COMMAND ${OESIGN} sign -e ${ENCLAVE} -c ${config} -k oesign_test.pem
+            -o single${index}.signed
+        RESULT_VARIABLE result)
+
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "oesign sign -c ${config} failed: ${result}")
+    endif ()
+
+    string(APPEND batch
+        "${ENCLAVE} ${config} oesign_test.pem batch${index}.signed\n")
+    math(EXPR index "${index} + 1")
+endforeach ()
+
+file(WRITE oesign_test.batch "${batch}")
+
+# One job at a time, so that the later configurations reuse the measurement
+# prefix saved by the first.
+execute_process(
+    COMMAND ${OESIGN} batch -b oesign_test.batch -j 1
+    RESULT_VARIABLE result)
+
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "oesign batch failed: ${result}")
+endif ()
+
+set(mrenclaves "")
+math(EXPR last "${index} - 1")
+
+foreach (i RANGE ${last})
+    get_mrenclave(single${i}.signed single)
+    get_mrenclave(batch${i}.signed batched)
+
+    if (NOT single STREQUAL batched)
+        message(FATAL_ERROR
+            "MRENCLAVE mismatch for configuration ${i}: "
+            "${single} (single) != ${batched} (batch)")
+    endif ()
+
+    list(FIND mrenclaves ${single} found)
+
+    if (NOT found EQUAL -1)
+        message(FATAL_ERROR "configuration ${i} did not change MRENCLAVE")
+    endif ()
+
+    list(APPEND mrenclaves ${single})
+endforeach ()
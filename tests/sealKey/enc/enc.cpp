@@ -533,10 +533,90 @@ bool TestAsymKey()
     return true;
 }
 
+// Keys served from the enclave key cache must match the ones derived again
+// after they are evicted.
+bool TestKeyCacheCase(
+    oe_seal_policy_t seal_policy,
+    const oe_asymmetric_key_params_t* params)
+{
+    bool passed = false;
+    uint8_t* seal_key[3] = {NULL};
+    size_t seal_key_size[3] = {0};
+    uint8_t* privkey[3] = {NULL};
+    size_t privkey_size[3] = {0};
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        // The first iteration fills the cache, the second one hits it
+        // and the last one runs after eviction.
+        if (i == 2 && oe_evict_cached_keys_by_policy(seal_policy) != OE_OK)
+            goto done;
+
+        if (oe_get_seal_key_by_policy(
+                seal_policy, &seal_key[i], &seal_key_size[i], NULL, NULL) !=
+            OE_OK)
+            goto done;
+
+        if (oe_get_private_key_by_policy(
+                seal_policy,
+                params,
+                &privkey[i],
+                &privkey_size[i],
+                NULL,
+                NULL) != OE_OK)
+            goto done;
+
+        if (i > 0 &&
+            (seal_key_size[i] != seal_key_size[0] ||
+             memcmp(seal_key[i], seal_key[0], seal_key_size[0]) != 0 ||
+             privkey_size[i] != privkey_size[0] ||
+             memcmp(privkey[i], privkey[0], privkey_size[0]) != 0))
+            goto done;
+    }
+
+    passed = true;
+
+done:
+    for (size_t i = 0; i < 3; i++)
+    {
+        oe_free_seal_key(seal_key[i], NULL);
+        oe_free_key(privkey[i], privkey_size[i], NULL, 0);
+    }
+
+    return passed;
+}
+
+bool TestKeyCache()
+{
+    oe_asymmetric_key_params_t params;
+    char data[] = "Key cache";
+    bool passed = true;
+
+    params.type = OE_ASYMMETRIC_KEY_EC_SECP256P1;
+    params.format = OE_ASYMMETRIC_KEY_PEM;
+    params.user_data = data;
+    params.user_data_size = sizeof(data) - 1;
+
+    if (oe_evict_cached_keys_by_policy(_OE_SEAL_POLICY_MAX) !=
+        OE_INVALID_PARAMETER)
+        return false;
+
+    for (uint32_t seal_policy = OE_SEAL_POLICY_UNIQUE;
+         passed && seal_policy <= OE_SEAL_POLICY_PRODUCT;
+         seal_policy++)
+    {
+        passed = TestKeyCacheCase((oe_seal_policy_t)seal_policy, &params);
+    }
+
+    oe_evict_cached_keys();
+
+    return passed;
+}
+
 int test_seal_key(int in)
 {
     if (TestOEGetPrivilegeKeys() && TestOEGetRegularKeys() &&
-        TestOEGetSealKey() && TestAsymKey())
+        TestOEGetSealKey() && TestAsymKey() && TestKeyCache())
     {
         return 0;
     }
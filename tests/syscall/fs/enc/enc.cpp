@@ -6,6 +6,7 @@
 #include <openenclave/enclave.h>
 #include <openenclave/internal/print.h>
 #include <openenclave/internal/syscall/device.h>
+#include <openenclave/internal/syscall/sys/sendfile.h>
 #include <openenclave/internal/syscall/unistd.h>
 #include <openenclave/internal/tests.h>
 #include <stdio.h>
@@ -485,6 +486,100 @@ void test_zero_sized_iovs(void)
     OE_TEST(oe_readv(OE_STDIN_FILENO, &iov, 0) == 0);
 }
 
+static void test_positional_io(const char* tmp_dir)
+{
+    char path[OE_PATH_MAX];
+    char buf[sizeof(ALPHABET)];
+    char a[3];
+    char b[4];
+    struct oe_iovec iov[2] = {{a, sizeof(a)}, {b, sizeof(b)}};
+    int fd;
+
+    printf("--- %s()\n", __FUNCTION__);
+
+    mkpath(path, tmp_dir, "positional");
+    fd = oe_open_d(
+        OE_DEVID_HOST_FILE_SYSTEM,
+        path,
+        OE_O_CREAT | OE_O_TRUNC | OE_O_RDWR,
+        MODE);
+    OE_TEST(fd >= 0);
+
+    /* Write out of order without moving the file offset. */
+    OE_TEST(oe_pwrite(fd, ALPHABET + 13, 13, 13) == 13);
+    OE_TEST(oe_pwrite(fd, ALPHABET, 13, 0) == 13);
+    OE_TEST(oe_lseek(fd, 0, OE_SEEK_CUR) == 0);
+
+    /* Read "lmnop" */
+    OE_TEST(oe_pread(fd, buf, 5, 11) == 5);
+    OE_TEST(memcmp(buf, "lmnop", 5) == 0);
+
+    /* Scatter "defghij" */
+    OE_TEST(oe_preadv(fd, iov, 2, 3) == 7);
+    OE_TEST(memcmp(a, "def", 3) == 0);
+    OE_TEST(memcmp(b, "ghij", 4) == 0);
+
+    /* Gather "defghij" over "vwxyz" and past the end of the file. */
+    OE_TEST(oe_pwritev(fd, iov, 2, 21) == 7);
+    OE_TEST(oe_pread(fd, buf, sizeof(buf), 0) == 28);
+    OE_TEST(memcmp(buf, "abcdefghijklmnopqrstu", 21) == 0);
+    OE_TEST(memcmp(buf + 21, "defghij", 7) == 0);
+    OE_TEST(oe_pread(fd, buf, sizeof(buf), 28) == 0);
+
+    OE_TEST(oe_pread(fd, buf, 1, -1) == -1);
+    OE_TEST(oe_errno == OE_EINVAL);
+    OE_TEST(oe_close(fd) == 0);
+
+    /* The standard streams cannot seek. */
+    OE_TEST(oe_pwrite(OE_STDOUT_FILENO, "x", 1, 0) == -1);
+    OE_TEST(oe_errno == OE_ESPIPE);
+
+    OE_TEST(oe_unlink_d(OE_DEVID_HOST_FILE_SYSTEM, path) == 0);
+}
+
+static void test_host_copy(const char* tmp_dir)
+{
+    char src[OE_PATH_MAX];
+    char dest[OE_PATH_MAX];
+    char buf[sizeof(ALPHABET)];
+    oe_off_t off_in = 13;
+    oe_off_t off_out = 0;
+    int in;
+    int out;
+
+    printf("--- %s()\n", __FUNCTION__);
+
+    mkpath(src, tmp_dir, "copy_src");
+    mkpath(dest, tmp_dir, "copy_dest");
+
+    const uint64_t devid = OE_DEVID_HOST_FILE_SYSTEM;
+    const int flags = OE_O_CREAT | OE_O_TRUNC | OE_O_RDWR;
+    OE_TEST((in = oe_open_d(devid, src, flags, MODE)) >= 0);
+    OE_TEST((out = oe_open_d(devid, dest, flags, MODE)) >= 0);
+    OE_TEST(oe_write(in, ALPHABET, 26) == 26);
+
+    /* Copy "nopqrstuvwxyz" without touching the file offsets. */
+    OE_TEST(oe_copy_file_range(in, &off_in, out, &off_out, 13, 0) == 13);
+    OE_TEST(off_in == 26 && off_out == 13);
+    OE_TEST(oe_lseek(out, 0, OE_SEEK_CUR) == 0);
+    OE_TEST(oe_copy_file_range(in, &off_in, out, &off_out, 13, 1) == -1);
+    OE_TEST(oe_errno == OE_EINVAL);
+
+    /* Append "abcdefghijklm" from the file offset of the input. */
+    OE_TEST(oe_lseek(in, 0, OE_SEEK_SET) == 0);
+    OE_TEST(oe_lseek(out, 13, OE_SEEK_SET) == 13);
+    OE_TEST(oe_sendfile(out, in, NULL, 13) == 13);
+    OE_TEST(oe_lseek(in, 0, OE_SEEK_CUR) == 13);
+
+    OE_TEST(oe_pread(out, buf, sizeof(buf), 0) == 26);
+    OE_TEST(memcmp(buf, "nopqrstuvwxyzabcdefghijklm", 26) == 0);
+
+    OE_TEST(oe_close(in) == 0);
+    OE_TEST(oe_close(out) == 0);
+    OE_TEST(oe_unlink_d(devid, src) == 0);
+    OE_TEST(oe_unlink_d(devid, dest) == 0);
+}
+
 extern "C" void test_dup_case1(const char* tmp_dir)
 {
     FILE* stream;
@@ -538,6 +633,188 @@ extern "C" void test_dup_case2(const char* tmp_dir)
     OE_TEST(umount("/") == 0);
 }
 
+static void test_ram_file_system(void)
+{
+    const int flags = OE_O_CREAT | OE_O_TRUNC | OE_O_RDWR;
+    char buf[2 * OE_PAGE_SIZE];
+    static const char zeros[sizeof(buf)];
+    struct oe_stat st;
+    ssize_t n;
+    size_t total = 0;
+    int fd;
+
+    printf("--- %s()\n", __FUNCTION__);
+
+    OE_TEST(oe_load_module_ram_file_system() == OE_OK);
+    OE_TEST(oe_mount("/", "/", OE_RAM_FILE_SYSTEM, 0, "size=64k") == 0);
+    OE_TEST((fd = oe_open("/file", flags, MODE)) >= 0);
+
+    /* A write past the end leaves a hole that reads as zeros. */
+    OE_TEST(oe_pwrite(fd, "x", 1, sizeof(buf)) == 1);
+    OE_TEST(oe_pread(fd, buf, sizeof(buf), 0) == sizeof(buf));
+    OE_TEST(memcmp(buf, zeros, sizeof(buf)) == 0);
+
+    /* Bytes cut off by truncate() read as zeros once the file grows. */
+    memset(buf, 'a', sizeof(buf));
+    OE_TEST(oe_pwrite(fd, buf, sizeof(buf), 0) == sizeof(buf));
+    OE_TEST(oe_truncate("/file", 1) == 0);
+    OE_TEST(oe_truncate("/file", sizeof(buf)) == 0);
+    OE_TEST(oe_pread(fd, buf, sizeof(buf), 0) == sizeof(buf));
+    OE_TEST(buf[0] == 'a');
+    OE_TEST(memcmp(buf + 1, zeros, sizeof(buf) - 1) == 0);
+
+    /* Writes fail once the size limit is reached. */
+    OE_TEST(oe_lseek(fd, 0, OE_SEEK_SET) == 0);
+
+    while ((n = oe_write(fd, buf, sizeof(buf))) > 0)
+        total += (size_t)n;
+
+    OE_TEST(n == -1 && oe_errno == OE_ENOSPC);
+    OE_TEST(total > 0 && total <= 64 * 1024);
+    OE_TEST(oe_stat("/file", &st) == 0);
+    OE_TEST(st.st_size == (oe_off_t)total);
+
+    /* An unlinked file keeps its data until it is closed. */
+    OE_TEST(oe_unlink("/file") == 0);
+    OE_TEST(oe_access("/file", OE_F_OK) != 0);
+    OE_TEST(oe_pread(fd, buf, 1, 0) == 1);
+    OE_TEST(buf[0] == 'a');
+    OE_TEST(oe_close(fd) == 0);
+
+    /* The files go away with the mount. */
+    OE_TEST(oe_mkdir("/dir", 0777) == 0);
+    OE_TEST(oe_umount("/") == 0);
+    OE_TEST(oe_mount("/", "/", OE_RAM_FILE_SYSTEM, 0, NULL) == 0);
+    OE_TEST(oe_access("/dir", OE_F_OK) != 0);
+    OE_TEST(oe_umount("/") == 0);
+
+    /* Malformed mount data is rejected. */
+    OE_TEST(oe_mount("/", "/", OE_RAM_FILE_SYSTEM, 0, "size=1x") == -1);
+    OE_TEST(oe_errno == OE_EINVAL);
+}
+
+/* Check that sizes and contents survive closing and reopening a protected
+ * file, for a new file and for appends to an existing one. */
+static void _test_sgx_file_system_reopen(const char* tmp_dir)
+{
+    const int flags = OE_O_CREAT | OE_O_TRUNC | OE_O_WRONLY;
+    static const char DATA1[] = "first";
+    static const char DATA2[] = "second";
+    const size_t n1 = sizeof(DATA1) - 1;
+    const size_t n2 = sizeof(DATA2) - 1;
+    char path[OE_PATH_MAX];
+    char buf[32];
+    struct oe_stat st;
+    int fd;
+
+    printf("--- %s()\n", __FUNCTION__);
+
+    mkpath(path, tmp_dir, "reopened");
+
+    OE_TEST(oe_mount("/", "/", OE_SGX_FILE_SYSTEM, 0, NULL) == 0);
+
+    OE_TEST((fd = oe_open(path, flags, MODE)) >= 0);
+    OE_TEST(oe_write(fd, DATA1, n1) == (ssize_t)n1);
+    OE_TEST(oe_close(fd) == 0);
+
+    OE_TEST(oe_stat(path, &st) == 0);
+    OE_TEST(st.st_size == (oe_off_t)n1);
+
+    OE_TEST((fd = oe_open(path, OE_O_RDONLY, 0)) >= 0);
+    OE_TEST(oe_read(fd, buf, sizeof(buf)) == (ssize_t)n1);
+    OE_TEST(memcmp(buf, DATA1, n1) == 0);
+    OE_TEST(oe_close(fd) == 0);
+
+    OE_TEST((fd = oe_open(path, OE_O_WRONLY | OE_O_APPEND, 0)) >= 0);
+    OE_TEST(oe_write(fd, DATA2, n2) == (ssize_t)n2);
+    OE_TEST(oe_close(fd) == 0);
+
+    OE_TEST((fd = oe_open(path, OE_O_RDONLY, 0)) >= 0);
+    OE_TEST(oe_read(fd, buf, sizeof(buf)) == (ssize_t)(n1 + n2));
+    OE_TEST(memcmp(buf, DATA1, n1) == 0);
+    OE_TEST(memcmp(buf + n1, DATA2, n2) == 0);
+    OE_TEST(oe_close(fd) == 0);
+
+    OE_TEST(oe_unlink(path) == 0);
+    OE_TEST(oe_umount("/") == 0);
+}
+
+static void test_sgx_file_system(const char* tmp_dir)
+{
+    const uint64_t devid = OE_DEVID_HOST_FILE_SYSTEM;
+    const int flags = OE_O_CREAT | OE_O_TRUNC | OE_O_RDWR;
+    const size_t num_blocks = 100;
+    const oe_off_t size = (oe_off_t)(num_blocks * OE_PAGE_SIZE);
+    char path[OE_PATH_MAX];
+    char buf[OE_PAGE_SIZE];
+    char byte;
+    struct oe_stat st;
+    int fd;
+
+    printf("--- %s()\n", __FUNCTION__);
+
+    mkpath(path, tmp_dir, "protected");
+
+    OE_TEST(oe_load_module_sgx_file_system() == OE_OK);
+    OE_TEST(oe_mount("/", "/", OE_SGX_FILE_SYSTEM, 0, NULL) == 0);
+
+    /* Write more blocks than are cached, and than one MHT node covers. */
+    OE_TEST((fd = oe_open(path, flags, MODE)) >= 0);
+
+    for (size_t i = 0; i < num_blocks; i++)
+    {
+        memset(buf, 'a' + (int)(i % 26), sizeof(buf));
+        OE_TEST(oe_write(fd, buf, sizeof(buf)) == sizeof(buf));
+    }
+
+    OE_TEST(oe_close(fd) == 0);
+    OE_TEST(oe_stat(path, &st) == 0);
+    OE_TEST(st.st_size == size);
+
+    /* Read it back sequentially, which prefetches. */
+    OE_TEST((fd = oe_open(path, OE_O_RDONLY, 0)) >= 0);
+
+    for (size_t i = 0; i < num_blocks; i++)
+    {
+        OE_TEST(oe_read(fd, buf, sizeof(buf)) == sizeof(buf));
+        OE_TEST(buf[0] == 'a' + (int)(i % 26));
+        OE_TEST(buf[sizeof(buf) - 1] == buf[0]);
+    }
+
+    OE_TEST(oe_read(fd, buf, sizeof(buf)) == 0);
+    OE_TEST(oe_close(fd) == 0);
+
+    /* The host sees neither the contents nor their size. The first data
+     * block follows the header and the first MHT node. */
+    OE_TEST((fd = oe_open_d(devid, path, OE_O_RDWR, 0)) >= 0);
+    OE_TEST(oe_lseek(fd, 0, OE_SEEK_END) > size);
+    OE_TEST(oe_pread(fd, buf, sizeof(buf), 2 * OE_PAGE_SIZE) == sizeof(buf));
+    OE_TEST(buf[0] != 'a' || buf[1] != 'a' || buf[2] != 'a' || buf[3] != 'a');
+
+    /* Corrupt the first data block. */
+    OE_TEST(oe_pread(fd, &byte, 1, 2 * OE_PAGE_SIZE + 10) == 1);
+    byte ^= 1;
+    OE_TEST(oe_pwrite(fd, &byte, 1, 2 * OE_PAGE_SIZE + 10) == 1);
+    OE_TEST(oe_close(fd) == 0);
+
+    /* The corrupt block fails to read, and the others still read. */
+    OE_TEST((fd = oe_open(path, OE_O_RDONLY, 0)) >= 0);
+    OE_TEST(oe_pread(fd, buf, 1, 10) == -1);
+    OE_TEST(oe_errno == OE_EIO);
+    OE_TEST(oe_pread(fd, buf, 1, OE_PAGE_SIZE) == 1);
+    OE_TEST(buf[0] == 'b');
+    OE_TEST(oe_close(fd) == 0);
+
+    OE_TEST(oe_unlink(path) == 0);
+    OE_TEST(oe_umount("/") == 0);
+
+    /* Malformed mount data is rejected. */
+    OE_TEST(oe_mount("/", "/", OE_SGX_FILE_SYSTEM, 0, "policy=x") == -1);
+    OE_TEST(oe_errno == OE_EINVAL);
+
+    _test_sgx_file_system_reopen(tmp_dir);
+}
+
 void test_fs(const char* src_dir, const char* tmp_dir)
 {
     (void)src_dir;
@@ -561,6 +838,14 @@ void test_fs(const char* src_dir, const char* tmp_dir)
         test_all(fs, tmp_dir);
     }
 
+    /* Test the RAMFS oe file descriptor interfaces. */
+    {
+        printf("=== testing oe-fd-ramfs:\n");
+
+        oe_fd_ramfs_file_system fs(tmp_dir);
+        test_all(fs, tmp_dir);
+    }
+
 #if defined(TEST_SGXFS)
     /* Test the SGXFS oe file descriptor interfaces. */
     {
@@ -659,6 +944,14 @@ void test_fs(const char* src_dir, const char* tmp_dir)
 
     test_zero_sized_iovs();
 
+    test_positional_io(tmp_dir);
+
+    test_host_copy(tmp_dir);
+
+    test_ram_file_system();
+
+    test_sgx_file_system(tmp_dir);
+
     /* Note: these must come last since they change STDOUT and STDERR. */
     test_dup_case1(tmp_dir);
     test_dup_case2(tmp_dir);
@@ -11,6 +11,7 @@
 #include <openenclave/corelibc/errno.h>
 #include <openenclave/corelibc/stdio.h>
 #include <openenclave/corelibc/stdlib.h>
+#include <openenclave/corelibc/string.h>
 #include <openenclave/enclave.h>
 #include <openenclave/internal/syscall/dirent.h>
 #include <openenclave/internal/syscall/fcntl.h>
@@ -132,6 +133,39 @@ class oe_fd_hostfs_file_system : public oe_fd_file_system
     }
 };
 
+class oe_fd_ramfs_file_system : public oe_fd_file_system
+{
+  public:
+    oe_fd_ramfs_file_system(const char* tmp_dir)
+    {
+        char path[OE_PATH_MAX];
+
+        OE_TEST(oe_load_module_ram_file_system() == OE_OK);
+        OE_TEST(
+            oe_mount("/", "/", OE_DEVICE_NAME_RAM_FILE_SYSTEM, 0, NULL) == 0);
+
+        /* The file system starts out empty, so create tmp_dir. */
+        oe_strlcpy(path, tmp_dir, sizeof(path));
+
+        for (char* p = path + 1; *p; p++)
+        {
+            if (*p == '/')
+            {
+                *p = '\0';
+                OE_TEST(oe_mkdir(path, 0777) == 0);
+                *p = '/';
+            }
+        }
+
+        OE_TEST(oe_mkdir(path, 0777) == 0);
+    }
+
+    ~oe_fd_ramfs_file_system()
+    {
+        OE_TEST(oe_umount("/") == 0);
+    }
+};
+
 #if defined(TEST_SGXFS)
 class oe_fd_sgxfs_file_system : public oe_fd_file_system
 {
@@ -0,0 +1,314 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#define _GNU_SOURCE
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/tests.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "pipe_test_t.h"
+
+static void _test_eventfd(void)
+{
+    int fd;
+    eventfd_t value;
+
+    OE_TEST((fd = eventfd(3, EFD_NONBLOCK)) >= 0);
+
+    OE_TEST(eventfd_read(fd, &value) == 0);
+    OE_TEST(value == 3);
+
+    OE_TEST(eventfd_read(fd, &value) == -1);
+    OE_TEST(errno == EAGAIN);
+
+    OE_TEST(eventfd_write(fd, 2) == 0);
+    OE_TEST(eventfd_write(fd, 5) == 0);
+    OE_TEST(eventfd_read(fd, &value) == 0);
+    OE_TEST(value == 7);
+
+    /* The counter cannot exceed 0xfffffffffffffffe. */
+    OE_TEST(eventfd_write(fd, UINT64_MAX) == -1);
+    OE_TEST(errno == EINVAL);
+
+    OE_TEST(close(fd) == 0);
+
+    /* A semaphore eventfd counts down by one. */
+    OE_TEST((fd = eventfd(2, EFD_SEMAPHORE | EFD_NONBLOCK)) >= 0);
+    OE_TEST(eventfd_read(fd, &value) == 0);
+    OE_TEST(value == 1);
+    OE_TEST(eventfd_read(fd, &value) == 0);
+    OE_TEST(value == 1);
+    OE_TEST(eventfd_read(fd, &value) == -1);
+    OE_TEST(errno == EAGAIN);
+    OE_TEST(close(fd) == 0);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+static void _test_pipe(void)
+{
+    int fds[2];
+    char buf[64];
+    size_t total = 0;
+
+    OE_TEST(pipe(fds) == 0);
+    OE_TEST(write(fds[1], "hello", 5) == 5);
+    OE_TEST(read(fds[0], buf, sizeof(buf)) == 5);
+    OE_TEST(memcmp(buf, "hello", 5) == 0);
+
+    /* Only one end can be read, and only the other written. */
+    OE_TEST(write(fds[0], "x", 1) == -1);
+    OE_TEST(errno == EBADF);
+    OE_TEST(read(fds[1], buf, 1) == -1);
+    OE_TEST(errno == EBADF);
+
+    /* Readers see the end of the file after the last writer closes. */
+    OE_TEST(write(fds[1], "bye", 3) == 3);
+    OE_TEST(close(fds[1]) == 0);
+    OE_TEST(read(fds[0], buf, sizeof(buf)) == 3);
+    OE_TEST(read(fds[0], buf, sizeof(buf)) == 0);
+    OE_TEST(close(fds[0]) == 0);
+
+    /* Writers get EPIPE after the last reader closes. */
+    OE_TEST(pipe(fds) == 0);
+    OE_TEST(close(fds[0]) == 0);
+    OE_TEST(write(fds[1], "x", 1) == -1);
+    OE_TEST(errno == EPIPE);
+    OE_TEST(close(fds[1]) == 0);
+
+    /* A nonblocking pipe fills up. */
+    OE_TEST(pipe2(fds, O_NONBLOCK) == 0);
+    OE_TEST(fcntl(fds[0], F_GETFL) & O_NONBLOCK);
+    OE_TEST(read(fds[0], buf, sizeof(buf)) == -1);
+    OE_TEST(errno == EAGAIN);
+
+    for (;;)
+    {
+        ssize_t n;
+
+        memset(buf, 'p', sizeof(buf));
+
+        if ((n = write(fds[1], buf, sizeof(buf))) == -1)
+        {
+            OE_TEST(errno == EAGAIN);
+            break;
+        }
+
+        total += (size_t)n;
+    }
+
+    OE_TEST(total == 64 * 1024);
+    OE_TEST(close(fds[0]) == 0);
+    OE_TEST(close(fds[1]) == 0);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+static void _test_poll(void)
+{
+    int efd;
+    int sv[2];
+    struct pollfd fds[2];
+
+    OE_TEST((efd = eventfd(0, 0)) >= 0);
+    OE_TEST(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+
+    fds[0].fd = efd;
+    fds[0].events = POLLIN;
+    fds[1].fd = sv[0];
+    fds[1].events = POLLIN;
+
+    OE_TEST(poll(fds, 2, 0) == 0);
+    OE_TEST(poll(fds, 2, 10) == 0);
+
+    /* Poll the eventfd alone, which needs no host poll. */
+    OE_TEST(eventfd_write(efd, 1) == 0);
+    OE_TEST(poll(fds, 1, -1) == 1);
+    OE_TEST(fds[0].revents == POLLIN);
+
+    OE_TEST(poll(fds, 2, -1) == 1);
+    OE_TEST(fds[0].revents == POLLIN);
+    OE_TEST(fds[1].revents == 0);
+
+    OE_TEST(write(sv[1], "x", 1) == 1);
+    OE_TEST(poll(fds, 2, -1) == 2);
+    OE_TEST(fds[0].revents == POLLIN);
+    OE_TEST(fds[1].revents == POLLIN);
+
+    OE_TEST(close(sv[0]) == 0);
+    OE_TEST(close(sv[1]) == 0);
+    OE_TEST(close(efd) == 0);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+static void _test_epoll(void)
+{
+    int epfd;
+    int efd;
+    int sv[2];
+    struct epoll_event event;
+    struct epoll_event events[4];
+
+    OE_TEST((epfd = epoll_create1(0)) >= 0);
+    OE_TEST((efd = eventfd(0, EFD_NONBLOCK)) >= 0);
+    OE_TEST(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+
+    event.events = EPOLLIN;
+    event.data.u64 = 42;
+    OE_TEST(epoll_ctl(epfd, EPOLL_CTL_ADD, efd, &event) == 0);
+    OE_TEST(epoll_ctl(epfd, EPOLL_CTL_ADD, efd, &event) == -1);
+    OE_TEST(errno == EEXIST);
+
+    event.data.u64 = 7;
+    OE_TEST(epoll_ctl(epfd, EPOLL_CTL_ADD, sv[0], &event) == 0);
+
+    OE_TEST(epoll_wait(epfd, events, 4, 0) == 0);
+    OE_TEST(epoll_wait(epfd, events, 4, 10) == 0);
+
+    OE_TEST(eventfd_write(efd, 1) == 0);
+    OE_TEST(epoll_wait(epfd, events, 4, -1) >= 1);
+    OE_TEST(events[0].events == EPOLLIN);
+    OE_TEST(events[0].data.u64 == 42);
+
+    /* Both kinds of files are reported. */
+    OE_TEST(write(sv[1], "x", 1) == 1);
+
+    for (int i = 0; i < 2; i++)
+    {
+        int n;
+        bool found = false;
+
+        OE_TEST((n = epoll_wait(epfd, events, 4, -1)) >= 1);
+
+        for (int j = 0; j < n; j++)
+            found = found || events[j].data.u64 == 7;
+
+        if (found)
+            break;
+
+        OE_TEST(i == 0);
+    }
+
+    /* A oneshot file fires once until it is modified. */
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = 42;
+    OE_TEST(epoll_ctl(epfd, EPOLL_CTL_DEL, sv[0], NULL) == 0);
+    OE_TEST(epoll_ctl(epfd, EPOLL_CTL_MOD, efd, &event) == 0);
+    OE_TEST(epoll_wait(epfd, events, 4, 0) == 1);
+    OE_TEST(epoll_wait(epfd, events, 4, 0) == 0);
+    OE_TEST(epoll_ctl(epfd, EPOLL_CTL_MOD, efd, &event) == 0);
+    OE_TEST(epoll_wait(epfd, events, 4, 0) == 1);
+
+    OE_TEST(epoll_ctl(epfd, EPOLL_CTL_DEL, efd, NULL) == 0);
+    OE_TEST(epoll_ctl(epfd, EPOLL_CTL_DEL, efd, NULL) == -1);
+    OE_TEST(errno == ENOENT);
+
+    OE_TEST(close(sv[0]) == 0);
+    OE_TEST(close(sv[1]) == 0);
+    OE_TEST(close(efd) == 0);
+    OE_TEST(close(epfd) == 0);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+#define NUM_MESSAGES 1000
+
+/* Larger than the pipe, so that a blocking write must wait for the reader. */
+static char _buf[128 * 1024];
+
+static void* _writer(void* arg)
+{
+    const int* fds = (const int*)arg;
+
+    for (uint32_t i = 0; i < NUM_MESSAGES; i++)
+        OE_TEST(write(fds[1], &i, sizeof(i)) == sizeof(i));
+
+    /* Wake the poll() of the main thread. */
+    OE_TEST(eventfd_write(fds[2], 1) == 0);
+
+    memset(_buf, 'w', sizeof(_buf));
+    OE_TEST(write(fds[1], _buf, sizeof(_buf)) == sizeof(_buf));
+    OE_TEST(close(fds[1]) == 0);
+
+    return NULL;
+}
+
+static void _test_threads(void)
+{
+    int fds[3];
+    pthread_t thread;
+    struct pollfd pfd;
+    eventfd_t value;
+    char buf[4096];
+    size_t total = 0;
+    ssize_t n;
+
+    OE_TEST(pipe(fds) == 0);
+    OE_TEST((fds[2] = eventfd(0, 0)) >= 0);
+
+    OE_TEST(pthread_create(&thread, NULL, _writer, fds) == 0);
+
+    /* Blocking reads wait for the writer. Messages are not split. */
+    for (uint32_t i = 0; i < NUM_MESSAGES; i++)
+    {
+        uint32_t m;
+
+        OE_TEST(read(fds[0], &m, sizeof(m)) == sizeof(m));
+        OE_TEST(m == i);
+    }
+
+    pfd.fd = fds[2];
+    pfd.events = POLLIN;
+    OE_TEST(poll(&pfd, 1, -1) == 1);
+    OE_TEST(eventfd_read(fds[2], &value) == 0);
+    OE_TEST(value == 1);
+
+    while ((n = read(fds[0], buf, sizeof(buf))) > 0)
+    {
+        for (ssize_t i = 0; i < n; i++)
+            OE_TEST(buf[i] == 'w');
+
+        total += (size_t)n;
+    }
+
+    OE_TEST(n == 0);
+    OE_TEST(total == sizeof(_buf));
+    OE_TEST(pthread_join(thread, NULL) == 0);
+
+    OE_TEST(close(fds[0]) == 0);
+    OE_TEST(close(fds[2]) == 0);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+void test_pipe(void)
+{
+    OE_TEST(oe_load_module_host_epoll() == OE_OK);
+    OE_TEST(oe_load_module_host_socket_interface() == OE_OK);
+
+    _test_eventfd();
+    _test_pipe();
+    _test_poll();
+    _test_epoll();
+    _test_threads();
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    1024, /* HeapPageCount */
+    256,  /* StackPageCount */
+    4);   /* TCSCount */
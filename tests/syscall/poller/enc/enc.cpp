@@ -1,10 +1,13 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <openenclave/corelibc/errno.h>
 #include <openenclave/corelibc/stdio.h>
 #include <openenclave/enclave.h>
+#include <openenclave/internal/syscall/sys/epoll.h>
 #include <openenclave/internal/syscall/sys/select.h>
 #include <openenclave/internal/syscall/sys/socket.h>
+#include <openenclave/internal/syscall/unistd.h>
 #include <openenclave/internal/tests.h>
 #include "../client.h"
 #include "../server.h"
@@ -324,6 +327,96 @@ extern "C" void test_fd_set(void)
     oe_printf("==== passed %s\n", __FUNCTION__);
 }
 
+extern "C" void test_epoll_wake(void)
+{
+    const size_t num_epolls = 100;
+    int epfds[num_epolls];
+    struct oe_epoll_event event;
+
+    _init();
+
+    /* Create more epoll instances than the host used to allow. */
+    for (size_t i = 0; i < num_epolls; i++)
+        OE_TEST((epfds[i] = oe_epoll_create1(0)) >= 0);
+
+    /* Only the epoll instance that was woken is interrupted. */
+    OE_TEST(oe_epoll_wake(epfds[num_epolls / 2]) == 0);
+    OE_TEST(oe_epoll_wait(epfds[num_epolls / 2 + 1], &event, 1, 0) == 0);
+    OE_TEST(oe_epoll_wait(epfds[num_epolls / 2], &event, 1, 0) == -1);
+    OE_TEST(oe_errno == OE_EINTR);
+    OE_TEST(oe_epoll_wait(epfds[num_epolls / 2], &event, 1, 0) == 0);
+
+    for (size_t i = 0; i < num_epolls; i++)
+        OE_TEST(oe_close(epfds[i]) == 0);
+
+    oe_printf("==== passed %s\n", __FUNCTION__);
+}
+
+extern "C" void test_epoll_defer_ctl(void)
+{
+    int epfd;
+    int sv[2];
+    struct oe_epoll_event event;
+    struct oe_epoll_event events[2];
+    const char c = 'x';
+
+    _init();
+
+    OE_TEST((epfd = oe_epoll_create1(OE_EPOLL_DEFER_CTL)) >= 0);
+    OE_TEST(oe_socketpair(OE_AF_LOCAL, OE_SOCK_STREAM, 0, sv) == 0);
+    OE_TEST(oe_write(sv[1], &c, sizeof(c)) == sizeof(c));
+
+    /* Changes are checked against the file descriptors already added. */
+    event.events = OE_EPOLLIN;
+    event.data.u64 = 1234;
+    OE_TEST(oe_epoll_ctl(epfd, OE_EPOLL_CTL_MOD, sv[0], &event) == -1);
+    OE_TEST(oe_errno == OE_ENOENT);
+    OE_TEST(oe_epoll_ctl(epfd, OE_EPOLL_CTL_ADD, sv[0], &event) == 0);
+    OE_TEST(oe_epoll_ctl(epfd, OE_EPOLL_CTL_ADD, sv[0], &event) == -1);
+    OE_TEST(oe_errno == OE_EEXIST);
+
+    /* The recorded change reaches the host with the wait. */
+    OE_TEST(oe_epoll_wait(epfd, &event, 1, 0) == 1);
+    OE_TEST(event.events & OE_EPOLLIN);
+    OE_TEST(event.data.u64 == 1234);
+
+    /* A delete followed by an add is sent as a modification. */
+    OE_TEST(oe_epoll_ctl(epfd, OE_EPOLL_CTL_DEL, sv[0], NULL) == 0);
+    event.data.u64 = 5678;
+    OE_TEST(oe_epoll_ctl(epfd, OE_EPOLL_CTL_ADD, sv[0], &event) == 0);
+    OE_TEST(oe_epoll_wait(epfd, &event, 1, 0) == 1);
+    OE_TEST(event.data.u64 == 5678);
+
+    /* An add followed by a delete is not sent at all. */
+    OE_TEST(oe_epoll_ctl(epfd, OE_EPOLL_CTL_ADD, sv[1], &event) == 0);
+    OE_TEST(oe_epoll_ctl(epfd, OE_EPOLL_CTL_DEL, sv[1], NULL) == 0);
+    OE_TEST(oe_epoll_wait(epfd, events, 2, 0) == 1);
+
+    event.events = OE_EPOLLOUT;
+    event.data.u64 = 42;
+    OE_TEST(oe_epoll_ctl(epfd, OE_EPOLL_CTL_ADD, sv[1], &event) == 0);
+    OE_TEST(oe_epoll_wait(epfd, events, 2, 0) == 2);
+
+    /* The host rejects modifications with OE_EPOLLEXCLUSIVE. The rejected
+     * change is reported as an error event and the file is dropped. */
+    event.events = OE_EPOLLOUT | OE_EPOLLEXCLUSIVE;
+    event.data.u64 = 43;
+    OE_TEST(oe_epoll_ctl(epfd, OE_EPOLL_CTL_MOD, sv[1], &event) == 0);
+    OE_TEST(oe_epoll_wait(epfd, events, 2, 0) == 2);
+    OE_TEST(events[0].data.u64 == 5678);
+    OE_TEST(events[1].events == OE_EPOLLERR);
+    OE_TEST(events[1].data.u64 == 43);
+    OE_TEST(oe_epoll_ctl(epfd, OE_EPOLL_CTL_DEL, sv[1], NULL) == -1);
+    OE_TEST(oe_errno == OE_ENOENT);
+
+    OE_TEST(oe_epoll_ctl(epfd, OE_EPOLL_CTL_DEL, sv[0], NULL) == 0);
+    OE_TEST(oe_close(sv[0]) == 0);
+    OE_TEST(oe_close(sv[1]) == 0);
+    OE_TEST(oe_close(epfd) == 0);
+
+    oe_printf("==== passed %s\n", __FUNCTION__);
+}
+
 OE_SET_ENCLAVE_SGX(
     1,    /* ProductID */
     1,    /* SecurityVersion */
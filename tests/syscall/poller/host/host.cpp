@@ -157,6 +157,10 @@ int main(int argc, const char* argv[])
 
     test_fd_set(_enclave);
 
+    test_epoll_wake(_enclave);
+
+    test_epoll_defer_ctl(_enclave);
+
     r = oe_terminate_enclave(_enclave);
     OE_TEST(r == OE_OK);
 
@@ -7,6 +7,7 @@
 #include <openenclave/internal/syscall/arpa/inet.h>
 #include <openenclave/internal/syscall/netdb.h>
 #include <openenclave/internal/syscall/netinet/in.h>
+#include <openenclave/internal/syscall/resolver.h>
 #include <openenclave/internal/tests.h>
 
 #include <resolver_test_t.h>
@@ -194,6 +195,77 @@ int ecall_getaddrinfo(struct addrinfo** res)
     return 0;
 }
 
+static bool _addrinfo_equal(
+    const struct oe_addrinfo* p,
+    const struct oe_addrinfo* q)
+{
+    for (; p && q; p = p->ai_next, q = q->ai_next)
+    {
+        if (p->ai_flags != q->ai_flags || p->ai_family != q->ai_family ||
+            p->ai_socktype != q->ai_socktype ||
+            p->ai_protocol != q->ai_protocol ||
+            p->ai_addrlen != q->ai_addrlen ||
+            memcmp(p->ai_addr, q->ai_addr, p->ai_addrlen) != 0)
+        {
+            return false;
+        }
+    }
+
+    return !p && !q;
+}
+
+int ecall_getaddrinfo_cache()
+{
+    struct oe_addrinfo* ai1 = NULL;
+    struct oe_addrinfo* ai2 = NULL;
+    struct oe_addrinfo* ai3 = NULL;
+    struct oe_addrinfo hints;
+    uint64_t hits;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    OE_TEST(oe_set_resolver_cache(16, 60 * 1000, 60 * 1000) == OE_OK);
+    hits = oe_get_resolver_cache_hits();
+
+    /* The second lookup is served by the cache. */
+    OE_TEST(oe_getaddrinfo("localhost", "telnet", &hints, &ai1) == 0);
+    OE_TEST(oe_get_resolver_cache_hits() == hits);
+    OE_TEST(oe_getaddrinfo("localhost", "telnet", &hints, &ai2) == 0);
+    OE_TEST(oe_get_resolver_cache_hits() == hits + 1);
+    OE_TEST(_addrinfo_equal(ai1, ai2));
+
+    /* Other hints are another entry. */
+    hints.ai_family = AF_INET;
+    OE_TEST(oe_getaddrinfo("localhost", "telnet", &hints, &ai3) == 0);
+    OE_TEST(oe_get_resolver_cache_hits() == hits + 1);
+
+    for (struct oe_addrinfo* p = ai3; p; p = p->ai_next)
+        OE_TEST(p->ai_family == AF_INET);
+
+    oe_freeaddrinfo(ai1);
+    oe_freeaddrinfo(ai2);
+    oe_freeaddrinfo(ai3);
+
+    /* Names that do not exist are cached too. */
+    {
+        const char name[] = "name.invalid";
+        int ret = oe_getaddrinfo(name, NULL, NULL, &ai1);
+
+        OE_TEST(ret != 0);
+        OE_TEST(oe_getaddrinfo(name, NULL, NULL, &ai1) == ret);
+        OE_TEST(ai1 == NULL);
+
+        if (ret == OE_EAI_NONAME || ret == OE_EAI_NODATA)
+            OE_TEST(oe_get_resolver_cache_hits() == hits + 2);
+    }
+
+    OE_TEST(oe_set_resolver_cache(0, 0, 0) == OE_OK);
+
+    return 0;
+}
+
 OE_SET_ENCLAVE_SGX(
     1,    /* ProductID */
     1,    /* SecurityVersion */
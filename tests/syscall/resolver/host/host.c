@@ -104,6 +104,9 @@ int main(int argc, const char* argv[])
         OE_TEST(found);
     }
 
+    OE_TEST(ecall_getaddrinfo_cache(client_enclave, &ret) == OE_OK);
+    OE_TEST(ret == 0);
+
     OE_TEST(
         ecall_getnameinfo(client_enclave, &ret, host, sizeof(host)) == OE_OK);
 
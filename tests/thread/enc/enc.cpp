@@ -301,6 +301,53 @@ size_t enc_tcs_used_thread_count()
     return g_tcs_used_thread_count;
 }
 
+// test_pthread_create
+static std::atomic<size_t> g_pthread_count;
+static pthread_t g_pthread_ids[16];
+
+static void* _pthread_start(void* arg)
+{
+    size_t index = (size_t)arg;
+
+    g_pthread_ids[index] = pthread_self();
+    g_pthread_count++;
+
+    return (void*)(index + 1);
+}
+
+void enc_test_pthread_create(size_t num_threads)
+{
+    pthread_t threads[OE_COUNTOF(g_pthread_ids)];
+    pthread_t detached;
+
+    OE_TEST(num_threads < OE_COUNTOF(g_pthread_ids));
+    g_pthread_count = 0;
+
+    for (size_t i = 0; i < num_threads; i++)
+        OE_TEST(
+            pthread_create(&threads[i], NULL, _pthread_start, (void*)i) == 0);
+
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        void* retval = NULL;
+
+        OE_TEST(pthread_join(threads[i], &retval) == 0);
+        OE_TEST(retval == (void*)(i + 1));
+        OE_TEST(pthread_equal(threads[i], g_pthread_ids[i]));
+    }
+
+    OE_TEST(g_pthread_count == num_threads);
+
+    // A detached thread frees its resources when it returns.
+    OE_TEST(
+        pthread_create(
+            &detached, NULL, _pthread_start, (void*)num_threads) == 0);
+    OE_TEST(pthread_detach(detached) == 0);
+
+    while (g_pthread_count != num_threads + 1)
+        host_usleep(1000);
+}
+
 OE_SET_ENCLAVE_SGX(
     1,    /* ProductID */
     1,    /* SecurityVersion */
@@ -318,6 +318,8 @@ int main(int argc, const char* argv[])
 
     test_readers_writer_lock(enclave);
 
+    OE_TEST(enc_test_pthread_create(enclave, 8) == OE_OK);
+
     test_tcs_exhaustion(enclave);
 
     if ((result = oe_terminate_enclave(enclave)) != OE_OK)
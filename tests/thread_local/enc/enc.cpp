@@ -6,6 +6,7 @@
 #include <openenclave/enclave.h>
 #include <openenclave/internal/tests.h>
 #include <stdio.h>
+#include <atomic>
 #include <random>
 #include <set>
 #include <thread>
@@ -17,6 +18,9 @@
 VISIBILITY_SPEC __thread volatile int __thread_int = 1;
 VISIBILITY_SPEC __thread volatile int g_x[10] = {8};
 
+// Number of times thread_local_struct was constructed.
+std::atomic<int> g_num_constructions(0);
+
 struct thread_local_struct
 {
     bool initialized;
@@ -26,6 +30,7 @@ struct thread_local_struct
     {
         value = v;
         initialized = true;
+        g_num_constructions++;
         printf("thread_local_struct initialized with value = %d\n", value);
     }
     ~thread_local_struct()
@@ -141,6 +146,12 @@ void enclave_thread(int thread_num, int iters, int step)
     OE_TEST(g_s.initialized);
     g_s.value += thread_num;
 
+#if defined(PERSISTENT_THREAD_LOCALS)
+    // The variables keep the values of the previous ECALL on this TCS.
+    __thread_int = 1;
+    thread_local_int = 5;
+#endif
+
     // Test that the thread local variables have expected value.
     volatile int thread_local_value1 = __thread_int;
     volatile int thread_local_value2 = thread_local_int;
@@ -175,6 +186,21 @@ void enclave_thread(int thread_num, int iters, int step)
     wait_for_test_completion();
 }
 
+int get_num_constructions()
+{
+    return g_num_constructions;
+}
+
+#if defined(PERSISTENT_THREAD_LOCALS)
+OE_SET_ENCLAVE_SGX_EX(
+    0,                                       /* ProductID */
+    0,                                       /* SecurityVersion */
+    true,                                    /* AllowDebug */
+    64,                                      /* HeapPageCount */
+    16,                                      /* StackPageCount */
+    16,                                      /* TCSCount */
+    OE_SGX_CONFIG_PERSISTENT_THREAD_LOCALS); /* Flags */
+#else
 OE_SET_ENCLAVE_SGX(
     0,    /* ProductID */
     0,    /* SecurityVersion */
@@ -182,3 +208,4 @@ OE_SET_ENCLAVE_SGX(
     64,   /* HeapPageCount */
     16,   /* StackPageCount */
     16);  /* TCSCount */
+#endif
@@ -31,17 +31,21 @@ int main(int argc, const char* argv[])
     oe_result_t result;
     oe_enclave_t* enclave = NULL;
 
-    if (((argc == 3) && strcmp(argv[2], "--exported-thread-locals")) ||
-        argc < 2)
+    bool exported = (argc == 3) && !strcmp(argv[2], "--exported-thread-locals");
+    bool persistent =
+        (argc == 3) && !strcmp(argv[2], "--persistent-thread-locals");
+
+    if (((argc == 3) && !exported && !persistent) || argc < 2)
     {
         fprintf(
             stderr,
-            "Usage: %s ENCLAVE_PATH [--exported-thread-locals]\n",
+            "Usage: %s ENCLAVE_PATH "
+            "[--exported-thread-locals | --persistent-thread-locals]\n",
             argv[0]);
         return 1;
     }
 
-    if (argc == 3)
+    if (exported)
     {
         // Ensure that the enclave has thread-local relocations.
         elf64_t elf = {0};
@@ -83,11 +87,11 @@ int main(int argc, const char* argv[])
              argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave)) != OE_OK)
         oe_put_err("oe_create_enclave(): result=%u", result);
 
+    const int num_threads = 16;
+
     // Run it twice to make sure the enclave thread is correctly reinitialized.
     for (int i = 0; i < 2; ++i)
     {
-        const int num_threads = 16;
-
         // Clear test data in the enclave.
         OE_TEST(prepare_for_test(enclave, num_threads) == OE_OK);
 
@@ -105,6 +109,18 @@ int main(int argc, const char* argv[])
         }
     }
 
+    // Thread-locals are constructed on every ECALL, unless they are kept
+    // across ECALLs, in which case they are constructed once per TCS. The
+    // threads of a run wait for each other in the enclave, so each run uses
+    // all the TCSs (the enclave has one per thread).
+    int num_constructions = 0;
+    OE_TEST(get_num_constructions(enclave, &num_constructions) == OE_OK);
+
+    if (persistent)
+        OE_TEST(num_constructions == num_threads);
+    else
+        OE_TEST(num_constructions == 2 * num_threads);
+
     result = oe_terminate_enclave(enclave);
     OE_TEST(result == OE_OK);
 
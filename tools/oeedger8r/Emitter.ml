@@ -794,7 +794,7 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
           (flatten_map (gen_ptr_count (arg :: args) param_count) members)
     else []
   in
-  let gen_ptr_array (plist : pdecl list) =
+  let gen_ptr_array (plist : pdecl list) (alloc_func : string) =
     let count =
       flatten_map (gen_ptr_count [] "1")
         (List.filter is_out_or_inout_ptr plist)
@@ -802,7 +802,7 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
     if count <> [] then
       (* TODO: Switch to malloc() to handle variable lengths. *)
       [ "size_t _ptrs_index = 0;"
-      ; sprintf "void** _ptrs = malloc(sizeof(void*) * (%s));"
+      ; sprintf "void** _ptrs = %s(sizeof(void*) * (%s));" alloc_func
           (String.concat " + " count)
       ; "if (_ptrs == NULL)"
       ; "{"
@@ -819,14 +819,51 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
     if count <> [] then "_ptrs_index = 0; /* For deep copy. */"
     else "/* No pointers to restore for deep copy. */"
   in
-  let gen_free_ptrs (plist : pdecl list) =
+  let gen_free_ptrs (plist : pdecl list) (free_func : string) =
     let count =
       flatten_map (gen_ptr_count [] "1")
         (List.filter is_out_or_inout_ptr plist)
     in
-    if count <> [] then ["if (_ptrs)"; "    free(_ptrs);"]
+    if count <> [] then ["if (_ptrs)"; sprintf "    %s(_ptrs);" free_func]
     else ["/* No `_ptrs` to free for deep copy. */"]
   in
+  (* ECALLs that get a batch variant (see [oe_gen_host_ecall_batch_wrapper]).
+     Array parameters and deep copies of out pointers are not supported. *)
+  let has_batch_variant (tf : trusted_func) =
+    let fd = tf.tf_fdecl in
+    (not tf.tf_is_switchless)
+    && List.for_all (fun (_, decl) -> not (is_array decl)) fd.plist
+    && flatten_map (gen_ptr_count [] "1")
+         (List.filter is_out_or_inout_ptr fd.plist)
+       = []
+  in
+  (* Indent the lines of [s] after the first by four more spaces. *)
+  let indent_continuation (s : string) =
+    let b = Buffer.create (String.length s) in
+    String.iter
+      (fun c ->
+        Buffer.add_char b c ;
+        if c = '\n' then Buffer.add_string b "    " )
+      s ;
+    Buffer.contents b
+  in
+  (* Generate the call struct and prototype of the batch variant. *)
+  let oe_gen_batch_prototype (fd : func_decl) =
+    [ sprintf "typedef struct _%s_batch_call" fd.fname
+    ; "{"
+    ; ( match fd.rtype with
+      | Void -> "    /* No return value. */"
+      | _ -> sprintf "    %s _retval;" (get_tystr fd.rtype) ) ]
+    @ List.map (fun p -> "    " ^ gen_parm_str p ^ ";") fd.plist
+    @ [ "    oe_result_t _result;"
+      ; sprintf "} %s_batch_call_t;" fd.fname
+      ; ""
+      ; sprintf "oe_result_t %s_batch(" fd.fname
+      ; "    oe_enclave_t* enclave,"
+      ; sprintf "    %s_batch_call_t* calls," fd.fname
+      ; "    size_t count);" ]
+    |> String.concat "\n"
+  in
   let oe_process_output_buffer (fd : func_decl) =
     let oe_serialize_buffer_outputs (plist : pdecl list) =
       let rec gen_serialize args count (ptype, decl) =
@@ -1097,13 +1134,17 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
     ; "    size_t _output_bytes_written = 0;"
     ; ""
     ; "    /* Deep copy buffer. */"
-    ; "    " ^ String.concat "\n    " (gen_ptr_array fd.plist)
+    ; "    "
+      ^ String.concat "\n    "
+          (gen_ptr_array fd.plist "oe_allocate_ecall_buffer")
     ; ""
     ; "    /* Fill marshalling struct. */"
     ; "    memset(&_args, 0, sizeof(_args));"
     ; "    " ^ String.concat "\n    " (gen_fill_marshal_struct fd)
     ; ""
-    ; "    " ^ String.concat "\n    " (oe_prepare_input_buffer fd "malloc")
+    ; "    "
+      ^ String.concat "\n    "
+          (oe_prepare_input_buffer fd "oe_allocate_ecall_buffer")
     ; ""
     ; "    /* Call enclave function. */"
     ; "    if ((_result = " ^ oe_ecall_function ^ "("
@@ -1124,9 +1165,146 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
     ; ""
     ; "done:"
     ; "    if (_buffer)"
-    ; "        free(_buffer);"
+    ; "        oe_free_ecall_buffer(_buffer);"
+    ; ""
+    ; "    "
+      ^ String.concat "\n    " (gen_free_ptrs fd.plist "oe_free_ecall_buffer")
+    ; ""
+    ; "    return _result;"
+    ; "}"
+    ; "" ]
+  in
+  (* Generate the batch variant of a host ECALL wrapper. It marshals each
+     call of [_calls] as the wrapper above does, makes all the calls with one
+     enclave entry, and then unmarshals the outputs of the calls that
+     succeeded. The result of each call is stored in its [_result] field. *)
+  let oe_gen_host_ecall_batch_wrapper (tf : trusted_func) =
+    let fd = tf.tf_fdecl in
+    let in_loop lines =
+      "        "
+      ^ String.concat "\n        " (List.map indent_continuation lines)
+    in
+    let restore_params =
+      List.map
+        (fun (_, decl) ->
+          sprintf "%s = _calls[_i].%s;" decl.identifier decl.identifier)
+        fd.plist
+    in
+    [ sprintf "oe_result_t %s_batch(" fd.fname
+    ; "    oe_enclave_t* enclave,"
+    ; sprintf "    %s_batch_call_t* _calls," fd.fname
+    ; "    size_t _count)"
+    ; "{"
+    ; "    oe_result_t _result = OE_FAILURE;"
+    ; "    size_t _i = 0;"
+    ; ""
+    ; "    /* Marshalling structs and buffers of all the calls. */"
+    ; sprintf "    %s_args_t* _batch_args = NULL;" fd.fname
+    ; "    oe_enclave_function_call_t* _batch = NULL;"
+    ; ""
+    ; "    /* Parameters of the current call. */"
+    ; ( match fd.rtype with
+      | Void -> "    /* No return value. */"
+      | _ -> sprintf "    %s* _retval = NULL;" (get_tystr fd.rtype) )
+    ; ( if fd.plist <> [] then
+        "    "
+        ^ String.concat "\n    "
+            (List.map (fun p -> gen_parm_str p ^ ";") fd.plist)
+      else "    /* No parameters. */" )
+    ; ""
+    ; "    /* Marshalling struct, buffer and sizes of the current call. */"
+    ; sprintf "    %s_args_t _args, *_pargs_in = NULL, *_pargs_out = NULL;"
+        fd.fname
+    ; "    size_t _input_buffer_size = 0;"
+    ; "    size_t _output_buffer_size = 0;"
+    ; "    size_t _total_buffer_size = 0;"
+    ; "    uint8_t* _buffer = NULL;"
+    ; "    uint8_t* _input_buffer = NULL;"
+    ; "    uint8_t* _output_buffer = NULL;"
+    ; "    size_t _input_buffer_offset = 0;"
+    ; "    size_t _output_buffer_offset = 0;"
+    ; "    size_t _output_bytes_written = 0;"
+    ; ""
+    ; "    if (_count == 0)"
+    ; "        return OE_OK;"
+    ; ""
+    ; "    if (!_calls)"
+    ; "        return OE_INVALID_PARAMETER;"
+    ; ""
+    ; sprintf
+        "    _batch_args = (%s_args_t*)calloc(_count, sizeof(*_batch_args));"
+        fd.fname
+    ; "    _batch = (oe_enclave_function_call_t*)calloc(_count, \
+       sizeof(*_batch));"
+    ; "    if (_batch_args == NULL || _batch == NULL)"
+    ; "    {"
+    ; "        _result = OE_OUT_OF_MEMORY;"
+    ; "        goto done;"
+    ; "    }"
+    ; ""
+    ; "    /* Marshal the inputs of each call. */"
+    ; "    for (_i = 0; _i < _count; _i++)"
+    ; "    {"
+    ; in_loop restore_params
+    ; "        _input_buffer_size = 0;"
+    ; "        _output_buffer_size = 0;"
+    ; "        _input_buffer_offset = 0;"
+    ; ""
+    ; "        /* Fill marshalling struct. */"
+    ; "        memset(&_args, 0, sizeof(_args));"
+    ; in_loop (gen_fill_marshal_struct fd)
+    ; ""
+    ; in_loop (oe_prepare_input_buffer fd "oe_allocate_ecall_buffer")
+    ; ""
+    ; "        /* The buffer is now freed with the batch. */"
+    ; "        _batch[_i].function_id = " ^ get_function_id fd ^ ";"
+    ; "        _batch[_i].input_buffer = _input_buffer;"
+    ; "        _batch[_i].input_buffer_size = _input_buffer_size;"
+    ; "        _batch[_i].output_buffer = _output_buffer;"
+    ; "        _batch[_i].output_buffer_size = _output_buffer_size;"
+    ; "        _batch_args[_i] = _args;"
+    ; "        _buffer = NULL;"
+    ; "    }"
+    ; ""
+    ; "    /* Call the enclave functions. */"
+    ; "    if ((_result = oe_call_enclave_functions(enclave, _batch, _count)) \
+       != OE_OK)"
+    ; "        goto done;"
+    ; ""
+    ; "    /* Unmarshal the outputs of each call. */"
+    ; "    for (_i = 0; _i < _count; _i++)"
+    ; "    {"
+    ; "        if ((_calls[_i]._result = _batch[_i].result) != OE_OK)"
+    ; "            continue;"
+    ; ""
+    ; ( match fd.rtype with
+      | Void -> "        /* No return value. */"
+      | _ -> "        _retval = &_calls[_i]._retval;" )
+    ; in_loop restore_params
+    ; "        _args = _batch_args[_i];"
+    ; "        _output_buffer = (uint8_t*)_batch[_i].output_buffer;"
+    ; "        _output_buffer_size = _batch[_i].output_buffer_size;"
+    ; "        _output_bytes_written = _batch[_i].output_bytes_written;"
+    ; "        _output_buffer_offset = 0;"
+    ; ""
+    ; in_loop (oe_process_output_buffer fd)
+    ; "    }"
+    ; ""
+    ; "    _result = OE_OK;"
+    ; ""
+    ; "done:"
+    ; "    if (_buffer)"
+    ; "        oe_free_ecall_buffer(_buffer);"
     ; ""
-    ; "    " ^ String.concat "\n    " (gen_free_ptrs fd.plist)
+    ; "    if (_batch)"
+    ; "    {"
+    ; "        for (_i = 0; _i < _count; _i++)"
+    ; "            oe_free_ecall_buffer((void*)_batch[_i].input_buffer);"
+    ; ""
+    ; "        free(_batch);"
+    ; "    }"
+    ; ""
+    ; "    free(_batch_args);"
     ; ""
     ; "    return _result;"
     ; "}"
@@ -1158,7 +1336,7 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
     ; "    /* Marshalling struct. */"
     ; sprintf "    %s_args_t _args, *_pargs_in = NULL, *_pargs_out = NULL;"
         fd.fname
-    ; "    " ^ String.concat "\n    " (gen_ptr_array fd.plist)
+    ; "    " ^ String.concat "\n    " (gen_ptr_array fd.plist "malloc")
     ; ""
     ; "    /* Marshalling buffer and sizes. */"
     ; "    size_t _input_buffer_size = 0;"
@@ -1354,6 +1532,12 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
         List.map (fun f -> oe_gen_prototype f.uf_fdecl ^ ";") ufs
       else ["/* There were no ocalls. */"]
     in
+    let oe_gen_batch_prototypes =
+      let batch_tfs = List.filter has_batch_variant tfs in
+      if batch_tfs <> [] then
+        List.map (fun f -> oe_gen_batch_prototype f.tf_fdecl) batch_tfs
+      else ["/* There were no ecalls with a batch variant. */"]
+    in
     let guard = "EDGER8R_" ^ String.uppercase ec.file_shortnm ^ "_U_H" in
     [ "#ifndef " ^ guard
     ; "#define " ^ guard
@@ -1375,6 +1559,9 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
     ; "/**** ECALL prototypes. ****/"
     ; String.concat "\n\n" oe_gen_tfunc_wrapper_prototypes
     ; ""
+    ; "/**** Batch ECALL prototypes. ****/"
+    ; String.concat "\n\n" oe_gen_batch_prototypes
+    ; ""
     ; "/**** OCALL prototypes. ****/"
     ; String.concat "\n\n" oe_gen_ufunc_prototypes
     ; ""
@@ -1388,6 +1575,12 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
       if tfs <> [] then flatten_map oe_gen_host_ecall_wrapper tfs
       else ["/* There were no ecalls. */"]
     in
+    let oe_gen_host_ecall_batch_wrappers =
+      let batch_tfs = List.filter has_batch_variant tfs in
+      if batch_tfs <> [] then
+        flatten_map oe_gen_host_ecall_batch_wrapper batch_tfs
+      else ["/* There were no ecalls with a batch variant. */"]
+    in
     let oe_gen_ocall_functions =
       if ufs <> [] then flatten_map oe_gen_ocall_function ufs
       else ["/* There were no ocalls. */"]
@@ -1416,6 +1609,9 @@ let gen_enclave_code (ec : enclave_content) (ep : edger8r_params) =
     ; "/**** ECALL function wrappers. ****/"
     ; ""
     ; String.concat "\n" oe_gen_host_ecall_wrappers
+    ; "/**** Batch ECALL function wrappers. ****/"
+    ; ""
+    ; String.concat "\n" oe_gen_host_ecall_batch_wrappers
     ; "/**** OCALL functions. ****/"
     ; ""
     ; String.concat "\n" oe_gen_ocall_functions
@@ -181,6 +181,10 @@ void dump_enclave_properties(const oe_sgx_enclave_properties_t* props)
 
     printf("xfrm=%lx\n", props->config.xfrm);
 
+    bool persistent_thread_locals =
+        props->config.flags & OE_SGX_CONFIG_PERSISTENT_THREAD_LOCALS;
+    printf("persistent_thread_locals=%u\n", persistent_thread_locals);
+
     printf(
         "num_heap_pages=%llu\n",
         OE_LLU(props->header.size_settings.num_heap_pages));